@@ -33,4 +33,10 @@ layout(set=0, binding=3) uniform Frame_ForwardPointLightUBO
 {
     uint num_point_lights;
     ForwardPointLightData point_light_list[32];
-} frame_forward_light_ubo;
\ No newline at end of file
+} frame_forward_light_ubo;
+
+// Draw ID of every instance slot, indexed with gl_InstanceIndex.
+layout(set=0, binding=4) buffer readonly Frame_InstanceSSBO
+{
+    uint draw_ids[];
+} frame_instance_ssbo;
\ No newline at end of file
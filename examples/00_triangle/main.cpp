@@ -1,5 +1,6 @@
 #include "vk_core.hpp"
 #include "renderer.hpp"
+#include "triangle_reflection.hpp"
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -13,10 +14,10 @@
 
 constexpr uint32_t window_width = 800u;
 constexpr uint32_t window_height = 800u;
-constexpr uint32_t frame_resource_count = 1u;
+constexpr uint32_t frame_resource_count = 2u;
 
 static std::pair<std::vector<float>, std::vector<uint32_t>> generate_triangle_data();
-static void flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const VkCommandPool vk_handle_cmd_pool, const uint32_t frame_resource_idx, const bool first_frame);
+static uint64_t flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx);
 static void blit(const uint32_t frame_resource_idx, const VkCommandBuffer vk_handle_cmd_buff);
 
 int main()
@@ -45,8 +46,8 @@ int main()
     glm::mat4x4 proj_mat { 1.0 };
     glm::mat4x4 view_mat { 1.0 };
 
-    renderer::update_uniform(renderer::BufferType::eFrame, "proj_mat", &(proj_mat[0][0]));
-    renderer::update_uniform(renderer::BufferType::eFrame, "view_mat", &(view_mat[0][0]));
+    renderer::update_uniform<&triangle_reflection::Frame_UBO::proj_mat>(proj_mat);
+    renderer::update_uniform<&triangle_reflection::Frame_UBO::view_mat>(view_mat);
 
     uint32_t material_ID = 0u;
     uint32_t renderable_ID = 0u;
@@ -66,30 +67,14 @@ int main()
 
         const uint32_t mesh_ID = renderer::create_mesh(mesh_init_info);
 
-        std::vector<float> material_data { 0.0, 0.0, 0.0 };
+        const triangle_reflection::sortbin_default_v3_pos::MaterialData material_data { .color = { 0.0f, 0.0f, 0.0f } };
+        const uint32_t m_ID = renderer::create_material("triangle_material", material_data, 0u);
 
-        const renderer::MaterialInitInfo material_init_info {
-            .name = "triangle_material",
-            .material_data_ptr = (uint8_t*)material_data.data(),
-            .material_data_size = static_cast<uint32_t>(material_data.size() * sizeof(float)),
-            .default_sort_bin_name = "default_v3_pos",
-        };
-
-        const uint32_t m_ID = renderer::create_material(material_init_info, 0u);    
+        triangle_reflection::sortbin_default_v3_pos::DrawData draw_data {};
+        const glm::mat4x4 model_mat { 1.0 };
+        memcpy(draw_data.model_mat.data(), &(model_mat[0][0]), sizeof(draw_data.model_mat));
 
-        std::vector<float> draw_data(16, 0);
-        glm::mat4x4 model_mat { 1.0 };
-        memcpy(draw_data.data(), &(model_mat[0][0]), 64);
-
-        const renderer::RenderableInitInfo renderable_init_info {
-            .mesh_ID = mesh_ID,
-            .material_ID = m_ID,
-            .draw_data_ptr = (uint8_t*)draw_data.data(),
-            .draw_data_size = static_cast<uint32_t>(draw_data.size() * sizeof(float)),
-            .default_sort_bin_name = "default_v3_pos",
-        };
-
-        const auto [r_ID, s_ID] = renderer::create_renderable(renderable_init_info, 0u);
+        const auto [r_ID, s_ID] = renderer::create_renderable(mesh_ID, m_ID, draw_data, 0u);
 
         material_ID = m_ID;
         renderable_ID = r_ID;
@@ -98,9 +83,34 @@ int main()
         renderer::add_renderable_to_sortbin(renderable_ID, sort_bin_ID);
     }
 
-    const VkCommandPool vk_handle_cmd_pool = vk_core::create_command_pool(0x0);
-    const VkCommandBuffer vk_handle_cmd_buff = vk_core::allocate_command_buffer(vk_handle_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-    const VkFence vk_handle_swapchain_image_acquire_fence = vk_core::create_fence(0x0);
+    // Every frame resource owns its command buffer and the fence its submission signals. Waiting on that fence
+    // before reusing the frame resource is the only CPU / GPU synchronisation, so the CPU can record frame N + 1
+    // while the GPU still works on frame N.
+    struct FrameResource
+    {
+        VkCommandPool vk_handle_cmd_pool = VK_NULL_HANDLE;
+        VkCommandBuffer vk_handle_cmd_buff = VK_NULL_HANDLE;
+        VkFence vk_handle_frame_fence = VK_NULL_HANDLE;
+        VkSemaphore vk_handle_image_acquired_sem4 = VK_NULL_HANDLE;
+    };
+
+    FrameResource frame_resource_list[frame_resource_count];
+
+    for (FrameResource& frame_resource : frame_resource_list)
+    {
+        frame_resource.vk_handle_cmd_pool = vk_core::create_command_pool(0x0);
+        frame_resource.vk_handle_cmd_buff = vk_core::allocate_command_buffer(frame_resource.vk_handle_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        frame_resource.vk_handle_frame_fence = vk_core::create_fence(VK_FENCE_CREATE_SIGNALED_BIT);
+        frame_resource.vk_handle_image_acquired_sem4 = vk_core::create_semaphore();
+    }
+
+    // Present waits on these. Indexed by swapchain image, an image is only re-acquired once its previous present is done.
+    std::vector<VkSemaphore> vk_handle_render_done_sem4_list(vk_core::get_swapchain_image_count());
+
+    for (VkSemaphore& vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_handle_sem4 = vk_core::create_semaphore();
+    }
 
     uint64_t frame_idx = 0;
     float rotation_angle = 0.0f;
@@ -110,18 +120,23 @@ int main()
         glfwPollEvents();
 
         uint32_t frame_resource_idx = frame_idx % frame_resource_count;
+        const FrameResource& frame_resource = frame_resource_list[frame_resource_idx];
+
+        vk_core::wait_for_fences(1, &frame_resource.vk_handle_frame_fence, VK_TRUE, UINT64_MAX);
+        vk_core::reset_fences(1, &frame_resource.vk_handle_frame_fence);
 
         glm::mat4x4 model_mat { 1.0 };
-        std::vector<float> material_data { 0.0f, glm::cos(glm::radians(rotation_angle)), glm::sin(glm::radians(rotation_angle)) };
+        const glm::vec3 color { 0.0f, glm::cos(glm::radians(rotation_angle)), glm::sin(glm::radians(rotation_angle)) };
         model_mat = glm::rotate(model_mat, glm::radians(rotation_angle++), glm::vec3(0.0, 0.0, 1.0));
-        renderer::update_uniform(renderer::BufferType::eMaterial, "color", material_data.data(), material_ID); 
-        renderer::update_uniform(renderer::BufferType::eDraw, "model_mat", &(model_mat[0][0]), renderable_ID); 
+        renderer::update_uniform<&triangle_reflection::sortbin_default_v3_pos::MaterialData::color>(color, material_ID);
+        renderer::update_uniform<&triangle_reflection::sortbin_default_v3_pos::DrawData::model_mat>(model_mat, renderable_ID);
+
+        vk_core::acquire_next_swapchain_image(frame_resource.vk_handle_image_acquired_sem4, VK_NULL_HANDLE);
+        const VkSemaphore vk_handle_render_done_sem4 = vk_handle_render_done_sem4_list[vk_core::get_active_swapchain_image_idx()];
 
-        vk_core::acquire_next_swapchain_image(VK_NULL_HANDLE, vk_handle_swapchain_image_acquire_fence);
-        vk_core::wait_for_fences(1, &vk_handle_swapchain_image_acquire_fence, VK_TRUE, UINT64_MAX);
-        vk_core::reset_fences(1, &vk_handle_swapchain_image_acquire_fence);
+        vk_core::reset_command_pool(frame_resource.vk_handle_cmd_pool);
 
-        vk_core::reset_command_pool(vk_handle_cmd_pool);
+        const VkCommandBuffer vk_handle_cmd_buff = frame_resource.vk_handle_cmd_buff;
 
         const VkCommandBufferBeginInfo cmd_buff_begin_info {
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -132,7 +147,7 @@ int main()
 
         vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info);
 
-            flush_uploads(vk_handle_cmd_buff, vk_handle_cmd_pool, frame_resource_idx, frame_idx == 0);
+            const uint64_t staging_retire_value = flush_uploads(vk_handle_cmd_buff, frame_resource_idx);
 
             renderer::record_render_pass("default", vk_handle_cmd_buff, {0, 0, window_width, window_height}, frame_resource_idx);
 
@@ -140,31 +155,54 @@ int main()
 
         vkEndCommandBuffer(vk_handle_cmd_buff);
 
-        const VkPipelineStageFlags none_flag = VK_PIPELINE_STAGE_FLAG_BITS_MAX_ENUM;
+        // The swapchain image is first touched by the pre-blit barrier
+        const VkPipelineStageFlags image_acquired_wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+        // The frame's own submission retires the staging region (the binary semaphore ignores its value).
+        const VkSemaphore vk_handle_signal_sem4_list[2] { vk_handle_render_done_sem4, renderer::get_staging_retire_semaphore() };
+        const uint64_t signal_value_list[2] { 0, staging_retire_value };
+
+        const VkTimelineSemaphoreSubmitInfo timeline_submit_info {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreValueCount = 0,
+            .pWaitSemaphoreValues = nullptr,
+            .signalSemaphoreValueCount = 2,
+            .pSignalSemaphoreValues = signal_value_list,
+        };
 
         const VkSubmitInfo submit_info {
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext = nullptr,
-            .waitSemaphoreCount = 0,
-            .pWaitSemaphores = nullptr,
-            .pWaitDstStageMask = &none_flag,
+            .pNext = &timeline_submit_info,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &frame_resource.vk_handle_image_acquired_sem4,
+            .pWaitDstStageMask = &image_acquired_wait_stage,
             .commandBufferCount = 1,
             .pCommandBuffers = &vk_handle_cmd_buff,
-            .signalSemaphoreCount = 0,
-            .pSignalSemaphores = nullptr,
+            .signalSemaphoreCount = 2,
+            .pSignalSemaphores = vk_handle_signal_sem4_list,
         };
 
-        vk_core::queue_submit(1, &submit_info, VK_NULL_HANDLE);
-        
-        vk_core::device_wait_idle();
+        vk_core::queue_submit(1, &submit_info, frame_resource.vk_handle_frame_fence);
 
-        vk_core::present(0, nullptr);
+        vk_core::present(1, &vk_handle_render_done_sem4);
 
         frame_idx++;
     }
 
-    vk_core::destroy_command_pool(vk_handle_cmd_pool);
-    vk_core::destroy_fence(vk_handle_swapchain_image_acquire_fence);
+    vk_core::device_wait_idle();
+
+    for (const FrameResource& frame_resource : frame_resource_list)
+    {
+        vk_core::destroy_command_pool(frame_resource.vk_handle_cmd_pool);
+        vk_core::destroy_fence(frame_resource.vk_handle_frame_fence);
+        vk_core::destroy_semaphore(frame_resource.vk_handle_image_acquired_sem4);
+    }
+
+    for (const VkSemaphore vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_core::destroy_semaphore(vk_handle_sem4);
+    }
 
     glfwDestroyWindow(glfw_window);
     glfwTerminate();
@@ -194,49 +232,16 @@ static std::pair<std::vector<float>, std::vector<uint32_t>> generate_triangle_da
     return { vertex_data, index_data };
 }
 
-static void flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const VkCommandPool vk_handle_cmd_pool, const uint32_t frame_resource_idx, const bool first_frame)
+static uint64_t flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx)
 {
-    bool uploads_pending = false;
     renderer::flush_coherent_buffer_uploads(renderer::BufferType::eFrame, frame_resource_idx);
-    uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eGeometry, frame_resource_idx);
-    uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eMaterial, frame_resource_idx);
-    uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eDraw, frame_resource_idx);
-
-    if (first_frame || uploads_pending)
-    {
-        renderer::flush_staging_to_device(vk_handle_cmd_buff);
-
-        vkEndCommandBuffer(vk_handle_cmd_buff);
-
-        const VkPipelineStageFlags none_flag = VK_PIPELINE_STAGE_FLAG_BITS_MAX_ENUM;
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eGeometry, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eMaterial, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eDraw, frame_resource_idx);
 
-        const VkSubmitInfo submit_info {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext = nullptr,
-            .waitSemaphoreCount = 0,
-            .pWaitSemaphores = nullptr,
-            .pWaitDstStageMask = &none_flag,
-            .commandBufferCount = 1,
-            .pCommandBuffers = &vk_handle_cmd_buff,
-            .signalSemaphoreCount = 0,
-            .pSignalSemaphores = nullptr,
-        };
-
-        vk_core::queue_submit(1, &submit_info, VK_NULL_HANDLE);
-        
-        vk_core::device_wait_idle();
-
-        vk_core::reset_command_pool(vk_handle_cmd_pool);
-
-        const VkCommandBufferBeginInfo cmd_buff_begin_info {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-            .pNext = nullptr,
-            .flags = 0x0,
-            .pInheritanceInfo = nullptr,
-        };
-
-        vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info);
-    }
+    // Copies are recorded into the frame's command buffer together with the barrier guarding them,
+    // the returned value retires the staging region once this frame's submission signals it.
+    return renderer::flush_staging_to_device(vk_handle_cmd_buff);
 }
 
 static void blit(const uint32_t frame_resource_idx, const VkCommandBuffer vk_handle_cmd_buff)
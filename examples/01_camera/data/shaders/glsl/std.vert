@@ -22,7 +22,7 @@ struct DrawData
 
 void main()
 {
-    DrawData draw_data = frame_draw_ssbo.data[gl_InstanceIndex];
+    DrawData draw_data = frame_draw_ssbo.data[frame_instance_ssbo.draw_ids[gl_InstanceIndex]];
     MaterialData mat_data = frame_mat_ssbo.data[draw_data.mat_id];
 
     gl_Position = frame_ubo.proj_mat * frame_ubo.view_mat * draw_data.model_matrix * vec4(in_pos, 1.0);
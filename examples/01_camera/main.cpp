@@ -18,7 +18,7 @@ constexpr uint32_t frame_resource_count = 1u;
 
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 static std::pair<std::vector<float>, std::vector<uint32_t>> generate_triangle_data();
-static void flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const VkCommandPool vk_handle_cmd_pool, const uint32_t frame_resource_idx, const bool first_frame);
+static uint64_t flush_uploads(const uint32_t frame_resource_idx);
 static void blit(const uint32_t frame_resource_idx, const VkCommandBuffer vk_handle_cmd_buff);
 
 int main()
@@ -98,9 +98,33 @@ int main()
         renderer::add_renderable_to_sortbin(renderable_ID, sort_bin_ID);
     }
 
-    const VkCommandPool vk_handle_cmd_pool = vk_core::create_command_pool(0x0);
-    const VkCommandBuffer vk_handle_cmd_buff = vk_core::allocate_command_buffer(vk_handle_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-    const VkFence vk_handle_swapchain_image_acquire_fence = vk_core::create_fence(0x0);
+    // Every frame resource owns its command buffer and the fence its submission signals. Waiting on that fence
+    // before reusing the frame resource is the only CPU / GPU synchronisation.
+    struct FrameResource
+    {
+        VkCommandPool vk_handle_cmd_pool = VK_NULL_HANDLE;
+        VkCommandBuffer vk_handle_cmd_buff = VK_NULL_HANDLE;
+        VkFence vk_handle_frame_fence = VK_NULL_HANDLE;
+        VkSemaphore vk_handle_image_acquired_sem4 = VK_NULL_HANDLE;
+    };
+
+    FrameResource frame_resource_list[frame_resource_count];
+
+    for (FrameResource& frame_resource : frame_resource_list)
+    {
+        frame_resource.vk_handle_cmd_pool = vk_core::create_command_pool(0x0);
+        frame_resource.vk_handle_cmd_buff = vk_core::allocate_command_buffer(frame_resource.vk_handle_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        frame_resource.vk_handle_frame_fence = vk_core::create_fence(VK_FENCE_CREATE_SIGNALED_BIT);
+        frame_resource.vk_handle_image_acquired_sem4 = vk_core::create_semaphore();
+    }
+
+    // Present waits on these. Indexed by swapchain image, an image is only re-acquired once its previous present is done.
+    std::vector<VkSemaphore> vk_handle_render_done_sem4_list(vk_core::get_swapchain_image_count());
+
+    for (VkSemaphore& vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_handle_sem4 = vk_core::create_semaphore();
+    }
 
     uint64_t frame_idx = 0;
     float rotation_angle = 0.0f;
@@ -110,6 +134,10 @@ int main()
         glfwPollEvents();
 
         uint32_t frame_resource_idx = frame_idx % frame_resource_count;
+        const FrameResource& frame_resource = frame_resource_list[frame_resource_idx];
+
+        vk_core::wait_for_fences(1, &frame_resource.vk_handle_frame_fence, VK_TRUE, UINT64_MAX);
+        vk_core::reset_fences(1, &frame_resource.vk_handle_frame_fence);
 
         if (Camera::proj_dirty)
         {
@@ -127,13 +155,20 @@ int main()
         std::vector<float> material_data { 0.0f, glm::cos(glm::radians(rotation_angle)), glm::sin(glm::radians(rotation_angle)) };
         model_mat = glm::rotate(model_mat, glm::radians(rotation_angle++), glm::vec3(0.0, 0.0, 1.0));
         renderer::update_uniform(renderer::BufferType::eMaterial, "color", material_data.data(), material_ID); 
-        renderer::update_uniform(renderer::BufferType::eDraw, "model_mat", &(model_mat[0][0]), renderable_ID); 
+        // Writes the draw data's model_mat and the culling bounds derived from it
+        renderer::set_renderable_transform(renderable_ID, &(model_mat[0][0]));
+
+        const glm::mat4x4 view_proj_mat = Camera::proj_mat * Camera::view_mat;
+        renderer::cull_render_pass("default", &(view_proj_mat[0][0]), frame_resource_idx);
 
-        vk_core::acquire_next_swapchain_image(VK_NULL_HANDLE, vk_handle_swapchain_image_acquire_fence);
-        vk_core::wait_for_fences(1, &vk_handle_swapchain_image_acquire_fence, VK_TRUE, UINT64_MAX);
-        vk_core::reset_fences(1, &vk_handle_swapchain_image_acquire_fence);
+        vk_core::acquire_next_swapchain_image(frame_resource.vk_handle_image_acquired_sem4, VK_NULL_HANDLE);
+        const VkSemaphore vk_handle_render_done_sem4 = vk_handle_render_done_sem4_list[vk_core::get_active_swapchain_image_idx()];
 
-        vk_core::reset_command_pool(vk_handle_cmd_pool);
+        const uint64_t upload_timeline_value = flush_uploads(frame_resource_idx);
+
+        vk_core::reset_command_pool(frame_resource.vk_handle_cmd_pool);
+
+        const VkCommandBuffer vk_handle_cmd_buff = frame_resource.vk_handle_cmd_buff;
 
         const VkCommandBufferBeginInfo cmd_buff_begin_info {
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -144,7 +179,7 @@ int main()
 
         vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info);
 
-            flush_uploads(vk_handle_cmd_buff, vk_handle_cmd_pool, frame_resource_idx, frame_idx == 0);
+            renderer::record_upload_acquire_barriers(vk_handle_cmd_buff);
 
             renderer::record_render_pass("default", vk_handle_cmd_buff, {0, 0, window_width, window_height}, frame_resource_idx);
 
@@ -152,31 +187,53 @@ int main()
 
         vkEndCommandBuffer(vk_handle_cmd_buff);
 
-        const VkPipelineStageFlags none_flag = VK_PIPELINE_STAGE_FLAG_BITS_MAX_ENUM;
+        // Waiting on a timeline value that has already been reached is a no-op (the binary semaphore ignores its value).
+        // The swapchain image is first touched by the pre-blit barrier.
+        const VkSemaphore vk_handle_wait_sem4_list[2] { renderer::get_upload_timeline_semaphore(), frame_resource.vk_handle_image_acquired_sem4 };
+        const VkPipelineStageFlags wait_stage_list[2] { renderer::get_upload_wait_stage_mask(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT };
+        const uint64_t wait_value_list[2] { upload_timeline_value, 0 };
+
+        const VkTimelineSemaphoreSubmitInfo timeline_submit_info {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreValueCount = 2,
+            .pWaitSemaphoreValues = wait_value_list,
+            .signalSemaphoreValueCount = 0,
+            .pSignalSemaphoreValues = nullptr,
+        };
 
         const VkSubmitInfo submit_info {
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext = nullptr,
-            .waitSemaphoreCount = 0,
-            .pWaitSemaphores = nullptr,
-            .pWaitDstStageMask = &none_flag,
+            .pNext = &timeline_submit_info,
+            .waitSemaphoreCount = 2,
+            .pWaitSemaphores = vk_handle_wait_sem4_list,
+            .pWaitDstStageMask = wait_stage_list,
             .commandBufferCount = 1,
             .pCommandBuffers = &vk_handle_cmd_buff,
-            .signalSemaphoreCount = 0,
-            .pSignalSemaphores = nullptr,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &vk_handle_render_done_sem4,
         };
 
-        vk_core::queue_submit(1, &submit_info, VK_NULL_HANDLE);
-        
-        vk_core::device_wait_idle();
+        vk_core::queue_submit(1, &submit_info, frame_resource.vk_handle_frame_fence);
 
-        vk_core::present(0, nullptr);
+        vk_core::present(1, &vk_handle_render_done_sem4);
 
         frame_idx++;
     }
 
-    vk_core::destroy_command_pool(vk_handle_cmd_pool);
-    vk_core::destroy_fence(vk_handle_swapchain_image_acquire_fence);
+    vk_core::device_wait_idle();
+
+    for (const FrameResource& frame_resource : frame_resource_list)
+    {
+        vk_core::destroy_command_pool(frame_resource.vk_handle_cmd_pool);
+        vk_core::destroy_fence(frame_resource.vk_handle_frame_fence);
+        vk_core::destroy_semaphore(frame_resource.vk_handle_image_acquired_sem4);
+    }
+
+    for (const VkSemaphore vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_core::destroy_semaphore(vk_handle_sem4);
+    }
 
     glfwDestroyWindow(glfw_window);
     glfwTerminate();
@@ -244,49 +301,15 @@ static std::pair<std::vector<float>, std::vector<uint32_t>> generate_triangle_da
     return { vertex_data, index_data };
 }
 
-static void flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const VkCommandPool vk_handle_cmd_pool, const uint32_t frame_resource_idx, const bool first_frame)
+static uint64_t flush_uploads(const uint32_t frame_resource_idx)
 {
-    bool uploads_pending = false;
     renderer::flush_coherent_buffer_uploads(renderer::BufferType::eFrame, frame_resource_idx);
-    uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eGeometry, frame_resource_idx);
-    uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eMaterial, frame_resource_idx);
-    uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eDraw, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eGeometry, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eMaterial, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eDraw, frame_resource_idx);
 
-    if (first_frame || uploads_pending)
-    {
-        renderer::flush_staging_to_device(vk_handle_cmd_buff);
-
-        vkEndCommandBuffer(vk_handle_cmd_buff);
-
-        const VkPipelineStageFlags none_flag = VK_PIPELINE_STAGE_FLAG_BITS_MAX_ENUM;
-
-        const VkSubmitInfo submit_info {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext = nullptr,
-            .waitSemaphoreCount = 0,
-            .pWaitSemaphores = nullptr,
-            .pWaitDstStageMask = &none_flag,
-            .commandBufferCount = 1,
-            .pCommandBuffers = &vk_handle_cmd_buff,
-            .signalSemaphoreCount = 0,
-            .pSignalSemaphores = nullptr,
-        };
-
-        vk_core::queue_submit(1, &submit_info, VK_NULL_HANDLE);
-        
-        vk_core::device_wait_idle();
-
-        vk_core::reset_command_pool(vk_handle_cmd_pool);
-
-        const VkCommandBufferBeginInfo cmd_buff_begin_info {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-            .pNext = nullptr,
-            .flags = 0x0,
-            .pInheritanceInfo = nullptr,
-        };
-
-        vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info);
-    }
+    // Copies run on the transfer queue, the frame's submission waits on the returned timeline value.
+    return renderer::submit_staging_to_transfer_queue();
 }
 
 static void blit(const uint32_t frame_resource_idx, const VkCommandBuffer vk_handle_cmd_buff)
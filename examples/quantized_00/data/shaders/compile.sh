@@ -0,0 +1,2 @@
+${VULKAN_SDK}/bin/glslc glsl/std.vert -o spirv/std.vert.spv
+${VULKAN_SDK}/bin/glslc glsl/std.frag -o spirv/std.frag.spv
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 460 core
+#extension GL_ARB_draw_instanced : enable
+
+layout(location=0) in vec4 in_pos; // R16G16B16A16_SNORM, dequantized with vertex_pos_scale / vertex_pos_bias
+
+layout(location=0) out vec3 out_color;
+
+struct MaterialData
+{
+    vec3 color;
+    uint __padding;
+};
+
+struct DrawData
+{
+    mat4 model_matrix;
+    vec3 vertex_pos_scale;
+    vec3 vertex_pos_bias;
+    uint mat_id;
+};
+
+#include "frame_desc_bindings.glsl"
+
+void main()
+{
+    DrawData draw_data = frame_draw_ssbo.data[frame_instance_ssbo.draw_ids[gl_InstanceIndex]];
+    MaterialData mat_data = frame_mat_ssbo.data[draw_data.mat_id];
+
+    const vec3 pos = in_pos.xyz * draw_data.vertex_pos_scale + draw_data.vertex_pos_bias;
+
+    gl_Position = frame_ubo.proj_mat * frame_ubo.view_mat * draw_data.model_matrix * vec4(pos, 1.0);
+    out_color = mat_data.color;
+}
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include "vk_core.hpp"
+#include "renderer.hpp"
+#include "quantized_reflection.hpp"
+
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <assert.h>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <cstring> 
+
+constexpr uint32_t window_width = 800u;
+constexpr uint32_t window_height = 800u;
+constexpr uint32_t frame_resource_count = 2u;
+
+static std::pair<std::vector<float>, std::vector<uint32_t>> generate_triangle_data();
+static uint64_t flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx);
+static void blit(const uint32_t frame_resource_idx, const VkCommandBuffer vk_handle_cmd_buff);
+
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    GLFWwindow *glfw_window = glfwCreateWindow(static_cast<int>(window_width), static_cast<int>(window_height), "App", nullptr, nullptr);
+    assert(glfw_window && "Failed to create window");
+
+    vk_core::init(window_width, window_height, glfw_window, "/home/mica/Desktop/clean-start/examples/quantized_00/data/json/vulkan_state.json");
+
+    const renderer::InitInfo renderer_init_info {
+        .window_width = window_width, 
+        .window_height = window_height, 
+        .frame_resource_count = frame_resource_count, 
+        .refl_file_frame_desc_set_def = "/home/mica/Desktop/clean-start/examples/quantized_00/data/json/reflection/frame_desc_set_reflection.json",
+        .refl_file_sortbin_mat_draw_def = "/home/mica/Desktop/clean-start/examples/quantized_00/data/json/reflection/sortbin_reflection.json",
+        .file_sortbin_pipeline_state = "/home/mica/Desktop/clean-start/examples/quantized_00/data/json/sortbin_pipeline_state.json",
+        .file_app_state = "/home/mica/Desktop/clean-start/examples/quantized_00/data/json/app_state.json", 
+        .path_shader_root = "/home/mica/Desktop/clean-start/examples/quantized_00/data/shaders/spirv/",
+    };
+
+    renderer::init(renderer_init_info);
+
+    glm::mat4x4 proj_mat { 1.0 };
+    glm::mat4x4 view_mat { 1.0 };
+
+    renderer::update_uniform<&quantized_reflection::Frame_UBO::proj_mat>(proj_mat);
+    renderer::update_uniform<&quantized_reflection::Frame_UBO::view_mat>(view_mat);
+
+    uint32_t material_ID = 0u;
+    uint32_t renderable_ID = 0u;
+    uint16_t sort_bin_ID = 0u;
+
+    {
+        const auto [vertex_data, index_data] = generate_triangle_data();
+
+        const renderer::MeshInitInfo mesh_init_info {
+            .vertex_stride = 12,
+            .vertex_count = 3,
+            .vertex_data = (uint8_t*)(vertex_data.data()),
+            .index_count = 3,
+            .index_data = (uint8_t*)(index_data.data()),
+            .index_stride = 4,
+            .vertex_attribute_list = { { .usage = "vertex_pos", .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = 0 } },
+            .quantize_sort_bin_name = "default_q_pos", // 16 bit positions, the vertex shader applies the mesh's scale / bias
+        };
+
+        const uint32_t mesh_ID = renderer::create_mesh(mesh_init_info);
+
+        const quantized_reflection::sortbin_default_q_pos::MaterialData material_data { .color = { 0.0f, 0.0f, 0.0f } };
+        const uint32_t m_ID = renderer::create_material("triangle_material", material_data, 0u);
+
+        quantized_reflection::sortbin_default_q_pos::DrawData draw_data {};
+        const glm::mat4x4 model_mat { 1.0 };
+        memcpy(draw_data.model_mat.data(), &(model_mat[0][0]), sizeof(draw_data.model_mat));
+
+        const auto [r_ID, s_ID] = renderer::create_renderable(mesh_ID, m_ID, draw_data, 0u);
+
+        material_ID = m_ID;
+        renderable_ID = r_ID;
+        sort_bin_ID = s_ID;
+
+        renderer::add_renderable_to_sortbin(renderable_ID, sort_bin_ID);
+    }
+
+    // Every frame resource owns its command buffer and the fence its submission signals. Waiting on that fence
+    // before reusing the frame resource is the only CPU / GPU synchronisation, so the CPU can record frame N + 1
+    // while the GPU still works on frame N.
+    struct FrameResource
+    {
+        VkCommandPool vk_handle_cmd_pool = VK_NULL_HANDLE;
+        VkCommandBuffer vk_handle_cmd_buff = VK_NULL_HANDLE;
+        VkFence vk_handle_frame_fence = VK_NULL_HANDLE;
+        VkSemaphore vk_handle_image_acquired_sem4 = VK_NULL_HANDLE;
+    };
+
+    FrameResource frame_resource_list[frame_resource_count];
+
+    for (FrameResource& frame_resource : frame_resource_list)
+    {
+        frame_resource.vk_handle_cmd_pool = vk_core::create_command_pool(0x0);
+        frame_resource.vk_handle_cmd_buff = vk_core::allocate_command_buffer(frame_resource.vk_handle_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        frame_resource.vk_handle_frame_fence = vk_core::create_fence(VK_FENCE_CREATE_SIGNALED_BIT);
+        frame_resource.vk_handle_image_acquired_sem4 = vk_core::create_semaphore();
+    }
+
+    // Present waits on these. Indexed by swapchain image, an image is only re-acquired once its previous present is done.
+    std::vector<VkSemaphore> vk_handle_render_done_sem4_list(vk_core::get_swapchain_image_count());
+
+    for (VkSemaphore& vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_handle_sem4 = vk_core::create_semaphore();
+    }
+
+    uint64_t frame_idx = 0;
+    float rotation_angle = 0.0f;
+
+    while (!glfwWindowShouldClose(glfw_window))
+    {
+        glfwPollEvents();
+
+        uint32_t frame_resource_idx = frame_idx % frame_resource_count;
+        const FrameResource& frame_resource = frame_resource_list[frame_resource_idx];
+
+        vk_core::wait_for_fences(1, &frame_resource.vk_handle_frame_fence, VK_TRUE, UINT64_MAX);
+        vk_core::reset_fences(1, &frame_resource.vk_handle_frame_fence);
+
+        glm::mat4x4 model_mat { 1.0 };
+        const glm::vec3 color { 0.0f, glm::cos(glm::radians(rotation_angle)), glm::sin(glm::radians(rotation_angle)) };
+        model_mat = glm::rotate(model_mat, glm::radians(rotation_angle++), glm::vec3(0.0, 0.0, 1.0));
+        renderer::update_uniform<&quantized_reflection::sortbin_default_q_pos::MaterialData::color>(color, material_ID);
+        renderer::update_uniform<&quantized_reflection::sortbin_default_q_pos::DrawData::model_mat>(model_mat, renderable_ID);
+
+        vk_core::acquire_next_swapchain_image(frame_resource.vk_handle_image_acquired_sem4, VK_NULL_HANDLE);
+        const VkSemaphore vk_handle_render_done_sem4 = vk_handle_render_done_sem4_list[vk_core::get_active_swapchain_image_idx()];
+
+        vk_core::reset_command_pool(frame_resource.vk_handle_cmd_pool);
+
+        const VkCommandBuffer vk_handle_cmd_buff = frame_resource.vk_handle_cmd_buff;
+
+        const VkCommandBufferBeginInfo cmd_buff_begin_info {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = 0x0,
+            .pInheritanceInfo = nullptr,
+        };
+
+        vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info);
+
+            const uint64_t staging_retire_value = flush_uploads(vk_handle_cmd_buff, frame_resource_idx);
+
+            renderer::record_render_pass("default", vk_handle_cmd_buff, {0, 0, window_width, window_height}, frame_resource_idx);
+
+            blit(frame_resource_idx, vk_handle_cmd_buff);
+
+        vkEndCommandBuffer(vk_handle_cmd_buff);
+
+        // The swapchain image is first touched by the pre-blit barrier
+        const VkPipelineStageFlags image_acquired_wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+        // The frame's own submission retires the staging region (the binary semaphore ignores its value).
+        const VkSemaphore vk_handle_signal_sem4_list[2] { vk_handle_render_done_sem4, renderer::get_staging_retire_semaphore() };
+        const uint64_t signal_value_list[2] { 0, staging_retire_value };
+
+        const VkTimelineSemaphoreSubmitInfo timeline_submit_info {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreValueCount = 0,
+            .pWaitSemaphoreValues = nullptr,
+            .signalSemaphoreValueCount = 2,
+            .pSignalSemaphoreValues = signal_value_list,
+        };
+
+        const VkSubmitInfo submit_info {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &timeline_submit_info,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &frame_resource.vk_handle_image_acquired_sem4,
+            .pWaitDstStageMask = &image_acquired_wait_stage,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &vk_handle_cmd_buff,
+            .signalSemaphoreCount = 2,
+            .pSignalSemaphores = vk_handle_signal_sem4_list,
+        };
+
+        vk_core::queue_submit(1, &submit_info, frame_resource.vk_handle_frame_fence);
+
+        vk_core::present(1, &vk_handle_render_done_sem4);
+
+        frame_idx++;
+    }
+
+    vk_core::device_wait_idle();
+
+    for (const FrameResource& frame_resource : frame_resource_list)
+    {
+        vk_core::destroy_command_pool(frame_resource.vk_handle_cmd_pool);
+        vk_core::destroy_fence(frame_resource.vk_handle_frame_fence);
+        vk_core::destroy_semaphore(frame_resource.vk_handle_image_acquired_sem4);
+    }
+
+    for (const VkSemaphore vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_core::destroy_semaphore(vk_handle_sem4);
+    }
+
+    glfwDestroyWindow(glfw_window);
+    glfwTerminate();
+
+    renderer::terminate();
+    vk_core::terminate();
+
+    return 0;
+}
+
+static std::pair<std::vector<float>, std::vector<uint32_t>> generate_triangle_data()
+{
+    const float x = 0.707;
+    const float tan_60 = glm::tan(glm::radians(60.0f));
+    const float height = x * tan_60;
+    const float height_down = x / tan_60;
+    const float height_up = height - height_down;
+
+    const std::vector<float> vertex_data {
+         0.0, -height_up  , 0.0,
+           x,  height_down, 0.0,
+          -x,  height_down, 0.0
+    };
+
+    const std::vector<uint32_t> index_data { 0, 1, 2 };
+
+    return { vertex_data, index_data };
+}
+
+static uint64_t flush_uploads(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx)
+{
+    renderer::flush_coherent_buffer_uploads(renderer::BufferType::eFrame, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eGeometry, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eMaterial, frame_resource_idx);
+    renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eDraw, frame_resource_idx);
+
+    // Copies are recorded into the frame's command buffer together with the barrier guarding them,
+    // the returned value retires the staging region once this frame's submission signals it.
+    return renderer::flush_staging_to_device(vk_handle_cmd_buff);
+}
+
+static void blit(const uint32_t frame_resource_idx, const VkCommandBuffer vk_handle_cmd_buff)
+{
+    const VkImageMemoryBarrier pre_blit_image_barriers[2] {
+        vk_core::get_active_swapchain_image_memory_barrier(
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+        ,
+        {   // Base Color Attachment
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .srcQueueFamilyIndex = vk_core::get_queue_family_idx(),
+            .dstQueueFamilyIndex = vk_core::get_queue_family_idx(),
+            .image = renderer::get_attachment_image(0, frame_resource_idx),
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            }
+        }
+    };
+
+    vkCmdPipelineBarrier(
+        vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_DEPENDENCY_BY_REGION_BIT,
+        0, nullptr,
+        0, nullptr,
+        2, pre_blit_image_barriers);
+
+    const VkImageBlit blit_info{
+        .srcSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .srcOffsets = {
+            { 0, 0, 0 },
+            {static_cast<int32_t>(window_width), static_cast<uint32_t>(window_height), 1}
+        },
+        .dstSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .dstOffsets = {
+            {0, 0, 0},
+            {static_cast<int32_t>(window_width), static_cast<uint32_t>(window_height), 1}
+        },
+    };
+
+    vkCmdBlitImage(
+        vk_handle_cmd_buff,
+        renderer::get_attachment_image(0, frame_resource_idx), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        vk_core::get_active_swapchain_image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1, &blit_info,
+        VK_FILTER_NEAREST);
+
+    const VkImageMemoryBarrier post_blit_image_barriers[2]{
+        vk_core::get_active_swapchain_image_memory_barrier(
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            0,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+        ,
+        {   // Base Color Attachment
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .srcQueueFamilyIndex = vk_core::get_queue_family_idx(),
+            .dstQueueFamilyIndex = vk_core::get_queue_family_idx(),
+            .image = renderer::get_attachment_image(0, frame_resource_idx),
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            }
+        }
+    };
+
+    vkCmdPipelineBarrier(
+        vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_DEPENDENCY_BY_REGION_BIT,
+        0, nullptr,
+        0, nullptr,
+        2, post_blit_image_barriers);
+}
\ No newline at end of file
@@ -26,10 +26,15 @@ layout(set=0, binding=2) buffer readonly DrawSSBO
     DrawData data[];
 } draw_ssbo;
 
+layout(set=0, binding=4) buffer readonly InstanceSSBO
+{
+    uint draw_ids[];
+} instance_ssbo;
+
 
 void main()
 {
-    DrawData draw_data = draw_ssbo.data[gl_InstanceIndex];
+    DrawData draw_data = draw_ssbo.data[instance_ssbo.draw_ids[gl_InstanceIndex]];
 
     gl_Position = frame_ubo.proj_mat * frame_ubo.view_mat * draw_data.model_matrix * vec4(in_pos, 1.0);
 }
\ No newline at end of file
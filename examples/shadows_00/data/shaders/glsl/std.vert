@@ -24,7 +24,7 @@ layout(set=1, binding=0) uniform sampler2D Pass_InputAttachments[1];
 
 void main()
 {
-    DrawData draw_data = frame_draw_ssbo.data[gl_InstanceIndex];
+    DrawData draw_data = frame_draw_ssbo.data[frame_instance_ssbo.draw_ids[gl_InstanceIndex]];
     MaterialData mat_data = frame_mat_ssbo.data[draw_data.mat_id];
 
     gl_Position = frame_ubo.proj_mat * frame_ubo.view_mat * draw_data.model_matrix * vec4(in_pos, 1.0);
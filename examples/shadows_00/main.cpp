@@ -101,8 +101,15 @@ int main()
 
     const VkCommandPool vk_handle_cmd_pool = vk_core::create_command_pool(0x0);
     const VkCommandBuffer vk_handle_cmd_buff = vk_core::allocate_command_buffer(vk_handle_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-    const VkFence vk_handle_swapchain_image_acquire_fence = vk_core::create_fence(0x0);
-    const VkPipelineStageFlags none_flag = VK_PIPELINE_STAGE_FLAG_BITS_MAX_ENUM;
+    // Signalled by the frame's submission, waited on before its command buffer is reused
+    const VkFence vk_handle_frame_fence = vk_core::create_fence(VK_FENCE_CREATE_SIGNALED_BIT);
+    const VkSemaphore vk_handle_image_acquired_sem4 = vk_core::create_semaphore();
+    std::vector<VkSemaphore> vk_handle_render_done_sem4_list(vk_core::get_swapchain_image_count());
+
+    for (VkSemaphore& vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_handle_sem4 = vk_core::create_semaphore();
+    }
 
     std::array<Entity, 2> entity_list;
 
@@ -227,9 +234,11 @@ int main()
 
         const uint32_t frame_resource_idx = frame_idx % frame_resource_count;
 
-        vk_core::acquire_next_swapchain_image(VK_NULL_HANDLE, vk_handle_swapchain_image_acquire_fence);
-        vk_core::wait_for_fences(1, &vk_handle_swapchain_image_acquire_fence, VK_TRUE, UINT64_MAX);
-        vk_core::reset_fences(1, &vk_handle_swapchain_image_acquire_fence);
+        vk_core::wait_for_fences(1, &vk_handle_frame_fence, VK_TRUE, UINT64_MAX);
+        vk_core::reset_fences(1, &vk_handle_frame_fence);
+
+        vk_core::acquire_next_swapchain_image(vk_handle_image_acquired_sem4, VK_NULL_HANDLE);
+        const VkSemaphore vk_handle_render_done_sem4 = vk_handle_render_done_sem4_list[vk_core::get_active_swapchain_image_idx()];
 
         if (Camera::proj_dirty)
         {
@@ -243,11 +252,10 @@ int main()
             renderer::update_uniform(renderer::BufferType::eFrame, "view_mat", &(Camera::view_mat[0][0]), frame_resource_idx);
         }
 
-        bool uploads_pending = false;
         renderer::flush_coherent_buffer_uploads(renderer::BufferType::eFrame, frame_resource_idx);
-        uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eGeometry, frame_resource_idx);
-        uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eMaterial, frame_resource_idx);
-        uploads_pending |= renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eDraw, frame_resource_idx);
+        renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eGeometry, frame_resource_idx);
+        renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eMaterial, frame_resource_idx);
+        renderer::flush_buffer_uploads_to_staging(renderer::BufferType::eDraw, frame_resource_idx);
 
         vk_core::reset_command_pool(vk_handle_cmd_pool);
 
@@ -260,32 +268,7 @@ int main()
 
         vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info);
 
-        if (frame_idx == 0 || uploads_pending)
-        {
-            renderer::flush_staging_to_device(vk_handle_cmd_buff);
-
-            vkEndCommandBuffer(vk_handle_cmd_buff);
-
-            const VkSubmitInfo submit_info {
-                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                .pNext = nullptr,
-                .waitSemaphoreCount = 0,
-                .pWaitSemaphores = nullptr,
-                .pWaitDstStageMask = &none_flag,
-                .commandBufferCount = 1,
-                .pCommandBuffers = &vk_handle_cmd_buff,
-                .signalSemaphoreCount = 0,
-                .pSignalSemaphores = nullptr,
-            };
-
-            vk_core::queue_submit(1, &submit_info, VK_NULL_HANDLE);
-            
-            vk_core::device_wait_idle();
-
-            vk_core::reset_command_pool(vk_handle_cmd_pool);
-
-            vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info);
-        }
+        const uint64_t staging_retire_value = renderer::flush_staging_to_device(vk_handle_cmd_buff);
         
         renderer::record_render_pass("shadow-pass", vk_handle_cmd_buff, {0, 0, window_width, window_height}, frame_resource_idx);
 
@@ -333,29 +316,50 @@ int main()
 
         vkEndCommandBuffer(vk_handle_cmd_buff);
 
+        const VkPipelineStageFlags image_acquired_wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+        // The frame's own submission retires the staging region (the binary semaphore ignores its value).
+        const VkSemaphore vk_handle_signal_sem4_list[2] { vk_handle_render_done_sem4, renderer::get_staging_retire_semaphore() };
+        const uint64_t signal_value_list[2] { 0, staging_retire_value };
+
+        const VkTimelineSemaphoreSubmitInfo timeline_submit_info {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreValueCount = 0,
+            .pWaitSemaphoreValues = nullptr,
+            .signalSemaphoreValueCount = 2,
+            .pSignalSemaphoreValues = signal_value_list,
+        };
+
         const VkSubmitInfo submit_info {
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext = nullptr,
-            .waitSemaphoreCount = 0,
-            .pWaitSemaphores = nullptr,
-            .pWaitDstStageMask = &none_flag,
+            .pNext = &timeline_submit_info,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &vk_handle_image_acquired_sem4,
+            .pWaitDstStageMask = &image_acquired_wait_stage,
             .commandBufferCount = 1,
             .pCommandBuffers = &vk_handle_cmd_buff,
-            .signalSemaphoreCount = 0,
-            .pSignalSemaphores = nullptr,
+            .signalSemaphoreCount = 2,
+            .pSignalSemaphores = vk_handle_signal_sem4_list,
         };
 
-        vk_core::queue_submit(1, &submit_info, VK_NULL_HANDLE);
-        
-        vk_core::device_wait_idle();
+        vk_core::queue_submit(1, &submit_info, vk_handle_frame_fence);
 
-        vk_core::present(0, nullptr);
+        vk_core::present(1, &vk_handle_render_done_sem4);
 
         frame_idx++;
     }
 
+    vk_core::device_wait_idle();
+
     vk_core::destroy_command_pool(vk_handle_cmd_pool);
-    vk_core::destroy_fence(vk_handle_swapchain_image_acquire_fence);
+    vk_core::destroy_fence(vk_handle_frame_fence);
+    vk_core::destroy_semaphore(vk_handle_image_acquired_sem4);
+
+    for (const VkSemaphore vk_handle_sem4 : vk_handle_render_done_sem4_list)
+    {
+        vk_core::destroy_semaphore(vk_handle_sem4);
+    }
 
     glfwDestroyWindow(glfw_window);
     glfwTerminate();
@@ -4,7 +4,11 @@
 #include <vulkan/vulkan.h>
 
 #include <stdint.h>
+#include <string.h>
+#include <span>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 // Could all be spec consts built into program
 
@@ -32,7 +36,53 @@ namespace renderer
         const char* const refl_file_sortbin_mat_draw_def;
         const char* const file_sortbin_pipeline_state;
         const char* const file_app_state;
+        // Bundle of the four files above compiled by renderer_state_bundle_compiler, loaded instead of parsing them.
+        // nullptr reads the JSON files, as does a bundle that fails to load when they are given.
+        const char* const file_state_bundle;
         const char* const path_shader_root;
+
+        // Threads culling and parallel recording run on, the calling thread included. 0 picks hardware_concurrency.
+        const uint32_t worker_thread_count;
+        // Records the draws of each render pass into secondary command buffers on those threads, which
+        // record_render_pass executes from vk_handle_cmd_buff.
+        const bool is_parallel_recording;
+        // Keeps the recorded draws of each render pass and frame resource in secondary command buffers, replayed by
+        // record_render_pass until a sortbin of the pass changes its renderables, the indirect draw streams grow or the
+        // frame descriptor set is rewritten. Frames recorded after cull_render_pass bypass it.
+        const bool is_record_caching;
+        // Sets cull mode, front face, topology and the depth test of each sortbin when recording instead of baking them
+        // into its pipeline, so sortbins with the same shaders and vertex input share one. Viewport and scissor are
+        // always dynamic, set from record_render_pass's render_area. Ignored when the device lacks the feature.
+        const bool is_extended_dynamic_state;
+    };
+
+    // Ingest optimizations create_mesh applies to triangle list meshes with 1, 2 or 4 byte indices, in this order.
+    // The caller's data is left untouched. Meshes without a vertex_pos attribute skip the overdraw pass.
+    struct MeshOptimizeInfo
+    {
+        bool  is_vertex_cache_optimized; // reorders triangles for post-transform vertex cache reuse
+        bool  is_overdraw_optimized; // then reorders clusters of them so outward facing surfaces are drawn first
+        float overdraw_threshold; // ACMR the overdraw clusters may give up, relative to the cache optimized order (0 picks 1.05)
+        bool  is_vertex_fetch_optimized; // reorders vertices by first use and drops unreferenced ones
+        bool  is_index_narrowed; // smallest index stride holding the vertex count, 1 byte only with VK_EXT_index_type_uint8
+    };
+
+    // Simplified LODs create_mesh appends to triangle list meshes with a vertex_pos attribute, after MeshOptimizeInfo.
+    // They share the mesh's vertices and are picked per renderable by cull_render_pass in passes with "lod-selection".
+    // The chain ends early once a level can not be simplified further within max_error.
+    struct MeshLodInfo
+    {
+        uint32_t lod_count; // levels after the full detail one, at most 7, 0 generates none
+        float    reduction; // target index count of a level relative to the previous one (0 picks 0.5)
+        float    max_error; // surface deviation a level may have, relative to the radius of the mesh bounds (0 picks 0.05)
+    };
+
+    // One attribute of the caller's vertex_data, in the terms of a sortbin's vertex-input state.
+    struct VertexAttributeInfo
+    {
+        std::string usage; // "vertex_pos", "vertex_normal", "vertex_texcoord", ...
+        VkFormat    format;
+        uint32_t    offset;
     };
 
     struct MeshInitInfo
@@ -43,6 +93,33 @@ namespace renderer
         uint32_t             index_count;
         const uint8_t*       index_data;
         uint32_t             index_stride;
+        MeshOptimizeInfo     optimize_info;
+        MeshLodInfo          lod_info;
+        // Layout of vertex_data. When empty, the float vertex_pos used for bounds, overdraw optimization and LODs is
+        // taken from the first sortbin consuming this vertex_stride with float positions.
+        std::vector<VertexAttributeInfo> vertex_attribute_list;
+        // Sortbin whose vertex-input state the vertices are quantized to, from the float attributes of vertex_attribute_list
+        // (required, every attribute of the sortbin must be listed). Renderables of the mesh get the position
+        // dequantization (position = stored * scale + bias) in their draw data members vertex_pos_scale / vertex_pos_bias
+        // when the sortbin declares them. Empty uploads as is.
+        std::string          quantize_sort_bin_name;
+    };
+
+    struct MeshReserveInfo
+    {
+        uint32_t vertex_stride;
+        uint32_t vertex_count;
+        uint32_t index_count;
+        uint32_t index_stride;
+    };
+
+    // Pointers into persistently mapped staging memory. Write vertex_count * vertex_stride and
+    // index_count * index_stride bytes respectively, then call commit_mesh before the next staging flush.
+    struct MeshUploadReservation
+    {
+        uint32_t mesh_ID;
+        uint8_t* vertex_data;
+        uint8_t* index_data;
     };
 
     struct MaterialInitInfo
@@ -71,24 +148,303 @@ namespace renderer
         eDraw,
     };
 
+    // A uniform member resolved once by get_uniform_handle. eMaterial / eDraw handles are resolved against a sortbin's
+    // block layout and stay valid for every material / renderable whose default sortbin is that sortbin.
+    struct UniformHandle
+    {
+        BufferType buffer_type;
+        uint32_t   member_idx; // eFrame
+        uint32_t   block_size; // eMaterial / eDraw
+        uint32_t   offset;
+        uint32_t   size;       // 0 when the member could not be resolved, updates through the handle do nothing
+    };
+
+    // Specialised by the header renderer_reflection_struct_generator writes from the reflection JSON, for the frame UBO
+    // struct and each sortbin's MaterialData / DrawData struct. UniformLayout<T> provides buffer_type, name (sortbin or
+    // UBO binding), block_size and data_size (== sizeof(T)). UniformMember<&T::member> provides the member's handle and
+    // is_model_mat, set for the draw data model_mat the culling bounds are derived from.
+    template<typename T> struct UniformLayout;
+    template<auto member_ptr> struct UniformMember;
+
+    // Copy regions / bytes handed to the staging buffer by flush_buffer_uploads_to_staging.
+    // last_* covers the most recent flush of that buffer, total_* everything since init.
+    struct UploadStats
+    {
+        uint64_t last_copy_region_count;
+        uint64_t last_staged_byte_count;
+        uint64_t total_copy_region_count;
+        uint64_t total_staged_byte_count;
+    };
+
+    // Geometry heap occupancy. Fragmentation is 1 - largest_free_range / free_byte_count.
+    // Average allocation latency is total_allocation_ns / allocation_count.
+    struct GeometryStats
+    {
+        uint32_t block_count;
+        uint64_t total_byte_count;
+        uint64_t used_byte_count;
+        uint64_t free_byte_count;
+        uint64_t pending_free_byte_count;
+        uint64_t largest_free_range;
+        uint32_t free_range_count;
+        float    fragmentation;
+        uint64_t allocation_count;
+        uint64_t free_count;
+        uint64_t moved_byte_count;
+        uint64_t total_allocation_ns;
+    };
+
+    // Render attachment memory after transient / aliasing analysis of the render pass graph.
+    // saved bytes are naive_byte_count - allocated_byte_count.
+    struct AttachmentMemoryStats
+    {
+        uint64_t naive_byte_count;
+        uint64_t allocated_byte_count;
+        uint32_t alias_group_count;
+        uint32_t aliased_attachment_count;
+        uint32_t transient_attachment_count;
+        uint32_t lazily_allocated_attachment_count;
+    };
+
+    // Cost of init. Pipelines are created through vk_core's pipeline cache, warm when its file matched the device, so
+    // pipeline_create_ns of a cold and a warm run shows what the cache saves. state_load_ns is the part of init_ns
+    // spent reading the renderer description, from the state bundle or the JSON files.
+    struct StartupStats
+    {
+        uint64_t init_ns;
+        uint64_t state_load_ns;
+        bool is_state_bundle;
+        uint32_t pipeline_count;
+        uint64_t pipeline_create_ns;
+        bool is_pipeline_cache_warm;
+    };
+
+    // CPU cost and draw submission counts of the last record_render_pass call.
+    // instance_count is the number of renderables drawn. Renderables of one mesh in a sortbin share an instanced draw,
+    // draw_command_count is the number of those draws (of their visible runs when culled) and draw_call_count the vkCmdDraw* calls issued
+    // for them (one per geometry block run of a sortbin stream when multiDrawIndirect is available, one per draw otherwise).
+    // With parallel recording, record_ns over a range of InitInfo::worker_thread_count gives the recording scaling.
+    struct RecordStats
+    {
+        uint64_t record_ns;
+        uint32_t draw_command_count;
+        uint32_t draw_call_count;
+        uint32_t instance_count;
+        uint32_t secondary_command_buffer_count; // 0 unless InitInfo::is_parallel_recording
+        uint32_t thread_count; // threads that recorded draws, 0 when replayed
+        uint32_t pipeline_bind_count; // per command buffer, consecutive sortbins sharing a pipeline bind it once
+        bool is_replayed; // cached draws of an earlier recording executed, see InitInfo::is_record_caching
+    };
+
+    // Ingest optimization of the last create_mesh call. ACMR is the vertex shader invocations per triangle of a 16 entry
+    // FIFO cache (3 worst, around 0.5 best). Bytes saved are the *_byte_count_before - *_byte_count_after, the vertex bytes
+    // including MeshInitInfo::quantize_sort_bin_name. lod_count includes the full detail level, the coarsest level has
+    // coarsest_lod_index_count indices and deviates coarsest_lod_error (object space) from the full detail surface.
+    // lod_index_byte_count is what the levels after the first add to index_byte_count_after.
+    struct MeshOptimizeStats
+    {
+        float    acmr_before;
+        float    acmr_after;
+        uint32_t overdraw_cluster_count;
+        uint32_t index_stride_before;
+        uint32_t index_stride_after;
+        uint64_t index_byte_count_before;
+        uint64_t index_byte_count_after;
+        uint64_t vertex_byte_count_before;
+        uint64_t vertex_byte_count_after;
+        uint64_t optimize_ns;
+        uint32_t lod_count;
+        uint32_t coarsest_lod_index_count;
+        float    coarsest_lod_error;
+        uint64_t lod_index_byte_count;
+        uint64_t lod_ns;
+    };
+
+    // Frustum culling of the last cull_render_pass call. instance_count / visible_instance_count are renderables,
+    // visible_draw_count the instanced draws they were compacted into. sorted_draw_count is 0 for "insertion" passes.
+    // triangle_count is what the visible indexed instances draw at their selected LODs, full_detail_triangle_count what
+    // they would without "lod-selection", lod_instance_count the instances drawn at a simplified level.
+    struct CullStats
+    {
+        uint32_t tested_count;
+        uint32_t instance_count;
+        uint32_t visible_instance_count;
+        uint32_t visible_draw_count;
+        uint64_t test_ns;
+        uint64_t compact_ns;
+        uint32_t sorted_draw_count;
+        uint64_t sort_ns; // key building and radix sort of the visible draws
+        uint32_t lod_instance_count;
+        uint64_t triangle_count;
+        uint64_t full_detail_triangle_count;
+        uint64_t lod_select_ns;
+    };
+
+    // Hi-Z occlusion culling of a render pass. candidate_count is the frustum visible instances tested on the GPU by the
+    // last cull_render_pass call. The visible counts are read back from the GPU and lag frame_resource_count frames:
+    // early_visible_count is what the first phase drew, late_visible_count the disoccluded instances the second phase added.
+    struct OcclusionCullStats
+    {
+        uint32_t candidate_count;
+        uint32_t early_visible_count;
+        uint32_t late_visible_count;
+        uint32_t pyramid_width;
+        uint32_t pyramid_height;
+        uint32_t pyramid_level_count;
+    };
+
     void init(const InitInfo& init_info);
     void terminate();
+    StartupStats get_startup_stats();
 
     uint32_t create_mesh(const MeshInitInfo& init_info);
+    MeshOptimizeStats get_mesh_optimize_stats();
+    MeshUploadReservation reserve_mesh(const MeshReserveInfo& reserve_info);
+    void commit_mesh(const uint32_t mesh_ID);
+    // Releases the mesh's geometry once in-flight frames are done with it. Every renderable using the mesh must be
+    // destroyed first (ASSERTed in debug builds), the ID may be handed out again by a later create_mesh / reserve_mesh.
+    void destroy_mesh(const uint32_t mesh_ID);
+    // Records up to max_move_byte_count bytes of geometry compaction copies into vk_handle_cmd_buff
+    // (outside of any rendering scope) and patches the affected meshes and queued draws.
+    // Returns the number of bytes moved.
+    uint64_t defragment_geometry(const VkCommandBuffer vk_handle_cmd_buff, const uint64_t max_move_byte_count);
+    GeometryStats get_geometry_stats();
     uint32_t create_material(const MaterialInitInfo& init_info, const uint32_t frame_resource_idx);
+    // The material must no longer be referenced by any renderable. Its ID and SSBO block are recycled.
+    void destroy_material(const uint32_t material_ID);
     std::pair<uint32_t, uint16_t> create_renderable(const RenderableInitInfo& init_info, const uint32_t frame_resource_idx);
+    // Removes the renderable from every sortbin. Its ID and draw SSBO block are recycled.
+    void destroy_renderable(const uint32_t renderable_ID);
+    // World transform (column major mat4) used to cull the renderable, bounded by its mesh's vertex_pos extents.
+    // When the renderable's draw data declares a mat4 "model_mat" the culling bounds are derived from it: this writes
+    // model_mat, and so do create_renderable and every update_uniform(s) of it, so both never disagree. Only writes
+    // through get_uniform_write_ptr bypass this and must be followed by update_renderable_bounds.
+    // Sortbins without model_mat only keep the bounds, renderables that never got a transform are never culled.
+    void set_renderable_transform(const uint32_t renderable_ID, const float* const model_mat);
+    // Only moves the culling bounds, the draw data is left as is.
+    void update_renderable_bounds(const uint32_t renderable_ID, const float* const model_mat);
 
+    // Resolves against the default sortbin of the material / renderable data_id, prefer a handle on hot paths.
     void update_uniform(const BufferType buffer_type, const std::string& uniform_name, const void* const value, const uint32_t data_id = UINT32_MAX);
+    // sortbin_ID picks the block layout of eMaterial / eDraw members and is ignored for eFrame.
+    UniformHandle get_uniform_handle(const BufferType buffer_type, const std::string& uniform_name, const uint16_t sortbin_ID = UINT16_MAX);
+    void update_uniform(const UniformHandle& handle, const void* const value, const uint32_t data_id = UINT32_MAX);
+    // Writes the member of every material / renderable in data_id_span, the value of data_id_span[i] being read from
+    // data + i * data_stride (a stride of 0 writes the same value to all of them). The written ranges are marked dirty
+    // in one pass over the pool's dirty bitmaps instead of once per ID.
+    void update_uniforms(const UniformHandle& handle, const std::span<const uint32_t> data_id_span, const void* const data, const uint32_t data_stride);
+    // Marks the member dirty and returns where handle.size bytes of it are written, valid until the next renderer call.
+    // A model_mat written this way does not update the culling bounds (see update_renderable_bounds).
+    void* get_uniform_write_ptr(const UniformHandle& handle, const uint32_t data_id = UINT32_MAX);
 
     void flush_coherent_buffer_uploads(const BufferType buffer_type, const uint32_t frame_resource_idx);
+    // eMaterial / eDraw also grow the frame's storage buffer and rewrite its descriptor when the pool outgrew it,
+    // so this must run before the frame's render passes are recorded.
+    // eDraw also stages the indirect draw commands of sortbin edits made since the frame's last flush.
     bool flush_buffer_uploads_to_staging(const BufferType buffer_type, const uint32_t frame_resource_idx);
-    void flush_staging_to_device(const VkCommandBuffer vk_handle_cmd_buff);
+    UploadStats get_upload_stats(const BufferType buffer_type);
+    AttachmentMemoryStats get_attachment_memory_stats();
+    // Returns the value the submission of vk_handle_cmd_buff must signal get_staging_retire_semaphore() to, next to
+    // its own signal semaphores. The staging region backing these copies is only reused once that value is reached.
+    // Either this or submit_staging_to_transfer_queue must be called once per frame, it also ages deferred geometry frees.
+    [[nodiscard]] uint64_t flush_staging_to_device(const VkCommandBuffer vk_handle_cmd_buff);
+    VkSemaphore get_staging_retire_semaphore(); // timeline
 
+    // Asynchronous alternative to flush_staging_to_device. Submits the queued copies on the transfer queue
+    // (the graphics queue when the device exposes no separate transfer family) and returns the value the
+    // upload timeline semaphore reaches once they complete (0 if nothing was submitted). The graphics
+    // submission consuming the data must wait on that value and record_upload_acquire_barriers() first.
+    uint64_t submit_staging_to_transfer_queue();
+    void record_upload_acquire_barriers(const VkCommandBuffer vk_handle_cmd_buff);
+    // The wait on this semaphore MUST use get_upload_wait_stage_mask() as its pWaitDstStageMask
+    // (indirect, vertex input, vertex / fragment / compute shader). A narrower mask leaves the reads of those
+    // stages and the acquire barriers outside the wait's scope.
+    VkSemaphore get_upload_timeline_semaphore();
+    VkPipelineStageFlags get_upload_wait_stage_mask();
+
+    // Renderables of one mesh are instances of a single draw of the sortbin, whatever their draw IDs. Shaders read the
+    // draw ID of an instance from the uint array of frame descriptor set binding 4 at gl_InstanceIndex.
     void add_renderable_to_sortbin(const uint32_t renderable_id, const uint16_t sortbin_id);
     void record_render_pass(const std::string& render_pass_name, const VkCommandBuffer vk_handle_cmd_buff, const VkRect2D render_area, const uint32_t frame_resource_idx);
+    RecordStats get_record_stats();
+
+    // Frustum culls every draw of the render pass's sortbins against view_proj_mat (column major, Vulkan clip space).
+    // The next record_render_pass of the pass with this frame_resource_idx only draws the visible instances.
+    // Must be called before that frame's flush_buffer_uploads_to_staging(eDraw), which stages the culled draws.
+    // Passes sharing sortbins (e.g. a shadow pass with the light's view_proj) are culled independently.
+    //
+    // A render pass declaring "occlusion-culling" : { "two-phase" : bool, "reverse-z" : bool } in the app state (both default
+    // to false) additionally occlusion culls the frustum visible instances on the GPU, against a depth pyramid built from
+    // the pass's depth attachment (which must be stored) after every record_render_pass. Single phase tests against the
+    // previous frame's pyramid. Two phase first draws what was visible last frame, rebuilds the pyramid and records the
+    // pass a second time (attachments loaded) for the instances that became visible. Needs multiDrawIndirect and
+    // drawIndirectCount, and the SPIR-V of the renderer's shaders (shaders/compile.sh).
+    //
+    // "draw-order" : "insertion" | "state" | "front-to-back" | "back-to-front" (default "insertion") reorders the visible
+    // draws within each sortbin draw list: "state" groups them by geometry block and mesh, "front-to-back" nearest first
+    // within a geometry block (opaque passes), "back-to-front" farthest first (blended passes). Unculled recordings keep
+    // insertion order.
+    //
+    // "lod-selection" : { "max-screen-error" : pixels } (default 1) draws each visible instance of a mesh created with
+    // MeshInitInfo::lod_info at the coarsest LOD whose error, projected onto the pass's render target, stays within
+    // max-screen-error. Instanced draws are split where their instances pick different LODs. Selection happens before
+    // "draw-order" and occlusion culling. Unculled recordings draw full detail.
+    void cull_render_pass(const std::string& render_pass_name, const float* const view_proj_mat, const uint32_t frame_resource_idx);
+    CullStats get_cull_stats();
+    // Zeroed for passes without occlusion culling.
+    OcclusionCullStats get_occlusion_cull_stats(const std::string& render_pass_name);
 
     VkImage get_attachment_image(const uint32_t attachment_id, const uint32_t frame_resource_idx);
     uint16_t get_sortbin_ID(const std::string& sortbin_name);
+
+    // Typed overloads for the structs of a generated reflection header, sizes and offsets checked at compile time.
+    template<typename T>
+    uint32_t create_material(const std::string& name, const T& material_data, const uint32_t frame_resource_idx)
+    {
+        static_assert(UniformLayout<T>::buffer_type == BufferType::eMaterial, "create_material - Not a generated MaterialData struct!");
+
+        const MaterialInitInfo init_info {
+            .name = name,
+            .material_data_ptr = reinterpret_cast<const uint8_t*>(&material_data),
+            .material_data_size = UniformLayout<T>::data_size,
+            .default_sort_bin_name = UniformLayout<T>::name,
+        };
+
+        return create_material(init_info, frame_resource_idx);
+    }
+
+    // The trailing material reference of draw_data is written by the renderer.
+    template<typename T>
+    std::pair<uint32_t, uint16_t> create_renderable(const uint32_t mesh_ID, const uint32_t material_ID, const T& draw_data, const uint32_t frame_resource_idx)
+    {
+        static_assert(UniformLayout<T>::buffer_type == BufferType::eDraw, "create_renderable - Not a generated DrawData struct!");
+
+        const RenderableInitInfo init_info {
+            .mesh_ID = mesh_ID,
+            .material_ID = material_ID,
+            .draw_data_ptr = reinterpret_cast<const uint8_t*>(&draw_data),
+            .draw_data_size = UniformLayout<T>::data_size - static_cast<uint32_t>(sizeof(uint32_t)),
+            .default_sort_bin_name = UniformLayout<T>::name,
+        };
+
+        return create_renderable(init_info, frame_resource_idx);
+    }
+
+    // Any trivially copyable value of the member's size, e.g. update_uniform<&DrawData::model_mat>(glm_mat4, renderable_ID).
+    // A plain copy into the member, a draw data model_mat also moves the renderable's culling bounds.
+    template<auto member_ptr, typename V>
+    void update_uniform(const V& value, const uint32_t data_id = UINT32_MAX)
+    {
+        using Member = UniformMember<member_ptr>;
+        static_assert(std::is_trivially_copyable_v<V> && sizeof(V) == Member::handle.size, "update_uniform - Value does not match the member's size!");
+
+        memcpy(get_uniform_write_ptr(Member::handle, data_id), &value, sizeof(V));
+
+        if constexpr (Member::is_model_mat)
+        {
+            update_renderable_bounds(data_id, reinterpret_cast<const float*>(&value));
+        }
+    }
 }; // renderer
 
 #endif // RENDERER_HPP
\ No newline at end of file
@@ -0,0 +1,4 @@
+mkdir -p spirv
+
+${VULKAN_SDK}/bin/glslc glsl/hiz_build.comp -o spirv/hiz_build.comp.spv
+${VULKAN_SDK}/bin/glslc glsl/occlusion_cull.comp -o spirv/occlusion_cull.comp.spv
@@ -1,38 +1,49 @@
 #include "GlobalState.hpp"
 #include "internal/misc/logger.hpp"
 #include "internal/misc/vk_enum_to_string.hpp"
-#include "internal/misc/json_structures.hpp"
+#include "internal/misc/StateDescription.hpp"
 #include "internal/pod/DescriptorVariable.hpp"
 #include "internal/buffers/UniformBuffer.hpp"
 #include "internal/buffers/GeometryBuffer.hpp"
+#include "internal/buffers/IndirectDrawBuffer.hpp"
 #include "internal/buffers/StagingBuffer.hpp"
 #include "internal/buffers/BufferPool_VariableBlock.hpp"
-
-#include "json.hpp"
-#include <fstream>
+#include "internal/misc/WorkerPool.hpp"
+#include "internal/misc/SecondaryCommandPools.hpp"
+#include "internal/misc/ShaderModuleCache.hpp"
+#include "internal/misc/sortbin_compatibility.hpp"
+#include "internal/visibility/DrawSorter.hpp"
+#include "internal/visibility/FrustumCuller.hpp"
+#include "internal/visibility/LodSelector.hpp"
+#include "internal/visibility/OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <chrono>
 #include <optional>
 
-static nlohmann::json read_json_file(const char* const filepath);
+#ifndef RENDERER_SHADER_DIR
+#define RENDERER_SHADER_DIR "shaders/spirv/"
+#endif
+
 static std::unordered_map<std::string, uint8_t> init_id_lut_render_attachment(const RendererState::CreateInfo& create_info);
 static std::unordered_map<std::string, uint16_t> init_id_lut_render_pass(const RendererState::CreateInfo& create_info);
 static std::unordered_map<std::string, uint16_t> init_id_lut_sort_bin(const RendererState::CreateInfo& create_info);
-static std::vector<RenderPass::Attachment> init_vec_render_attachment(const RendererState::CreateInfo& create_info);
+static std::vector<RenderPass::Attachment> init_vec_render_attachment(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment, std::vector<vk_core::MemoryAllocation>& alias_allocation_list, RendererState::AttachmentMemoryStats& memory_stats);
 static std::vector<uint16_t> get_registered_sortbins(const JSONInfo_AppSortBin& sortbin_info, const JSONInfo_RenderPass::State& render_pass_state, const std::unordered_map<std::string, uint16_t>& sortbin_name_to_id_umap);
 static std::vector<RenderPass::ReadAttachmentPassInfo> get_registered_inputs(const JSONInfo_RenderPass::State& render_pass_state, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment);
 static std::vector<RenderPass::WriteAttachmentPassInfo> get_registered_color_outputs(const JSONInfo_RenderPass::State& render_pass_state, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment);
 static std::optional<RenderPass::WriteAttachmentPassInfo> get_registered_depth_output(const JSONInfo_RenderPass::State& render_pass_state, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment);
-static std::vector<RenderPass> init_vec_render_pass(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment, const std::unordered_map<std::string, uint16_t>& name_id_lut_sort_bin);
+static std::vector<RenderPass> init_vec_render_pass(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment, const std::unordered_map<std::string, uint16_t>& name_id_lut_sort_bin, const std::vector<RenderPass::Attachment>& render_attachment_vec);
 static VkDescriptorPool init_desc_pool(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec);
 static std::vector<VkDescriptorSetLayoutBinding> create_desc_set_binding_list(const std::vector<JSONInfo_DescriptorBinding>& json_desc_set_binding_list);
 static VkDescriptorSetLayout init_frame_desc_set_layout(const RendererState::CreateInfo& create_info);
 static std::vector<VkDescriptorSet> init_vec_frame_desc_set(const RendererState::CreateInfo& create_info, const VkDescriptorPool vk_handle_desc_pool, const VkDescriptorSetLayout vk_handle_desc_set_layout);
 static std::vector<uint16_t> init_vec_compatible_sortbin_ID(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint16_t>& name_id_lut_sort_bin);
-static std::vector<VkViewport> create_viewport(const RendererState::CreateInfo& create_info);
-static std::vector<VkRect2D> create_scissor(const RendererState::CreateInfo& create_info);
-static VkPipelineViewportStateCreateInfo create_viewport_state(const std::vector<VkViewport>& viewport_vec, const std::vector<VkRect2D>& scissor_vec);
+static VkPipelineViewportStateCreateInfo create_viewport_state();
+static std::vector<VkDynamicState> create_dynamic_state_vec(const bool is_extended_dynamic_state);
+static VkPipelineDynamicStateCreateInfo create_dynamic_state(const std::vector<VkDynamicState>& dynamic_state_vec);
 static VkPipelineMultisampleStateCreateInfo create_multisample_state();
-static VkShaderModule create_shader_module(const std::string& shader_root_path, const std::string& shader_name);
-static std::vector<VkPipelineShaderStageCreateInfo> create_shader_stage_vec(const std::vector<std::string>& shader_name_list, const std::string& shader_root_path);
+static std::vector<VkPipelineShaderStageCreateInfo> create_shader_stage_vec(const std::vector<std::string>& shader_name_list, const std::string& shader_root_path, ShaderModuleCache& shader_module_cache);
 static VkPipelineInputAssemblyStateCreateInfo create_input_assembly_state(const JSONInfo_SortBinPipelineState::State& sortbin_state);
 static VkPipelineRasterizationStateCreateInfo create_rasterization_state(const JSONInfo_SortBinPipelineState::State& sortbin_state);
 static VkPipelineDepthStencilStateCreateInfo create_depth_stencil_state(const JSONInfo_SortBinPipelineState::State& sortbin_state);
@@ -43,32 +54,78 @@ static VkPipelineRenderingCreateInfo create_rendering_create_info(const std::vec
 static std::vector<VkPipelineColorBlendAttachmentState> create_color_blend_attachment_state_vec(const RenderPass& render_pass);
 static VkPipelineColorBlendStateCreateInfo create_color_blend_state(const std::vector<VkPipelineColorBlendAttachmentState>& color_blend_attachment_state_vec);
 static std::unordered_map<std::string, DescriptorVariable> create_desc_var_umap(const std::vector<JSONInfo_DescriptorVariable>& json_desc_var_list);
-static std::vector<SortBin> init_vec_sort_bin(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec, const std::vector<RenderPass::Attachment> render_attachment_list, const std::unordered_map<std::string, uint16_t>& name_id_lut_render_pass, const VkDescriptorSetLayout vk_handle_frame_desc_set_layout);
+static uint32_t get_draw_model_mat_offset(const std::vector<JSONInfo_DescriptorVariable>& json_draw_desc_var_list);
+static SortBin::DynamicState get_sort_bin_dynamic_state(const JSONInfo_SortBinPipelineState::State& sortbin_state);
+static bool is_pipeline_state_shareable(const JSONInfo_SortBinPipelineState::State& sortbin_state_a, const JSONInfo_SortBinPipelineState::State& sortbin_state_b, const bool is_extended_dynamic_state);
+static VkPipeline create_sort_bin_pipeline(const JSONInfo_SortBinPipelineState::State& sort_bin_pipeline_state, const RenderPass& render_pass, const std::vector<RenderPass::Attachment>& render_attachment_list, const VkPipelineLayout vk_handle_pipeline_layout, const std::vector<VkPipelineShaderStageCreateInfo>& shader_stage_vec, const bool is_extended_dynamic_state);
+static std::vector<SortBin> init_vec_sort_bin(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec, const std::vector<RenderPass::Attachment> render_attachment_list, const std::unordered_map<std::string, uint16_t>& name_id_lut_render_pass, const std::vector<uint16_t>& compatible_sortbin_ID_lut, const VkDescriptorSetLayout vk_handle_frame_desc_set_layout, const bool is_extended_dynamic_state, WorkerPool& worker_pool);
 static std::unique_ptr<UniformBuffer> create_frame_ubo(const RendererState::CreateInfo& create_info, const std::string& ubo_name);
-static void update_frame_desc_sets(const uint32_t frame_resource_count, const UniformBuffer* frame_uniform_buffer, const BufferPool_VariableBlock* material_data_buffer, const BufferPool_VariableBlock* draw_data_buffer, const UniformBuffer* frame_fwd_light_ubo, const std::vector<VkDescriptorSet>& vk_handle_desc_set_list);
+static void init_occlusion_cullers(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec, const std::vector<RenderPass::Attachment>& render_attachment_vec, const uint32_t sortbin_count, std::vector<RendererState::RenderPassCullState>& render_pass_cull_state_vec);
+static void init_draw_orders(const RendererState::CreateInfo& create_info, std::vector<RendererState::RenderPassCullState>& render_pass_cull_state_vec);
+static void init_lod_selections(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec, const std::vector<RenderPass::Attachment>& render_attachment_vec, std::vector<RendererState::RenderPassCullState>& render_pass_cull_state_vec);
+static void update_frame_desc_sets(const uint32_t frame_resource_count, const UniformBuffer* frame_uniform_buffer, const BufferPool_VariableBlock* material_data_buffer, const BufferPool_VariableBlock* draw_data_buffer, const UniformBuffer* frame_fwd_light_ubo, const BufferPool_VariableBlock* instance_buffer, const std::vector<VkDescriptorSet>& vk_handle_desc_set_list);
 
 RendererState::RendererState(const CreateInfo& create_info)
     : name_id_lut_render_attachment { init_id_lut_render_attachment(create_info) }
     , name_id_lut_render_pass { init_id_lut_render_pass(create_info) }
     , name_id_lut_sort_bin { init_id_lut_sort_bin(create_info) }
-    , render_attachment_vec{ init_vec_render_attachment(create_info) }
-    , render_pass_vec{ init_vec_render_pass(create_info, name_id_lut_render_attachment, name_id_lut_sort_bin) }
+    , render_attachment_vec{ init_vec_render_attachment(create_info, name_id_lut_render_attachment, render_attachment_alias_allocation_vec, render_attachment_memory_stats) }
+    , render_pass_vec{ init_vec_render_pass(create_info, name_id_lut_render_attachment, name_id_lut_sort_bin, render_attachment_vec) }
     , vk_handle_frame_desc_pool{ init_desc_pool(create_info, render_pass_vec) }
     , vk_handle_frame_desc_set_layout{ init_frame_desc_set_layout(create_info) }
     , vk_handle_frame_desc_set_vec{ init_vec_frame_desc_set(create_info, vk_handle_frame_desc_pool, vk_handle_frame_desc_set_layout) }
     , compatible_sortbin_ID_lut{ init_vec_compatible_sortbin_ID(create_info, name_id_lut_sort_bin) }
 {
-    sort_bin_vec = init_vec_sort_bin(create_info, render_pass_vec, render_attachment_vec, name_id_lut_render_pass, vk_handle_frame_desc_set_layout);
-    geometry_buffer = std::make_unique<GeometryBuffer>(1 << 10);
-    staging_buffer = std::make_unique<StagingBuffer>(1 << 10);
+    is_extended_dynamic_state = create_info.is_extended_dynamic_state && vk_core::has_extended_dynamic_state();
+
+    if (create_info.is_extended_dynamic_state && !is_extended_dynamic_state)
+    {
+        LOG("Warning - Extended dynamic state not supported, raster and depth state stays in the pipelines!\n");
+    }
+
+    worker_pool = std::make_unique<WorkerPool>(create_info.worker_thread_count);
+
+    sort_bin_vec = init_vec_sort_bin(create_info, render_pass_vec, render_attachment_vec, name_id_lut_render_pass, compatible_sortbin_ID_lut, vk_handle_frame_desc_set_layout, is_extended_dynamic_state, *worker_pool);
+    geometry_buffer = std::make_unique<GeometryBuffer>(1 << 24, create_info.frame_resource_count);
+    indirect_draw_buffer = std::make_unique<IndirectDrawBuffer>(static_cast<uint32_t>(sort_bin_vec.size()), create_info.frame_resource_count);
+    staging_buffer = std::make_unique<StagingBuffer>(1 << 16, create_info.frame_resource_count);
     material_data_buffer = std::make_unique<BufferPool_VariableBlock>(create_info.frame_resource_count, 1 << 10);
     draw_data_buffer = std::make_unique<BufferPool_VariableBlock>(create_info.frame_resource_count, 1 << 10);
+    instance_buffer = std::make_unique<BufferPool_VariableBlock>(create_info.frame_resource_count, 1 << 10);
+
+    frustum_culler = std::make_unique<FrustumCuller>(*worker_pool);
+    draw_sorter = std::make_unique<DrawSorter>(*worker_pool);
+    lod_selector = std::make_unique<LodSelector>(*worker_pool);
+
+    if (create_info.is_parallel_recording)
+    {
+        for (uint32_t i = 0; i < render_pass_vec.size(); i++)
+        {
+            secondary_cmd_pools_vec.push_back(std::make_unique<SecondaryCommandPools>(create_info.frame_resource_count, worker_pool->get_worker_count()));
+        }
+    }
+
+    if (create_info.is_record_caching)
+    {
+        for (uint32_t i = 0; i < render_pass_vec.size(); i++)
+        {
+            record_cache_vec.push_back(std::make_unique<RenderPass::RecordCache>(create_info.frame_resource_count, create_info.is_parallel_recording ? worker_pool->get_worker_count() : 1));
+        }
+    }
+
+    render_pass_generation_vec.resize(render_pass_vec.size(), 0);
+    frame_desc_set_generation_vec.resize(create_info.frame_resource_count, 0);
+
+    render_pass_cull_state_vec.resize(render_pass_vec.size());
+    init_occlusion_cullers(create_info, render_pass_vec, render_attachment_vec, static_cast<uint32_t>(sort_bin_vec.size()), render_pass_cull_state_vec);
+    init_draw_orders(create_info, render_pass_cull_state_vec);
+    init_lod_selections(create_info, render_pass_vec, render_attachment_vec, render_pass_cull_state_vec);
 
     // Need to not harcode these!!!
     frame_general_ubo = create_frame_ubo(create_info, "Frame_UBO");
     frame_fwd_light_ubo = create_frame_ubo(create_info, "Frame_ForwardPointLightUBO");
 
-    update_frame_desc_sets(create_info.frame_resource_count, frame_general_ubo.get(), material_data_buffer.get(), draw_data_buffer.get(), frame_fwd_light_ubo.get(), vk_handle_frame_desc_set_vec);
+    update_frame_desc_sets(create_info.frame_resource_count, frame_general_ubo.get(), material_data_buffer.get(), draw_data_buffer.get(), frame_fwd_light_ubo.get(), instance_buffer.get(), vk_handle_frame_desc_set_vec);
 }
 
 RendererState::~RendererState()
@@ -79,7 +136,11 @@ RendererState::~RendererState()
     for (const SortBin& sortbin : sort_bin_vec)
     {
         vk_core::destroy_pipeline_layout(sortbin.vk_handle_pipeline_layout);
-        vk_core::destroy_pipeline(sortbin.vk_handle_pipeline);
+
+        if (sortbin.is_pipeline_owner)
+        {
+            vk_core::destroy_pipeline(sortbin.vk_handle_pipeline);
+        }
     }
 
     for (const RenderPass& render_pass : render_pass_vec)
@@ -102,29 +163,21 @@ RendererState::~RendererState()
             vk_core::destroy_image_view(vk_handle_image_view);
         }
 
-        for (const VkDeviceMemory vk_handle_image_memory : attachment.vk_handle_image_memory_list)
+        for (const vk_core::MemoryAllocation& image_memory_allocation : attachment.image_memory_allocation_list)
         {
-            vk_core::free_memory(vk_handle_image_memory);
+            vk_core::free_allocation(image_memory_allocation);
         }
     }
-}
 
-static nlohmann::json read_json_file(const char* const filepath)
-{
-    std::ifstream file(filepath);
-    ASSERT(file.is_open(), "Failed to vulkan init config file: %s\n", filepath);
-
-    const nlohmann::json json_data = nlohmann::json::parse(file);
-
-    file.close();
-
-    return json_data;
+    for (const vk_core::MemoryAllocation& alias_allocation : render_attachment_alias_allocation_vec)
+    {
+        vk_core::free_allocation(alias_allocation);
+    }
 }
 
 static std::unordered_map<std::string, uint8_t> init_id_lut_render_attachment(const RendererState::CreateInfo& create_info)
 {    
-    const auto json_data = read_json_file(create_info.file_app_state);
-    const JSONInfo_RenderAttachment render_attachment_info = json_data.at("render-attachments").get<JSONInfo_RenderAttachment>();
+    const JSONInfo_RenderAttachment& render_attachment_info = create_info.p_state_description->render_attachment_info;
 
     uint16_t render_attachment_ID = 0u;
     std::unordered_map<std::string, uint8_t> umap;
@@ -149,8 +202,7 @@ static std::unordered_map<std::string, uint8_t> init_id_lut_render_attachment(co
 
 static std::unordered_map<std::string, uint16_t> init_id_lut_render_pass(const RendererState::CreateInfo& create_info)
 {
-    const auto json_data = read_json_file(create_info.file_app_state);
-    const JSONInfo_RenderPass render_pass_info = json_data.at("render-passes").get<JSONInfo_RenderPass>();
+    const JSONInfo_RenderPass& render_pass_info = create_info.p_state_description->render_pass_info;
 
     uint16_t render_pass_ID = 0u;
     std::unordered_map<std::string, uint16_t> umap;
@@ -175,8 +227,7 @@ static std::unordered_map<std::string, uint16_t> init_id_lut_render_pass(const R
 
 static std::unordered_map<std::string, uint16_t> init_id_lut_sort_bin(const RendererState::CreateInfo& create_info)
 {
-    const auto json_data = read_json_file(create_info.file_app_state);
-    const JSONInfo_AppSortBin sortbin_info = json_data.at("sortbins").get<JSONInfo_AppSortBin>();
+    const JSONInfo_AppSortBin& sortbin_info = create_info.p_state_description->sortbin_info;
 
     uint16_t sortbin_ID = 0u;
     std::unordered_map<std::string, uint16_t> umap;
@@ -199,13 +250,67 @@ static std::unordered_map<std::string, uint16_t> init_id_lut_sort_bin(const Rend
     return umap;
 }
 
-static std::vector<RenderPass::Attachment> init_vec_render_attachment(const RendererState::CreateInfo& create_info)
+// Span of render passes touching a render attachment. Passes are assumed to be recorded in declaration order every frame.
+struct RenderAttachmentLifetime
+{
+    uint32_t first_pass_idx = UINT32_MAX;
+    uint32_t last_pass_idx = 0;
+    bool is_read = false;
+    bool is_stored = false;
+    bool needs_previous_contents = false; // first access reads / loads what an earlier frame left behind
+};
+
+static std::vector<RenderAttachmentLifetime> get_render_attachment_lifetimes(const JSONInfo_RenderPass& render_pass_info, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment)
 {
-    const auto json_data = read_json_file(create_info.file_app_state);
-    const JSONInfo_RenderAttachment render_attachment_info = json_data.at("render-attachments").get<JSONInfo_RenderAttachment>();
+    std::vector<RenderAttachmentLifetime> lifetime_list(name_id_lut_render_attachment.size());
 
-    std::vector<RenderPass::Attachment> render_attachment_list;
-    std::vector<VkImageMemoryBarrier> image_memory_barriers;
+    for (uint32_t pass_idx = 0; pass_idx < render_pass_info.state_list.size(); pass_idx++)
+    {
+        const JSONInfo_RenderPass::State& render_pass_state = render_pass_info.state_list[pass_idx];
+
+        const auto touch = [&](const std::string& attachment_name, const bool reads_previous_contents) -> RenderAttachmentLifetime&
+        {
+            RenderAttachmentLifetime& lifetime = lifetime_list[name_id_lut_render_attachment.at(attachment_name)];
+
+            if (lifetime.first_pass_idx == UINT32_MAX)
+            {
+                lifetime.first_pass_idx = pass_idx;
+                lifetime.needs_previous_contents = reads_previous_contents;
+            }
+
+            lifetime.last_pass_idx = pass_idx;
+            return lifetime;
+        };
+
+        for (const JSONInfo_RenderPass::ReadAttachmentState& read_attachment_state : render_pass_state.input_attachment_list)
+        {
+            touch(read_attachment_state.name, true).is_read = true;
+        }
+
+        for (const JSONInfo_RenderPass::WriteAttachmentState& write_attachment_state : render_pass_state.color_attachment_list)
+        {
+            touch(write_attachment_state.name, write_attachment_state.load_op == VK_ATTACHMENT_LOAD_OP_LOAD).is_stored |= write_attachment_state.store_op == VK_ATTACHMENT_STORE_OP_STORE;
+        }
+
+        if (render_pass_state.depth_attachment.has_value())
+        {
+            const JSONInfo_RenderPass::WriteAttachmentState& depth_attachment_state = render_pass_state.depth_attachment.value();
+            touch(depth_attachment_state.name, depth_attachment_state.load_op == VK_ATTACHMENT_LOAD_OP_LOAD).is_stored |= depth_attachment_state.store_op == VK_ATTACHMENT_STORE_OP_STORE;
+        }
+    }
+
+    return lifetime_list;
+}
+
+static std::vector<RenderPass::Attachment> init_vec_render_attachment(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment, std::vector<vk_core::MemoryAllocation>& alias_allocation_list, RendererState::AttachmentMemoryStats& memory_stats)
+{
+    const JSONInfo_RenderAttachment& render_attachment_info = create_info.p_state_description->render_attachment_info;
+    const JSONInfo_RenderPass& render_pass_info = create_info.p_state_description->render_pass_info;
+
+    const std::vector<RenderAttachmentLifetime> lifetime_list = get_render_attachment_lifetimes(render_pass_info, name_id_lut_render_attachment);
+
+    std::vector<VkImageCreateInfo> image_create_info_list;
+    std::vector<VkImageViewCreateInfo> image_view_create_info_list;
 
     for (const JSONInfo_RenderAttachment::ImageState& render_attachment_image_state : render_attachment_info.image_state_list)
     {
@@ -220,21 +325,6 @@ static std::vector<RenderPass::Attachment> init_vec_render_attachment(const Rend
         image_create_info.pQueueFamilyIndices = nullptr;
         image_create_info.extent = {create_info.window_x_dim, create_info.window_y_dim, 1};
 
-        VkImageMemoryBarrier image_memory_barrier {};
-        image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        image_memory_barrier.pNext = nullptr;
-        image_memory_barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
-        image_memory_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
-        image_memory_barrier.srcQueueFamilyIndex = vk_core::get_queue_family_idx();
-        image_memory_barrier.dstQueueFamilyIndex = vk_core::get_queue_family_idx();
-        image_memory_barrier.subresourceRange = {
-            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-            .baseMipLevel = 0,
-            .levelCount = 1,
-            .baseArrayLayer = 0,
-            .layerCount = 1,
-        };
-
         // Shared
 
         if (render_attachment_info.shared_image_state.format.has_value()) 
@@ -287,7 +377,7 @@ static std::vector<RenderPass::Attachment> init_vec_render_attachment(const Rend
         image_create_info.format = render_attachment_image_state.format.value();
         image_create_info.usage = render_attachment_image_state.usage.value();
 
-        VkImageViewCreateInfo image_view_create_info {
+        const VkImageViewCreateInfo image_view_create_info {
             .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0x0,
@@ -304,8 +394,178 @@ static std::vector<RenderPass::Attachment> init_vec_render_attachment(const Rend
             }
         };
 
-        render_attachment_list.emplace_back(image_create_info, image_view_create_info, create_info.frame_resource_count);
+        image_create_info_list.push_back(image_create_info);
+        image_view_create_info_list.push_back(image_view_create_info);
+    }
+
+    // Depth attachments feeding an occlusion culling pyramid are sampled by its build shader after their pass.
+    for (const JSONInfo_RenderPass::State& render_pass_state : render_pass_info.state_list)
+    {
+        if (render_pass_state.occlusion_culling.has_value())
+        {
+            image_create_info_list[name_id_lut_render_attachment.at(render_pass_state.depth_attachment.value().name)].usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+        }
+    }
+
+    // Attachments that are neither stored nor read never need to leave tile memory. Mark them transient and,
+    // where the device offers it, back them with lazily allocated memory.
+    // Attachments used outside the render passes (copies, storage) or whose contents carry over between frames
+    // keep memory of their own, everything else may share memory with attachments whose pass spans do not overlap.
+
+    const uint32_t attachment_count = static_cast<uint32_t>(image_create_info_list.size());
+    const VkImageUsageFlags external_usage_flags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    const VkImageUsageFlags transient_compatible_usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+    std::vector<VkMemoryRequirements> memory_requirements_list(attachment_count);
+    std::vector<VkMemoryPropertyFlags> memory_property_flags_list(attachment_count, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    std::vector<uint32_t> alias_candidate_idx_list;
+
+    for (uint32_t attachment_idx = 0; attachment_idx < attachment_count; attachment_idx++)
+    {
+        VkImageCreateInfo& image_create_info = image_create_info_list[attachment_idx];
+        const RenderAttachmentLifetime& lifetime = lifetime_list[attachment_idx];
 
+        const bool is_transient = lifetime.first_pass_idx != UINT32_MAX && !lifetime.is_read && !lifetime.is_stored && !lifetime.needs_previous_contents &&
+            (image_create_info.usage & ~transient_compatible_usage_flags) == 0;
+
+        if (is_transient)
+        {
+            image_create_info.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            memory_stats.transient_attachment_count++;
+        }
+
+        memory_requirements_list[attachment_idx] = vk_core::get_image_memory_requirements(image_create_info);
+        memory_stats.naive_byte_count += memory_requirements_list[attachment_idx].size * create_info.frame_resource_count;
+
+        const VkMemoryPropertyFlags lazy_memory_property_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+        if (is_transient && vk_core::has_memory_type(memory_requirements_list[attachment_idx].memoryTypeBits, lazy_memory_property_flags))
+        {
+            memory_property_flags_list[attachment_idx] = lazy_memory_property_flags;
+            memory_stats.lazily_allocated_attachment_count++;
+            continue;
+        }
+
+        const bool is_persistent = lifetime.first_pass_idx == UINT32_MAX || lifetime.needs_previous_contents ||
+            (image_create_info.usage & external_usage_flags) || image_create_info.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (!is_persistent)
+        {
+            alias_candidate_idx_list.push_back(attachment_idx);
+        }
+    }
+
+    // Greedy interval packing, largest first: every candidate joins the first group it shares a memory type with
+    // and whose members' pass spans it does not overlap.
+
+    struct AliasGroup
+    {
+        VkMemoryRequirements memory_requirements;
+        std::vector<uint32_t> attachment_idx_list;
+    };
+
+    std::sort(alias_candidate_idx_list.begin(), alias_candidate_idx_list.end(), [&](const uint32_t a, const uint32_t b)
+    {
+        return memory_requirements_list[a].size > memory_requirements_list[b].size;
+    });
+
+    std::vector<AliasGroup> alias_group_list;
+
+    for (const uint32_t attachment_idx : alias_candidate_idx_list)
+    {
+        const VkMemoryRequirements& memory_requirements = memory_requirements_list[attachment_idx];
+        const RenderAttachmentLifetime& lifetime = lifetime_list[attachment_idx];
+
+        AliasGroup* p_alias_group = nullptr;
+
+        for (AliasGroup& alias_group : alias_group_list)
+        {
+            if ((alias_group.memory_requirements.memoryTypeBits & memory_requirements.memoryTypeBits) == 0)
+            {
+                continue;
+            }
+
+            const bool overlaps = std::any_of(alias_group.attachment_idx_list.begin(), alias_group.attachment_idx_list.end(), [&](const uint32_t member_idx)
+            {
+                return lifetime.first_pass_idx <= lifetime_list[member_idx].last_pass_idx && lifetime_list[member_idx].first_pass_idx <= lifetime.last_pass_idx;
+            });
+
+            if (!overlaps)
+            {
+                p_alias_group = &alias_group;
+                break;
+            }
+        }
+
+        if (p_alias_group == nullptr)
+        {
+            alias_group_list.push_back({ .memory_requirements = memory_requirements, .attachment_idx_list = {} });
+            p_alias_group = &alias_group_list.back();
+        }
+
+        p_alias_group->memory_requirements.size = std::max(p_alias_group->memory_requirements.size, memory_requirements.size);
+        p_alias_group->memory_requirements.alignment = std::max(p_alias_group->memory_requirements.alignment, memory_requirements.alignment);
+        p_alias_group->memory_requirements.memoryTypeBits &= memory_requirements.memoryTypeBits;
+        p_alias_group->attachment_idx_list.push_back(attachment_idx);
+    }
+
+    // Single member groups gain nothing, those attachments allocate like any other.
+    std::vector<std::vector<vk_core::MemoryAllocation>> attachment_alias_allocation_list(attachment_count);
+
+    for (const AliasGroup& alias_group : alias_group_list)
+    {
+        if (alias_group.attachment_idx_list.size() < 2)
+        {
+            continue;
+        }
+
+        std::vector<vk_core::MemoryAllocation> group_allocation_list;
+
+        for (uint32_t i = 0; i < create_info.frame_resource_count; i++)
+        {
+            group_allocation_list.push_back(vk_core::allocate_image_memory_for_requirements(alias_group.memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+            alias_allocation_list.push_back(group_allocation_list.back());
+        }
+
+        for (const uint32_t attachment_idx : alias_group.attachment_idx_list)
+        {
+            attachment_alias_allocation_list[attachment_idx] = group_allocation_list;
+        }
+
+        memory_stats.alias_group_count++;
+        memory_stats.aliased_attachment_count += static_cast<uint32_t>(alias_group.attachment_idx_list.size());
+        memory_stats.allocated_byte_count += alias_group.memory_requirements.size * create_info.frame_resource_count;
+    }
+
+    std::vector<RenderPass::Attachment> render_attachment_list;
+    std::vector<VkImageMemoryBarrier> image_memory_barriers;
+
+    for (uint32_t attachment_idx = 0; attachment_idx < attachment_count; attachment_idx++)
+    {
+        const VkImageCreateInfo& image_create_info = image_create_info_list[attachment_idx];
+
+        render_attachment_list.emplace_back(image_create_info, image_view_create_info_list[attachment_idx], create_info.frame_resource_count,
+            memory_property_flags_list[attachment_idx], attachment_alias_allocation_list[attachment_idx]);
+
+        if (!render_attachment_list.back().is_aliased)
+        {
+            memory_stats.allocated_byte_count += memory_requirements_list[attachment_idx].size * create_info.frame_resource_count;
+        }
+
+        VkImageMemoryBarrier image_memory_barrier {};
+        image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        image_memory_barrier.pNext = nullptr;
+        image_memory_barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+        image_memory_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+        image_memory_barrier.srcQueueFamilyIndex = vk_core::get_queue_family_idx();
+        image_memory_barrier.dstQueueFamilyIndex = vk_core::get_queue_family_idx();
+        image_memory_barrier.subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
 
         image_memory_barrier.oldLayout = image_create_info.initialLayout;
 
@@ -367,6 +627,10 @@ static std::vector<RenderPass::Attachment> init_vec_render_attachment(const Rend
     vk_core::device_wait_idle();
     vk_core::destroy_command_pool(vk_handle_cmd_pool);
 
+    LOG("App Info - Render attachment memory: %lu bytes (%lu bytes without aliasing), %u alias groups, %u transient / %u lazily allocated attachments\n",
+        memory_stats.allocated_byte_count, memory_stats.naive_byte_count, memory_stats.alias_group_count,
+        memory_stats.transient_attachment_count, memory_stats.lazily_allocated_attachment_count);
+
     return render_attachment_list;
 }
 
@@ -442,20 +706,37 @@ static std::optional<RenderPass::WriteAttachmentPassInfo> get_registered_depth_o
     return std::nullopt;
 }
 
-static std::vector<RenderPass> init_vec_render_pass(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment, const std::unordered_map<std::string, uint16_t>& name_id_lut_sort_bin)
+static std::vector<RenderPass> init_vec_render_pass(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint8_t>& name_id_lut_render_attachment, const std::unordered_map<std::string, uint16_t>& name_id_lut_sort_bin, const std::vector<RenderPass::Attachment>& render_attachment_vec)
 {
-    const auto json_data = read_json_file(create_info.file_app_state);
-    const JSONInfo_RenderPass render_pass_info = json_data.at("render-passes").get<JSONInfo_RenderPass>();
-    const JSONInfo_AppSortBin sortbin_info = json_data.at("sortbins").get<JSONInfo_AppSortBin>();
+    const JSONInfo_RenderPass& render_pass_info = create_info.p_state_description->render_pass_info;
+    const JSONInfo_AppSortBin& sortbin_info = create_info.p_state_description->sortbin_info;
 
     std::vector<RenderPass> vec;
+    std::vector<bool> attachment_written_list(render_attachment_vec.size(), false);
+
+    // The first pass writing an aliased attachment takes over memory another attachment used before it.
+    const auto mark_alias_first_write = [&](RenderPass::WriteAttachmentPassInfo& attachment_pass_info)
+    {
+        attachment_pass_info.discard_contents = render_attachment_vec[attachment_pass_info.attachment_idx].is_aliased && !attachment_written_list[attachment_pass_info.attachment_idx];
+        attachment_written_list[attachment_pass_info.attachment_idx] = true;
+    };
 
     for (const JSONInfo_RenderPass::State render_pass_state : render_pass_info.state_list)
     {
         const auto sortbin_IDs = get_registered_sortbins(sortbin_info, render_pass_state, name_id_lut_sort_bin);
         const auto input_info = get_registered_inputs(render_pass_state, name_id_lut_render_attachment);
-        const auto color_info = get_registered_color_outputs(render_pass_state, name_id_lut_render_attachment);
-        const auto depth_info = get_registered_depth_output(render_pass_state, name_id_lut_render_attachment);
+        auto color_info = get_registered_color_outputs(render_pass_state, name_id_lut_render_attachment);
+        auto depth_info = get_registered_depth_output(render_pass_state, name_id_lut_render_attachment);
+
+        for (RenderPass::WriteAttachmentPassInfo& color_attachment_pass_info : color_info)
+        {
+            mark_alias_first_write(color_attachment_pass_info);
+        }
+
+        if (depth_info.has_value())
+        {
+            mark_alias_first_write(depth_info.value());
+        }
 
         const RenderPass::InitInfo render_pass_init_info {
             .frame_resource_count = create_info.frame_resource_count,
@@ -475,8 +756,7 @@ static std::vector<RenderPass> init_vec_render_pass(const RendererState::CreateI
 
 static VkDescriptorPool init_desc_pool(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec)
 {
-    const auto json_data_frame_desc_refl = read_json_file(create_info.refl_file_frame_desc_set_def);
-    const auto frame_desc_set_binding_vec = json_data_frame_desc_refl.at("bindings").get<std::vector<JSONInfo_DescriptorBinding>>();
+    const auto& frame_desc_set_binding_vec = create_info.p_state_description->frame_desc_set_binding_list;
 
     std::unordered_map<VkDescriptorType, uint32_t> desc_type_count_umap;
 
@@ -548,8 +828,7 @@ static std::vector<VkDescriptorSetLayoutBinding> create_desc_set_binding_list(co
 
 static VkDescriptorSetLayout init_frame_desc_set_layout(const RendererState::CreateInfo& create_info)
 {
-    const auto json_data_frame_desc_refl = read_json_file(create_info.refl_file_frame_desc_set_def).at("bindings").get<std::vector<JSONInfo_DescriptorBinding>>();
-    const auto frame_desc_set_binding_list = create_desc_set_binding_list(json_data_frame_desc_refl);
+    const auto frame_desc_set_binding_list = create_desc_set_binding_list(create_info.p_state_description->frame_desc_set_binding_list);
 
     const VkDescriptorSetLayoutCreateInfo desc_set_layout_create_info {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
@@ -579,195 +858,88 @@ static std::vector<VkDescriptorSet> init_vec_frame_desc_set(const RendererState:
 
 static std::vector<uint16_t> init_vec_compatible_sortbin_ID(const RendererState::CreateInfo& create_info, const std::unordered_map<std::string, uint16_t>& name_id_lut_sort_bin)
 {
-    const auto json_data_sort_bin_refl_state = read_json_file(create_info.refl_file_sortbin_mat_draw_def);
-    const auto sort_bin_reflection_umap = json_data_sort_bin_refl_state.at("sortbin-reflections").get<JSONInfo_SortBinReflection>().state_umap;
-    const auto sort_bin_pipeline_state_umap = read_json_file(create_info.file_sortbin_pipeline_state).at("sortbins").get<JSONInfo_SortBinPipelineState>().state_umap;
+    const auto& sort_bin_app_state_vec = create_info.p_state_description->sortbin_info.sortbin_list;
+    const auto& sort_bin_reflection_umap = create_info.p_state_description->sortbin_reflection_info.state_umap;
+    const auto& sort_bin_pipeline_state_umap = create_info.p_state_description->sortbin_pipeline_state_info.state_umap;
 
-    // compaitble if vertex input state "aligns" and iff material and draw definitions are the same or DNE
+    std::vector<sortbin_compatibility::SortBinState> sort_bin_state_vec;
 
-    struct SortBinAlikeState
+    for (const auto& sort_bin_app_state : sort_bin_app_state_vec)
     {
-        JSONInfo_SortBinPipelineState::VertexInputState vertex_input_state;
-        std::vector<JSONInfo_DescriptorVariable> definition_material_data;
-        std::vector<JSONInfo_DescriptorVariable> definition_draw_data;
-
-        bool operator==(const SortBinAlikeState& other) const
-        {
-            for (size_t i = 0; i < vertex_input_state.binding_description_list.size(); ++i)
-            {
-                if (vertex_input_state.binding_description_list[i].binding != other.vertex_input_state.binding_description_list[i].binding ||
-                    vertex_input_state.binding_description_list[i].stride != other.vertex_input_state.binding_description_list[i].stride ||
-                    vertex_input_state.binding_description_list[i].inputRate != other.vertex_input_state.binding_description_list[i].inputRate)
-                {
-                    return false;
-                }
-            }
-
-            if (vertex_input_state.attribute_description_list.size() == other.vertex_input_state.attribute_description_list.size())
-            {
-                for (size_t i = 0; i < vertex_input_state.attribute_description_list.size(); ++i)
-                {
-                    if (vertex_input_state.attribute_description_list[i].usage != other.vertex_input_state.attribute_description_list[i].usage &&
-                        vertex_input_state.attribute_description_list[i].attribute_desctiption.offset != other.vertex_input_state.attribute_description_list[i].attribute_desctiption.offset &&
-                        vertex_input_state.attribute_description_list[i].attribute_desctiption.format != other.vertex_input_state.attribute_description_list[i].attribute_desctiption.format &&
-                        vertex_input_state.attribute_description_list[i].attribute_desctiption.location != other.vertex_input_state.attribute_description_list[i].attribute_desctiption.location &&
-                        vertex_input_state.attribute_description_list[i].attribute_desctiption.binding != other.vertex_input_state.attribute_description_list[i].attribute_desctiption.binding)
-                    {
-                        return false;
-                    }
-                }
-
-                return true;
-            }
-
-            // Attributes must be a subset of the other
-            std::vector<JSONInfo_SortBinPipelineState::VertexInputAttributeDescription> large_attrib_list;
-            std::vector<JSONInfo_SortBinPipelineState::VertexInputAttributeDescription> small_attrib_list;
-
-            if (vertex_input_state.attribute_description_list.size() < other.vertex_input_state.attribute_description_list.size())
-            {
-                // Other has more attributes
-                large_attrib_list = other.vertex_input_state.attribute_description_list;
-                small_attrib_list = vertex_input_state.attribute_description_list;
-            }
-            else
-            {
-                // Same # of attributes or I have more
-                large_attrib_list = vertex_input_state.attribute_description_list;
-                small_attrib_list = other.vertex_input_state.attribute_description_list;
-            }
-
-            uint32_t found_count = 0;
-
-            for (const auto& large_attrib : large_attrib_list)
-            {
-                for (const auto& small_attrib : small_attrib_list)
-                {
-                    if (small_attrib.usage == large_attrib.usage)
-                    {
-                        if (small_attrib.attribute_desctiption.offset != large_attrib.attribute_desctiption.offset ||
-                            small_attrib.attribute_desctiption.format != large_attrib.attribute_desctiption.format ||
-                            small_attrib.attribute_desctiption.location != large_attrib.attribute_desctiption.location ||
-                            small_attrib.attribute_desctiption.binding != large_attrib.attribute_desctiption.binding)
-                        {
-                            return false;
-                        }
-
-                        found_count++;
-                    }
-                }
-            }
-
-            if (found_count != small_attrib_list.size())
-            {
-                // Not all attributes in the smaller list were found in the larger list
-                return false;
-            }
-
-            bool mat_def_equal = false;
-            bool draw_def_equal = false;
-
-            if (definition_material_data.empty() || other.definition_material_data.empty())
-            {
-                mat_def_equal = true;
-            }
-
-            if (definition_draw_data.empty() || other.definition_draw_data.empty())
-            {
-                draw_def_equal = true;
-            }
-
-            if (mat_def_equal && draw_def_equal)
-            {
-                return true;
-            }
+        ASSERT(sort_bin_reflection_umap.contains(sort_bin_app_state.name), "Sortbin %s not found in sortbin reflection file!\n", sort_bin_app_state.name.c_str());
+        ASSERT(sort_bin_pipeline_state_umap.contains(sort_bin_app_state.name), "Sortbin %s not found in sortbin pipeline state file!\n", sort_bin_app_state.name.c_str());
+        const auto& sort_bin_reflection_state = sort_bin_reflection_umap.at(sort_bin_app_state.name);
+        const auto& sort_bin_pipeline_state = sort_bin_pipeline_state_umap.at(sort_bin_app_state.name);
 
-            return vertex_input_state == other.vertex_input_state &&
-                   definition_material_data == other.definition_material_data &&
-                   definition_draw_data == other.definition_draw_data;
-        }
-    };
+        sort_bin_state_vec.push_back({
+            .p_vertex_input_state = &sort_bin_pipeline_state.pipeline_state.vertex_input_state,
+            .p_definition_material_data = &sort_bin_reflection_state.definition_material_data.members,
+            .p_definition_draw_data = &sort_bin_reflection_state.definition_draw_data.members,
+        });
+    }
 
-    struct CustomHash
-    {
-        size_t operator()(const SortBinAlikeState& state) const
-        {
-            return 0lu;
-        }
-    };
+    sortbin_compatibility::ClassifyStats classify_stats;
+    const std::vector<uint16_t> class_vec = sortbin_compatibility::classify(sort_bin_state_vec, classify_stats);
 
-    uint16_t uncompatible_sort_bin_count = 0u;
     std::vector<uint16_t> compatible_sort_bin_ID_vec(name_id_lut_sort_bin.size(), -1);
 
-    std::unordered_map<SortBinAlikeState, uint16_t, CustomHash> alike_sort_bin_umap;
-
-    for (const auto& [sort_bin_name, sort_bin_ID] : name_id_lut_sort_bin)
+    for (uint32_t sort_bin_idx = 0; sort_bin_idx < sort_bin_app_state_vec.size(); sort_bin_idx++)
     {
-        ASSERT(sort_bin_reflection_umap.contains(sort_bin_name), "Sortbin %s not found in sortbin reflection file!\n", sort_bin_name.c_str());
-        ASSERT(sort_bin_pipeline_state_umap.contains(sort_bin_name), "Sortbin %s not found in sortbin pipeline state file!\n", sort_bin_name.c_str());
-        const auto sort_bin_reflection_state = sort_bin_reflection_umap.at(sort_bin_name);
-        const auto sort_bin_pipeline_state = sort_bin_pipeline_state_umap.at(sort_bin_name);
-
-        const SortBinAlikeState alike_state {
-            .vertex_input_state = sort_bin_pipeline_state.pipeline_state.vertex_input_state,
-            .definition_material_data = sort_bin_reflection_state.definition_material_data.members,
-            .definition_draw_data = sort_bin_reflection_state.definition_draw_data.members
-        };
-
-        const auto alike_iter = alike_sort_bin_umap.find(alike_state);
-
-        if (alike_iter == alike_sort_bin_umap.end())
-        {
-           // I have ecnountered a new state that is not compatible with any previous states
-           compatible_sort_bin_ID_vec[sort_bin_ID] = uncompatible_sort_bin_count;
-           alike_sort_bin_umap[alike_state] = uncompatible_sort_bin_count++;
-        }
-        else
-        {
-            compatible_sort_bin_ID_vec[sort_bin_ID] = alike_iter->second;
-        }
+        compatible_sort_bin_ID_vec[name_id_lut_sort_bin.at(sort_bin_app_state_vec[sort_bin_idx].name)] = class_vec[sort_bin_idx];
     }
 
+    LOG("App Info - %zu sortbins in %u compatibility classes, classified in %.3f ms\n",
+        sort_bin_app_state_vec.size(), classify_stats.class_count, static_cast<double>(classify_stats.classify_ns) * 1e-6);
+
     return compatible_sort_bin_ID_vec;
 }
 
-static std::vector<VkViewport> create_viewport(const RendererState::CreateInfo& create_info)
+static VkPipelineViewportStateCreateInfo create_viewport_state()
 {
-    const std::vector<VkViewport> viewport {{
-        .x = 0,
-        .y = 0,
-        .width = static_cast<float>(create_info.window_x_dim),
-        .height = static_cast<float>(create_info.window_y_dim),
-        .minDepth = 0,
-        .maxDepth = 1,
-    }};
-
-    return viewport;
+    // Viewport and scissor are dynamic, set from the render area when recording.
+    const VkPipelineViewportStateCreateInfo default_viewport_state {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .viewportCount = 1,
+        .pViewports = nullptr,
+        .scissorCount = 1,
+        .pScissors = nullptr,
+    };
+
+    return default_viewport_state;
 }
 
-static std::vector<VkRect2D> create_scissor(const RendererState::CreateInfo& create_info)
+static std::vector<VkDynamicState> create_dynamic_state_vec(const bool is_extended_dynamic_state)
 {
-    const std::vector<VkRect2D> scissor {{
-        .offset = {.x = 0, .y = 0},
-        .extent = {create_info.window_x_dim, create_info.window_y_dim}
-    }};
+    std::vector<VkDynamicState> dynamic_state_vec { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    if (is_extended_dynamic_state)
+    {
+        dynamic_state_vec.insert(dynamic_state_vec.end(), {
+            VK_DYNAMIC_STATE_CULL_MODE,
+            VK_DYNAMIC_STATE_FRONT_FACE,
+            VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+            VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+            VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+            VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+        });
+    }
 
-    return scissor;
+    return dynamic_state_vec;
 }
 
-static VkPipelineViewportStateCreateInfo create_viewport_state(const std::vector<VkViewport>& viewport_vec, const std::vector<VkRect2D>& scissor_vec)
+static VkPipelineDynamicStateCreateInfo create_dynamic_state(const std::vector<VkDynamicState>& dynamic_state_vec)
 {
-    const VkPipelineViewportStateCreateInfo default_viewport_state {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+    const VkPipelineDynamicStateCreateInfo dynamic_state_create_info {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0x0,
-        .viewportCount = static_cast<uint32_t>(viewport_vec.size()),
-        .pViewports = viewport_vec.data(),
-        .scissorCount = static_cast<uint32_t>(scissor_vec.size()),
-        .pScissors = scissor_vec.data(),
+        .dynamicStateCount = static_cast<uint32_t>(dynamic_state_vec.size()),
+        .pDynamicStates = dynamic_state_vec.data(),
     };
 
-    return default_viewport_state;
+    return dynamic_state_create_info;
 }
 
 static VkPipelineMultisampleStateCreateInfo create_multisample_state()
@@ -785,35 +957,7 @@ static VkPipelineMultisampleStateCreateInfo create_multisample_state()
     return default_multisample_state;
 }
 
-static VkShaderModule create_shader_module(const std::string& shader_root_path, const std::string& shader_name)
-{
-    const std::string complete_filepath = shader_root_path + shader_name + ".spv";
-
-    FILE* f = fopen(complete_filepath.c_str(), "r");
-    ASSERT(f != 0, "Failed to open file %s!\n", complete_filepath.c_str());
-
-    fseek(f, 0, SEEK_END);
-    const size_t nbytes_file_size = (size_t)ftell(f);
-    rewind(f);
-
-    uint32_t* buffer = (uint32_t*)malloc(nbytes_file_size);
-    fread(buffer, nbytes_file_size, 1, f);
-    fclose(f);
-
-    VkShaderModuleCreateInfo create_info {
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = nbytes_file_size,
-        .pCode = buffer,
-    };
-
-    const VkShaderModule shader_module = vk_core::create_shader_module(create_info);
-
-    free(buffer);
-
-    return shader_module;
-};
-
-static std::vector<VkPipelineShaderStageCreateInfo> create_shader_stage_vec(const std::vector<std::string>& shader_name_list, const std::string& shader_root_path)
+static std::vector<VkPipelineShaderStageCreateInfo> create_shader_stage_vec(const std::vector<std::string>& shader_name_list, const std::string& shader_root_path, ShaderModuleCache& shader_module_cache)
 {    
     const auto get_shader_stage = [](const std::string& shader_name) {
         if (shader_name.ends_with(".vert"))
@@ -835,7 +979,7 @@ static std::vector<VkPipelineShaderStageCreateInfo> create_shader_stage_vec(cons
             .pNext = nullptr,
             .flags = 0x0,
             .stage = get_shader_stage(shader_name),
-            .module = create_shader_module(shader_root_path, shader_name),
+            .module = shader_module_cache.get(shader_root_path + shader_name + ".spv"),
             .pName = "main",
             .pSpecializationInfo = nullptr,
         };
@@ -904,6 +1048,34 @@ static std::vector<VkVertexInputAttributeDescription> create_attrib_binding_vec(
     return attribute_description_vec;
 }
 
+static VkVertexInputAttributeDescription get_vertex_pos_attribute(const JSONInfo_SortBinPipelineState::State& sortbin_state)
+{
+    for (const auto& attrib : sortbin_state.pipeline_state.vertex_input_state.attribute_description_list)
+    {
+        if (attrib.usage == "vertex_pos")
+        {
+            return attrib.attribute_desctiption;
+        }
+    }
+
+    return { .location = 0, .binding = 0, .format = VK_FORMAT_UNDEFINED, .offset = 0 };
+}
+
+static std::vector<SortBin::VertexAttribute> get_vertex_attribute_list(const JSONInfo_SortBinPipelineState::State& sortbin_state)
+{
+    std::vector<SortBin::VertexAttribute> vertex_attribute_list;
+
+    for (const auto& attrib : sortbin_state.pipeline_state.vertex_input_state.attribute_description_list)
+    {
+        if (attrib.attribute_desctiption.binding == 0)
+        {
+            vertex_attribute_list.push_back({ .usage = attrib.usage, .description = attrib.attribute_desctiption });
+        }
+    }
+
+    return vertex_attribute_list;
+}
+
 static VkPipelineVertexInputStateCreateInfo create_vertex_input_state(const JSONInfo_SortBinPipelineState::State& sortbin_state, const std::vector<VkVertexInputAttributeDescription>& attrib_description_vec)
 {
     const VkPipelineVertexInputStateCreateInfo vertex_input_create_info {
@@ -1026,6 +1198,20 @@ static VkPipelineColorBlendStateCreateInfo create_color_blend_state(const std::v
     return color_blend_state_create_info;
 }
 
+static uint32_t get_draw_model_mat_offset(const std::vector<JSONInfo_DescriptorVariable>& json_draw_desc_var_list)
+{
+    for (const JSONInfo_DescriptorVariable& json_desc_var : json_draw_desc_var_list)
+    {
+        if (json_desc_var.name == "model_mat")
+        {
+            ASSERT(json_desc_var.size == 16 * sizeof(float) && json_desc_var.internal_structure.empty(), "Draw data model_mat must be a mat4!\n");
+            return json_desc_var.offset;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
 static std::unordered_map<std::string, DescriptorVariable> create_desc_var_umap(const std::vector<JSONInfo_DescriptorVariable>& json_desc_var_list)
 {
     std::unordered_map<std::string, DescriptorVariable> desc_var_umap;
@@ -1062,22 +1248,161 @@ static std::unordered_map<std::string, DescriptorVariable> create_desc_var_umap(
     return desc_var_umap;
 }
 
+static SortBin::DynamicState get_sort_bin_dynamic_state(const JSONInfo_SortBinPipelineState::State& sortbin_state)
+{
+    const SortBin::DynamicState dynamic_state {
+        .topology = sortbin_state.pipeline_state.input_assembly_state.topology,
+        .cull_mode = sortbin_state.pipeline_state.rasterization_state.cull_mode,
+        .front_face = sortbin_state.pipeline_state.rasterization_state.front_face,
+        .depth_test_enable = sortbin_state.pipeline_state.depth_stencil_state.depth_test_enable ? VK_TRUE : VK_FALSE,
+        .depth_write_enable = sortbin_state.pipeline_state.depth_stencil_state.depth_write_enable ? VK_TRUE : VK_FALSE,
+        .depth_compare_op = sortbin_state.pipeline_state.depth_stencil_state.depth_compare_op,
+    };
+
+    return dynamic_state;
+}
+
+// Extended dynamic state only lets the topology change within the class the pipeline was created with.
+static uint32_t get_topology_class(const VkPrimitiveTopology topology)
+{
+    switch (topology)
+    {
+        case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+            return 0;
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+            return 1;
+        case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+// Sortbins of the same render pass and push constant ranges can share a pipeline when everything it bakes in is equal.
+// With extended dynamic state that excludes SortBin::DynamicState.
+static bool is_pipeline_state_shareable(const JSONInfo_SortBinPipelineState::State& sortbin_state_a, const JSONInfo_SortBinPipelineState::State& sortbin_state_b, const bool is_extended_dynamic_state)
+{
+    const auto& state_a = sortbin_state_a.pipeline_state;
+    const auto& state_b = sortbin_state_b.pipeline_state;
+
+    if (state_a.shader_state.shader_names != state_b.shader_state.shader_names ||
+        !(state_a.vertex_input_state == state_b.vertex_input_state) ||
+        state_a.rasterization_state.polygon_mode != state_b.rasterization_state.polygon_mode ||
+        state_a.depth_stencil_state.stencil_test_enable != state_b.depth_stencil_state.stencil_test_enable)
+    {
+        return false;
+    }
+
+    if (is_extended_dynamic_state)
+    {
+        return get_topology_class(state_a.input_assembly_state.topology) == get_topology_class(state_b.input_assembly_state.topology);
+    }
+
+    return get_sort_bin_dynamic_state(sortbin_state_a) == get_sort_bin_dynamic_state(sortbin_state_b);
+}
+
+static bool is_push_const_range_vec_equal(const std::vector<VkPushConstantRange>& range_vec_a, const std::vector<VkPushConstantRange>& range_vec_b)
+{
+    return std::equal(range_vec_a.begin(), range_vec_a.end(), range_vec_b.begin(), range_vec_b.end(), [](const VkPushConstantRange& range_a, const VkPushConstantRange& range_b)
+    {
+        return range_a.stageFlags == range_b.stageFlags && range_a.offset == range_b.offset && range_a.size == range_b.size;
+    });
+}
+
+static VkPipeline create_sort_bin_pipeline(
+    const JSONInfo_SortBinPipelineState::State& sort_bin_pipeline_state,
+    const RenderPass& render_pass,
+    const std::vector<RenderPass::Attachment>& render_attachment_list,
+    const VkPipelineLayout vk_handle_pipeline_layout,
+    const std::vector<VkPipelineShaderStageCreateInfo>& shader_stage_vec,
+    const bool is_extended_dynamic_state)
+{
+    // Default States
+    const auto attrib_binding_vec = create_attrib_binding_vec(sort_bin_pipeline_state);
+    const auto viewport_state = create_viewport_state();
+    const auto multisample_state = create_multisample_state();
+    const auto dynamic_state_vec = create_dynamic_state_vec(is_extended_dynamic_state);
+    const auto dynamic_state = create_dynamic_state(dynamic_state_vec);
+
+    // User-Specified States
+    const auto input_assembly_state = create_input_assembly_state(sort_bin_pipeline_state);
+    const auto rasterization_state = create_rasterization_state(sort_bin_pipeline_state);
+    const auto depth_stencil_state = create_depth_stencil_state(sort_bin_pipeline_state);
+    const auto vertex_input_state = create_vertex_input_state(sort_bin_pipeline_state, attrib_binding_vec);
+
+    // Rendering Info
+    const auto color_attachment_format_vec = get_sort_bin_color_attachment_format_vec(render_pass, render_attachment_list);
+    const VkFormat depth_attachment_format = render_pass.write_depth_attachment_pass_info.has_value() ? render_attachment_list[render_pass.write_depth_attachment_pass_info->attachment_idx].format : VK_FORMAT_UNDEFINED;
+    const auto rendering_create_info = create_rendering_create_info(color_attachment_format_vec, depth_attachment_format);
+
+    // Blending Info
+    const auto color_blend_attachment_state_vec = create_color_blend_attachment_state_vec(render_pass);
+    const auto color_blend_state = create_color_blend_state(color_blend_attachment_state_vec);
+
+    // Pipeline Creation
+    const VkGraphicsPipelineCreateInfo graphics_pipeline_create_info {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &rendering_create_info,
+        .flags = 0x0,
+        .stageCount = static_cast<uint32_t>(shader_stage_vec.size()),
+        .pStages = shader_stage_vec.data(),
+        .pVertexInputState = &vertex_input_state,
+        .pInputAssemblyState = &input_assembly_state,
+        .pTessellationState = nullptr,
+        .pViewportState = &viewport_state,
+        .pRasterizationState = &rasterization_state,
+        .pMultisampleState = &multisample_state,
+        .pDepthStencilState = &depth_stencil_state,
+        .pColorBlendState = &color_blend_state,
+        .pDynamicState = &dynamic_state,
+        .layout = vk_handle_pipeline_layout,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = 0,
+    };
+
+    return vk_core::create_graphics_pipeline(graphics_pipeline_create_info);
+}
+
+// Sortbins are built in three steps: layouts, pipeline sharing and shader modules on the calling thread, then the
+// pipelines, which carry the driver's shader compilation, concurrently on the worker pool, then the sortbins themselves.
 static std::vector<SortBin> init_vec_sort_bin(
     const RendererState::CreateInfo& create_info,
     const std::vector<RenderPass>& render_pass_vec,
     const std::vector<RenderPass::Attachment> render_attachment_list,
     const std::unordered_map<std::string, uint16_t>& name_id_lut_render_pass,
-    const VkDescriptorSetLayout vk_handle_frame_desc_set_layout)
+    const std::vector<uint16_t>& compatible_sortbin_ID_lut,
+    const VkDescriptorSetLayout vk_handle_frame_desc_set_layout,
+    const bool is_extended_dynamic_state,
+    WorkerPool& worker_pool)
 {
-    const auto json_data_app_state = read_json_file(create_info.file_app_state);
-    const auto json_data_sort_bin_pipeline_state = read_json_file(create_info.file_sortbin_pipeline_state);
-    const auto json_data_sort_bin_refl_state = read_json_file(create_info.refl_file_sortbin_mat_draw_def);
+    const auto& sort_bin_app_state_vec = create_info.p_state_description->sortbin_info.sortbin_list;
+    const auto& sort_bin_pipeline_state_umap = create_info.p_state_description->sortbin_pipeline_state_info.state_umap;
+    const auto& sort_bin_reflection_state_umap = create_info.p_state_description->sortbin_reflection_info.state_umap;
 
-    const auto sort_bin_app_state_vec = json_data_app_state.at("sortbins").get<JSONInfo_AppSortBin>().sortbin_list;
-    const auto sort_bin_pipeline_state_umap = json_data_sort_bin_pipeline_state.at("sortbins").get<JSONInfo_SortBinPipelineState>().state_umap;
-    const auto sort_bin_reflection_state_umap = json_data_sort_bin_refl_state.at("sortbin-reflections").get<JSONInfo_SortBinReflection>().state_umap;
+    struct SharedPipeline
+    {
+        uint16_t render_pass_ID;
+        const JSONInfo_SortBinPipelineState::State* p_sort_bin_pipeline_state;
+        std::vector<VkPushConstantRange> push_const_range_vec;
+        VkPipelineLayout vk_handle_pipeline_layout; // of the owning sortbin
+        std::vector<VkPipelineShaderStageCreateInfo> shader_stage_vec;
+    };
 
-    std::vector<SortBin> sortbin_list;
+    struct SortBinBuild
+    {
+        VkPipelineLayout vk_handle_pipeline_layout;
+        uint32_t shared_pipeline_idx;
+        bool is_pipeline_owner;
+    };
+
+    ShaderModuleCache shader_module_cache;
+    std::vector<SharedPipeline> shared_pipeline_list;
+    std::vector<SortBinBuild> sort_bin_build_list;
 
     for (const auto& sort_bin_app_state : sort_bin_app_state_vec)
     {
@@ -1093,53 +1418,63 @@ static std::vector<SortBin> init_vec_sort_bin(
         const auto& sort_bin_pipeline_state = sort_bin_pipeline_state_umap.at(sort_bin_app_state.name);
         const auto& sort_bin_reflection_state = sort_bin_reflection_state_umap.at(sort_bin_app_state.name);
 
-        // Default States
-        const auto viewport_vec = create_viewport(create_info);
-        const auto scissors_vec = create_scissor(create_info);
-        const auto attrib_binding_vec = create_attrib_binding_vec(sort_bin_pipeline_state);
-        const auto viewport_state = create_viewport_state(viewport_vec, scissors_vec);
-        const auto multisample_state = create_multisample_state();
-
-        // User-Specified States
-        const auto shader_stage_vec = create_shader_stage_vec(sort_bin_pipeline_state.pipeline_state.shader_state.shader_names, create_info.path_shader_root);
-        const auto input_assembly_state = create_input_assembly_state(sort_bin_pipeline_state);
-        const auto rasterization_state = create_rasterization_state(sort_bin_pipeline_state);
-        const auto depth_stencil_state = create_depth_stencil_state(sort_bin_pipeline_state);
-        const auto vertex_input_state = create_vertex_input_state(sort_bin_pipeline_state, attrib_binding_vec);
         const auto push_const_range_vec = create_push_const_ranges(sort_bin_reflection_state);
         const auto vk_handle_pipeline_layout = create_sort_bin_pipeline_layout(vk_handle_frame_desc_set_layout, render_pass.get_desc_set_layout(), push_const_range_vec);
 
-        // Rendering Info
-        const auto color_attachment_format_vec = get_sort_bin_color_attachment_format_vec(render_pass, render_attachment_list);
-        const VkFormat depth_attachment_format = render_pass.write_depth_attachment_pass_info.has_value() ? render_attachment_list[render_pass.write_depth_attachment_pass_info->attachment_idx].format : VK_FORMAT_UNDEFINED;
-        const auto rendering_create_info = create_rendering_create_info(color_attachment_format_vec, depth_attachment_format);
+        // Layouts of sortbins sharing a pipeline are identically defined, so stay compatible with it.
+        const auto shared_pipeline_iter = std::find_if(shared_pipeline_list.begin(), shared_pipeline_list.end(), [&](const SharedPipeline& shared_pipeline)
+        {
+            return shared_pipeline.render_pass_ID == render_pass_ID &&
+                is_push_const_range_vec_equal(shared_pipeline.push_const_range_vec, push_const_range_vec) &&
+                is_pipeline_state_shareable(*shared_pipeline.p_sort_bin_pipeline_state, sort_bin_pipeline_state, is_extended_dynamic_state);
+        });
 
-        // Blending Info
-        const auto color_blend_attachment_state_vec = create_color_blend_attachment_state_vec(render_pass);
-        const auto color_blend_state = create_color_blend_state(color_blend_attachment_state_vec);
-        
-        // Pipeline Creation
-        const VkGraphicsPipelineCreateInfo graphics_pipeline_create_info {
-            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-            .pNext = &rendering_create_info,
-            .flags = 0x0,
-            .stageCount = static_cast<uint32_t>(shader_stage_vec.size()),
-            .pStages = shader_stage_vec.data(),
-            .pVertexInputState = &vertex_input_state,
-            .pInputAssemblyState = &input_assembly_state,
-            .pTessellationState = nullptr,
-            .pViewportState = &viewport_state,
-            .pRasterizationState = &rasterization_state,
-            .pMultisampleState = &multisample_state,
-            .pDepthStencilState = &depth_stencil_state,
-            .pColorBlendState = &color_blend_state,
-            .pDynamicState = nullptr,
-            .layout = vk_handle_pipeline_layout,
-            .renderPass = VK_NULL_HANDLE,
-            .subpass = 0,
-            .basePipelineHandle = VK_NULL_HANDLE,
-            .basePipelineIndex = 0,
-        };
+        const bool is_pipeline_owner = shared_pipeline_iter == shared_pipeline_list.end();
+
+        if (is_pipeline_owner)
+        {
+            shared_pipeline_list.push_back({
+                .render_pass_ID = render_pass_ID,
+                .p_sort_bin_pipeline_state = &sort_bin_pipeline_state,
+                .push_const_range_vec = push_const_range_vec,
+                .vk_handle_pipeline_layout = vk_handle_pipeline_layout,
+                .shader_stage_vec = create_shader_stage_vec(sort_bin_pipeline_state.pipeline_state.shader_state.shader_names, create_info.path_shader_root, shader_module_cache),
+            });
+        }
+
+        sort_bin_build_list.push_back({
+            .vk_handle_pipeline_layout = vk_handle_pipeline_layout,
+            .shared_pipeline_idx = static_cast<uint32_t>(is_pipeline_owner ? shared_pipeline_list.size() - 1 : shared_pipeline_iter - shared_pipeline_list.begin()),
+            .is_pipeline_owner = is_pipeline_owner,
+        });
+    }
+
+    const auto pipeline_create_start = std::chrono::steady_clock::now();
+
+    std::vector<VkPipeline> vk_handle_pipeline_list(shared_pipeline_list.size(), VK_NULL_HANDLE);
+
+    worker_pool.run(static_cast<uint32_t>(shared_pipeline_list.size()), [&](const uint32_t pipeline_idx, const uint32_t)
+    {
+        const SharedPipeline& shared_pipeline = shared_pipeline_list[pipeline_idx];
+
+        vk_handle_pipeline_list[pipeline_idx] = create_sort_bin_pipeline(*shared_pipeline.p_sort_bin_pipeline_state,
+            render_pass_vec[shared_pipeline.render_pass_ID],
+            render_attachment_list,
+            shared_pipeline.vk_handle_pipeline_layout,
+            shared_pipeline.shader_stage_vec,
+            is_extended_dynamic_state);
+    });
+
+    const auto pipeline_create_end = std::chrono::steady_clock::now();
+
+    std::vector<SortBin> sortbin_list;
+
+    for (uint32_t sort_bin_idx = 0; sort_bin_idx < sort_bin_app_state_vec.size(); sort_bin_idx++)
+    {
+        const auto& sort_bin_app_state = sort_bin_app_state_vec[sort_bin_idx];
+        const auto& sort_bin_pipeline_state = sort_bin_pipeline_state_umap.at(sort_bin_app_state.name);
+        const auto& sort_bin_reflection_state = sort_bin_reflection_state_umap.at(sort_bin_app_state.name);
+        const SortBinBuild& sort_bin_build = sort_bin_build_list[sort_bin_idx];
 
         SortBin sortbin {
             .name = sort_bin_app_state.name,
@@ -1149,25 +1484,32 @@ static std::vector<SortBin> init_vec_sort_bin(
             .material_data_block_end_padding_size = sort_bin_reflection_state.definition_material_data.end_padding,
             .draw_data_block_size = sort_bin_reflection_state.definition_draw_data.size,
             .draw_data_block_end_padding_size = sort_bin_reflection_state.definition_draw_data.end_padding,
-            .vk_handle_pipeline = vk_core::create_graphics_pipeline(graphics_pipeline_create_info),
-            .vk_handle_pipeline_layout = vk_handle_pipeline_layout
+            .draw_model_mat_offset = get_draw_model_mat_offset(sort_bin_reflection_state.definition_draw_data.members),
+            .vk_handle_pipeline = vk_handle_pipeline_list[sort_bin_build.shared_pipeline_idx],
+            .vk_handle_pipeline_layout = sort_bin_build.vk_handle_pipeline_layout,
+            .is_pipeline_owner = sort_bin_build.is_pipeline_owner,
+            .compatible_sort_bin_set_ID = compatible_sortbin_ID_lut[sort_bin_idx],
+            .vertex_stride = sort_bin_pipeline_state.pipeline_state.vertex_input_state.binding_description_list.empty() ? 0 : sort_bin_pipeline_state.pipeline_state.vertex_input_state.binding_description_list[0].stride,
+            .vertex_pos_attribute = get_vertex_pos_attribute(sort_bin_pipeline_state),
+            .vertex_attribute_list = get_vertex_attribute_list(sort_bin_pipeline_state),
+            .dynamic_state = get_sort_bin_dynamic_state(sort_bin_pipeline_state),
         };
 
         sortbin_list.push_back(std::move(sortbin));
-
-        for (const VkPipelineShaderStageCreateInfo& shader_stage_create_info : shader_stage_vec)
-        {
-            vk_core::destroy_shader_module(shader_stage_create_info.module);
-        }
     }
 
+    LOG("App Info - %zu sortbins share %zu pipelines, created in %.2f ms on %u threads from %u shader modules (%u files, %lu bytes)\n",
+        sortbin_list.size(), shared_pipeline_list.size(),
+        static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(pipeline_create_end - pipeline_create_start).count()) * 1e-3,
+        worker_pool.get_worker_count(),
+        shader_module_cache.get_module_count(), shader_module_cache.get_file_count(), shader_module_cache.get_file_byte_count());
+
     return sortbin_list;
 }
 
 static std::unique_ptr<UniformBuffer> create_frame_ubo(const RendererState::CreateInfo& create_info, const std::string& ubo_name)
 {
-    const auto json_data_frame_desc_refl = read_json_file(create_info.refl_file_frame_desc_set_def);
-    const auto frame_desc_set_binding_vec = json_data_frame_desc_refl.at("bindings").get<std::vector<JSONInfo_DescriptorBinding>>();
+    const auto& frame_desc_set_binding_vec = create_info.p_state_description->frame_desc_set_binding_list;
 
     uint64_t size = 0lu;
     std::unordered_map<std::string, DescriptorVariable> desc_var_umap;
@@ -1190,7 +1532,96 @@ static std::unique_ptr<UniformBuffer> create_frame_ubo(const RendererState::Crea
     return std::make_unique<UniformBuffer>(create_info.frame_resource_count, size, std::move(desc_var_umap));
 }
 
-static void update_frame_desc_sets(const uint32_t frame_resource_count, const UniformBuffer* frame_uniform_buffer, const BufferPool_VariableBlock* material_data_buffer, const BufferPool_VariableBlock* draw_data_buffer, const UniformBuffer* frame_fwd_light_ubo, const std::vector<VkDescriptorSet>& vk_handle_desc_set_list)
+static void init_occlusion_cullers(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec, const std::vector<RenderPass::Attachment>& render_attachment_vec, const uint32_t sortbin_count, std::vector<RendererState::RenderPassCullState>& render_pass_cull_state_vec)
+{
+    const JSONInfo_RenderPass& render_pass_info = create_info.p_state_description->render_pass_info;
+
+    // Every culler builds its pipelines from the same Hi-Z build and cull shaders.
+    ShaderModuleCache shader_module_cache;
+
+    for (uint32_t render_pass_ID = 0; render_pass_ID < render_pass_info.state_list.size(); render_pass_ID++)
+    {
+        const JSONInfo_RenderPass::State& render_pass_state = render_pass_info.state_list[render_pass_ID];
+
+        if (!render_pass_state.occlusion_culling.has_value())
+        {
+            continue;
+        }
+
+        // The compacted draws are consumed through count buffers.
+        if (!vk_core::has_multi_draw_indirect() || !vk_core::has_draw_indirect_count())
+        {
+            LOG("Warning - Render pass %s: occlusion culling needs multiDrawIndirect and drawIndirectCount, disabled!\n", render_pass_state.name.c_str());
+            continue;
+        }
+
+        const RenderPass::WriteAttachmentPassInfo& depth_attachment_pass_info = render_pass_vec[render_pass_ID].write_depth_attachment_pass_info.value();
+        const RenderPass::Attachment& depth_attachment = render_attachment_vec[depth_attachment_pass_info.attachment_idx];
+
+        const OcclusionCuller::CreateInfo occlusion_culler_create_info {
+            .frame_resource_count = create_info.frame_resource_count,
+            .sortbin_count = sortbin_count,
+            .is_two_phase = render_pass_state.occlusion_culling.value().is_two_phase,
+            .is_reverse_z = render_pass_state.occlusion_culling.value().is_reverse_z,
+            .vk_handle_depth_image_list = depth_attachment.vk_handle_image_list,
+            .vk_handle_depth_image_view_list = depth_attachment.vk_handle_image_view_list,
+            .depth_format = depth_attachment.format,
+            .depth_extent = { depth_attachment.extent.width, depth_attachment.extent.height },
+            .depth_image_layout = depth_attachment_pass_info.image_layout,
+            .shader_root_path = RENDERER_SHADER_DIR,
+            .p_shader_module_cache = &shader_module_cache,
+        };
+
+        render_pass_cull_state_vec[render_pass_ID].occlusion_culler = std::make_unique<OcclusionCuller>(occlusion_culler_create_info);
+
+        LOG("App Info - Render pass %s: %s Hi-Z occlusion culling\n", render_pass_state.name.c_str(), occlusion_culler_create_info.is_two_phase ? "two phase" : "single phase");
+    }
+}
+
+static void init_draw_orders(const RendererState::CreateInfo& create_info, std::vector<RendererState::RenderPassCullState>& render_pass_cull_state_vec)
+{
+    const JSONInfo_RenderPass& render_pass_info = create_info.p_state_description->render_pass_info;
+
+    for (uint32_t render_pass_ID = 0; render_pass_ID < render_pass_info.state_list.size(); render_pass_ID++)
+    {
+        render_pass_cull_state_vec[render_pass_ID].draw_order = render_pass_info.state_list[render_pass_ID].draw_order;
+    }
+}
+
+// Errors are measured against the height of the pass's depth attachment, or its first color attachment.
+static void init_lod_selections(const RendererState::CreateInfo& create_info, const std::vector<RenderPass>& render_pass_vec, const std::vector<RenderPass::Attachment>& render_attachment_vec, std::vector<RendererState::RenderPassCullState>& render_pass_cull_state_vec)
+{
+    const JSONInfo_RenderPass& render_pass_info = create_info.p_state_description->render_pass_info;
+
+    for (uint32_t render_pass_ID = 0; render_pass_ID < render_pass_info.state_list.size(); render_pass_ID++)
+    {
+        const JSONInfo_RenderPass::State& render_pass_state = render_pass_info.state_list[render_pass_ID];
+
+        if (!render_pass_state.lod_selection.has_value())
+        {
+            continue;
+        }
+
+        const RenderPass& render_pass = render_pass_vec[render_pass_ID];
+        uint32_t target_height = create_info.window_y_dim;
+
+        if (render_pass.write_depth_attachment_pass_info.has_value())
+        {
+            target_height = render_attachment_vec[render_pass.write_depth_attachment_pass_info.value().attachment_idx].extent.height;
+        }
+        else if (!render_pass.write_color_attachment_pass_info_list.empty())
+        {
+            target_height = render_attachment_vec[render_pass.write_color_attachment_pass_info_list[0].attachment_idx].extent.height;
+        }
+
+        const float max_screen_error = render_pass_state.lod_selection.value().max_screen_error;
+        render_pass_cull_state_vec[render_pass_ID].lod_error_scale = static_cast<float>(target_height) / (2.0f * max_screen_error);
+
+        LOG("App Info - Render pass %s: LOD selection within %.2f pixels of %u\n", render_pass_state.name.c_str(), max_screen_error, target_height);
+    }
+}
+
+static void update_frame_desc_sets(const uint32_t frame_resource_count, const UniformBuffer* frame_uniform_buffer, const BufferPool_VariableBlock* material_data_buffer, const BufferPool_VariableBlock* draw_data_buffer, const UniformBuffer* frame_fwd_light_ubo, const BufferPool_VariableBlock* instance_buffer, const std::vector<VkDescriptorSet>& vk_handle_desc_set_list)
 {
     for (uint32_t i = 0; i < frame_resource_count; i++)
     {
@@ -1198,8 +1629,9 @@ static void update_frame_desc_sets(const uint32_t frame_resource_count, const Un
         const VkDescriptorBufferInfo mat_ssbo_desc_buffer_info = material_data_buffer->get_descriptor_buffer_info(i);
         const VkDescriptorBufferInfo draw_ssbo_desc_buffer_info = draw_data_buffer->get_descriptor_buffer_info(i);
         const VkDescriptorBufferInfo frame_fwd_light_ubo_desc_buffer_info = frame_fwd_light_ubo->get_descriptor_buffer_info(i);
+        const VkDescriptorBufferInfo instance_ssbo_desc_buffer_info = instance_buffer->get_descriptor_buffer_info(i);
 
-        const std::array<VkWriteDescriptorSet, 4> write_desc_set_list {{
+        const std::array<VkWriteDescriptorSet, 5> write_desc_set_list {{
             {
                 .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
                 .pNext = nullptr,
@@ -1248,6 +1680,18 @@ static void update_frame_desc_sets(const uint32_t frame_resource_count, const Un
                 .pBufferInfo = &frame_fwd_light_ubo_desc_buffer_info,
                 .pTexelBufferView = nullptr,
             },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext = nullptr,
+                .dstSet = vk_handle_desc_set_list[i],
+                .dstBinding = 4,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pImageInfo = nullptr,
+                .pBufferInfo = &instance_ssbo_desc_buffer_info,
+                .pTexelBufferView = nullptr,
+            },
         }};
 
         vk_core::update_desc_sets(static_cast<uint32_t>(write_desc_set_list.size()), write_desc_set_list.data(), 0, nullptr);
@@ -3,8 +3,11 @@
 
 #include "RenderPass.hpp"
 #include "internal/pod/Material.hpp"
+#include "internal/pod/DrawOrder.hpp"
 #include "internal/pod/Mesh.hpp"
 #include "internal/pod/Renderable.hpp"
+#include "internal/pod/StagingAllocation.hpp"
+#include "internal/pod/VisibleDrawLists.hpp"
 
 #include <inttypes.h>
 #include <string>
@@ -14,8 +17,16 @@
 
 class UniformBuffer;
 class GeometryBuffer;
+struct IndirectDrawBuffer;
+struct WorkerPool;
+struct SecondaryCommandPools;
+struct FrustumCuller;
+struct DrawSorter;
+struct LodSelector;
+struct OcclusionCuller;
 class BufferPool_VariableBlock;
 class StagingBuffer;
+struct StateDescription;
 
 struct RendererState
 {
@@ -23,6 +34,22 @@ struct RendererState
     const std::unordered_map<std::string, uint16_t> name_id_lut_render_pass;
     const std::unordered_map<std::string, uint16_t> name_id_lut_sort_bin;
 
+    // Render attachment memory footprint. naive_byte_count is what one allocation per image would have cost.
+    // Lazily allocated attachments are counted at their full size even though they are rarely backed.
+    struct AttachmentMemoryStats
+    {
+        uint64_t naive_byte_count = 0;
+        uint64_t allocated_byte_count = 0;
+        uint32_t alias_group_count = 0;
+        uint32_t aliased_attachment_count = 0;
+        uint32_t transient_attachment_count = 0;
+        uint32_t lazily_allocated_attachment_count = 0;
+    };
+
+    // Filled by the render attachment setup, so both must precede render_attachment_vec.
+    std::vector<vk_core::MemoryAllocation> render_attachment_alias_allocation_vec; // [alias group][frame resource]
+    AttachmentMemoryStats render_attachment_memory_stats {};
+
     const std::vector<RenderPass::Attachment> render_attachment_vec;
     const std::vector<RenderPass> render_pass_vec;
 
@@ -32,31 +59,140 @@ struct RendererState
     const std::vector<uint16_t> compatible_sortbin_ID_lut;
 
     std::vector<SortBin> sort_bin_vec;
+    bool is_extended_dynamic_state = false; // requested and supported, sortbin raster and depth state is set when recording
+
+    // Filled by renderer::init, see renderer::StartupStats.
+    struct StartupStats
+    {
+        uint64_t init_ns = 0;
+        uint64_t state_load_ns = 0;
+        bool is_state_bundle = false;
+        uint32_t pipeline_count = 0;
+        uint64_t pipeline_create_ns = 0;
+        bool is_pipeline_cache_warm = false;
+    };
+
+    StartupStats startup_stats {};
+
+    // Filled by the most recent renderer::record_render_pass.
+    struct RecordStats
+    {
+        uint64_t record_ns = 0;
+        uint32_t draw_command_count = 0;
+        uint32_t draw_call_count = 0;
+        uint32_t instance_count = 0;
+        uint32_t secondary_cmd_buff_count = 0;
+        uint32_t thread_count = 0;
+        uint32_t pipeline_bind_count = 0;
+        bool is_replayed = false;
+    };
+
+    RecordStats last_record_stats {};
+
+    // Filled by the most recent renderer::create_mesh, see renderer::MeshOptimizeStats.
+    struct MeshOptimizeStats
+    {
+        float acmr_before = 0.0f;
+        float acmr_after = 0.0f;
+        uint32_t overdraw_cluster_count = 0;
+        uint32_t index_stride_before = 0;
+        uint32_t index_stride_after = 0;
+        uint64_t index_byte_count_before = 0;
+        uint64_t index_byte_count_after = 0;
+        uint64_t vertex_byte_count_before = 0;
+        uint64_t vertex_byte_count_after = 0;
+        uint64_t optimize_ns = 0;
+        uint32_t lod_count = 1;
+        uint32_t coarsest_lod_index_count = 0;
+        float coarsest_lod_error = 0.0f;
+        uint64_t lod_index_byte_count = 0;
+        uint64_t lod_ns = 0;
+    };
+
+    MeshOptimizeStats last_mesh_optimize_stats {};
 
     std::unordered_map<std::string, uint32_t> name_id_lut_material;
 
     std::vector<Renderable> renderable_vec;
+    std::vector<uint32_t> renderable_free_ID_list; // IDs released by renderer::destroy_renderable
+
+    // Instance of a draw ID in the instanced draw of its mesh in a sortbin, see SortBin::InstanceGroup.
+    struct DrawInstance
+    {
+        uint16_t sortbin_id;
+        uint32_t instance_idx; // slot first_instance + instance_idx of the draw
+    };
+
+    std::unordered_map<uint32_t, std::vector<DrawInstance>> draw_instance_umap; // by draw ID, one per sortbin it was added to
     std::vector<Mesh> mesh_vec; 
+    std::vector<uint32_t> mesh_free_ID_list; // IDs released by renderer::destroy_mesh
     std::vector<Material> material_vec;
+    std::vector<uint32_t> material_free_ID_list; // IDs released by renderer::destroy_material
+    std::vector<uint32_t> uniform_block_ID_list; // scratch of renderer::update_uniforms
+
+    // Meshes reserved through renderer::reserve_mesh that have not been committed yet.
+    struct PendingMeshUpload
+    {
+        StagingAllocation vertex_allocation;
+        VkDeviceSize vertex_dst_offset;
+        StagingAllocation index_allocation;
+        VkDeviceSize index_dst_offset;
+    };
+
+    std::unordered_map<uint32_t, PendingMeshUpload> pending_mesh_upload_umap;
 
     std::unique_ptr<UniformBuffer>            frame_general_ubo;
     std::unique_ptr<UniformBuffer>            frame_fwd_light_ubo;
     std::unique_ptr<GeometryBuffer>           geometry_buffer;
+    std::unique_ptr<IndirectDrawBuffer>       indirect_draw_buffer;
     std::unique_ptr<BufferPool_VariableBlock> material_data_buffer;
     std::unique_ptr<BufferPool_VariableBlock> draw_data_buffer;
+    std::unique_ptr<BufferPool_VariableBlock> instance_buffer; // draw ID of every instance slot, blocks of 4 byte slots
     std::unique_ptr<StagingBuffer>            staging_buffer;
 
+    std::unique_ptr<WorkerPool>               worker_pool;
+    std::unique_ptr<FrustumCuller>            frustum_culler;
+    std::unique_ptr<DrawSorter>               draw_sorter;
+    std::unique_ptr<LodSelector>              lod_selector;
+
+    // Per render pass, only with parallel recording.
+    std::vector<std::unique_ptr<SecondaryCommandPools>> secondary_cmd_pools_vec;
+
+    // Per render pass, only with record caching. Culled recordings bypass it.
+    std::vector<std::unique_ptr<RenderPass::RecordCache>> record_cache_vec;
+    std::vector<uint64_t> render_pass_generation_vec; // bumped with the generation of every sortbin the pass draws
+    std::vector<uint64_t> frame_desc_set_generation_vec; // per frame resource, bumped by descriptor writes after init
+
+    // Frustum culling results of a render pass, see renderer::cull_render_pass.
+    // The indirect draw buffer is created on the first cull and holds the visible draws only.
+    // Passes with "occlusion-culling" in the app state also get an occlusion culler, which replaces it while supported.
+    // The visible draws switch to the LOD their projected error allows in passes with "lod-selection", then are
+    // reordered by the pass's "draw-order" before either consumes them.
+    struct RenderPassCullState
+    {
+        DrawOrder draw_order = DrawOrder::eInsertion;
+        float lod_error_scale = 0.0f; // render target height / (2 * "max-screen-error"), 0 draws full detail
+        std::vector<VisibleDrawLists> visible_draw_lists_vec; // indexed by sortbin ID
+        std::unique_ptr<IndirectDrawBuffer> indirect_draw_buffer;
+        std::unique_ptr<OcclusionCuller> occlusion_culler;
+        std::vector<bool> is_frame_culled_vec; // per frame resource, cleared by the next record_render_pass
+    };
+
+    std::vector<RenderPassCullState> render_pass_cull_state_vec;
+
     struct CreateInfo
     {
-        const char* const refl_file_frame_desc_set_def;
-        const char* const refl_file_sortbin_mat_draw_def;
-        const char* const file_sortbin_pipeline_state;
-        const char* const file_app_state;
+        const StateDescription* const p_state_description;
         const char* const path_shader_root;
 
         uint8_t frame_resource_count;
         uint32_t window_x_dim;
         uint32_t window_y_dim;
+
+        uint32_t worker_thread_count;
+        bool is_parallel_recording;
+        bool is_record_caching;
+        bool is_extended_dynamic_state;
     };
 
     explicit RendererState(const CreateInfo& create_info);
@@ -1,11 +1,36 @@
 #include "RenderPass.hpp"
 #include "internal/pod/DrawInfo.hpp"
+#include "internal/misc/SecondaryCommandPools.hpp"
+#include "internal/misc/WorkerPool.hpp"
+#include "internal/misc/logger.hpp"
+#include "internal/visibility/OcclusionCuller.hpp"
 #include "vk_core.hpp"
 
+#include <algorithm>
+
+// Consecutive draws of one sortbin stream, the unit draws are recorded and split across secondary command buffers in.
+// With multiDrawIndirect a slice covers the whole stream, otherwise [draw_begin, draw_end) of its draw list.
+struct DrawSlice
+{
+    uint16_t sortbin_id;
+    VkIndexType index_type;
+    uint32_t draw_begin;
+    uint32_t draw_end;
+    uint32_t cost; // vkCmdDraw* calls it records
+};
+
+static constexpr uint32_t s_min_task_cost = 64; // draw calls per secondary command buffer, below this recording is cheaper than the execute
+static constexpr uint32_t s_task_per_worker_count = 4; // slack for uneven tasks
+
 static VkRenderingAttachmentInfo create_rendering_attachment_info(const uint32_t frame_idx, const std::vector<RenderPass::Attachment>& render_attachments, const RenderPass::WriteAttachmentPassInfo& attachment_pass_info);
 static std::vector<VkRenderingAttachmentInfo> create_color_attachment_info_list(const uint32_t frame_idx, const std::vector<RenderPass::Attachment>& render_attachments, const std::vector<RenderPass::WriteAttachmentPassInfo> color_attachment_pass_info_list);
-static void record_draws(const VkCommandBuffer vk_handle_cmd_buff, const std::vector<DrawInfo>& draw_list, const VkIndexType index_type);
-static void record_sortbin_draws(const VkCommandBuffer vk_handle_cmd_buff, const std::vector<SortBin>& sortbins, const std::vector<uint16_t>& supported_sortbin_ids, const std::array<VkBuffer, 3>& vk_handle_index_buffer_list, const VkDescriptorSet vk_handle_frame_desc_set, const VkDescriptorSet vk_handle_render_pass_desc_set);
+static void record_alias_discard_barriers(const uint32_t frame_idx, const VkCommandBuffer vk_handle_cmd_buff, const std::vector<RenderPass::Attachment>& render_attachments, const std::vector<RenderPass::WriteAttachmentPassInfo>& color_attachment_pass_info_list, const std::optional<RenderPass::WriteAttachmentPassInfo>& depth_attachment_pass_info);
+static void record_draws(const VkCommandBuffer vk_handle_cmd_buff, const DrawInfo* const p_draw_list, const uint32_t draw_count, const VkIndexType index_type, const std::vector<VkBuffer>& vk_handle_geometry_buffer_list, RenderPass::RecordStats& record_stats);
+static void record_indirect_draws(const VkCommandBuffer vk_handle_cmd_buff, const IndirectDrawStream& indirect_draw_stream, const VkIndexType index_type, const std::vector<VkBuffer>& vk_handle_geometry_buffer_list, RenderPass::RecordStats& record_stats);
+static void build_draw_slice_list(const RenderPass::RecordInfo& record_info, const std::vector<uint16_t>& supported_sortbin_ids, const uint32_t max_slice_cost, std::vector<DrawSlice>& slice_list);
+static void record_dynamic_state(const VkCommandBuffer vk_handle_cmd_buff, const SortBin::DynamicState* const p_bound_dynamic_state, const SortBin::DynamicState& dynamic_state);
+static void record_draw_slices(const VkCommandBuffer vk_handle_cmd_buff, const RenderPass::RecordInfo& record_info, const VkDescriptorSet vk_handle_render_pass_desc_set, const DrawSlice* const p_slice_list, const uint32_t slice_count, RenderPass::RecordStats& record_stats);
+static RenderPass::RecordStats record_draw_slices_to_secondaries(const RenderPass::RecordInfo& record_info, const VkDescriptorSet vk_handle_render_pass_desc_set, const VkCommandBufferInheritanceInfo& inheritance_info, const VkCommandBufferUsageFlags usage_flags, const std::vector<uint16_t>& supported_sortbin_ids, SecondaryCommandPools& secondary_cmd_pools, WorkerPool* const p_worker_pool, std::vector<VkCommandBuffer>& vk_handle_cmd_buff_list);
 
 uint32_t RenderPass::s_input_attachment_count = 0u;
 VkSampler RenderPass::s_vk_handle_input_attachment_sampler = VK_NULL_HANDLE;
@@ -38,17 +63,27 @@ void RenderPass::create_input_attachment_sampler()
     s_vk_handle_input_attachment_sampler = vk_core::create_sampler(sampler_create_info);
 }
 
-RenderPass::Attachment::Attachment(const VkImageCreateInfo& image_create_info, VkImageViewCreateInfo image_view_create_info, const uint32_t frame_resource_count)
+RenderPass::Attachment::Attachment(const VkImageCreateInfo& image_create_info, VkImageViewCreateInfo image_view_create_info, const uint32_t frame_resource_count,
+    const VkMemoryPropertyFlags memory_property_flags, const std::vector<vk_core::MemoryAllocation>& alias_memory_allocation_list)
     : extent { image_create_info.extent }
     , format { image_create_info.format }
+    , samples { image_create_info.samples }
     , mip_count { image_create_info.mipLevels }
     , layer_count { image_create_info.arrayLayers }
+    , is_aliased { !alias_memory_allocation_list.empty() }
 {
     for ( uint32_t i = 0; i < frame_resource_count; i++)
     {
         const VkImage vk_handle_image = vk_core::create_image(image_create_info);
-        const VkDeviceMemory vk_handle_image_memory = vk_core::allocate_image_memory(vk_handle_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        vk_core::bind_image_memory(vk_handle_image, vk_handle_image_memory);
+
+        if (is_aliased)
+        {
+            vk_core::bind_image_memory(vk_handle_image, alias_memory_allocation_list[i]);
+        }
+        else
+        {
+            image_memory_allocation_list.push_back(vk_core::allocate_and_bind_image_memory(vk_handle_image, memory_property_flags));
+        }
 
         image_view_create_info.image = vk_handle_image;
 
@@ -56,10 +91,17 @@ RenderPass::Attachment::Attachment(const VkImageCreateInfo& image_create_info, V
 
         vk_handle_image_list.push_back(vk_handle_image);
         vk_handle_image_view_list.push_back(vk_handle_image_view);
-        vk_handle_image_memory_list.push_back(vk_handle_image_memory);
     }
 }
 
+RenderPass::RecordCache::RecordCache(const uint32_t frame_resource_count, const uint32_t worker_count)
+    : secondary_cmd_pools { std::make_unique<SecondaryCommandPools>(frame_resource_count, worker_count) }
+    , cached_frame_list(frame_resource_count)
+{
+}
+
+RenderPass::RecordCache::~RecordCache() = default;
+
 RenderPass::RenderPass(const InitInfo&& init_info)
     : supported_sortbin_id_list { std::move(init_info.supported_sortbin_id_list) }
     , read_attachment_pass_info_list { std::move(init_info.read_attachment_pass_info_list) }
@@ -139,7 +181,7 @@ void RenderPass::init_desc_sets(const uint32_t frame_resource_count, const VkDes
     }
 }
 
-void RenderPass::record(const RenderPass::RecordInfo& record_info) const 
+RenderPass::RecordStats RenderPass::record(const RenderPass::RecordInfo& record_info) const 
 {
     VkRenderingAttachmentInfo depth_rendering_attachment_info = {};
     if (write_depth_attachment_pass_info.has_value())
@@ -150,15 +192,29 @@ void RenderPass::record(const RenderPass::RecordInfo& record_info) const
             write_depth_attachment_pass_info.value());
     }
 
-    const std::vector<VkRenderingAttachmentInfo> color_rendering_attachment_infos = 
+    std::vector<VkRenderingAttachmentInfo> color_rendering_attachment_infos = 
         create_color_attachment_info_list(record_info.frame_idx,
         record_info.global_attachment_list, 
         write_color_attachment_pass_info_list);
 
+    // Resuming continues on top of what the earlier recording of this pass left in the attachments.
+    if (record_info.is_resumed)
+    {
+        depth_rendering_attachment_info.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+
+        for (VkRenderingAttachmentInfo& color_rendering_attachment_info : color_rendering_attachment_infos)
+        {
+            color_rendering_attachment_info.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        }
+    }
+
+    const bool is_parallel = record_info.p_worker_pool != nullptr && record_info.p_secondary_cmd_pools != nullptr;
+    const bool is_cached = record_info.p_record_cache != nullptr;
+
     const VkRenderingInfo rendering_info {
         .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
         .pNext = nullptr,
-        .flags = 0x0,
+        .flags = is_parallel || is_cached ? static_cast<VkRenderingFlags>(VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT) : 0x0,
         .renderArea = record_info.render_area,
         .layerCount = 1,
         .viewMask = 0x0,
@@ -168,21 +224,186 @@ void RenderPass::record(const RenderPass::RecordInfo& record_info) const
         .pStencilAttachment = nullptr,
     };
 
+    if (!record_info.is_resumed)
+    {
+        record_alias_discard_barriers(record_info.frame_idx,
+            record_info.vk_handle_cmd_buff,
+            record_info.global_attachment_list,
+            write_color_attachment_pass_info_list,
+            write_depth_attachment_pass_info);
+    }
+
+    const VkDescriptorSet vk_handle_render_pass_desc_set = m_vk_handle_desc_set_layout != VK_NULL_HANDLE ? m_vk_handle_desc_set_list[record_info.frame_idx] : VK_NULL_HANDLE;
+
     vkCmdBeginRendering(record_info.vk_handle_cmd_buff, &rendering_info);
 
-    record_sortbin_draws(
-        record_info.vk_handle_cmd_buff, 
-        record_info.global_sortbin_list,
-        supported_sortbin_id_list,
-        record_info.vk_handle_index_buffer_list,
-        record_info.vk_handle_global_desc_set,
-        m_vk_handle_desc_set_layout != VK_NULL_HANDLE ? m_vk_handle_desc_set_list[record_info.frame_idx] : VK_NULL_HANDLE);
+    RecordStats record_stats {};
+
+    if (!is_parallel && !is_cached)
+    {
+        std::vector<DrawSlice> slice_list;
+        build_draw_slice_list(record_info, supported_sortbin_id_list, UINT32_MAX, slice_list);
+
+        record_draw_slices(record_info.vk_handle_cmd_buff, record_info, vk_handle_render_pass_desc_set, slice_list.data(), static_cast<uint32_t>(slice_list.size()), record_stats);
+        record_stats.thread_count = 1;
+
+        vkCmdEndRendering(record_info.vk_handle_cmd_buff);
+
+        return record_stats;
+    }
+
+    std::vector<VkFormat> color_format_list;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+    for (const WriteAttachmentPassInfo& attachment_pass_info : write_color_attachment_pass_info_list)
+    {
+        color_format_list.push_back(record_info.global_attachment_list[attachment_pass_info.attachment_idx].format);
+        samples = record_info.global_attachment_list[attachment_pass_info.attachment_idx].samples;
+    }
+
+    if (write_depth_attachment_pass_info.has_value())
+    {
+        samples = record_info.global_attachment_list[write_depth_attachment_pass_info->attachment_idx].samples;
+    }
+
+    const VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .viewMask = 0x0,
+        .colorAttachmentCount = static_cast<uint32_t>(color_format_list.size()),
+        .pColorAttachmentFormats = color_format_list.data(),
+        .depthAttachmentFormat = write_depth_attachment_pass_info.has_value() ? record_info.global_attachment_list[write_depth_attachment_pass_info->attachment_idx].format : VK_FORMAT_UNDEFINED,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .rasterizationSamples = samples,
+    };
+
+    const VkCommandBufferInheritanceInfo inheritance_info {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = &inheritance_rendering_info,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0,
+        .framebuffer = VK_NULL_HANDLE,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags = 0x0,
+        .pipelineStatistics = 0x0,
+    };
+
+    if (is_cached)
+    {
+        RecordCache::CachedFrame& cached_frame = record_info.p_record_cache->cached_frame_list[record_info.frame_idx];
+
+        if (cached_frame.is_valid && cached_frame.key == record_info.record_cache_key)
+        {
+            record_stats = cached_frame.record_stats;
+            record_stats.thread_count = 0;
+            record_stats.is_replayed = true;
+        }
+        else
+        {
+            // Kept across frames, so no ONE_TIME_SUBMIT. Only ever pending in the frame resource's own primary.
+            record_info.p_record_cache->secondary_cmd_pools->reset(record_info.frame_idx);
+            cached_frame.vk_handle_cmd_buff_list.clear();
+
+            cached_frame.record_stats = record_draw_slices_to_secondaries(record_info, vk_handle_render_pass_desc_set, inheritance_info, 0x0,
+                supported_sortbin_id_list, *record_info.p_record_cache->secondary_cmd_pools, record_info.p_worker_pool, cached_frame.vk_handle_cmd_buff_list);
+            cached_frame.key = record_info.record_cache_key;
+            cached_frame.is_valid = true;
+
+            record_stats = cached_frame.record_stats;
+        }
+
+        if (!cached_frame.vk_handle_cmd_buff_list.empty())
+        {
+            vkCmdExecuteCommands(record_info.vk_handle_cmd_buff, static_cast<uint32_t>(cached_frame.vk_handle_cmd_buff_list.size()), cached_frame.vk_handle_cmd_buff_list.data());
+        }
+    }
+    else
+    {
+        // A resumed recording belongs to the same frame, its secondaries must survive until the frame is submitted.
+        if (!record_info.is_resumed)
+        {
+            record_info.p_secondary_cmd_pools->reset(record_info.frame_idx);
+        }
+
+        std::vector<VkCommandBuffer> vk_handle_cmd_buff_list;
+        record_stats = record_draw_slices_to_secondaries(record_info, vk_handle_render_pass_desc_set, inheritance_info, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            supported_sortbin_id_list, *record_info.p_secondary_cmd_pools, record_info.p_worker_pool, vk_handle_cmd_buff_list);
+
+        if (!vk_handle_cmd_buff_list.empty())
+        {
+            vkCmdExecuteCommands(record_info.vk_handle_cmd_buff, static_cast<uint32_t>(vk_handle_cmd_buff_list.size()), vk_handle_cmd_buff_list.data());
+        }
+    }
 
     vkCmdEndRendering(record_info.vk_handle_cmd_buff);
+
+    return record_stats;
 }
 
 // Helper functions
 
+static void record_alias_discard_barriers(const uint32_t frame_idx,
+    const VkCommandBuffer vk_handle_cmd_buff,
+    const std::vector<RenderPass::Attachment>& render_attachments,
+    const std::vector<RenderPass::WriteAttachmentPassInfo>& color_attachment_pass_info_list,
+    const std::optional<RenderPass::WriteAttachmentPassInfo>& depth_attachment_pass_info)
+{
+    // The memory of an aliased attachment was last written through another image, so its previous contents
+    // (and layout) are meaningless. Waiting on all prior work also orders the other image's accesses before ours.
+    std::vector<VkImageMemoryBarrier> image_memory_barrier_list;
+
+    const auto add_barrier = [&](const RenderPass::WriteAttachmentPassInfo& attachment_pass_info, const VkImageAspectFlags aspect_mask)
+    {
+        if (!attachment_pass_info.discard_contents)
+        {
+            return;
+        }
+
+        image_memory_barrier_list.push_back({
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = attachment_pass_info.image_layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = render_attachments[attachment_pass_info.attachment_idx].vk_handle_image_list[frame_idx],
+            .subresourceRange = {
+                .aspectMask = aspect_mask,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        });
+    };
+
+    for (const RenderPass::WriteAttachmentPassInfo& attachment_pass_info : color_attachment_pass_info_list)
+    {
+        add_barrier(attachment_pass_info, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+
+    if (depth_attachment_pass_info.has_value())
+    {
+        add_barrier(depth_attachment_pass_info.value(), VK_IMAGE_ASPECT_DEPTH_BIT);
+    }
+
+    if (image_memory_barrier_list.empty())
+    {
+        return;
+    }
+
+    vkCmdPipelineBarrier(vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0x0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(image_memory_barrier_list.size()), image_memory_barrier_list.data());
+}
+
 static VkRenderingAttachmentInfo create_rendering_attachment_info(const uint32_t frame_idx, 
     const std::vector<RenderPass::Attachment>& render_attachments, 
     const RenderPass::WriteAttachmentPassInfo& attachment_pass_info)
@@ -221,13 +442,42 @@ static std::vector<VkRenderingAttachmentInfo> create_color_attachment_info_list(
 }
 
 static void record_draws(const VkCommandBuffer vk_handle_cmd_buff, 
-    const std::vector<DrawInfo>& draw_list,
-    const VkIndexType index_type)
+    const DrawInfo* const p_draw_list,
+    const uint32_t draw_count,
+    const VkIndexType index_type,
+    const std::vector<VkBuffer>& vk_handle_geometry_buffer_list,
+    RenderPass::RecordStats& record_stats)
 {
+    // Draws whose mesh lost its last instance stay in the sortbin lists until the mesh is destroyed.
+    for (uint32_t draw_idx = 0; draw_idx < draw_count; draw_idx++)
+    {
+        const uint32_t instance_count = p_draw_list[draw_idx].instance_count;
+        record_stats.draw_command_count += instance_count != 0;
+        record_stats.draw_call_count += instance_count != 0;
+        record_stats.instance_count += instance_count;
+    }
+
+    // Draws are rebound whenever they cross into another geometry block.
+    uint32_t bound_geometry_block_id = UINT32_MAX;
+    const VkDeviceSize offset = 0;
+
     if (index_type == VK_INDEX_TYPE_MAX_ENUM)
     {
-        for (const DrawInfo& draw_info : draw_list)
+        for (uint32_t draw_idx = 0; draw_idx < draw_count; draw_idx++)
         {
+            const DrawInfo& draw_info = p_draw_list[draw_idx];
+
+            if (draw_info.instance_count == 0)
+            {
+                continue;
+            }
+
+            if (draw_info.geometry_block_id != bound_geometry_block_id)
+            {
+                bound_geometry_block_id = draw_info.geometry_block_id;
+                vkCmdBindVertexBuffers(vk_handle_cmd_buff, 0, 1, &vk_handle_geometry_buffer_list[bound_geometry_block_id], &offset);
+            }
+
             vkCmdDraw(vk_handle_cmd_buff, 
                 draw_info.vertex_count,
                 draw_info.instance_count,
@@ -237,8 +487,22 @@ static void record_draws(const VkCommandBuffer vk_handle_cmd_buff,
     }
     else
     {
-        for (const DrawInfo& draw_info : draw_list)
+        for (uint32_t draw_idx = 0; draw_idx < draw_count; draw_idx++)
         {
+            const DrawInfo& draw_info = p_draw_list[draw_idx];
+
+            if (draw_info.instance_count == 0)
+            {
+                continue;
+            }
+
+            if (draw_info.geometry_block_id != bound_geometry_block_id)
+            {
+                bound_geometry_block_id = draw_info.geometry_block_id;
+                vkCmdBindVertexBuffers(vk_handle_cmd_buff, 0, 1, &vk_handle_geometry_buffer_list[bound_geometry_block_id], &offset);
+                vkCmdBindIndexBuffer(vk_handle_cmd_buff, vk_handle_geometry_buffer_list[bound_geometry_block_id], 0, index_type);
+            }
+
             vkCmdDrawIndexed(vk_handle_cmd_buff,
                 draw_info.index_count,
                 draw_info.instance_count,
@@ -249,19 +513,192 @@ static void record_draws(const VkCommandBuffer vk_handle_cmd_buff,
     }
 }
 
-static void record_sortbin_draws(const VkCommandBuffer vk_handle_cmd_buff,
-    const std::vector<SortBin>& sortbins,
+static void record_indirect_draws(const VkCommandBuffer vk_handle_cmd_buff,
+    const IndirectDrawStream& indirect_draw_stream,
+    const VkIndexType index_type,
+    const std::vector<VkBuffer>& vk_handle_geometry_buffer_list,
+    RenderPass::RecordStats& record_stats)
+{
+    if (indirect_draw_stream.command_count == 0)
+    {
+        return;
+    }
+
+    // One call per geometry block run. A stream living in a single block reads its draw count from the buffer,
+    // leaving room for the GPU to compact the commands.
+    const std::vector<IndirectDrawRun>& run_list = *indirect_draw_stream.p_run_list;
+    const bool use_stream_count = vk_core::has_draw_indirect_count() && run_list.size() == 1;
+    const VkDeviceSize offset = 0;
+
+    record_stats.instance_count += indirect_draw_stream.instance_count;
+
+    for (const IndirectDrawRun& run : run_list)
+    {
+        const VkBuffer vk_handle_geometry_buffer = vk_handle_geometry_buffer_list[run.geometry_block_id];
+        const VkDeviceSize command_offset = indirect_draw_stream.command_offset + static_cast<VkDeviceSize>(run.first_command) * indirect_draw_stream.command_stride;
+
+        // Runs compacted on the GPU carry a count of their own.
+        const bool use_run_count = run.count_slot != UINT32_MAX;
+        const bool use_count_buffer = use_run_count || use_stream_count;
+        const VkDeviceSize count_offset = indirect_draw_stream.count_offset + (use_run_count ? static_cast<VkDeviceSize>(run.count_slot) * sizeof(uint32_t) : 0);
+
+        vkCmdBindVertexBuffers(vk_handle_cmd_buff, 0, 1, &vk_handle_geometry_buffer, &offset);
+
+        if (index_type == VK_INDEX_TYPE_MAX_ENUM)
+        {
+            if (use_count_buffer)
+            {
+                vkCmdDrawIndirectCount(vk_handle_cmd_buff, indirect_draw_stream.vk_handle_buffer, command_offset,
+                    indirect_draw_stream.vk_handle_buffer, count_offset, run.command_count, indirect_draw_stream.command_stride);
+            }
+            else
+            {
+                vkCmdDrawIndirect(vk_handle_cmd_buff, indirect_draw_stream.vk_handle_buffer, command_offset, run.command_count, indirect_draw_stream.command_stride);
+            }
+        }
+        else
+        {
+            vkCmdBindIndexBuffer(vk_handle_cmd_buff, vk_handle_geometry_buffer, 0, index_type);
+
+            if (use_count_buffer)
+            {
+                vkCmdDrawIndexedIndirectCount(vk_handle_cmd_buff, indirect_draw_stream.vk_handle_buffer, command_offset,
+                    indirect_draw_stream.vk_handle_buffer, count_offset, run.command_count, indirect_draw_stream.command_stride);
+            }
+            else
+            {
+                vkCmdDrawIndexedIndirect(vk_handle_cmd_buff, indirect_draw_stream.vk_handle_buffer, command_offset, run.command_count, indirect_draw_stream.command_stride);
+            }
+        }
+
+        record_stats.draw_command_count += run.command_count;
+        record_stats.draw_call_count++;
+    }
+}
+
+static IndirectDrawStream get_indirect_draw_stream(const RenderPass::RecordInfo& record_info, const uint16_t sortbin_id, const VkIndexType index_type)
+{
+    return record_info.p_occlusion_culler ?
+        record_info.p_occlusion_culler->get_stream(sortbin_id, index_type, record_info.frame_idx, record_info.occlusion_phase) :
+        record_info.indirect_draw_buffer.get_stream(sortbin_id, index_type, record_info.frame_idx);
+}
+
+static const std::vector<DrawInfo>& get_draw_list(const RenderPass::RecordInfo& record_info, const uint16_t sortbin_id, const VkIndexType index_type)
+{
+    if (record_info.p_visible_draw_lists_list)
+    {
+        const VisibleDrawLists& visible_draw_lists = (*record_info.p_visible_draw_lists_list)[sortbin_id];
+
+        switch (index_type)
+        {
+            case VK_INDEX_TYPE_UINT32: return visible_draw_lists.draw_list_u32;
+            case VK_INDEX_TYPE_UINT16: return visible_draw_lists.draw_list_u16;
+            case VK_INDEX_TYPE_UINT8_EXT: return visible_draw_lists.draw_list_u8;
+            default: return visible_draw_lists.draw_list;
+        }
+    }
+
+    const SortBin& sortbin = record_info.global_sortbin_list[sortbin_id];
+
+    switch (index_type)
+    {
+        case VK_INDEX_TYPE_UINT32: return sortbin.draw_list_u32;
+        case VK_INDEX_TYPE_UINT16: return sortbin.draw_list_u16;
+        case VK_INDEX_TYPE_UINT8_EXT: return sortbin.draw_list_u8;
+        default: return sortbin.draw_list;
+    }
+}
+
+static void build_draw_slice_list(const RenderPass::RecordInfo& record_info,
     const std::vector<uint16_t>& supported_sortbin_ids,
-    const std::array<VkBuffer, 3>& vk_handle_index_buffer_list,
-    const VkDescriptorSet vk_handle_frame_desc_set,
-    const VkDescriptorSet vk_handle_render_pass_desc_set)
+    const uint32_t max_slice_cost,
+    std::vector<DrawSlice>& slice_list)
 {
-    if (sortbins.empty() || supported_sortbin_ids.empty())
+    if (record_info.global_sortbin_list.empty())
     {
         return;
     }
 
-    std::vector<VkDescriptorSet> vk_handle_desc_set_list { vk_handle_frame_desc_set };
+    static constexpr VkIndexType s_index_type_list[] = { VK_INDEX_TYPE_UINT32, VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT8_EXT, VK_INDEX_TYPE_MAX_ENUM };
+
+    for (const uint16_t sortbin_id : supported_sortbin_ids)
+    {
+        for (const VkIndexType index_type : s_index_type_list)
+        {
+            // Without multiDrawIndirect / drawIndirectFirstInstance (the draw id rides in firstInstance) fall back to direct draws.
+            if (vk_core::has_multi_draw_indirect())
+            {
+                const IndirectDrawStream stream = get_indirect_draw_stream(record_info, sortbin_id, index_type);
+
+                if (stream.command_count != 0)
+                {
+                    slice_list.push_back({ sortbin_id, index_type, 0, 0, static_cast<uint32_t>(stream.p_run_list->size()) });
+                }
+
+                continue;
+            }
+
+            // Large draw lists are split so one sortbin can spread over several workers.
+            const uint32_t draw_count = static_cast<uint32_t>(get_draw_list(record_info, sortbin_id, index_type).size());
+
+            for (uint32_t draw_begin = 0; draw_begin < draw_count; draw_begin += max_slice_cost)
+            {
+                const uint32_t draw_end = draw_count - draw_begin > max_slice_cost ? draw_begin + max_slice_cost : draw_count;
+                slice_list.push_back({ sortbin_id, index_type, draw_begin, draw_end, draw_end - draw_begin });
+            }
+        }
+    }
+}
+
+// Sets the fields of dynamic_state that differ from p_bound_dynamic_state, all of them when it is nullptr.
+static void record_dynamic_state(const VkCommandBuffer vk_handle_cmd_buff, const SortBin::DynamicState* const p_bound_dynamic_state, const SortBin::DynamicState& dynamic_state)
+{
+    if (!p_bound_dynamic_state || p_bound_dynamic_state->topology != dynamic_state.topology)
+    {
+        vkCmdSetPrimitiveTopology(vk_handle_cmd_buff, dynamic_state.topology);
+    }
+
+    if (!p_bound_dynamic_state || p_bound_dynamic_state->cull_mode != dynamic_state.cull_mode)
+    {
+        vkCmdSetCullMode(vk_handle_cmd_buff, dynamic_state.cull_mode);
+    }
+
+    if (!p_bound_dynamic_state || p_bound_dynamic_state->front_face != dynamic_state.front_face)
+    {
+        vkCmdSetFrontFace(vk_handle_cmd_buff, dynamic_state.front_face);
+    }
+
+    if (!p_bound_dynamic_state || p_bound_dynamic_state->depth_test_enable != dynamic_state.depth_test_enable)
+    {
+        vkCmdSetDepthTestEnable(vk_handle_cmd_buff, dynamic_state.depth_test_enable);
+    }
+
+    if (!p_bound_dynamic_state || p_bound_dynamic_state->depth_write_enable != dynamic_state.depth_write_enable)
+    {
+        vkCmdSetDepthWriteEnable(vk_handle_cmd_buff, dynamic_state.depth_write_enable);
+    }
+
+    if (!p_bound_dynamic_state || p_bound_dynamic_state->depth_compare_op != dynamic_state.depth_compare_op)
+    {
+        vkCmdSetDepthCompareOp(vk_handle_cmd_buff, dynamic_state.depth_compare_op);
+    }
+}
+
+static void record_draw_slices(const VkCommandBuffer vk_handle_cmd_buff,
+    const RenderPass::RecordInfo& record_info,
+    const VkDescriptorSet vk_handle_render_pass_desc_set,
+    const DrawSlice* const p_slice_list,
+    const uint32_t slice_count,
+    RenderPass::RecordStats& record_stats)
+{
+    if (slice_count == 0)
+    {
+        return;
+    }
+
+    const std::vector<SortBin>& sortbins = record_info.global_sortbin_list;
+
+    std::vector<VkDescriptorSet> vk_handle_desc_set_list { record_info.vk_handle_global_desc_set };
     if ( vk_handle_render_pass_desc_set != VK_NULL_HANDLE )
     {
         vk_handle_desc_set_list.push_back(vk_handle_render_pass_desc_set);
@@ -269,41 +706,164 @@ static void record_sortbin_draws(const VkCommandBuffer vk_handle_cmd_buff,
 
     vkCmdBindDescriptorSets(vk_handle_cmd_buff,
         VK_PIPELINE_BIND_POINT_GRAPHICS, 
-        sortbins[supported_sortbin_ids[0]].vk_handle_pipeline_layout,
+        sortbins[p_slice_list[0].sortbin_id].vk_handle_pipeline_layout,
         0, 
         static_cast<uint32_t>(vk_handle_desc_set_list.size()), vk_handle_desc_set_list.data(),
         0, nullptr);
 
-    for (const uint32_t sortbin_id : supported_sortbin_ids)
-    {
-        const SortBin& sortbin = sortbins[sortbin_id];
+    // Dynamic state is not inherited by secondaries, every command buffer sets its own.
+    const VkViewport viewport {
+        .x = static_cast<float>(record_info.render_area.offset.x),
+        .y = static_cast<float>(record_info.render_area.offset.y),
+        .width = static_cast<float>(record_info.render_area.extent.width),
+        .height = static_cast<float>(record_info.render_area.extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
 
-        vkCmdBindPipeline(vk_handle_cmd_buff, 
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            sortbin.vk_handle_pipeline);
+    vkCmdSetViewport(vk_handle_cmd_buff, 0, 1, &viewport);
+    vkCmdSetScissor(vk_handle_cmd_buff, 0, 1, &record_info.render_area);
 
-        if (!sortbin.draw_list_u32.empty())
+    uint32_t bound_sortbin_id = UINT32_MAX;
+    VkPipeline vk_handle_bound_pipeline = VK_NULL_HANDLE;
+    const SortBin::DynamicState* p_bound_dynamic_state = nullptr;
+
+    for (uint32_t slice_idx = 0; slice_idx < slice_count; slice_idx++)
+    {
+        const DrawSlice& slice = p_slice_list[slice_idx];
+
+        if (slice.sortbin_id != bound_sortbin_id)
         {
-            vkCmdBindIndexBuffer(vk_handle_cmd_buff, vk_handle_index_buffer_list[0], 0, VK_INDEX_TYPE_UINT32);
-            record_draws(vk_handle_cmd_buff, sortbin.draw_list_u32, VK_INDEX_TYPE_UINT32);
+            bound_sortbin_id = slice.sortbin_id;
+            const SortBin& sortbin = sortbins[bound_sortbin_id];
+
+            if (sortbin.vk_handle_pipeline != vk_handle_bound_pipeline)
+            {
+                vkCmdBindPipeline(vk_handle_cmd_buff, 
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    sortbin.vk_handle_pipeline);
+
+                vk_handle_bound_pipeline = sortbin.vk_handle_pipeline;
+                record_stats.pipeline_bind_count++;
+            }
+
+            if (record_info.is_extended_dynamic_state)
+            {
+                record_dynamic_state(vk_handle_cmd_buff, p_bound_dynamic_state, sortbin.dynamic_state);
+                p_bound_dynamic_state = &sortbin.dynamic_state;
+            }
         }
 
-        if (!sortbin.draw_list_u16.empty())
+        if (vk_core::has_multi_draw_indirect())
         {
-            vkCmdBindIndexBuffer(vk_handle_cmd_buff, vk_handle_index_buffer_list[1], 0, VK_INDEX_TYPE_UINT16);
-            record_draws(vk_handle_cmd_buff, sortbin.draw_list_u16, VK_INDEX_TYPE_UINT16);
+            record_indirect_draws(vk_handle_cmd_buff, get_indirect_draw_stream(record_info, slice.sortbin_id, slice.index_type), slice.index_type, record_info.vk_handle_geometry_buffer_list, record_stats);
+            continue;
         }
 
-        if (!sortbin.draw_list_u8.empty())
+        const std::vector<DrawInfo>& draw_list = get_draw_list(record_info, slice.sortbin_id, slice.index_type);
+        record_draws(vk_handle_cmd_buff, draw_list.data() + slice.draw_begin, slice.draw_end - slice.draw_begin, slice.index_type, record_info.vk_handle_geometry_buffer_list, record_stats);
+    }
+}
+
+static RenderPass::RecordStats record_draw_slices_to_secondaries(const RenderPass::RecordInfo& record_info,
+    const VkDescriptorSet vk_handle_render_pass_desc_set,
+    const VkCommandBufferInheritanceInfo& inheritance_info,
+    const VkCommandBufferUsageFlags usage_flags,
+    const std::vector<uint16_t>& supported_sortbin_ids,
+    SecondaryCommandPools& secondary_cmd_pools,
+    WorkerPool* const p_worker_pool,
+    std::vector<VkCommandBuffer>& vk_handle_cmd_buff_list)
+{
+    // Without a worker pool everything goes to one secondary recorded on the calling thread.
+    const uint32_t worker_count = p_worker_pool ? secondary_cmd_pools.get_worker_count() : 1;
+
+    // First pass sizes the tasks, the second splits the draw lists to them.
+    std::vector<DrawSlice> slice_list;
+    build_draw_slice_list(record_info, supported_sortbin_ids, UINT32_MAX, slice_list);
+
+    uint32_t total_cost = 0;
+    for (const DrawSlice& slice : slice_list)
+    {
+        total_cost += slice.cost;
+    }
+
+    const uint32_t task_cost = p_worker_pool ? std::max(s_min_task_cost, total_cost / (worker_count * s_task_per_worker_count)) : UINT32_MAX;
+
+    if (!vk_core::has_multi_draw_indirect() && p_worker_pool)
+    {
+        slice_list.clear();
+        build_draw_slice_list(record_info, supported_sortbin_ids, task_cost, slice_list);
+    }
+
+    // Tasks are runs of consecutive slices, so executing their secondaries in task order keeps the draw order.
+    std::vector<uint32_t> task_first_slice_list;
+    uint32_t current_task_cost = task_cost;
+
+    for (uint32_t slice_idx = 0; slice_idx < slice_list.size(); slice_idx++)
+    {
+        if (current_task_cost >= task_cost)
         {
-            vkCmdBindIndexBuffer(vk_handle_cmd_buff, vk_handle_index_buffer_list[2], 0, VK_INDEX_TYPE_UINT8_EXT);
-            record_draws(vk_handle_cmd_buff, sortbin.draw_list_u8, VK_INDEX_TYPE_UINT8_EXT);
+            task_first_slice_list.push_back(slice_idx);
+            current_task_cost = 0;
         }
 
-        if (!sortbin.draw_list.empty())
+        current_task_cost += slice_list[slice_idx].cost;
+    }
+
+    const uint32_t task_count = static_cast<uint32_t>(task_first_slice_list.size());
+    task_first_slice_list.push_back(static_cast<uint32_t>(slice_list.size()));
+
+    vk_handle_cmd_buff_list.resize(task_count);
+    std::vector<RenderPass::RecordStats> task_record_stats_list(task_count);
+    std::vector<uint8_t> is_worker_used_list(worker_count, 0);
+
+    const VkCommandBufferBeginInfo cmd_buff_begin_info {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = usage_flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritance_info,
+    };
+
+    const auto record_task = [&](const uint32_t task_idx, const uint32_t worker_idx)
+    {
+        const VkCommandBuffer vk_handle_cmd_buff = secondary_cmd_pools.acquire(record_info.frame_idx, worker_idx);
+
+        VK_CHECK(vkBeginCommandBuffer(vk_handle_cmd_buff, &cmd_buff_begin_info));
+
+        const uint32_t first_slice_idx = task_first_slice_list[task_idx];
+        record_draw_slices(vk_handle_cmd_buff, record_info, vk_handle_render_pass_desc_set,
+            slice_list.data() + first_slice_idx, task_first_slice_list[task_idx + 1] - first_slice_idx, task_record_stats_list[task_idx]);
+
+        VK_CHECK(vkEndCommandBuffer(vk_handle_cmd_buff));
+
+        vk_handle_cmd_buff_list[task_idx] = vk_handle_cmd_buff;
+        is_worker_used_list[worker_idx] = 1;
+    };
+
+    if (p_worker_pool)
+    {
+        p_worker_pool->run(task_count, record_task);
+    }
+    else
+    {
+        for (uint32_t task_idx = 0; task_idx < task_count; task_idx++)
         {
-            record_draws(vk_handle_cmd_buff, sortbin.draw_list, VK_INDEX_TYPE_MAX_ENUM);
+            record_task(task_idx, 0);
         }
     }
-}
 
+    RenderPass::RecordStats record_stats {};
+
+    for (const RenderPass::RecordStats& task_record_stats : task_record_stats_list)
+    {
+        record_stats.draw_command_count += task_record_stats.draw_command_count;
+        record_stats.draw_call_count += task_record_stats.draw_call_count;
+        record_stats.instance_count += task_record_stats.instance_count;
+        record_stats.pipeline_bind_count += task_record_stats.pipeline_bind_count;
+    }
+
+    record_stats.secondary_cmd_buff_count = task_count;
+    record_stats.thread_count = static_cast<uint32_t>(std::count(is_worker_used_list.begin(), is_worker_used_list.end(), 1));
+
+    return record_stats;
+}
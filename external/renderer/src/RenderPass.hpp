@@ -2,6 +2,9 @@
 #define RENDERER_RENDER_PASS_HPP
 
 #include "internal/pod/SortBin.hpp"
+#include "internal/buffers/IndirectDrawBuffer.hpp"
+#include "internal/pod/VisibleDrawLists.hpp"
+#include "vk_core.hpp"
 
 #include  <vulkan/vulkan.h>
 
@@ -11,6 +14,10 @@
 #include <memory>
 #include <optional>
 
+struct OcclusionCuller;
+struct SecondaryCommandPools;
+struct WorkerPool;
+
 struct RenderPass
 {
 private:
@@ -26,16 +33,21 @@ public:
 
     struct Attachment
     {
-        explicit Attachment(const VkImageCreateInfo& image_create_info, VkImageViewCreateInfo image_view_create_info, const uint32_t frame_resource_count);
+        // alias_memory_allocation_list holds one externally owned allocation per frame resource to bind the images to.
+        // When empty, each image gets its own memory of memory_property_flags, released through image_memory_allocation_list.
+        explicit Attachment(const VkImageCreateInfo& image_create_info, VkImageViewCreateInfo image_view_create_info, const uint32_t frame_resource_count,
+            const VkMemoryPropertyFlags memory_property_flags, const std::vector<vk_core::MemoryAllocation>& alias_memory_allocation_list);
 
         VkExtent3D extent = { 0, 0, 0 };
         VkFormat format = VK_FORMAT_UNDEFINED;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
         uint32_t mip_count = 0u;
         uint32_t layer_count = 0u;
+        bool is_aliased = false;
 
         std::vector<VkImage> vk_handle_image_list;
         std::vector<VkImageView> vk_handle_image_view_list;
-        std::vector<VkDeviceMemory> vk_handle_image_memory_list;
+        std::vector<vk_core::MemoryAllocation> image_memory_allocation_list;
     };
 
     struct ReadAttachmentPassInfo
@@ -51,6 +63,23 @@ public:
         VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         VkAttachmentStoreOp store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         VkClearValue clear_value = { .color = { 0, 0, 0, 0 } };
+        bool discard_contents = false; // first use of an aliased attachment, transitioned from UNDEFINED before rendering
+    };
+
+    struct RecordCache;
+
+    // Generations of everything the draws of a recording reference. Any change means they must be recorded again.
+    struct RecordCacheKey
+    {
+        uint64_t render_pass_generation = 0; // draw lists of the pass's sortbins
+        uint64_t indirect_draw_generation = 0; // streams of the frame resource, see IndirectDrawBuffer::get_frame_generation
+        uint64_t frame_desc_set_generation = 0; // writes to the frame resource's descriptor set
+        int32_t render_area_x = 0; // viewport and scissor, set in every recorded command buffer
+        int32_t render_area_y = 0;
+        uint32_t render_area_width = 0;
+        uint32_t render_area_height = 0;
+
+        bool operator==(const RecordCacheKey&) const = default;
     };
 
     struct RecordInfo
@@ -59,9 +88,56 @@ public:
         const VkCommandBuffer vk_handle_cmd_buff;
         const std::vector<Attachment> global_attachment_list;
         const std::vector<SortBin>& global_sortbin_list;
-        const VkRect2D render_area;
-        const std::array<VkBuffer, 3> vk_handle_index_buffer_list;
+        const VkRect2D render_area; // also the viewport and scissor
+        const bool is_extended_dynamic_state; // sets SortBin::dynamic_state whenever a sortbin is bound
+        const std::vector<VkBuffer>& vk_handle_geometry_buffer_list; // indexed by DrawInfo::geometry_block_id
         const VkDescriptorSet vk_handle_global_desc_set;
+        const IndirectDrawBuffer& indirect_draw_buffer;
+        const std::vector<VisibleDrawLists>* p_visible_draw_lists_list; // culled draws indexed by sortbin ID, nullptr draws the sortbin lists
+        const OcclusionCuller* p_occlusion_culler; // when set, its GPU compacted streams of occlusion_phase are drawn instead
+        const uint32_t occlusion_phase;
+        const bool is_resumed; // loads every attachment and skips the discard barriers, for a second pass over the same frame
+        // When both are set the draws are split into secondary command buffers recorded on the worker pool, which the
+        // primary executes in order. The pools of frame_idx are reset unless is_resumed.
+        WorkerPool* const p_worker_pool;
+        SecondaryCommandPools* const p_secondary_cmd_pools;
+        // When set, the draws of frame_idx are kept in secondary command buffers and replayed as long as
+        // record_cache_key matches the key they were recorded with. Not for culled or resumed recordings.
+        RecordCache* const p_record_cache;
+        const RecordCacheKey record_cache_key;
+    };
+
+    struct RecordStats
+    {
+        uint32_t draw_command_count = 0; // draws executed on the GPU, one per mesh of a sortbin list, its visible runs when culled
+        uint32_t draw_call_count = 0; // vkCmdDraw* calls recorded
+        uint32_t instance_count = 0; // renderables drawn, the instanced draw of a mesh covers all of them
+        uint32_t secondary_cmd_buff_count = 0; // 0 when recorded straight into the primary
+        uint32_t thread_count = 0; // threads that recorded draws
+        uint32_t pipeline_bind_count = 0; // vkCmdBindPipeline calls, sortbins sharing a pipeline only bind it once
+        bool is_replayed = false; // cached draws executed, nothing recorded
+    };
+
+    struct RecordCache
+    {
+        struct CachedFrame
+        {
+            bool is_valid = false;
+            RecordCacheKey key {};
+            std::vector<VkCommandBuffer> vk_handle_cmd_buff_list;
+            RecordStats record_stats {};
+        };
+
+        RecordCache(const uint32_t frame_resource_count, const uint32_t worker_count);
+        ~RecordCache();
+
+        RecordCache(const RecordCache&) = delete;
+        RecordCache& operator=(const RecordCache&) = delete;
+        RecordCache(RecordCache&&) = delete;
+        RecordCache& operator=(RecordCache&&) = delete;
+
+        std::unique_ptr<SecondaryCommandPools> secondary_cmd_pools; // reset only when a frame resource is recorded again
+        std::vector<CachedFrame> cached_frame_list; // per frame resource
     };
 
     struct InitInfo {
@@ -76,7 +152,7 @@ public:
 
     void init_desc_sets(const uint32_t frame_resource_count, const VkDescriptorPool vk_handle_desc_pool, const std::vector<Attachment>& render_attachments);
 
-    void record(const RecordInfo& record_info) const;
+    RecordStats record(const RecordInfo& record_info) const;
 
     VkDescriptorSetLayout get_desc_set_layout() const { return m_vk_handle_desc_set_layout; }
 
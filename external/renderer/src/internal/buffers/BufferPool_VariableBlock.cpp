@@ -1,91 +1,331 @@
 #include "BufferPool_VariableBlock.hpp"
+#include "../misc/logger.hpp"
 #include "vk_core.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <string.h>
+
 BufferPool_VariableBlock::BufferPool_VariableBlock(const uint32_t frame_resource_count, const uint64_t per_frame_buffer_size)
     : m_frame_resource_count { frame_resource_count }
     , m_per_frame_buffer_size { per_frame_buffer_size }
+{
+    for (uint32_t i = 0; i < frame_resource_count; i++)
+    {
+        m_frame_buffer_list.push_back(create_frame_buffer(per_frame_buffer_size));
+    }
+
+    m_cpu_data.resize(per_frame_buffer_size, 0);
+    const uint64_t granule_count = (per_frame_buffer_size + s_dirty_granule_size - 1) / s_dirty_granule_size;
+    m_per_frame_dirty_bitmap.resize(frame_resource_count);
+
+    for (DirtyBitmap& bitmap : m_per_frame_dirty_bitmap)
+    {
+        bitmap.word_list.resize((granule_count + 63) / 64, 0);
+    }
+
+    m_batch_dirty_bitmap.word_list.resize((granule_count + 63) / 64, 0);
+}
+
+BufferPool_VariableBlock::~BufferPool_VariableBlock()
+{
+    for (const FrameBuffer& frame_buffer : m_frame_buffer_list)
+    {
+        destroy_frame_buffer(frame_buffer);
+    }
+
+    for (const RetiredBuffer& retired_buffer : m_retired_buffer_list)
+    {
+        destroy_frame_buffer(retired_buffer.frame_buffer);
+    }
+} 
+
+BufferPool_VariableBlock::FrameBuffer BufferPool_VariableBlock::create_frame_buffer(const uint64_t size)
 {
     const VkBufferCreateInfo buffer_create_info {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0x0,
-        .size = m_frame_resource_count * per_frame_buffer_size,
+        .size = size,
         .usage = (VkBufferUsageFlags)(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 0,
         .pQueueFamilyIndices = nullptr,
     };
 
-    uint64_t allocated_size = 0;
-    m_vk_handle_buffer = vk_core::create_buffer(buffer_create_info);
-    m_vk_handle_memory = vk_core::allocate_buffer_memory(m_vk_handle_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocated_size);
-    vk_core::bind_buffer_memory(m_vk_handle_buffer, m_vk_handle_memory);
+    FrameBuffer frame_buffer {};
+    frame_buffer.vk_handle_buffer = vk_core::create_buffer(buffer_create_info);
+    frame_buffer.memory_allocation = vk_core::allocate_and_bind_buffer_memory(frame_buffer.vk_handle_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    frame_buffer.size = size;
 
-    m_cpu_data.resize(per_frame_buffer_size, 0);
-    m_per_frame_dirty_blocks.resize(frame_resource_count);
+    return frame_buffer;
 }
 
-BufferPool_VariableBlock::~BufferPool_VariableBlock()
+void BufferPool_VariableBlock::destroy_frame_buffer(const FrameBuffer& frame_buffer)
 {
-    vk_core::free_memory(m_vk_handle_memory);
-    vk_core::destroy_buffer(m_vk_handle_buffer);
-} 
+    vk_core::destroy_buffer(frame_buffer.vk_handle_buffer);
+    vk_core::free_allocation(frame_buffer.memory_allocation);
+}
 
 uint32_t BufferPool_VariableBlock::acquire_block(const uint32_t block_size)
 {
-    if (block_size <= 0)
-        return -1;
+    ASSERT(block_size > 0, "BufferPool_VariableBlock - Block size must be non-zero!\n");
 
-    m_current_offset = std::ceil(static_cast<float>(m_current_offset) / static_cast<float>(block_size)) * block_size + block_size;
+    SizeClass& size_class = m_size_class_umap[block_size];
 
-    return (m_current_offset / block_size) - 1;
+    if (!size_class.free_block_id_list.empty())
+    {
+        const uint32_t block_id = size_class.free_block_id_list.back();
+        size_class.free_block_id_list.pop_back();
+        return block_id;
+    }
+
+    if (size_class.next_block_id == size_class.end_block_id)
+    {
+        const uint64_t slab_block_count = std::clamp<uint64_t>(s_max_slab_size / block_size, 1, s_slab_block_count);
+        const uint64_t slab_offset = ((m_current_offset + block_size - 1) / block_size) * block_size;
+        const uint64_t slab_end = slab_offset + static_cast<uint64_t>(block_size) * slab_block_count;
+
+        if (slab_end > m_per_frame_buffer_size)
+        {
+            grow(slab_end);
+        }
+
+        m_current_offset = slab_end;
+        size_class.next_block_id = slab_offset / block_size;
+        size_class.end_block_id = size_class.next_block_id + slab_block_count;
+    }
+
+    ASSERT(size_class.next_block_id < UINT32_MAX, "BufferPool_VariableBlock - Block id space exhausted for block size %u!\n", block_size);
+
+    return static_cast<uint32_t>(size_class.next_block_id++);
+}
+
+void BufferPool_VariableBlock::release_block(const uint32_t block_size, const uint32_t block_id)
+{
+    const auto iter = m_size_class_umap.find(block_size);
+    ASSERT(iter != m_size_class_umap.end(), "BufferPool_VariableBlock - Releasing block %u of unknown size %u!\n", block_id, block_size);
+
+    iter->second.free_block_id_list.push_back(block_id);
+}
+
+void BufferPool_VariableBlock::grow(const uint64_t min_size)
+{
+    const uint64_t new_size = ((std::max(m_per_frame_buffer_size * 2, min_size) + s_dirty_granule_size - 1) / s_dirty_granule_size) * s_dirty_granule_size;
+    const uint64_t granule_count = new_size / s_dirty_granule_size;
+
+    m_cpu_data.resize(new_size, 0);
+
+    for (DirtyBitmap& bitmap : m_per_frame_dirty_bitmap)
+    {
+        bitmap.word_list.resize((granule_count + 63) / 64, 0);
+    }
+
+    m_batch_dirty_bitmap.word_list.resize((granule_count + 63) / 64, 0);
+
+    m_per_frame_buffer_size = new_size;
+}
+
+bool BufferPool_VariableBlock::sync_frame_capacity(const uint32_t frame_resource_idx)
+{
+    FrameBuffer& frame_buffer = m_frame_buffer_list[frame_resource_idx];
+
+    if (frame_buffer.size >= m_per_frame_buffer_size)
+    {
+        return false;
+    }
+
+    // Copies queued earlier this frame may still target the old buffer.
+    m_retired_buffer_list.push_back({ frame_buffer, m_frame_epoch });
+    frame_buffer = create_frame_buffer(m_per_frame_buffer_size);
+
+    mark_dirty(m_per_frame_dirty_bitmap[frame_resource_idx], 0, m_current_offset);
+
+    return true;
+}
+
+void BufferPool_VariableBlock::advance_frame()
+{
+    m_frame_epoch++;
+
+    std::erase_if(m_retired_buffer_list, [this](const RetiredBuffer& retired_buffer) {
+        if (retired_buffer.frame_epoch + m_frame_resource_count < m_frame_epoch)
+        {
+            destroy_frame_buffer(retired_buffer.frame_buffer);
+            return true;
+        }
+        return false;
+    });
+}
+
+void BufferPool_VariableBlock::mark_dirty(const uint64_t offset, const uint64_t size)
+{
+    for (DirtyBitmap& bitmap : m_per_frame_dirty_bitmap)
+    {
+        mark_dirty(bitmap, offset, size);
+    }
+}
+
+void BufferPool_VariableBlock::mark_dirty(DirtyBitmap& bitmap, const uint64_t offset, const uint64_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    const uint64_t first_granule = offset / s_dirty_granule_size;
+    const uint64_t last_granule = (offset + size - 1) / s_dirty_granule_size;
+    const uint64_t first_word = first_granule / 64;
+    const uint64_t last_word = last_granule / 64;
+
+    for (uint64_t word = first_word; word <= last_word; word++)
+    {
+        const uint64_t lo = (word == first_word) ? first_granule % 64 : 0;
+        const uint64_t hi = (word == last_word) ? last_granule % 64 : 63;
+        const uint64_t mask = (hi - lo == 63) ? ~0ull : (((1ull << (hi - lo + 1)) - 1) << lo);
+
+        bitmap.word_list[word] |= mask;
+    }
+
+    bitmap.first_dirty_word = std::min(bitmap.first_dirty_word, first_word);
+    bitmap.last_dirty_word = std::max(bitmap.last_dirty_word, last_word);
 }
 
 void* BufferPool_VariableBlock::get_writable_block(const uint32_t block_size, const uint32_t block_id)
 {
-    for (uint32_t i = 0; i < m_frame_resource_count; i++)
+    return get_writable_range(block_size, block_id, 0, block_size);
+}
+
+void* BufferPool_VariableBlock::get_writable_range(const uint32_t block_size, const uint32_t block_id, const uint32_t member_offset, const uint32_t member_size)
+{
+    const uint64_t block_offset = static_cast<uint64_t>(block_id) * block_size;
+    mark_dirty(block_offset + member_offset, member_size);
+
+    return (void*)(&(m_cpu_data[block_offset]));
+}
+
+void BufferPool_VariableBlock::write_member_list(const uint32_t block_size, const uint32_t* const block_id_list, const uint32_t block_count,
+    const uint32_t member_offset, const uint32_t member_size, const uint8_t* const data, const uint32_t data_stride)
+{
+    if (block_count == 0 || member_size == 0)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < block_count; i++)
     {
-        m_per_frame_dirty_blocks[i].insert({block_size, block_id});
+        const uint64_t offset = static_cast<uint64_t>(block_id_list[i]) * block_size + member_offset;
+        ASSERT(offset + member_size <= m_current_offset, "BufferPool_VariableBlock - Block %u of size %u was never acquired!\n", block_id_list[i], block_size);
+
+        memcpy(&m_cpu_data[offset], data + static_cast<uint64_t>(i) * data_stride, member_size);
+        mark_dirty(m_batch_dirty_bitmap, offset, member_size);
+    }
+
+    const uint64_t first_word = m_batch_dirty_bitmap.first_dirty_word;
+    const uint64_t last_word = m_batch_dirty_bitmap.last_dirty_word;
+
+    for (DirtyBitmap& bitmap : m_per_frame_dirty_bitmap)
+    {
+        for (uint64_t word = first_word; word <= last_word; word++)
+        {
+            bitmap.word_list[word] |= m_batch_dirty_bitmap.word_list[word];
+        }
+
+        bitmap.first_dirty_word = std::min(bitmap.first_dirty_word, first_word);
+        bitmap.last_dirty_word = std::max(bitmap.last_dirty_word, last_word);
     }
 
-    return (void*)(&(m_cpu_data[block_id * block_size]));
+    std::fill(m_batch_dirty_bitmap.word_list.begin() + first_word, m_batch_dirty_bitmap.word_list.begin() + last_word + 1, 0);
+    m_batch_dirty_bitmap.first_dirty_word = UINT64_MAX;
+    m_batch_dirty_bitmap.last_dirty_word = 0;
 }
 
 const std::vector<UploadInfo> BufferPool_VariableBlock::get_queued_uploads(const uint32_t frame_resource_idx)
 {
-   std::unordered_set<DirtyBlockID, DirtyBlockID::Hash>& frame_dirty_blocks = m_per_frame_dirty_blocks[frame_resource_idx]; 
+    DirtyBitmap& bitmap = m_per_frame_dirty_bitmap[frame_resource_idx];
 
-   if (frame_dirty_blocks.empty())
-   {
-       return {};
-   }   
+    m_upload_stats.last_copy_region_count = 0;
+    m_upload_stats.last_staged_byte_count = 0;
 
-   std::vector<UploadInfo> upload_info_list {};
-   upload_info_list.reserve(frame_dirty_blocks.size());
+    if (bitmap.first_dirty_word == UINT64_MAX || m_frame_buffer_list[frame_resource_idx].size < m_per_frame_buffer_size)
+    {
+        return {};
+    }
 
-   for (const DirtyBlockID& dirty_block : frame_dirty_blocks)
-   {
-       const VkDeviceSize offset = dirty_block.block_size * dirty_block.block_id;
-       const UploadInfo upload_info {
+    std::vector<UploadInfo> upload_info_list {};
+
+    const auto emit_run = [&](const uint64_t run_first_granule, const uint64_t run_end_granule)
+    {
+        const VkDeviceSize offset = run_first_granule * s_dirty_granule_size;
+        const VkDeviceSize end = std::min<VkDeviceSize>(run_end_granule * s_dirty_granule_size, m_per_frame_buffer_size);
+
+        const UploadInfo upload_info {
             .dst_offset = offset,
-            .size = dirty_block.block_size,
-            .data_pointer = &m_cpu_data[offset], 
-       };
+            .size = end - offset,
+            .data_pointer = &m_cpu_data[offset],
+        };
 
-       upload_info_list.push_back(upload_info);
-   }
+        upload_info_list.push_back(upload_info);
+        m_upload_stats.last_staged_byte_count += end - offset;
+    };
 
-   frame_dirty_blocks.clear();
+    uint64_t run_first_granule = UINT64_MAX;
+    uint64_t run_end_granule = 0;
 
-   return upload_info_list;
-} 
+    for (uint64_t word = bitmap.first_dirty_word; word <= bitmap.last_dirty_word; word++)
+    {
+        uint64_t bits = bitmap.word_list[word];
+        bitmap.word_list[word] = 0;
+
+        while (bits)
+        {
+            const uint32_t first_bit = std::countr_zero(bits);
+            const uint64_t shifted_bits = bits >> first_bit;
+            const uint32_t bit_count = (~shifted_bits == 0) ? 64 - first_bit : std::countr_zero(~shifted_bits);
+
+            const uint64_t first_granule = word * 64 + first_bit;
+            const uint64_t end_granule = first_granule + bit_count;
+
+            if (run_first_granule != UINT64_MAX && first_granule <= run_end_granule + s_merge_gap_granule_count)
+            {
+                run_end_granule = end_granule;
+            }
+            else
+            {
+                if (run_first_granule != UINT64_MAX)
+                {
+                    emit_run(run_first_granule, run_end_granule);
+                }
+
+                run_first_granule = first_granule;
+                run_end_granule = end_granule;
+            }
+
+            bits = (first_bit + bit_count == 64) ? 0 : bits & ~(((1ull << bit_count) - 1) << first_bit);
+        }
+    }
+
+    if (run_first_granule != UINT64_MAX)
+    {
+        emit_run(run_first_granule, run_end_granule);
+    }
+
+    bitmap.first_dirty_word = UINT64_MAX;
+    bitmap.last_dirty_word = 0;
+
+    m_upload_stats.last_copy_region_count = upload_info_list.size();
+    m_upload_stats.total_copy_region_count += m_upload_stats.last_copy_region_count;
+    m_upload_stats.total_staged_byte_count += m_upload_stats.last_staged_byte_count;
+
+    return upload_info_list;
+}
 
 VkDescriptorBufferInfo BufferPool_VariableBlock::get_descriptor_buffer_info(const uint32_t frame_resource_idx) const
 {
     const VkDescriptorBufferInfo buffer_info {
-        .buffer = m_vk_handle_buffer,
-        .offset = m_per_frame_buffer_size * frame_resource_idx,
-        .range = m_per_frame_buffer_size
+        .buffer = m_frame_buffer_list[frame_resource_idx].vk_handle_buffer,
+        .offset = 0,
+        .range = m_frame_buffer_list[frame_resource_idx].size
     };
 
     return buffer_info;
@@ -3,46 +3,91 @@
 
 #include "../pod/UploadInfo.hpp"
 
+#include "vk_core.hpp"
+
 #include <vulkan/vulkan.h>
 
 #include <inttypes.h>
+#include <unordered_map>
 #include <vector>
-#include <unordered_set>
-#include <cmath>
 
+struct BufferPoolUploadStats
+{
+    uint64_t last_copy_region_count = 0;
+    uint64_t last_staged_byte_count = 0;
+    uint64_t total_copy_region_count = 0;
+    uint64_t total_staged_byte_count = 0;
+};
+
+// Storage buffer pool handing out fixed size blocks addressed by block_id * block_size, so a shader can index
+// the buffer as an array of its own block type. Blocks of one size are carved from slabs of s_slab_block_count
+// blocks, fewer for blocks so large that a slab would pass s_max_slab_size (slab start aligned to the block size),
+// and recycled through a per size class free list, making acquire_block / release_block O(1) and keeping
+// inter-size padding to one gap per slab.
+//
+// Every frame resource owns its own VkBuffer. When the pool outgrows it, sync_frame_capacity(frame_resource_idx)
+// recreates that frame's buffer only, so descriptor ranges of frames still in flight remain valid. The replaced
+// buffer is destroyed frame_resource_count calls to advance_frame() later.
 struct BufferPool_VariableBlock
 {
 private:
 protected:
 
-    struct DirtyBlockID
+    // Dirty state is tracked per frame resource as a bitmap of 16 byte granules (std430 vec4 alignment).
+    // Uploads walk the bitmap in address order and merge set runs separated by at most s_merge_gap_granule_count
+    // clean granules, so scattered member updates become a handful of sorted copy regions.
+    static constexpr uint32_t s_dirty_granule_size = 16;
+    static constexpr uint32_t s_merge_gap_granule_count = 4;
+    static constexpr uint32_t s_slab_block_count = 32;
+    static constexpr uint64_t s_max_slab_size = 1 << 16;
+
+    struct DirtyBitmap
+    {
+        std::vector<uint64_t> word_list;
+        uint64_t first_dirty_word = UINT64_MAX;
+        uint64_t last_dirty_word = 0;
+    };
+
+    struct SizeClass
+    {
+        std::vector<uint32_t> free_block_id_list;
+        uint64_t next_block_id = 0;
+        uint64_t end_block_id = 0;
+    };
+
+    struct FrameBuffer
+    {
+        VkBuffer vk_handle_buffer = VK_NULL_HANDLE;
+        vk_core::MemoryAllocation memory_allocation {};
+        uint64_t size = 0;
+    };
+
+    struct RetiredBuffer
     {
-        uint32_t block_size;
-        uint32_t block_id;
-
-        bool operator==(const DirtyBlockID& other) const
-        {
-            return block_size == other.block_size && 
-                   block_id   == other.block_id;
-        }
-
-        struct Hash
-        {
-            std::size_t operator()(const DirtyBlockID& obj) const
-            {
-                return std::hash<uint32_t>()(obj.block_id * obj.block_size);
-            }
-        };
+        FrameBuffer frame_buffer;
+        uint64_t frame_epoch;
     };
 
     const uint32_t m_frame_resource_count = 0;
-    const uint64_t m_per_frame_buffer_size = 0;
-    VkBuffer m_vk_handle_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_vk_handle_memory = VK_NULL_HANDLE;
+    uint64_t m_per_frame_buffer_size = 0;
+    uint64_t m_frame_epoch = 0;
+
+    std::vector<FrameBuffer> m_frame_buffer_list;
+    std::vector<RetiredBuffer> m_retired_buffer_list;
 
     uint64_t m_current_offset = 0;
+    std::unordered_map<uint32_t, SizeClass> m_size_class_umap; // block size -> size class
     std::vector<uint8_t> m_cpu_data;
-    std::vector<std::unordered_set<DirtyBlockID, DirtyBlockID::Hash>> m_per_frame_dirty_blocks;
+    std::vector<DirtyBitmap> m_per_frame_dirty_bitmap;
+    DirtyBitmap m_batch_dirty_bitmap; // collects the ranges of one write_member_list, empty in between
+    BufferPoolUploadStats m_upload_stats {};
+
+    static FrameBuffer create_frame_buffer(const uint64_t size);
+    static void destroy_frame_buffer(const FrameBuffer& frame_buffer);
+
+    void grow(const uint64_t min_size);
+    void mark_dirty(const uint64_t offset, const uint64_t size);
+    void mark_dirty(DirtyBitmap& bitmap, const uint64_t offset, const uint64_t size);
 
 public:
 
@@ -55,10 +100,28 @@ public:
     BufferPool_VariableBlock& operator=(BufferPool_VariableBlock&&) = delete;
 
     uint32_t acquire_block(const uint32_t block_size);
+    // The block id may be handed out again by the next acquire_block of the same size.
+    void release_block(const uint32_t block_size, const uint32_t block_id);
     void* get_writable_block(const uint32_t block_size, const uint32_t block_id);
+    // Only [member_offset, member_offset + member_size) of the block is re-uploaded.
+    void* get_writable_range(const uint32_t block_size, const uint32_t block_id, const uint32_t member_offset, const uint32_t member_size);
+    // Copies member_size bytes into [member_offset, member_offset + member_size) of each listed block, the source of
+    // block_id_list[i] being data + i * data_stride. The touched granules are merged into every frame's bitmap at once.
+    void write_member_list(const uint32_t block_size, const uint32_t* const block_id_list, const uint32_t block_count,
+        const uint32_t member_offset, const uint32_t member_size, const uint8_t* const data, const uint32_t data_stride);
+    // Returns nothing while the frame's buffer is smaller than the pool, call sync_frame_capacity first.
     const std::vector<UploadInfo> get_queued_uploads(const uint32_t frame_resource_idx); 
 
-    VkBuffer get_vk_handle_buffer() const { return m_vk_handle_buffer; }
+    // Recreates the frame's buffer if the pool grew since its last sync and queues a full re-upload of it.
+    // Returns true when the descriptor range of the frame must be rewritten.
+    // Must only be called while no submission using frame_resource_idx is pending.
+    bool sync_frame_capacity(const uint32_t frame_resource_idx);
+    void advance_frame();
+
+    VkBuffer get_vk_handle_buffer(const uint32_t frame_resource_idx) const { return m_frame_buffer_list[frame_resource_idx].vk_handle_buffer; }
+    const BufferPoolUploadStats& get_upload_stats() const { return m_upload_stats; }
+    // Host copy of the whole pool, reallocated when acquire_block grows it.
+    const std::vector<uint8_t>& get_cpu_data() const { return m_cpu_data; }
     VkDescriptorBufferInfo get_descriptor_buffer_info(const uint32_t frame_resource_idx) const;
 };
 
@@ -1,51 +1,477 @@
 #include "GeometryBuffer.hpp"
+#include "../misc/logger.hpp"
 #include "vk_core.hpp"
 
-GeometryBuffer::GeometryBuffer(const uint64_t size)
-{    
+#include <algorithm>
+#include <chrono>
+
+static VkDeviceSize align_up(const VkDeviceSize offset, const uint32_t alignment)
+{
+    return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+GeometryBuffer::GeometryBuffer(const VkDeviceSize block_size, const uint32_t frame_resource_count)
+    : m_block_size { block_size }
+    , m_frame_resource_count { frame_resource_count }
+{
+    ASSERT(block_size > 0, "GeometryBuffer - Block size must be non-zero!\n");
+
+    create_block(block_size);
+}
+
+GeometryBuffer::~GeometryBuffer()
+{
+    for (Block& block : m_block_list)
+    {
+        destroy_block(block);
+    }
+}
+
+uint32_t GeometryBuffer::create_block(const VkDeviceSize min_size)
+{
     const VkBufferCreateInfo create_info {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0x0,
-        .size = 1024 * 1024, 
-        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .size = std::max(m_block_size, min_size),
+        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 0,
         .pQueueFamilyIndices = nullptr
     };
 
-    m_vk_handle_buffer = vk_core::create_buffer(create_info);
-    m_vk_handle_buffer_memory = vk_core::allocate_buffer_memory(m_vk_handle_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_buffer_size);
-    vk_core::bind_buffer_memory(m_vk_handle_buffer, m_vk_handle_buffer_memory);
+    Block block {};
+    block.vk_handle_buffer = vk_core::create_buffer(create_info);
+    block.memory_allocation = vk_core::allocate_and_bind_buffer_memory(block.vk_handle_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    block.size = create_info.size;
+    insert_free_range(block, 0, block.size);
+
+    // Reuse the slot of a released block so block ids stay small.
+    const auto iter = std::find_if(m_block_list.begin(), m_block_list.end(), [](const Block& b) { return b.vk_handle_buffer == VK_NULL_HANDLE; });
+    if (iter != m_block_list.end())
+    {
+        const uint32_t block_id = static_cast<uint32_t>(iter - m_block_list.begin());
+        m_vk_handle_buffer_list[block_id] = block.vk_handle_buffer;
+        *iter = std::move(block);
+        return block_id;
+    }
+
+    m_vk_handle_buffer_list.push_back(block.vk_handle_buffer);
+    m_block_list.push_back(std::move(block));
+    return static_cast<uint32_t>(m_block_list.size() - 1);
 }
 
-GeometryBuffer::~GeometryBuffer()
+void GeometryBuffer::destroy_block(Block& block)
 {
-    vk_core::destroy_buffer(m_vk_handle_buffer);
-    vk_core::free_memory(m_vk_handle_buffer_memory);
+    if (block.vk_handle_buffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vk_core::destroy_buffer(block.vk_handle_buffer);
+    vk_core::free_allocation(block.memory_allocation);
+    block = Block {};
 }
 
-int32_t GeometryBuffer::queue_upload(const uint32_t stride, const uint32_t count, std::vector<uint8_t>&& data)
+void GeometryBuffer::insert_free_range(Block& block, VkDeviceSize offset, VkDeviceSize size)
 {
-    const int32_t nth_entity = m_buffer_offset == 0 ? 0 : std::ceil(m_buffer_offset / static_cast<float>(stride));
-    m_buffer_offset = nth_entity * stride;
-    const VkDeviceSize upload_size = count * stride;
+    // Coalesce with the following range.
+    auto next = block.free_range_by_offset.lower_bound(offset);
+    if (next != block.free_range_by_offset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        erase_free_range(block, next->first, next->second);
+        next = block.free_range_by_offset.lower_bound(offset);
+    }
+
+    // Coalesce with the preceding range.
+    if (next != block.free_range_by_offset.begin())
+    {
+        const auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            erase_free_range(block, prev->first, prev->second);
+        }
+    }
+
+    block.free_range_by_offset.emplace(offset, size);
+    block.free_range_by_size.emplace(size, offset);
+}
+
+void GeometryBuffer::erase_free_range(Block& block, const VkDeviceSize offset, const VkDeviceSize size)
+{
+    block.free_range_by_offset.erase(offset);
+
+    auto [first, last] = block.free_range_by_size.equal_range(size);
+    for (; first != last; ++first)
+    {
+        if (first->second == offset)
+        {
+            block.free_range_by_size.erase(first);
+            return;
+        }
+    }
+
+    ASSERT(false, "GeometryBuffer - Free range (%lu, %lu) missing from size index!\n", offset, size);
+}
+
+bool GeometryBuffer::try_allocate(Block& block, const uint32_t alignment, const VkDeviceSize size, VkDeviceSize& offset)
+{
+    // Best fit: smallest free range that still fits once its start is aligned.
+    for (auto iter = block.free_range_by_size.lower_bound(size); iter != block.free_range_by_size.end(); ++iter)
+    {
+        const VkDeviceSize range_size = iter->first;
+        const VkDeviceSize range_offset = iter->second;
+        const VkDeviceSize aligned_offset = align_up(range_offset, alignment);
+
+        if (aligned_offset + size > range_offset + range_size)
+        {
+            continue;
+        }
+
+        erase_free_range(block, range_offset, range_size);
+
+        if (aligned_offset > range_offset)
+        {
+            insert_free_range(block, range_offset, aligned_offset - range_offset);
+        }
+
+        const VkDeviceSize tail_offset = aligned_offset + size;
+        if (tail_offset < range_offset + range_size)
+        {
+            insert_free_range(block, tail_offset, range_offset + range_size - tail_offset);
+        }
+
+        offset = aligned_offset;
+        return true;
+    }
+
+    return false;
+}
+
+bool GeometryBuffer::find_lower_range(const Block& block, const uint32_t alignment, const VkDeviceSize size, const VkDeviceSize limit, VkDeviceSize& offset)
+{
+    // First fit from the start of the block. The destination must end before limit so the
+    // source and destination of the copy never overlap.
+    for (const auto& [range_offset, range_size] : block.free_range_by_offset)
+    {
+        if (range_offset >= limit)
+        {
+            break;
+        }
+
+        const VkDeviceSize aligned_offset = align_up(range_offset, alignment);
+
+        if (aligned_offset + size <= range_offset + range_size && aligned_offset + size <= limit)
+        {
+            offset = aligned_offset;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+GeometryAllocation GeometryBuffer::allocate(const uint32_t block_id, const uint32_t alignment, const VkDeviceSize size, const uint32_t owner_id)
+{
+    Block& block = m_block_list[block_id];
+
+    VkDeviceSize offset = 0;
+    if (!try_allocate(block, alignment, size, offset))
+    {
+        return {};
+    }
+
+    block.used_size += size;
+    block.live_allocation_map.emplace(offset, LiveAllocation{ size, alignment, owner_id, m_frame_epoch });
+
+    return { block_id, offset, size };
+}
+
+void GeometryBuffer::release(const uint32_t block_id, const VkDeviceSize offset, const VkDeviceSize size)
+{
+    Block& block = m_block_list[block_id];
+
+    block.used_size -= size;
+    block.live_allocation_map.erase(offset);
+    insert_free_range(block, offset, size);
+}
+
+void GeometryBuffer::allocate_mesh(const uint32_t owner_id,
+    const uint32_t vertex_stride, const VkDeviceSize vertex_size,
+    const uint32_t index_stride, const VkDeviceSize index_size,
+    GeometryAllocation& vertex_allocation, GeometryAllocation& index_allocation)
+{
+    ASSERT(vertex_stride > 0 && vertex_size > 0, "GeometryBuffer - Mesh %u has no vertex data!\n", owner_id);
+    ASSERT(index_size == 0 || index_stride > 0, "GeometryBuffer - Mesh %u has index data but no index stride!\n", owner_id);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto try_block = [&](const uint32_t block_id) -> bool
+    {
+        vertex_allocation = allocate(block_id, vertex_stride, vertex_size, owner_id);
+        if (vertex_allocation.block_id == UINT32_MAX)
+        {
+            return false;
+        }
+
+        if (index_size == 0)
+        {
+            index_allocation = { block_id, 0, 0 };
+            return true;
+        }
+
+        index_allocation = allocate(block_id, index_stride, index_size, owner_id);
+        if (index_allocation.block_id == UINT32_MAX)
+        {
+            // Never handed out, so it can go straight back to the free list.
+            release(block_id, vertex_allocation.offset, vertex_allocation.size);
+            return false;
+        }
 
-    if (m_buffer_size < m_buffer_offset + upload_size)
+        return true;
+    };
+
+    bool allocated = false;
+    for (uint32_t block_id = 0; block_id < m_block_list.size() && !allocated; ++block_id)
+    {
+        allocated = m_block_list[block_id].vk_handle_buffer != VK_NULL_HANDLE && try_block(block_id);
+    }
+
+    if (!allocated)
     {
-        return -1;
+        const uint32_t block_id = create_block(vertex_size + vertex_stride + index_size + index_stride);
+        allocated = try_block(block_id);
+        ASSERT(allocated, "GeometryBuffer - Failed to allocate mesh %u in a fresh block!\n", owner_id);
     }
 
-    m_queued_upload_list.emplace_back(UploadInfo{
-        m_buffer_offset,
-        upload_size,
-        nullptr,
-        std::move(data)
+    m_stats.allocation_count++;
+    m_stats.total_allocation_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+void GeometryBuffer::free(const GeometryAllocation& allocation)
+{
+    if (allocation.size == 0)
+    {
+        return;
+    }
+
+    Block& block = m_block_list[allocation.block_id];
+    ASSERT(block.live_allocation_map.contains(allocation.offset), "GeometryBuffer - Freeing unknown allocation (%u, %lu)!\n", allocation.block_id, allocation.offset);
+
+    block.used_size -= allocation.size;
+    block.live_allocation_map.erase(allocation.offset);
+    m_pending_free_list.push_back({ allocation.block_id, allocation.offset, allocation.size, m_frame_epoch });
+    m_stats.free_count++;
+}
+
+void GeometryBuffer::advance_frame()
+{
+    m_frame_epoch++;
+
+    const auto retire_end = std::partition(m_pending_free_list.begin(), m_pending_free_list.end(), [this](const PendingFree& pending_free) {
+        return pending_free.frame_epoch + m_frame_resource_count >= m_frame_epoch;
     });
 
-    m_buffer_offset += upload_size;
+    if (retire_end == m_pending_free_list.end())
+    {
+        return;
+    }
+
+    for (auto iter = retire_end; iter != m_pending_free_list.end(); ++iter)
+    {
+        insert_free_range(m_block_list[iter->block_id], iter->offset, iter->size);
+    }
+
+    m_pending_free_list.erase(retire_end, m_pending_free_list.end());
+
+    // Block 0 is kept around so the heap never drops to zero buffers.
+    for (uint32_t block_id = 1; block_id < m_block_list.size(); ++block_id)
+    {
+        Block& block = m_block_list[block_id];
+
+        const bool is_empty = block.vk_handle_buffer != VK_NULL_HANDLE && block.live_allocation_map.empty() &&
+            block.free_range_by_offset.size() == 1 && block.free_range_by_offset.begin()->second == block.size;
+
+        if (is_empty)
+        {
+            destroy_block(block);
+            m_vk_handle_buffer_list[block_id] = VK_NULL_HANDLE;
+        }
+    }
+}
+
+std::vector<GeometryMove> GeometryBuffer::defragment(const VkCommandBuffer vk_handle_cmd_buff, const VkDeviceSize max_move_byte_count)
+{
+    std::vector<GeometryMove> move_list;
+    VkDeviceSize moved_byte_count = 0;
+
+    for (uint32_t block_id = 0; block_id < m_block_list.size() && moved_byte_count < max_move_byte_count; ++block_id)
+    {
+        Block& block = m_block_list[block_id];
+
+        if (block.vk_handle_buffer == VK_NULL_HANDLE || block.free_range_by_offset.empty())
+        {
+            continue;
+        }
+
+        // Walk from the end of the block so live data settles towards the front and the free space towards the back.
+        std::vector<VkDeviceSize> candidate_offset_list;
+        for (auto iter = block.live_allocation_map.rbegin(); iter != block.live_allocation_map.rend(); ++iter)
+        {
+            if (iter->second.frame_epoch < m_frame_epoch)
+            {
+                candidate_offset_list.push_back(iter->first);
+            }
+        }
+
+        // Free ranges below the candidates only shrink during the walk (vacated sources stay pending, the limit drops),
+        // so once (size, alignment) found no range every free range below is shorter than size + alignment - 1 and
+        // larger candidates can be skipped without scanning. Nothing larger than the largest free range fits either.
+        VkDeviceSize max_fitting_size = block.free_range_by_size.rbegin()->first;
+
+        for (const VkDeviceSize src_offset : candidate_offset_list)
+        {
+            const LiveAllocation allocation = block.live_allocation_map.at(src_offset);
+
+            if (moved_byte_count + allocation.size > max_move_byte_count)
+            {
+                break;
+            }
+
+            if (allocation.size > max_fitting_size)
+            {
+                continue;
+            }
 
-    data.clear();
+            VkDeviceSize dst_offset = 0;
+            if (!find_lower_range(block, allocation.alignment, allocation.size, src_offset, dst_offset))
+            {
+                max_fitting_size = std::min(max_fitting_size, allocation.size + allocation.alignment - 2);
+                continue;
+            }
+
+            const auto range_iter = std::prev(block.free_range_by_offset.upper_bound(dst_offset));
+            const VkDeviceSize range_offset = range_iter->first;
+            const VkDeviceSize range_size = range_iter->second;
+
+            erase_free_range(block, range_offset, range_size);
+
+            if (dst_offset > range_offset)
+            {
+                insert_free_range(block, range_offset, dst_offset - range_offset);
+            }
+
+            if (dst_offset + allocation.size < range_offset + range_size)
+            {
+                insert_free_range(block, dst_offset + allocation.size, range_offset + range_size - dst_offset - allocation.size);
+            }
+
+            block.live_allocation_map.erase(src_offset);
+            block.live_allocation_map.emplace(dst_offset, LiveAllocation{ allocation.size, allocation.alignment, allocation.owner_id, m_frame_epoch });
+            m_pending_free_list.push_back({ block_id, src_offset, allocation.size, m_frame_epoch });
+
+            move_list.push_back({ allocation.owner_id, block_id, src_offset, dst_offset, allocation.size });
+            moved_byte_count += allocation.size;
+        }
+    }
+
+    if (move_list.empty())
+    {
+        return move_list;
+    }
+
+    // Staging copies and vertex fetches from earlier submissions must be done with the source ranges,
+    // and retired destination ranges may still be read by the vertex input stage.
+    const VkMemoryBarrier pre_copy_barrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+
+    vkCmdPipelineBarrier(
+        vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0x0,
+        1, &pre_copy_barrier,
+        0, nullptr,
+        0, nullptr);
+
+    for (uint32_t block_id = 0; block_id < m_block_list.size(); ++block_id)
+    {
+        std::vector<VkBufferCopy> copy_list;
+
+        for (const GeometryMove& move : move_list)
+        {
+            if (move.block_id == block_id)
+            {
+                copy_list.push_back({ move.src_offset, move.dst_offset, move.size });
+            }
+        }
+
+        if (!copy_list.empty())
+        {
+            const VkBuffer vk_handle_buffer = m_block_list[block_id].vk_handle_buffer;
+            vkCmdCopyBuffer(vk_handle_cmd_buff, vk_handle_buffer, vk_handle_buffer, static_cast<uint32_t>(copy_list.size()), copy_list.data());
+        }
+    }
+
+    const VkMemoryBarrier post_copy_barrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
+    };
+
+    vkCmdPipelineBarrier(
+        vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0x0,
+        1, &post_copy_barrier,
+        0, nullptr,
+        0, nullptr);
+
+    m_stats.moved_byte_count += moved_byte_count;
+
+    return move_list;
+}
+
+GeometryHeapStats GeometryBuffer::get_stats() const
+{
+    GeometryHeapStats stats = m_stats;
+
+    for (const Block& block : m_block_list)
+    {
+        if (block.vk_handle_buffer == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        stats.block_count++;
+        stats.total_byte_count += block.size;
+        stats.used_byte_count += block.used_size;
+        stats.free_range_count += static_cast<uint32_t>(block.free_range_by_offset.size());
+
+        for (const auto& [range_offset, range_size] : block.free_range_by_offset)
+        {
+            stats.free_byte_count += range_size;
+        }
+
+        if (!block.free_range_by_size.empty())
+        {
+            stats.largest_free_range = std::max(stats.largest_free_range, block.free_range_by_size.rbegin()->first);
+        }
+    }
+
+    for (const PendingFree& pending_free : m_pending_free_list)
+    {
+        stats.pending_free_byte_count += pending_free.size;
+    }
 
-    return nth_entity;
+    return stats;
 }
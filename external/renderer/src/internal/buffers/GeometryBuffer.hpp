@@ -1,33 +1,141 @@
 #ifndef RENDERER_GEOMETRY_BUFFER_HPP
 #define RENDERER_GEOMETRY_BUFFER_HPP
 
-#include "../pod/UploadInfo.hpp"
+#include "vk_core.hpp"
 
 #include <vulkan/vulkan.h>
 
+#include <map>
 #include <vector>
-#include <cmath>
 
+struct GeometryAllocation
+{
+    uint32_t block_id = UINT32_MAX;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+};
+
+// A live allocation moved by GeometryBuffer::defragment. owner_id is the id passed to allocate_mesh.
+struct GeometryMove
+{
+    uint32_t owner_id;
+    uint32_t block_id;
+    VkDeviceSize src_offset;
+    VkDeviceSize dst_offset;
+    VkDeviceSize size;
+};
+
+struct GeometryHeapStats
+{
+    uint32_t block_count = 0;
+    VkDeviceSize total_byte_count = 0;
+    VkDeviceSize used_byte_count = 0;
+    VkDeviceSize free_byte_count = 0;
+    VkDeviceSize pending_free_byte_count = 0;
+    VkDeviceSize largest_free_range = 0;
+    uint32_t free_range_count = 0;
+    uint64_t allocation_count = 0;
+    uint64_t free_count = 0;
+    uint64_t moved_byte_count = 0;
+    uint64_t total_allocation_ns = 0;
+};
+
+// Paged vertex / index heap. Each block is its own VkBuffer carved up by an offset ordered free list
+// (best fit lookup through a size ordered index, neighbours coalesced on release).
+// Blocks are added on demand, so allocations never fail, and released again once they run empty.
+//
+// Vertex and index ranges of a mesh always share a block so a single vertex + index buffer binding covers a draw.
+// Offsets are aligned to the element stride, keeping vertex_offset / first_index integral.
+//
+// Ranges released through free() or vacated by defragment() may still be read by frames in flight.
+// They are only returned to the free list after frame_resource_count calls to advance_frame().
 struct GeometryBuffer
 {
 private:
-    VkBuffer m_vk_handle_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_vk_handle_buffer_memory = VK_NULL_HANDLE;
-    VkDeviceSize m_buffer_size = 0;
-    VkDeviceSize m_buffer_offset = 0;
+protected:
+
+    struct LiveAllocation
+    {
+        VkDeviceSize size;
+        uint32_t alignment;
+        uint32_t owner_id;
+        uint64_t frame_epoch;
+    };
+
+    struct Block
+    {
+        VkBuffer vk_handle_buffer = VK_NULL_HANDLE;
+        vk_core::MemoryAllocation memory_allocation {};
+        VkDeviceSize size = 0;
+        VkDeviceSize used_size = 0;
 
-    std::vector<UploadInfo> m_queued_upload_list;
+        std::map<VkDeviceSize, VkDeviceSize> free_range_by_offset; // offset -> size
+        std::multimap<VkDeviceSize, VkDeviceSize> free_range_by_size; // size -> offset
+        std::map<VkDeviceSize, LiveAllocation> live_allocation_map; // offset -> allocation
+    };
+
+    struct PendingFree
+    {
+        uint32_t block_id;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        uint64_t frame_epoch;
+    };
+
+    VkDeviceSize m_block_size = 0;
+    uint32_t m_frame_resource_count = 0;
+    uint64_t m_frame_epoch = 0;
+
+    std::vector<Block> m_block_list;
+    std::vector<VkBuffer> m_vk_handle_buffer_list; // mirrors m_block_list, VK_NULL_HANDLE for released blocks
+    std::vector<PendingFree> m_pending_free_list;
+
+    GeometryHeapStats m_stats {};
+
+    uint32_t create_block(const VkDeviceSize min_size);
+    void destroy_block(Block& block);
+
+    static void insert_free_range(Block& block, VkDeviceSize offset, VkDeviceSize size);
+    static void erase_free_range(Block& block, const VkDeviceSize offset, const VkDeviceSize size);
+    static bool try_allocate(Block& block, const uint32_t alignment, const VkDeviceSize size, VkDeviceSize& offset);
+    static bool find_lower_range(const Block& block, const uint32_t alignment, const VkDeviceSize size, const VkDeviceSize limit, VkDeviceSize& offset);
+
+    GeometryAllocation allocate(const uint32_t block_id, const uint32_t alignment, const VkDeviceSize size, const uint32_t owner_id);
+    void release(const uint32_t block_id, const VkDeviceSize offset, const VkDeviceSize size);
 
 public:
-    GeometryBuffer(const uint64_t size);
+    GeometryBuffer(const VkDeviceSize block_size, const uint32_t frame_resource_count);
     ~GeometryBuffer();
 
-    int32_t queue_upload(const uint32_t stride, const uint32_t count, std::vector<uint8_t>&& data);
+    GeometryBuffer(const GeometryBuffer&) = delete;
+    GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+    GeometryBuffer(GeometryBuffer&&) = delete;
+    GeometryBuffer& operator=(GeometryBuffer&&) = delete;
+
+    // Allocates the vertex and index ranges of a mesh inside the same block.
+    // index_size may be 0 for non-indexed meshes, index_allocation is then left empty.
+    void allocate_mesh(const uint32_t owner_id,
+        const uint32_t vertex_stride, const VkDeviceSize vertex_size,
+        const uint32_t index_stride, const VkDeviceSize index_size,
+        GeometryAllocation& vertex_allocation, GeometryAllocation& index_allocation);
+
+    // Deferred release, see advance_frame().
+    void free(const GeometryAllocation& allocation);
+
+    // Marks the end of a frame's uploads. Retires pending frees older than frame_resource_count frames
+    // and destroys blocks that ran empty.
+    void advance_frame();
+
+    // Moves up to max_move_byte_count bytes of live allocations into lower free ranges of their block,
+    // recording the copies (framed by the required barriers) into vk_handle_cmd_buff.
+    // Only allocations uploaded in a previous frame are moved. The caller must patch everything that refers
+    // to a moved range before the command buffer draws with it.
+    std::vector<GeometryMove> defragment(const VkCommandBuffer vk_handle_cmd_buff, const VkDeviceSize max_move_byte_count);
 
-    std::vector<UploadInfo>&& get_queued_uploads() { return std::move(m_queued_upload_list); }
-    void reset_queued_uploads() { m_queued_upload_list.clear(); }
+    GeometryHeapStats get_stats() const;
 
-    VkBuffer get_vk_handle_buffer() const { return m_vk_handle_buffer; }
+    VkBuffer get_vk_handle_buffer(const uint32_t block_id) const { return m_vk_handle_buffer_list[block_id]; }
+    const std::vector<VkBuffer>& get_vk_handle_buffer_list() const { return m_vk_handle_buffer_list; }
 };
 
-#endif // RENDERER_GEOMETRY_BUFFER_HPP
\ No newline at end of file
+#endif // RENDERER_GEOMETRY_BUFFER_HPP
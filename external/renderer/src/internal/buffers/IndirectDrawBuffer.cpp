@@ -0,0 +1,349 @@
+#include "IndirectDrawBuffer.hpp"
+#include "StagingBuffer.hpp"
+#include "../misc/logger.hpp"
+#include "vk_core.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+IndirectDrawBuffer::IndirectDrawBuffer(const uint32_t sortbin_count, const uint32_t frame_resource_count)
+    : m_frame_resource_count { frame_resource_count }
+    , m_frame_generation_list(frame_resource_count, 0)
+{
+    m_stream_list.resize(static_cast<size_t>(sortbin_count) * s_stream_per_sortbin_count);
+
+    for (uint32_t stream_idx = 0; stream_idx < m_stream_list.size(); stream_idx++)
+    {
+        Stream& stream = m_stream_list[stream_idx];
+        const bool is_indexed = (stream_idx % s_stream_per_sortbin_count) != s_stream_per_sortbin_count - 1;
+
+        stream.command_stride = is_indexed ? sizeof(VkDrawIndexedIndirectCommand) : sizeof(VkDrawIndirectCommand);
+        stream.command_data.resize(s_count_header_size, 0);
+        stream.frame_buffer_list.resize(frame_resource_count);
+    }
+}
+
+IndirectDrawBuffer::~IndirectDrawBuffer()
+{
+    for (const Stream& stream : m_stream_list)
+    {
+        for (const FrameBuffer& frame_buffer : stream.frame_buffer_list)
+        {
+            if (frame_buffer.vk_handle_buffer != VK_NULL_HANDLE)
+            {
+                vk_core::destroy_buffer(frame_buffer.vk_handle_buffer);
+                vk_core::free_allocation(frame_buffer.memory_allocation);
+            }
+        }
+    }
+
+    for (const RetiredBuffer& retired_buffer : m_retired_buffer_list)
+    {
+        vk_core::destroy_buffer(retired_buffer.vk_handle_buffer);
+        vk_core::free_allocation(retired_buffer.memory_allocation);
+    }
+}
+
+uint32_t IndirectDrawBuffer::get_stream_idx(const uint16_t sortbin_id, const VkIndexType index_type)
+{
+    uint32_t type_idx = 0;
+
+    switch (index_type)
+    {
+        case VK_INDEX_TYPE_UINT32:
+        {
+            type_idx = 0;
+            break;
+        }
+        case VK_INDEX_TYPE_UINT16:
+        {
+            type_idx = 1;
+            break;
+        }
+        case VK_INDEX_TYPE_UINT8_EXT:
+        {
+            type_idx = 2;
+            break;
+        }
+        default:
+        {
+            type_idx = 3;
+            break;
+        }
+    }
+
+    return static_cast<uint32_t>(sortbin_id) * s_stream_per_sortbin_count + type_idx;
+}
+
+void IndirectDrawBuffer::encode_command(Stream& stream, const uint32_t command_idx, const DrawInfo& draw_info)
+{
+    uint8_t* const p_command = stream.command_data.data() + s_count_header_size + static_cast<size_t>(command_idx) * stream.command_stride;
+
+    if (stream.command_stride == sizeof(VkDrawIndexedIndirectCommand))
+    {
+        const VkDrawIndexedIndirectCommand command {
+            .indexCount = draw_info.index_count,
+            .instanceCount = draw_info.instance_count,
+            .firstIndex = draw_info.first_index,
+            .vertexOffset = draw_info.vertex_offset,
+            .firstInstance = draw_info.first_instance,
+        };
+
+        memcpy(p_command, &command, sizeof(command));
+    }
+    else
+    {
+        const VkDrawIndirectCommand command {
+            .vertexCount = draw_info.vertex_count,
+            .instanceCount = draw_info.instance_count,
+            .firstVertex = draw_info.first_vertex,
+            .firstInstance = draw_info.first_instance,
+        };
+
+        memcpy(p_command, &command, sizeof(command));
+    }
+}
+
+void IndirectDrawBuffer::write_command(Stream& stream, const uint32_t command_idx, const DrawInfo& draw_info)
+{
+    encode_command(stream, command_idx, draw_info);
+    stream.instance_count += draw_info.instance_count;
+
+    // Consecutive draws of the same geometry block share a run.
+    if (!stream.run_list.empty() && stream.run_list.back().geometry_block_id == draw_info.geometry_block_id &&
+        stream.run_list.back().first_command + stream.run_list.back().command_count == command_idx)
+    {
+        stream.run_list.back().command_count++;
+    }
+    else
+    {
+        stream.run_list.push_back({ draw_info.geometry_block_id, command_idx, 1 });
+    }
+}
+
+void IndirectDrawBuffer::mark_dirty(Stream& stream, const uint32_t first_command, const uint32_t command_count)
+{
+    for (FrameBuffer& frame_buffer : stream.frame_buffer_list)
+    {
+        frame_buffer.is_count_dirty = true;
+
+        if (command_count == 0)
+        {
+            continue;
+        }
+
+        mark_dirty_chunks(frame_buffer, first_command / s_dirty_chunk_command_count, (first_command + command_count - 1) / s_dirty_chunk_command_count + 1);
+    }
+}
+
+void IndirectDrawBuffer::mark_dirty_chunks(FrameBuffer& frame_buffer, const uint32_t chunk_begin, const uint32_t chunk_end)
+{
+    if (frame_buffer.dirty_chunk_bitmap.size() * 64 < chunk_end)
+    {
+        frame_buffer.dirty_chunk_bitmap.resize((chunk_end + 63) / 64, 0);
+    }
+
+    for (uint32_t chunk = chunk_begin; chunk < chunk_end; chunk++)
+    {
+        frame_buffer.dirty_chunk_bitmap[chunk / 64] |= 1ull << (chunk % 64);
+    }
+
+    frame_buffer.dirty_chunk_begin = std::min(frame_buffer.dirty_chunk_begin, chunk_begin);
+    frame_buffer.dirty_chunk_end = std::max(frame_buffer.dirty_chunk_end, chunk_end);
+}
+
+void IndirectDrawBuffer::append(const uint16_t sortbin_id, const VkIndexType index_type, const DrawInfo& draw_info)
+{
+    Stream& stream = m_stream_list[get_stream_idx(sortbin_id, index_type)];
+
+    stream.command_data.resize(stream.command_data.size() + stream.command_stride);
+    write_command(stream, stream.command_count, draw_info);
+
+    mark_dirty(stream, stream.command_count, 1);
+    stream.command_count++;
+    stream.layout_generation++;
+}
+
+void IndirectDrawBuffer::update(const uint16_t sortbin_id, const VkIndexType index_type, const uint32_t command_idx, const DrawInfo& draw_info)
+{
+    Stream& stream = m_stream_list[get_stream_idx(sortbin_id, index_type)];
+    ASSERT(command_idx < stream.command_count, "IndirectDrawBuffer::update - Command %u out of range!\n", command_idx);
+
+    // instanceCount sits at the same offset in both command layouts.
+    uint32_t prev_instance_count = 0;
+    memcpy(&prev_instance_count, stream.command_data.data() + s_count_header_size + static_cast<size_t>(command_idx) * stream.command_stride + offsetof(VkDrawIndirectCommand, instanceCount), sizeof(uint32_t));
+
+    encode_command(stream, command_idx, draw_info);
+    stream.instance_count = stream.instance_count - prev_instance_count + draw_info.instance_count;
+
+    mark_dirty(stream, command_idx, 1);
+}
+
+void IndirectDrawBuffer::rebuild(const uint16_t sortbin_id, const VkIndexType index_type, const std::vector<DrawInfo>& draw_list)
+{
+    Stream& stream = m_stream_list[get_stream_idx(sortbin_id, index_type)];
+
+    stream.command_count = static_cast<uint32_t>(draw_list.size());
+    stream.command_data.resize(s_count_header_size + static_cast<size_t>(stream.command_count) * stream.command_stride);
+    stream.instance_count = 0;
+    stream.run_list.clear();
+
+    for (uint32_t command_idx = 0; command_idx < stream.command_count; command_idx++)
+    {
+        write_command(stream, command_idx, draw_list[command_idx]);
+    }
+
+    mark_dirty(stream, 0, stream.command_count);
+    stream.layout_generation++;
+}
+
+void IndirectDrawBuffer::resize_frame_buffer(FrameBuffer& frame_buffer, const VkDeviceSize min_size)
+{
+    // Copies queued earlier this frame may still target the old buffer.
+    if (frame_buffer.vk_handle_buffer != VK_NULL_HANDLE)
+    {
+        m_retired_buffer_list.push_back({ frame_buffer.vk_handle_buffer, frame_buffer.memory_allocation, m_frame_epoch });
+    }
+
+    const VkDeviceSize size = std::bit_ceil(std::max(min_size, s_min_buffer_size));
+
+    const VkBufferCreateInfo buffer_create_info {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .size = size,
+        .usage = (VkBufferUsageFlags)(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+    };
+
+    frame_buffer.vk_handle_buffer = vk_core::create_buffer(buffer_create_info);
+    frame_buffer.memory_allocation = vk_core::allocate_and_bind_buffer_memory(frame_buffer.vk_handle_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    frame_buffer.size = size;
+}
+
+bool IndirectDrawBuffer::queue_uploads(const uint32_t frame_resource_idx, StagingBuffer& staging_buffer)
+{
+    bool has_uploads = false;
+
+    for (Stream& stream : m_stream_list)
+    {
+        FrameBuffer& frame_buffer = stream.frame_buffer_list[frame_resource_idx];
+
+        if (!frame_buffer.is_count_dirty)
+        {
+            continue;
+        }
+
+        const VkDeviceSize required_size = stream.command_data.size();
+
+        if (frame_buffer.size < required_size)
+        {
+            resize_frame_buffer(frame_buffer, required_size);
+            mark_dirty_chunks(frame_buffer, 0, (stream.command_count + s_dirty_chunk_command_count - 1) / s_dirty_chunk_command_count);
+            m_frame_generation_list[frame_resource_idx]++;
+        }
+        else if (frame_buffer.uploaded_layout_generation != stream.layout_generation)
+        {
+            m_frame_generation_list[frame_resource_idx]++;
+        }
+
+        // One copy per run of dirty chunks. Commands past the end of a shrunk stream are left as they are, the count
+        // never reaches them.
+        const auto is_chunk_dirty = [&](const uint32_t chunk_idx) { return (frame_buffer.dirty_chunk_bitmap[chunk_idx / 64] >> (chunk_idx % 64)) & 1; };
+        uint32_t chunk = frame_buffer.dirty_chunk_begin;
+
+        while (chunk < frame_buffer.dirty_chunk_end)
+        {
+            if (!is_chunk_dirty(chunk))
+            {
+                chunk++;
+                continue;
+            }
+
+            const uint32_t run_begin = chunk;
+            uint32_t run_end = chunk;
+
+            // Runs separated by at most s_merge_gap_chunk_count clean chunks share a copy.
+            while (chunk < frame_buffer.dirty_chunk_end && chunk <= run_end + s_merge_gap_chunk_count)
+            {
+                if (is_chunk_dirty(chunk))
+                {
+                    run_end = chunk + 1;
+                }
+
+                chunk++;
+            }
+
+            chunk = run_end;
+
+            const uint32_t first_command = run_begin * s_dirty_chunk_command_count;
+            const uint32_t end_command = std::min(run_end * s_dirty_chunk_command_count, stream.command_count);
+
+            if (first_command < end_command)
+            {
+                const VkDeviceSize dst_offset = s_count_header_size + static_cast<VkDeviceSize>(first_command) * stream.command_stride;
+                const VkDeviceSize upload_size = static_cast<VkDeviceSize>(end_command - first_command) * stream.command_stride;
+
+                staging_buffer.queue_upload(frame_buffer.vk_handle_buffer, dst_offset, upload_size, stream.command_data.data() + dst_offset);
+            }
+        }
+
+        if (frame_buffer.dirty_chunk_begin < frame_buffer.dirty_chunk_end)
+        {
+            std::fill(frame_buffer.dirty_chunk_bitmap.begin() + frame_buffer.dirty_chunk_begin / 64,
+                frame_buffer.dirty_chunk_bitmap.begin() + (frame_buffer.dirty_chunk_end + 63) / 64, 0);
+        }
+
+        memcpy(stream.command_data.data(), &stream.command_count, sizeof(uint32_t));
+        staging_buffer.queue_upload(frame_buffer.vk_handle_buffer, 0, sizeof(uint32_t), stream.command_data.data());
+
+        frame_buffer.dirty_chunk_begin = UINT32_MAX;
+        frame_buffer.dirty_chunk_end = 0;
+        frame_buffer.is_count_dirty = false;
+        frame_buffer.uploaded_layout_generation = stream.layout_generation;
+        frame_buffer.uploaded_command_count = stream.command_count;
+        frame_buffer.uploaded_instance_count = stream.instance_count;
+        frame_buffer.uploaded_run_list = stream.run_list;
+
+        has_uploads = true;
+    }
+
+    return has_uploads;
+}
+
+void IndirectDrawBuffer::advance_frame()
+{
+    m_frame_epoch++;
+
+    std::erase_if(m_retired_buffer_list, [this](const RetiredBuffer& retired_buffer) {
+        if (retired_buffer.frame_epoch + m_frame_resource_count < m_frame_epoch)
+        {
+            vk_core::destroy_buffer(retired_buffer.vk_handle_buffer);
+            vk_core::free_allocation(retired_buffer.memory_allocation);
+            return true;
+        }
+        return false;
+    });
+}
+
+IndirectDrawStream IndirectDrawBuffer::get_stream(const uint16_t sortbin_id, const VkIndexType index_type, const uint32_t frame_resource_idx) const
+{
+    const Stream& stream = m_stream_list[get_stream_idx(sortbin_id, index_type)];
+    const FrameBuffer& frame_buffer = stream.frame_buffer_list[frame_resource_idx];
+
+    const IndirectDrawStream indirect_draw_stream {
+        .vk_handle_buffer = frame_buffer.vk_handle_buffer,
+        .count_offset = 0,
+        .command_offset = s_count_header_size,
+        .command_stride = stream.command_stride,
+        .command_count = frame_buffer.uploaded_command_count,
+        .instance_count = frame_buffer.uploaded_instance_count,
+        .p_run_list = &frame_buffer.uploaded_run_list,
+    };
+
+    return indirect_draw_stream;
+}
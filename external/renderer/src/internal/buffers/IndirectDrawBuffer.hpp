@@ -0,0 +1,133 @@
+#ifndef RENDERER_INDIRECT_DRAW_BUFFER_HPP
+#define RENDERER_INDIRECT_DRAW_BUFFER_HPP
+
+#include "../pod/DrawInfo.hpp"
+
+#include "vk_core.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <inttypes.h>
+#include <vector>
+
+struct StagingBuffer;
+
+// Consecutive commands of a stream that read from the same geometry block, drawn with a single indirect call.
+struct IndirectDrawRun
+{
+    uint32_t geometry_block_id;
+    uint32_t first_command;
+    uint32_t command_count;
+    uint32_t count_slot = UINT32_MAX; // GPU written draw count at count_offset + 4 * count_slot, command_count being the maximum
+};
+
+// Device copy of one stream as of its frame's last queue_uploads().
+struct IndirectDrawStream
+{
+    VkBuffer vk_handle_buffer = VK_NULL_HANDLE;
+    VkDeviceSize count_offset = 0;
+    VkDeviceSize command_offset = 0;
+    uint32_t command_stride = 0;
+    uint32_t command_count = 0;
+    uint32_t instance_count = 0; // summed over all commands
+    const std::vector<IndirectDrawRun>* p_run_list = nullptr;
+};
+
+// Indirect draw commands mirroring the draw lists of every sortbin, one stream per sortbin and index type
+// (VK_INDEX_TYPE_MAX_ENUM selects the non-indexed stream). Each stream owns one buffer per frame resource laid out as
+// [uint32 command count, padded to s_count_header_size][VkDrawIndexedIndirectCommand or VkDrawIndirectCommand ...],
+// so the count can also be consumed as a vkCmdDraw*IndirectCount count buffer.
+//
+// append() / update() only dirty the chunk of commands they write, rebuild() the whole stream. queue_uploads() stages
+// each frame's runs of dirty chunks and regrows that frame's buffer when needed. Replaced buffers are destroyed frame_resource_count calls to
+// advance_frame() later.
+struct IndirectDrawBuffer
+{
+private:
+protected:
+
+    static constexpr uint32_t s_stream_per_sortbin_count = 4; // u32, u16, u8, non-indexed
+    static constexpr VkDeviceSize s_count_header_size = 16;
+    static constexpr VkDeviceSize s_min_buffer_size = 1 << 12;
+    // Dirty state is one bit per chunk of s_dirty_chunk_command_count commands (160 bytes of indexed commands).
+    // Uploads merge runs of dirty chunks separated by at most s_merge_gap_chunk_count clean ones, so scattered
+    // update()s cost a few dozen copy regions per stream instead of re-uploading everything between them.
+    static constexpr uint32_t s_dirty_chunk_command_count = 8;
+    static constexpr uint32_t s_merge_gap_chunk_count = 4;
+
+    struct FrameBuffer
+    {
+        VkBuffer vk_handle_buffer = VK_NULL_HANDLE;
+        vk_core::MemoryAllocation memory_allocation {};
+        VkDeviceSize size = 0;
+
+        std::vector<uint64_t> dirty_chunk_bitmap;
+        uint32_t dirty_chunk_begin = UINT32_MAX; // bounds of the set bits
+        uint32_t dirty_chunk_end = 0;
+        bool is_count_dirty = false;
+
+        uint64_t uploaded_layout_generation = 0;
+        uint32_t uploaded_command_count = 0;
+        uint32_t uploaded_instance_count = 0;
+        std::vector<IndirectDrawRun> uploaded_run_list;
+    };
+
+    struct RetiredBuffer
+    {
+        VkBuffer vk_handle_buffer;
+        vk_core::MemoryAllocation memory_allocation;
+        uint64_t frame_epoch;
+    };
+
+    struct Stream
+    {
+        uint32_t command_stride = 0;
+        uint32_t command_count = 0;
+        uint32_t instance_count = 0;
+        uint64_t layout_generation = 0; // bumped by append() / rebuild(), which change the command count or runs
+        std::vector<uint8_t> command_data;
+        std::vector<IndirectDrawRun> run_list;
+        std::vector<FrameBuffer> frame_buffer_list;
+    };
+
+    const uint32_t m_frame_resource_count = 0;
+    uint64_t m_frame_epoch = 0;
+    std::vector<uint64_t> m_frame_generation_list; // per frame resource, see get_frame_generation()
+
+    std::vector<Stream> m_stream_list;
+    std::vector<RetiredBuffer> m_retired_buffer_list;
+
+    static uint32_t get_stream_idx(const uint16_t sortbin_id, const VkIndexType index_type);
+    static void encode_command(Stream& stream, const uint32_t command_idx, const DrawInfo& draw_info);
+    static void write_command(Stream& stream, const uint32_t command_idx, const DrawInfo& draw_info);
+    static void mark_dirty(Stream& stream, const uint32_t first_command, const uint32_t command_count);
+    static void mark_dirty_chunks(FrameBuffer& frame_buffer, const uint32_t chunk_begin, const uint32_t chunk_end);
+
+    void resize_frame_buffer(FrameBuffer& frame_buffer, const VkDeviceSize min_size);
+
+public:
+    IndirectDrawBuffer(const uint32_t sortbin_count, const uint32_t frame_resource_count);
+    ~IndirectDrawBuffer();
+
+    IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+    IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+    IndirectDrawBuffer(IndirectDrawBuffer&&) = delete;
+    IndirectDrawBuffer& operator=(IndirectDrawBuffer&&) = delete;
+
+    void append(const uint16_t sortbin_id, const VkIndexType index_type, const DrawInfo& draw_info);
+    // Rewrites command_idx in place. The draw must stay in the same geometry block (instance count / range changes).
+    void update(const uint16_t sortbin_id, const VkIndexType index_type, const uint32_t command_idx, const DrawInfo& draw_info);
+    // Replaces the stream with draw_list, for edits other than appends (removals, patched offsets).
+    void rebuild(const uint16_t sortbin_id, const VkIndexType index_type, const std::vector<DrawInfo>& draw_list);
+
+    // Must only be called while no submission using frame_resource_idx is pending.
+    bool queue_uploads(const uint32_t frame_resource_idx, StagingBuffer& staging_buffer);
+    void advance_frame();
+
+    IndirectDrawStream get_stream(const uint16_t sortbin_id, const VkIndexType index_type, const uint32_t frame_resource_idx) const;
+    // Changes whenever queue_uploads() alters what get_stream() returns for frame_resource_idx beyond the command
+    // contents (buffer, command count, runs), so draws recorded from its streams must be recorded again.
+    uint64_t get_frame_generation(const uint32_t frame_resource_idx) const { return m_frame_generation_list[frame_resource_idx]; }
+};
+
+#endif // RENDERER_INDIRECT_DRAW_BUFFER_HPP
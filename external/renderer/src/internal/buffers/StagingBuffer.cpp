@@ -1,13 +1,20 @@
 #include "StagingBuffer.hpp"
+#include "../misc/logger.hpp"
+#include "../misc/stream_memcpy.hpp"
 #include "vk_core.hpp"
 
-StagingBuffer::StagingBuffer(const VkDeviceSize size)
+#include <algorithm>
+
+StagingBuffer::StagingBuffer(const VkDeviceSize region_size, const uint32_t region_count)
+    : m_region_size { region_size }
 {
+    ASSERT(region_count > 0, "StagingBuffer - Region count must be non-zero!\n");
+
     const VkBufferCreateInfo buffer_create_info {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0x0,
-        .size = size,
+        .size = region_size * region_count,
         .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 0,
@@ -15,41 +22,353 @@ StagingBuffer::StagingBuffer(const VkDeviceSize size)
     };
 
     m_vk_handle_buffer = vk_core::create_buffer(buffer_create_info);
-    m_vk_handle_memory = vk_core::allocate_buffer_memory(m_vk_handle_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_buffer_size);
-    vk_core::bind_buffer_memory(m_vk_handle_buffer, m_vk_handle_memory);
-    vk_core::map_memory(m_vk_handle_memory, 0, m_buffer_size, 0x0, (void**)&m_mapped_ptr);
+    m_memory_allocation = vk_core::allocate_and_bind_buffer_memory(m_vk_handle_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_mapped_ptr = static_cast<uint8_t*>(m_memory_allocation.mapped_ptr);
+
+    m_region_list.resize(region_count);
+
+    for (uint32_t i = 0; i < region_count; i++)
+    {
+        Region& region = m_region_list[i];
+
+        region.ring_chunk.vk_handle_buffer = m_vk_handle_buffer;
+        region.ring_chunk.mapped_ptr = m_mapped_ptr + i * region_size;
+        region.ring_chunk.base_offset = i * region_size;
+        region.ring_chunk.size = region_size;
+        region.vk_handle_transfer_cmd_pool = vk_core::create_transfer_command_pool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        region.vk_handle_transfer_cmd_buff = vk_core::allocate_command_buffer(region.vk_handle_transfer_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    }
+
+    m_vk_handle_timeline_sem4 = vk_core::create_timeline_semaphore(m_timeline_value);
+    m_vk_handle_retire_sem4 = vk_core::create_timeline_semaphore(m_retire_value);
 }
 
 StagingBuffer::~StagingBuffer()
 {
-    vk_core::unmap_memory(m_vk_handle_memory);
+    for (const Region& region : m_region_list)
+    {
+        for (const Chunk& chunk : region.overflow_chunk_list)
+        {
+            destroy_overflow_chunk(chunk);
+        }
+
+        vk_core::destroy_command_pool(region.vk_handle_transfer_cmd_pool);
+    }
+
+    vk_core::destroy_semaphore(m_vk_handle_timeline_sem4);
+    vk_core::destroy_semaphore(m_vk_handle_retire_sem4);
+
     vk_core::destroy_buffer(m_vk_handle_buffer);
-    vk_core::free_memory(m_vk_handle_memory);
+    vk_core::free_allocation(m_memory_allocation);
 }
 
-void StagingBuffer::queue_upload(const VkBuffer vk_handle_dst_buffer, const VkDeviceSize dst_offset, const VkDeviceSize upload_size, const void* const data)
+StagingBuffer::Chunk StagingBuffer::create_overflow_chunk(const VkDeviceSize size)
+{
+    const VkBufferCreateInfo buffer_create_info {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .size = size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+    };
+
+    Chunk chunk {};
+
+    chunk.vk_handle_buffer = vk_core::create_buffer(buffer_create_info);
+    chunk.memory_allocation = vk_core::allocate_and_bind_buffer_memory(chunk.vk_handle_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    chunk.mapped_ptr = static_cast<uint8_t*>(chunk.memory_allocation.mapped_ptr);
+    chunk.size = size;
+
+    return chunk;
+}
+
+void StagingBuffer::destroy_overflow_chunk(const Chunk& chunk)
+{
+    vk_core::destroy_buffer(chunk.vk_handle_buffer);
+    vk_core::free_allocation(chunk.memory_allocation);
+}
+
+void StagingBuffer::reclaim_region(Region& region)
 {
-    memcpy(m_mapped_ptr + m_buffer_offset, data, upload_size); 
+    if (!region.in_flight)
+    {
+        return;
+    }
+
+    vk_core::wait_semaphore(region.vk_handle_retire_sem4, region.retire_value, UINT64_MAX);
+    vk_core::reset_command_pool(region.vk_handle_transfer_cmd_pool);
+
+    for (const Chunk& chunk : region.overflow_chunk_list)
+    {
+        destroy_overflow_chunk(chunk);
+    }
+
+    region.overflow_chunk_list.clear();
+    region.ring_chunk.offset = 0;
+    region.in_flight = false;
+}
+
+StagingBuffer::Chunk& StagingBuffer::get_chunk(Region& region, const uint32_t chunk_idx)
+{
+    return chunk_idx == s_ring_chunk_idx ? region.ring_chunk : region.overflow_chunk_list[chunk_idx];
+}
+
+StagingAllocation StagingBuffer::allocate(const VkDeviceSize size)
+{
+    Region& region = m_region_list[m_active_region_idx];
+    reclaim_region(region);
+
+    uint32_t chunk_idx = s_ring_chunk_idx;
+
+    if (region.ring_chunk.offset + size > region.ring_chunk.size)
+    {
+        chunk_idx = static_cast<uint32_t>(region.overflow_chunk_list.size()) - 1;
+
+        if (region.overflow_chunk_list.empty() || region.overflow_chunk_list.back().offset + size > region.overflow_chunk_list.back().size)
+        {
+            // LOG("StagingBuffer - Region %u full, spilling %lu bytes to overflow chunk\n", m_active_region_idx, size);
+            region.overflow_chunk_list.push_back(create_overflow_chunk(std::max(size, m_region_size)));
+            chunk_idx = static_cast<uint32_t>(region.overflow_chunk_list.size()) - 1;
+        }
+    }
+
+    Chunk& chunk = get_chunk(region, chunk_idx);
+
+    const StagingAllocation allocation {
+        .mapped_ptr = chunk.mapped_ptr + chunk.offset,
+        .src_offset = chunk.base_offset + chunk.offset,
+        .size = size,
+        .region_idx = m_active_region_idx,
+        .chunk_idx = chunk_idx,
+        .region_generation = region.generation,
+    };
+
+    chunk.offset += size;
+
+    return allocation;
+}
+
+void StagingBuffer::commit(const StagingAllocation& allocation, const VkBuffer vk_handle_dst_buffer, const VkDeviceSize dst_offset)
+{
+    if (allocation.size == 0)
+    {
+        return;
+    }
+
+    Region& region = m_region_list[allocation.region_idx];
+    ASSERT(allocation.region_idx == m_active_region_idx && allocation.region_generation == region.generation, "StagingBuffer - Committing an allocation whose region was already flushed!\n");
 
     const VkBufferCopy buffer_copy {
-        .srcOffset = m_buffer_offset,
+        .srcOffset = allocation.src_offset,
         .dstOffset = dst_offset,
-        .size = upload_size,
+        .size = allocation.size,
+    };
+
+    get_chunk(region, allocation.chunk_idx).dst_buffer_copy_map[vk_handle_dst_buffer].push_back(buffer_copy);
+}
+
+void StagingBuffer::queue_upload(const VkBuffer vk_handle_dst_buffer, const VkDeviceSize dst_offset, const VkDeviceSize upload_size, const void* const data)
+{
+    if (upload_size == 0)
+    {
+        return;
+    }
+
+    const StagingAllocation allocation = allocate(upload_size);
+    stream_memcpy(allocation.mapped_ptr, data, upload_size);
+    commit(allocation, vk_handle_dst_buffer, dst_offset);
+}
+
+bool StagingBuffer::region_has_uploads(const Region& region) const
+{
+    return !region.in_flight && (region.ring_chunk.offset != 0 || !region.overflow_chunk_list.empty());
+}
+
+void StagingBuffer::record_copies(const VkCommandBuffer vk_handle_cmd_buff, Chunk& chunk, std::vector<VkBufferMemoryBarrier>* const p_ownership_barrier_list)
+{
+    for (const auto& [vk_handle_dst_buffer, buff_copies] : chunk.dst_buffer_copy_map)
+    {
+        vkCmdCopyBuffer(vk_handle_cmd_buff, chunk.vk_handle_buffer, vk_handle_dst_buffer, static_cast<uint32_t>(buff_copies.size()), buff_copies.data());
+
+        if (!p_ownership_barrier_list)
+        {
+            continue;
+        }
+
+        for (const VkBufferCopy& buff_copy : buff_copies)
+        {
+            p_ownership_barrier_list->push_back({
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+                .srcQueueFamilyIndex = vk_core::get_transfer_queue_family_idx(),
+                .dstQueueFamilyIndex = vk_core::get_queue_family_idx(),
+                .buffer = vk_handle_dst_buffer,
+                .offset = buff_copy.dstOffset,
+                .size = buff_copy.size,
+            });
+        }
+    }
+
+    chunk.dst_buffer_copy_map.clear();
+}
+
+uint64_t StagingBuffer::flush(const VkCommandBuffer vk_handle_cmd_buff)
+{
+    Region& region = m_region_list[m_active_region_idx];
+
+    // Handed out even when nothing is recorded, so the caller can signal it unconditionally.
+    const uint64_t retire_value = ++m_retire_value;
+
+    if (!region_has_uploads(region))
+    {
+        return retire_value;
+    }
+
+    // LOG("Flushing staging buffer region %u\n", m_active_region_idx);
+    record_copies(vk_handle_cmd_buff, region.ring_chunk, nullptr);
+
+    for (Chunk& chunk : region.overflow_chunk_list)
+    {
+        record_copies(vk_handle_cmd_buff, chunk, nullptr);
+    }
+
+    const VkMemoryBarrier memory_barrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+    };
+
+    vkCmdPipelineBarrier(
+        vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        s_upload_consumer_stage_mask,
+        0x0,
+        1, &memory_barrier,
+        0, nullptr,
+        0, nullptr);
+
+    region.vk_handle_retire_sem4 = m_vk_handle_retire_sem4;
+    region.retire_value = retire_value;
+    region.in_flight = true;
+    region.generation++;
+    m_active_region_idx = (m_active_region_idx + 1) % static_cast<uint32_t>(m_region_list.size());
+
+    return retire_value;
+}
+
+uint64_t StagingBuffer::submit()
+{
+    Region& region = m_region_list[m_active_region_idx];
+
+    if (!region_has_uploads(region))
+    {
+        return 0;
+    }
+
+    const bool ownership_transfer = vk_core::has_dedicated_transfer_queue();
+    std::vector<VkBufferMemoryBarrier> release_barrier_list {};
+
+    const VkCommandBufferBeginInfo cmd_buff_begin_info {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr,
     };
 
-    m_buffer_offset += upload_size;
+    vkBeginCommandBuffer(region.vk_handle_transfer_cmd_buff, &cmd_buff_begin_info);
+
+    record_copies(region.vk_handle_transfer_cmd_buff, region.ring_chunk, ownership_transfer ? &release_barrier_list : nullptr);
+
+    for (Chunk& chunk : region.overflow_chunk_list)
+    {
+        record_copies(region.vk_handle_transfer_cmd_buff, chunk, ownership_transfer ? &release_barrier_list : nullptr);
+    }
+
+    if (ownership_transfer)
+    {
+        // Release half of the ownership transfer. dstAccessMask is ignored on the releasing queue.
+        m_pending_acquire_barrier_list.insert(m_pending_acquire_barrier_list.end(), release_barrier_list.begin(), release_barrier_list.end());
 
-    m_dst_buffer_copy_map[vk_handle_dst_buffer].push_back(buffer_copy);
+        for (VkBufferMemoryBarrier& barrier : release_barrier_list)
+        {
+            barrier.dstAccessMask = 0x0;
+        }
+
+        vkCmdPipelineBarrier(
+            region.vk_handle_transfer_cmd_buff,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0x0,
+            0, nullptr,
+            static_cast<uint32_t>(release_barrier_list.size()), release_barrier_list.data(),
+            0, nullptr);
+    }
+
+    vkEndCommandBuffer(region.vk_handle_transfer_cmd_buff);
+
+    const uint64_t signal_value = ++m_timeline_value;
+
+    const VkTimelineSemaphoreSubmitInfo timeline_submit_info {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = 0,
+        .pWaitSemaphoreValues = nullptr,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &signal_value,
+    };
+
+    const VkSubmitInfo submit_info {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &timeline_submit_info,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &region.vk_handle_transfer_cmd_buff,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &m_vk_handle_timeline_sem4,
+    };
+
+    vk_core::transfer_queue_submit(1, &submit_info, VK_NULL_HANDLE);
+
+    region.vk_handle_retire_sem4 = m_vk_handle_timeline_sem4;
+    region.retire_value = signal_value;
+    region.in_flight = true;
+    region.generation++;
+    m_active_region_idx = (m_active_region_idx + 1) % static_cast<uint32_t>(m_region_list.size());
+
+    return signal_value;
 }
 
-void StagingBuffer::flush(const VkCommandBuffer vk_handle_cmd_buff)
+void StagingBuffer::record_acquire_barriers(const VkCommandBuffer vk_handle_cmd_buff)
 {
-    // LOG("Flushing staging buffer\n");
-    for (const auto& [vk_handle_dst_buffer, buff_copies] : m_dst_buffer_copy_map)
+    if (m_pending_acquire_barrier_list.empty())
     {
-        vkCmdCopyBuffer(vk_handle_cmd_buff, m_vk_handle_buffer, vk_handle_dst_buffer, static_cast<uint32_t>(buff_copies.size()), buff_copies.data());
+        return;
     }
 
-    m_dst_buffer_copy_map.clear();
-    m_buffer_offset = 0; // this needs to wait until upload in complete
+    // Acquire half of the ownership transfer. srcAccessMask is ignored on the acquiring queue.
+    for (VkBufferMemoryBarrier& barrier : m_pending_acquire_barrier_list)
+    {
+        barrier.srcAccessMask = 0x0;
+    }
+
+    // srcStageMask matches the semaphore wait stages so the acquire is ordered after the wait, which in turn
+    // is ordered after the release on the transfer queue.
+    vkCmdPipelineBarrier(
+        vk_handle_cmd_buff,
+        s_upload_consumer_stage_mask,
+        s_upload_consumer_stage_mask,
+        0x0,
+        0, nullptr,
+        static_cast<uint32_t>(m_pending_acquire_barrier_list.size()), m_pending_acquire_barrier_list.data(),
+        0, nullptr);
+
+    m_pending_acquire_barrier_list.clear();
 }
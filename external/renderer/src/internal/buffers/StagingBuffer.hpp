@@ -1,31 +1,123 @@
 #ifndef RENDERER_STAGING_BUFFER_HPP
 #define RENDERER_STAGING_BUFFER_HPP
 
+#include "../pod/StagingAllocation.hpp"
+
+#include "vk_core.hpp"
+
 #include <vulkan/vulkan.h>
 
 #include <unordered_map>
 #include <cstring>
 #include <vector>
 
-// This technically needs to consider frame resources as well. We don't want to change the CPU data while uploading.
+// Ring of per-frame-resource regions carved out of one persistently mapped buffer.
+// Every flush() closes the active region and advances the ring. A region is only rewritten once the timeline value
+// it was closed with has been reached, so the CPU never overwrites data the GPU has yet to copy.
+// Uploads that do not fit in the active region spill into temporary overflow chunks owned by that region,
+// which are released together with the region.
+//
+// Regions can either be flushed into a caller provided graphics command buffer (flush) or submitted
+// on the transfer queue (submit). The former retires on a retire timeline semaphore value signalled by the
+// caller's own submission of that command buffer, so no submission of its own is needed. The latter signals the
+// upload timeline semaphore the graphics submission waits on and, when the transfer family differs from the
+// graphics family, releases ownership of every written range.
+// The matching acquire barriers are recorded on the graphics side by record_acquire_barriers().
 
 struct StagingBuffer
 {
 private:
-    VkDeviceSize m_buffer_size = 0;
-    VkBuffer m_vk_handle_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_vk_handle_memory = VK_NULL_HANDLE;
+protected:
+
+    struct Chunk
+    {
+        VkBuffer vk_handle_buffer = VK_NULL_HANDLE;
+        vk_core::MemoryAllocation memory_allocation {};
+        uint8_t* mapped_ptr = nullptr;
+        VkDeviceSize base_offset = 0;
+        VkDeviceSize size = 0;
+        VkDeviceSize offset = 0;
+
+        std::unordered_map<VkBuffer, std::vector<VkBufferCopy>> dst_buffer_copy_map;
+    };
 
+    struct Region
+    {
+        Chunk ring_chunk;
+        std::vector<Chunk> overflow_chunk_list;
+        VkSemaphore vk_handle_retire_sem4 = VK_NULL_HANDLE; // reaches retire_value once the region's copies completed
+        uint64_t retire_value = 0;
+        VkCommandPool vk_handle_transfer_cmd_pool = VK_NULL_HANDLE;
+        VkCommandBuffer vk_handle_transfer_cmd_buff = VK_NULL_HANDLE;
+        uint64_t generation = 0;
+        bool in_flight = false;
+    };
+
+    static constexpr uint32_t s_ring_chunk_idx = UINT32_MAX;
+
+    VkDeviceSize m_region_size = 0;
+    VkBuffer m_vk_handle_buffer = VK_NULL_HANDLE;
+    vk_core::MemoryAllocation m_memory_allocation {};
     uint8_t* m_mapped_ptr = nullptr;
-    VkDeviceSize m_buffer_offset = 0;
 
-    std::unordered_map<VkBuffer, std::vector<VkBufferCopy>> m_dst_buffer_copy_map;
+    std::vector<Region> m_region_list;
+    uint32_t m_active_region_idx = 0;
+
+    VkSemaphore m_vk_handle_timeline_sem4 = VK_NULL_HANDLE;
+    uint64_t m_timeline_value = 0;
+    VkSemaphore m_vk_handle_retire_sem4 = VK_NULL_HANDLE;
+    uint64_t m_retire_value = 0;
+    std::vector<VkBufferMemoryBarrier> m_pending_acquire_barrier_list;
+
+    static Chunk create_overflow_chunk(const VkDeviceSize size);
+    static void destroy_overflow_chunk(const Chunk& chunk);
+    static void record_copies(const VkCommandBuffer vk_handle_cmd_buff, Chunk& chunk, std::vector<VkBufferMemoryBarrier>* const p_ownership_barrier_list);
+
+    bool region_has_uploads(const Region& region) const;
+    Chunk& get_chunk(Region& region, const uint32_t chunk_idx);
+    void reclaim_region(Region& region);
+
 public:
-    StagingBuffer(const VkDeviceSize size);
+    // Every stage that may read uploaded data: indirect commands, vertex / index fetch, and shader reads of the
+    // uniform / storage buffers (graphics and the occlusion cull compute pass). The graphics submission waiting on
+    // the timeline semaphore must use exactly this mask, the acquire barriers are chained to it.
+    static constexpr VkPipelineStageFlags s_upload_consumer_stage_mask =
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    StagingBuffer(const VkDeviceSize region_size, const uint32_t region_count);
+    // The owner waits for the device to go idle first, a flushed region is not waited on.
     ~StagingBuffer();
 
+    StagingBuffer(const StagingBuffer&) = delete;
+    StagingBuffer& operator=(const StagingBuffer&) = delete;
+    StagingBuffer(StagingBuffer&&) = delete;
+    StagingBuffer& operator=(StagingBuffer&&) = delete;
+
     void queue_upload(const VkBuffer vk_handle_dst_buffer, const VkDeviceSize dst_offset, const VkDeviceSize upload_size, const void* const data);
-    void flush(const VkCommandBuffer vk_handle_cmd_buff);
+
+    // Two step alternative to queue_upload for callers that produce data in place (e.g. mesh decoders).
+    // allocate hands out mapped staging memory in the active region, commit queues its copy to the destination.
+    // The allocation must be committed before the next flush()/submit().
+    StagingAllocation allocate(const VkDeviceSize size);
+    void commit(const StagingAllocation& allocation, const VkBuffer vk_handle_dst_buffer, const VkDeviceSize dst_offset);
+
+    // Records all queued copies followed by a transfer -> vertex / indirect / shader read barrier.
+    // Returns the value the submission containing vk_handle_cmd_buff MUST signal the retire timeline semaphore to,
+    // also when nothing was queued (nothing is recorded then). The region is reused once the value is reached.
+    [[nodiscard]] uint64_t flush(const VkCommandBuffer vk_handle_cmd_buff);
+
+    // Records and submits all queued copies on the transfer queue.
+    // Returns the timeline value the graphics submission must wait on, or 0 when nothing was queued.
+    uint64_t submit();
+
+    // Records the queue family ownership acquire barriers for every range released by submit().
+    // No-op when the transfer queue aliases the graphics queue.
+    void record_acquire_barriers(const VkCommandBuffer vk_handle_cmd_buff);
+
+    VkDeviceSize get_region_size() const { return m_region_size; }
+    VkSemaphore get_vk_handle_timeline_semaphore() const { return m_vk_handle_timeline_sem4; }
+    VkSemaphore get_vk_handle_retire_semaphore() const { return m_vk_handle_retire_sem4; }
 };
 
-#endif // RENDERER_STAGING_BUFFER_HPP
\ No newline at end of file
+#endif // RENDERER_STAGING_BUFFER_HPP
@@ -1,11 +1,26 @@
 #include "UniformBuffer.hpp"
 #include "../misc/logger.hpp"
 
+#include <algorithm>
+
 UniformBuffer::UniformBuffer(const uint32_t frame_resource_count, const uint64_t per_frame_buffer_size, const std::unordered_map<std::string, DescriptorVariable>&& member_var_refl_set)
     : m_frame_resource_count { frame_resource_count }
     , m_per_frame_buffer_size { per_frame_buffer_size }
-    , m_member_var_refl_set{ member_var_refl_set.begin(), member_var_refl_set.end() }
 {
+    ASSERT(frame_resource_count <= 32, "UniformBuffer - At most 32 frame resources are supported!\n");
+
+    for (const auto& [member_name, member_var_refl] : member_var_refl_set)
+    {
+        m_member_list.push_back(member_var_refl);
+    }
+
+    std::sort(m_member_list.begin(), m_member_list.end(), [](const DescriptorVariable& a, const DescriptorVariable& b) { return a.offset < b.offset; });
+
+    for (uint32_t member_idx = 0; member_idx < m_member_list.size(); member_idx++)
+    {
+        m_member_idx_umap[m_member_list[member_idx].name] = member_idx;
+    }
+
     const VkBufferCreateInfo buffer_create_info {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .pNext = nullptr,
@@ -17,51 +32,70 @@ UniformBuffer::UniformBuffer(const uint32_t frame_resource_count, const uint64_t
         .pQueueFamilyIndices = nullptr,
     };
 
-    uint64_t allocated_size = 0;
     m_vk_handle_buffer = vk_core::create_buffer(buffer_create_info);
-    m_vk_handle_memory = vk_core::allocate_buffer_memory(m_vk_handle_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocated_size);
-    vk_core::bind_buffer_memory(m_vk_handle_buffer, m_vk_handle_memory);
-    vk_core::map_memory(m_vk_handle_memory, 0, allocated_size, 0x0, (void**)&m_mapped_data);
+    m_memory_allocation = vk_core::allocate_and_bind_buffer_memory(m_vk_handle_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_mapped_data = static_cast<uint8_t*>(m_memory_allocation.mapped_ptr);
 
     m_cpu_data.resize(m_per_frame_buffer_size);
-    m_per_frame_dirty_members.resize(m_frame_resource_count);
+    m_member_dirty_frame_mask.resize(m_member_list.size(), 0x0);
+    m_per_frame_dirty_member_idx_list.resize(m_frame_resource_count);
 }
 
 UniformBuffer::~UniformBuffer()
 {
-    vk_core::unmap_memory(m_vk_handle_memory);
     vk_core::destroy_buffer(m_vk_handle_buffer);
-    vk_core::free_memory(m_vk_handle_memory);
+    vk_core::free_allocation(m_memory_allocation);
+}
+
+uint32_t UniformBuffer::find_member(const std::string& member_name) const
+{
+    const auto it = m_member_idx_umap.find(member_name);
+    return it == m_member_idx_umap.end() ? UINT32_MAX : it->second;
 }
 
 void UniformBuffer::update_member(const std::string& member_name, const void* data)
 {
-    const auto it = m_member_var_refl_set.find(member_name);
-    ASSERT(it != m_member_var_refl_set.end(), "Member variable %s not found in uniform buffer!\n", member_name.c_str());
+    const uint32_t member_idx = find_member(member_name);
+    ASSERT(member_idx != UINT32_MAX, "Member variable %s not found in uniform buffer!\n", member_name.c_str());
 
-    const DescriptorVariable& member_var_refl = it->second;
-    const uint64_t offset = member_var_refl.offset;
-    const uint64_t size = member_var_refl.size;
+    update_member(member_idx, data);
+}
 
-    memcpy(m_cpu_data.data() + offset, data, size);
+void UniformBuffer::update_member(const uint32_t member_idx, const void* data)
+{
+    memcpy(get_writable_member(member_idx), data, m_member_list[member_idx].size);
+}
+
+void* UniformBuffer::get_writable_member(const uint32_t member_idx)
+{
+    const uint32_t all_frame_mask = static_cast<uint32_t>((1ull << m_frame_resource_count) - 1);
+    const uint32_t clean_frame_mask = all_frame_mask & ~m_member_dirty_frame_mask[member_idx];
 
     for (uint32_t i = 0; i < m_frame_resource_count; i++)
     {
-        m_per_frame_dirty_members[i].insert(member_var_refl);
+        if (clean_frame_mask & (1u << i))
+        {
+            m_per_frame_dirty_member_idx_list[i].push_back(member_idx);
+        }
     }
+
+    m_member_dirty_frame_mask[member_idx] = all_frame_mask;
+
+    return m_cpu_data.data() + m_member_list[member_idx].offset;
 }
 
 void UniformBuffer::flush_updates(const uint32_t frame_resource_idx)
 {
-    for (const DescriptorVariable& member_var_refl : m_per_frame_dirty_members[frame_resource_idx])
+    for (const uint32_t member_idx : m_per_frame_dirty_member_idx_list[frame_resource_idx])
     {
-        const uint64_t offset = member_var_refl.offset;
-        const uint64_t size = member_var_refl.size;
+        const uint64_t offset = m_member_list[member_idx].offset;
+        const uint64_t size = m_member_list[member_idx].size;
 
         memcpy(m_mapped_data + frame_resource_idx * m_per_frame_buffer_size + offset, m_cpu_data.data() + offset, size);
+        m_member_dirty_frame_mask[member_idx] &= ~(1u << frame_resource_idx);
     }
 
-    m_per_frame_dirty_members[frame_resource_idx].clear();
+    m_per_frame_dirty_member_idx_list[frame_resource_idx].clear();
 }
 
 VkDescriptorBufferInfo UniformBuffer::get_descriptor_buffer_info(const uint32_t frame_resource_idx) const
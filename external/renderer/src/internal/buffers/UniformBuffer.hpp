@@ -7,7 +7,6 @@
 #include <vulkan/vulkan.h>
 
 #include <unordered_map>
-#include <unordered_set>
 #include <string>
 #include <vector>
 #include <string.h>
@@ -18,14 +17,17 @@ private:
 protected:
     const uint32_t m_frame_resource_count = 0;
     const uint64_t m_per_frame_buffer_size = 0;
-    const std::unordered_map<std::string, DescriptorVariable> m_member_var_refl_set;
+    std::vector<DescriptorVariable> m_member_list; // by member idx, sorted by offset
+    std::unordered_map<std::string, uint32_t> m_member_idx_umap;
 
     VkBuffer m_vk_handle_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_vk_handle_memory = VK_NULL_HANDLE;
+    vk_core::MemoryAllocation m_memory_allocation {};
     uint8_t* m_mapped_data = nullptr;
 
     std::vector<uint8_t> m_cpu_data;
-    std::vector<std::unordered_set<DescriptorVariable, DescriptorVariable::Hash>> m_per_frame_dirty_members;
+    // A member updated since a frame's last flush is listed once for that frame and has the frame's bit set.
+    std::vector<uint32_t> m_member_dirty_frame_mask; // by member idx
+    std::vector<std::vector<uint32_t>> m_per_frame_dirty_member_idx_list;
 public:
     UniformBuffer(const uint32_t frame_resource_count, const uint64_t per_frame_buffer_size, const std::unordered_map<std::string, DescriptorVariable>&& member_var_refl_set);
     ~UniformBuffer();
@@ -35,7 +37,15 @@ public:
     UniformBuffer(UniformBuffer&&) = delete;
     UniformBuffer& operator=(UniformBuffer&&) = delete;
 
+    // Members are indexed in offset order, so a member's idx can be derived from the reflection alone.
+    // UINT32_MAX when the buffer has no member of that name.
+    uint32_t find_member(const std::string& member_name) const;
+    const DescriptorVariable& get_member(const uint32_t member_idx) const { return m_member_list[member_idx]; }
+
     void update_member(const std::string& member_name, const void* const data);
+    void update_member(const uint32_t member_idx, const void* const data);
+    // Marks the member dirty for every frame and returns its bytes.
+    void* get_writable_member(const uint32_t member_idx);
     void flush_updates(const uint32_t frame_resource_idx);
     VkDescriptorBufferInfo get_descriptor_buffer_info(const uint32_t frame_resource_idx) const;
 };
@@ -0,0 +1,50 @@
+#include "SecondaryCommandPools.hpp"
+
+#include "vk_core.hpp"
+
+SecondaryCommandPools::SecondaryCommandPools(const uint32_t frame_resource_count, const uint32_t worker_count)
+    : m_worker_count { worker_count }
+    , m_pool_list(frame_resource_count * worker_count)
+{
+    for (WorkerCommandPool& pool : m_pool_list)
+    {
+        pool.vk_handle_cmd_pool = vk_core::create_command_pool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    }
+}
+
+SecondaryCommandPools::~SecondaryCommandPools()
+{
+    // Destroying a pool frees its command buffers.
+    for (const WorkerCommandPool& pool : m_pool_list)
+    {
+        vk_core::destroy_command_pool(pool.vk_handle_cmd_pool);
+    }
+}
+
+void SecondaryCommandPools::reset(const uint32_t frame_resource_idx)
+{
+    for (uint32_t worker_idx = 0; worker_idx < m_worker_count; worker_idx++)
+    {
+        WorkerCommandPool& pool = m_pool_list[frame_resource_idx * m_worker_count + worker_idx];
+
+        if (pool.used_count == 0)
+        {
+            continue;
+        }
+
+        vk_core::reset_command_pool(pool.vk_handle_cmd_pool);
+        pool.used_count = 0;
+    }
+}
+
+VkCommandBuffer SecondaryCommandPools::acquire(const uint32_t frame_resource_idx, const uint32_t worker_idx)
+{
+    WorkerCommandPool& pool = m_pool_list[frame_resource_idx * m_worker_count + worker_idx];
+
+    if (pool.used_count == pool.vk_handle_cmd_buff_list.size())
+    {
+        pool.vk_handle_cmd_buff_list.push_back(vk_core::allocate_command_buffer(pool.vk_handle_cmd_pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+    }
+
+    return pool.vk_handle_cmd_buff_list[pool.used_count++];
+}
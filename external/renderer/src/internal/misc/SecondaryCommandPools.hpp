@@ -0,0 +1,46 @@
+#ifndef RENDERER_SECONDARY_COMMAND_POOLS_HPP
+#define RENDERER_SECONDARY_COMMAND_POOLS_HPP
+
+#include <vulkan/vulkan.h>
+
+#include <inttypes.h>
+#include <vector>
+
+// Secondary command buffers of one render pass, recorded on the worker pool.
+//
+// Every (frame resource, worker) pair owns a transient command pool, so workers allocate and record without locking.
+// reset() recycles a frame resource's pools wholesale and hands their command buffers out again in allocation order,
+// growing a pool only when a recording needs more buffers than any before it.
+struct SecondaryCommandPools
+{
+private:
+protected:
+
+    struct WorkerCommandPool
+    {
+        VkCommandPool vk_handle_cmd_pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> vk_handle_cmd_buff_list;
+        uint32_t used_count = 0;
+    };
+
+    const uint32_t m_worker_count;
+    std::vector<WorkerCommandPool> m_pool_list; // frame resource * m_worker_count + worker
+
+public:
+    SecondaryCommandPools(const uint32_t frame_resource_count, const uint32_t worker_count);
+    ~SecondaryCommandPools();
+
+    SecondaryCommandPools(const SecondaryCommandPools&) = delete;
+    SecondaryCommandPools& operator=(const SecondaryCommandPools&) = delete;
+    SecondaryCommandPools(SecondaryCommandPools&&) = delete;
+    SecondaryCommandPools& operator=(SecondaryCommandPools&&) = delete;
+
+    // Calling thread only, once no submission of the frame resource's previous recording is pending.
+    void reset(const uint32_t frame_resource_idx);
+    // Safe to call concurrently for distinct worker_idx.
+    VkCommandBuffer acquire(const uint32_t frame_resource_idx, const uint32_t worker_idx);
+
+    uint32_t get_worker_count() const { return m_worker_count; }
+};
+
+#endif // RENDERER_SECONDARY_COMMAND_POOLS_HPP
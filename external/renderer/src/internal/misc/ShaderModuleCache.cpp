@@ -0,0 +1,102 @@
+#include "ShaderModuleCache.hpp"
+#include "logger.hpp"
+
+#include "vk_core.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t hash_fnv1a(const uint8_t* const data, const uint64_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (uint64_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+ShaderModuleCache::~ShaderModuleCache()
+{
+    for (const Module& module : m_module_list)
+    {
+        vk_core::destroy_shader_module(module.vk_handle_shader_module);
+    }
+}
+
+VkShaderModule ShaderModuleCache::get(const std::string& file_path)
+{
+    const auto path_iter = m_path_umap.find(file_path);
+
+    if (path_iter != m_path_umap.end())
+    {
+        return m_module_list[path_iter->second].vk_handle_shader_module;
+    }
+
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    ASSERT(fd >= 0, "Failed to open file %s!\n", file_path.c_str());
+
+    struct stat file_stat {};
+    ASSERT(fstat(fd, &file_stat) == 0 && file_stat.st_size > 0 && file_stat.st_size % sizeof(uint32_t) == 0, "%s is not a SPIR-V file!\n", file_path.c_str());
+
+    const uint64_t size = static_cast<uint64_t>(file_stat.st_size);
+
+    // Mappings are page aligned, so the code can be handed to the driver in place.
+    void* const p_mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    ASSERT(p_mapping != MAP_FAILED, "Failed to map file %s!\n", file_path.c_str());
+
+    const uint8_t* const p_code = static_cast<const uint8_t*>(p_mapping);
+    const uint64_t hash = hash_fnv1a(p_code, size);
+
+    m_file_count++;
+    m_file_byte_count += size;
+
+    uint32_t module_idx = UINT32_MAX;
+    const auto [hash_begin, hash_end] = m_hash_umap.equal_range(hash);
+
+    for (auto hash_iter = hash_begin; hash_iter != hash_end; hash_iter++)
+    {
+        const Module& module = m_module_list[hash_iter->second];
+
+        if (module.code.size() * sizeof(uint32_t) == size && memcmp(module.code.data(), p_code, size) == 0)
+        {
+            module_idx = hash_iter->second;
+            break;
+        }
+    }
+
+    if (module_idx == UINT32_MAX)
+    {
+        const VkShaderModuleCreateInfo create_info {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0x0,
+            .codeSize = size,
+            .pCode = static_cast<const uint32_t*>(p_mapping),
+        };
+
+        Module module {
+            .hash = hash,
+            .code = std::vector<uint32_t>(size / sizeof(uint32_t)),
+            .vk_handle_shader_module = vk_core::create_shader_module(create_info),
+        };
+
+        memcpy(module.code.data(), p_code, size);
+
+        module_idx = static_cast<uint32_t>(m_module_list.size());
+        m_module_list.push_back(std::move(module));
+        m_hash_umap.emplace(hash, module_idx);
+    }
+
+    munmap(p_mapping, size);
+
+    m_path_umap.emplace(file_path, module_idx);
+
+    return m_module_list[module_idx].vk_handle_shader_module;
+}
@@ -0,0 +1,52 @@
+#ifndef RENDERER_SHADER_MODULE_CACHE_HPP
+#define RENDERER_SHADER_MODULE_CACHE_HPP
+
+#include <vulkan/vulkan.h>
+
+#include <inttypes.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Shader modules of the pipelines built at init, created once per distinct SPIR-V.
+//
+// Files are mmapped rather than read into a heap copy. A file loaded before returns its module without touching the
+// disk again, a new file whose contents match an earlier one (64 bit FNV-1a hash, confirmed by a full compare) shares
+// that module. Modules live as long as the cache, which only has to outlive the pipeline creation using them.
+struct ShaderModuleCache
+{
+private:
+protected:
+
+    struct Module
+    {
+        uint64_t hash;
+        std::vector<uint32_t> code;
+        VkShaderModule vk_handle_shader_module;
+    };
+
+    std::vector<Module> m_module_list;
+    std::unordered_multimap<uint64_t, uint32_t> m_hash_umap; // content hash -> m_module_list idx
+    std::unordered_map<std::string, uint32_t> m_path_umap; // file path -> m_module_list idx
+
+    uint32_t m_file_count = 0;
+    uint64_t m_file_byte_count = 0;
+
+public:
+    ShaderModuleCache() = default;
+    ~ShaderModuleCache();
+
+    ShaderModuleCache(const ShaderModuleCache&) = delete;
+    ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+    ShaderModuleCache(ShaderModuleCache&&) = delete;
+    ShaderModuleCache& operator=(ShaderModuleCache&&) = delete;
+
+    // Calling thread only. The returned module may be used concurrently.
+    VkShaderModule get(const std::string& file_path);
+
+    uint32_t get_module_count() const { return static_cast<uint32_t>(m_module_list.size()); }
+    uint32_t get_file_count() const { return m_file_count; }
+    uint64_t get_file_byte_count() const { return m_file_byte_count; }
+};
+
+#endif // RENDERER_SHADER_MODULE_CACHE_HPP
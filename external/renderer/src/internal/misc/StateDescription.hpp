@@ -0,0 +1,20 @@
+#ifndef RENDERER_STATE_DESCRIPTION_HPP
+#define RENDERER_STATE_DESCRIPTION_HPP
+
+#include "json_structures.hpp"
+
+#include <vector>
+
+// Everything renderer init reads from the four description files of renderer::InitInfo, loaded once up front either
+// from the JSON files themselves or from a state bundle compiled out of them, see state_bundle.hpp.
+struct StateDescription
+{
+    std::vector<JSONInfo_DescriptorBinding> frame_desc_set_binding_list; // refl_file_frame_desc_set_def "bindings"
+    JSONInfo_SortBinReflection sortbin_reflection_info; // refl_file_sortbin_mat_draw_def "sortbin-reflections"
+    JSONInfo_SortBinPipelineState sortbin_pipeline_state_info; // file_sortbin_pipeline_state "sortbins"
+    JSONInfo_RenderAttachment render_attachment_info; // file_app_state "render-attachments"
+    JSONInfo_RenderPass render_pass_info; // file_app_state "render-passes"
+    JSONInfo_AppSortBin sortbin_info; // file_app_state "sortbins"
+};
+
+#endif // RENDERER_STATE_DESCRIPTION_HPP
@@ -0,0 +1,102 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(const uint32_t worker_count)
+{
+    const uint32_t helper_thread_count = (worker_count != 0 ? worker_count : std::max(std::thread::hardware_concurrency(), 1u)) - 1;
+
+    m_thread_list.reserve(helper_thread_count);
+
+    for (uint32_t i = 0; i < helper_thread_count; i++)
+    {
+        m_thread_list.emplace_back(&WorkerPool::thread_main, this, i + 1);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_terminating = true;
+    }
+
+    m_batch_start_cv.notify_all();
+
+    for (std::thread& thread : m_thread_list)
+    {
+        thread.join();
+    }
+}
+
+void WorkerPool::work(const uint32_t worker_idx)
+{
+    for (uint32_t task_idx = m_next_task_idx.fetch_add(1, std::memory_order_relaxed); task_idx < m_task_count; task_idx = m_next_task_idx.fetch_add(1, std::memory_order_relaxed))
+    {
+        (*m_p_task)(task_idx, worker_idx);
+    }
+}
+
+void WorkerPool::thread_main(const uint32_t worker_idx)
+{
+    uint64_t seen_batch_generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_batch_start_cv.wait(lock, [&]() { return m_is_terminating || m_batch_generation != seen_batch_generation; });
+
+            if (m_is_terminating)
+            {
+                return;
+            }
+
+            seen_batch_generation = m_batch_generation;
+        }
+
+        work(worker_idx);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy_thread_count--;
+        }
+
+        m_batch_done_cv.notify_one();
+    }
+}
+
+void WorkerPool::run(const uint32_t task_count, const Task& task)
+{
+    if (task_count == 0)
+    {
+        return;
+    }
+
+    // Not worth waking anyone up for a single task.
+    if (task_count == 1 || m_thread_list.empty())
+    {
+        for (uint32_t task_idx = 0; task_idx < task_count; task_idx++)
+        {
+            task(task_idx, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_p_task = &task;
+        m_task_count = task_count;
+        m_next_task_idx.store(0, std::memory_order_relaxed);
+        m_busy_thread_count = static_cast<uint32_t>(m_thread_list.size());
+        m_batch_generation++;
+    }
+
+    m_batch_start_cv.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_batch_done_cv.wait(lock, [this]() { return m_busy_thread_count == 0; });
+    m_p_task = nullptr;
+}
@@ -0,0 +1,55 @@
+#ifndef RENDERER_WORKER_POOL_HPP
+#define RENDERER_WORKER_POOL_HPP
+
+#include <inttypes.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing one batch of tasks at a time. run() hands task indices out through an
+// atomic counter, the calling thread works on the batch as well and returns once every task has finished.
+// worker_idx is in [0, get_worker_count()), the calling thread always being worker 0, so it can index per worker scratch.
+struct WorkerPool
+{
+private:
+protected:
+
+    using Task = std::function<void(const uint32_t task_idx, const uint32_t worker_idx)>;
+
+    std::vector<std::thread> m_thread_list;
+
+    std::mutex m_mutex;
+    std::condition_variable m_batch_start_cv;
+    std::condition_variable m_batch_done_cv;
+
+    const Task* m_p_task = nullptr;
+    uint32_t m_task_count = 0;
+    uint64_t m_batch_generation = 0;
+    uint32_t m_busy_thread_count = 0;
+    bool m_is_terminating = false;
+
+    std::atomic<uint32_t> m_next_task_idx { 0 };
+
+    void work(const uint32_t worker_idx);
+    void thread_main(const uint32_t worker_idx);
+
+public:
+    // worker_count includes the calling thread, 0 picks hardware_concurrency.
+    explicit WorkerPool(const uint32_t worker_count = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+
+    // Not reentrant, must not be called from inside a task.
+    void run(const uint32_t task_count, const Task& task);
+
+    uint32_t get_worker_count() const { return static_cast<uint32_t>(m_thread_list.size()) + 1; }
+};
+
+#endif // RENDERER_WORKER_POOL_HPP
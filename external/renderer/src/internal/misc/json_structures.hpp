@@ -1,11 +1,15 @@
 #ifndef JSON_STRUCTURES_HPP
 #define JSON_STRUCTURES_HPP
 
+#include "logger.hpp"
 #include "vk_enum_to_string.hpp"
+#include "../pod/DrawOrder.hpp"
 
 #include <vulkan/vulkan.h>
 
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "json.hpp"
@@ -31,12 +35,12 @@ struct JSONInfo_DescriptorVariable
         return name == other.name &&
                offset == other.offset &&
                size == other.size &&
-               count == other.count;
+               count == other.count &&
                internal_structure == other.internal_structure;
     }
 };
 
-void from_json(const nlohmann::json& json_data, JSONInfo_DescriptorVariable& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_DescriptorVariable& info)
 {
     info.name = json_data.at("name").get<std::string>();
     info.offset = json_data.at("offset").get<uint32_t>();
@@ -55,7 +59,7 @@ struct JSONInfo_DescriptorBinding
     std::vector<JSONInfo_DescriptorVariable> buffer_variables;
 };
 
-void from_json(const nlohmann::json& json_data, JSONInfo_DescriptorBinding& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_DescriptorBinding& info)
 {
     info.name = json_data.at("name").get<std::string>();
     info.binding_ID = json_data.at("binding-id").get<uint32_t>();
@@ -89,7 +93,7 @@ struct JSONInfo_RenderAttachment
     std::vector<ImageState> image_state_list;
 };
 
-void from_json(const nlohmann::json& json_data, JSONInfo_RenderAttachment& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_RenderAttachment& info)
 {
     if (json_data.contains("shared-state"))
     {
@@ -233,24 +237,40 @@ struct JSONInfo_RenderPass
         VkClearValue clear_value;
     };
 
+    // Hi-Z occlusion culling of the pass's draws against its depth attachment.
+    struct OcclusionCullingState
+    {
+        bool is_two_phase = false;
+        bool is_reverse_z = false;
+    };
+
+    // Per instance LOD selection of the pass's culled draws.
+    struct LodSelectionState
+    {
+        float max_screen_error = 1.0f; // pixels
+    };
+
     struct State
     {
         std::string name;
         std::vector<ReadAttachmentState> input_attachment_list;
         std::vector<WriteAttachmentState> color_attachment_list;
         std::optional<WriteAttachmentState> depth_attachment;
+        std::optional<OcclusionCullingState> occlusion_culling;
+        std::optional<LodSelectionState> lod_selection;
+        DrawOrder draw_order;
     };
 
     std::vector<State> state_list;
 };
 
-void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::ReadAttachmentState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::ReadAttachmentState& info)
 {
     info.name = json_data.at("name").get<std::string>();
     info.image_layout = string_to_enum_VkImageLayout(json_data.at("image-layout").get<std::string>());
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::WriteAttachmentState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::WriteAttachmentState& info)
 {
     info.name = json_data.at("name").get<std::string>();
     info.image_layout = string_to_enum_VkImageLayout(json_data.at("image-layout").get<std::string>());
@@ -272,7 +292,18 @@ void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::WriteAttach
     }
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::State& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::OcclusionCullingState& info)
+{
+    info.is_two_phase = json_data.value("two-phase", false);
+    info.is_reverse_z = json_data.value("reverse-z", false);
+}
+
+inline void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::LodSelectionState& info)
+{
+    info.max_screen_error = json_data.value("max-screen-error", 1.0f);
+}
+
+inline void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::State& info)
 {
     info.name = json_data.at("name").get<std::string>();
     info.input_attachment_list = json_data.at("input-attachments");
@@ -286,9 +317,53 @@ void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass::State& info
     {
         info.depth_attachment = std::nullopt;
     }
+
+    if (json_data.contains("occlusion-culling"))
+    {
+        ASSERT(info.depth_attachment.has_value(), "Render pass %s - occlusion culling needs a depth attachment!\n", info.name.c_str());
+        ASSERT(info.depth_attachment.value().store_op == VK_ATTACHMENT_STORE_OP_STORE, "Render pass %s - occlusion culling needs the depth attachment stored!\n", info.name.c_str());
+        info.occlusion_culling = json_data.at("occlusion-culling");
+    }
+    else
+    {
+        info.occlusion_culling = std::nullopt;
+    }
+
+    if (json_data.contains("lod-selection"))
+    {
+        info.lod_selection = json_data.at("lod-selection");
+        ASSERT(info.lod_selection.value().max_screen_error > 0.0f, "Render pass %s - lod-selection needs a positive max-screen-error!\n", info.name.c_str());
+    }
+    else
+    {
+        info.lod_selection = std::nullopt;
+    }
+
+    const std::string draw_order = json_data.value("draw-order", "insertion");
+
+    if (draw_order == "insertion")
+    {
+        info.draw_order = DrawOrder::eInsertion;
+    }
+    else if (draw_order == "state")
+    {
+        info.draw_order = DrawOrder::eState;
+    }
+    else if (draw_order == "front-to-back")
+    {
+        info.draw_order = DrawOrder::eFrontToBack;
+    }
+    else if (draw_order == "back-to-front")
+    {
+        info.draw_order = DrawOrder::eBackToFront;
+    }
+    else
+    {
+        EXIT("Render pass %s - unknown draw-order %s!\n", info.name.c_str(), draw_order.c_str());
+    }
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_RenderPass& info)
 {
     info.state_list = json_data;
 }
@@ -326,19 +401,19 @@ struct JSONInfo_SortBinReflection
     std::unordered_map<std::string, State> state_umap;
 };
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection::PushConstantState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection::PushConstantState& info)
 {
 
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection::BlockDefinition& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection::BlockDefinition& info)
 {
     info.size = json_data.at("block-size").get<uint32_t>();
     info.end_padding = json_data.at("end-padding").get<uint32_t>();
     info.members = json_data.at("members").get<std::vector<JSONInfo_DescriptorVariable>>();
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection::State& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection::State& info)
 {
     info.sortbin_name = json_data.at("name").get<std::string>();
     info.definition_material_data = json_data.at("definition-material-data");
@@ -346,7 +421,7 @@ void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection::Stat
     info.push_const_state_list = json_data.at("definition-push-const-data");
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection& info)
 {
     const std::vector<JSONInfo_SortBinReflection::State>& state_list = json_data;
 
@@ -384,6 +459,12 @@ void from_json(const nlohmann::json& json_data, JSONInfo_SortBinReflection& info
 
 struct JSONInfo_AppSortBin
 {
+    // Per instance LOD selection of the pass's culled draws.
+    struct LodSelectionState
+    {
+        float max_screen_error = 1.0f; // pixels
+    };
+
     struct State
     {
         std::string name;
@@ -393,13 +474,13 @@ struct JSONInfo_AppSortBin
     std::vector<State> sortbin_list;
 };
 
-void from_json(const nlohmann::json& json_data, JSONInfo_AppSortBin::State& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_AppSortBin::State& info)
 {
     info.name = json_data.at("name").get<std::string>();
     info.render_pass_name = json_data.at("render-pass-name").get<std::string>();
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_AppSortBin& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_AppSortBin& info)
 {
     info.sortbin_list = json_data;
 }
@@ -496,19 +577,19 @@ struct JSONInfo_SortBinPipelineState
     std::unordered_map<std::string, State> state_umap;
 };
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::ShaderState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::ShaderState& info)
 {
     info.shader_names = json_data;
 }
 
-void from_json(const nlohmann::json& json_data, VkVertexInputBindingDescription& info)
+inline void from_json(const nlohmann::json& json_data, VkVertexInputBindingDescription& info)
 {
     info.binding = json_data.at("binding").get<uint32_t>();
     info.stride = json_data.at("stride").get<uint32_t>();
     info.inputRate = string_to_enum_VkVertexInputRate(json_data.at("input-rate").get<std::string>());
 }
 
-void from_json(const nlohmann::json& json_data, VkVertexInputAttributeDescription& info)
+inline void from_json(const nlohmann::json& json_data, VkVertexInputAttributeDescription& info)
 {
     info.location = json_data.at("location").get<uint32_t>();
     info.binding = json_data.at("binding").get<uint32_t>();
@@ -516,7 +597,7 @@ void from_json(const nlohmann::json& json_data, VkVertexInputAttributeDescriptio
     info.offset = json_data.at("offset").get<uint32_t>();
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::VertexInputState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::VertexInputState& info)
 {
     info.binding_description_list = json_data.at("vertex-input-binding-desc");
 
@@ -531,19 +612,19 @@ void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::V
     }
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::InputAssemblyState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::InputAssemblyState& info)
 {
     info.topology = string_to_enum_VkPrimitiveTopology(json_data.at("topology").get<std::string>());
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::RasterizationState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::RasterizationState& info)
 {
     info.polygon_mode = string_to_enum_VkPolygonMode(json_data.at("polygon-mode").get<std::string>());
     info.cull_mode = string_to_enum_VkCullModeFlagBits(json_data.at("cull-mode").get<std::string>());
     info.front_face = string_to_enum_VkFrontFace(json_data.at("front-face").get<std::string>());
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::DepthStencilState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::DepthStencilState& info)
 {
     info.depth_test_enable = json_data.at("depth-test-enable").get<bool>();
     info.depth_write_enable = json_data.at("depth-write-enable").get<bool>();
@@ -551,7 +632,7 @@ void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::D
     info.stencil_test_enable = json_data.at("stencil-test-enable").get<bool>();
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::PipelineState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::PipelineState& info)
 {
     info.shader_state = json_data.at("shader-state");
     info.vertex_input_state = json_data.at("vertex-input-state");
@@ -560,13 +641,13 @@ void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::P
     info.depth_stencil_state = json_data.at("depth-stencil-state");
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::State& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState::State& info)
 {
     info.sortbin_name = json_data.at("name").get<std::string>();
     info.pipeline_state = json_data.at("pipeline-state");
 }
 
-void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState& info)
+inline void from_json(const nlohmann::json& json_data, JSONInfo_SortBinPipelineState& info)
 {
     const std::vector<JSONInfo_SortBinPipelineState::State>& state_list = json_data;
 
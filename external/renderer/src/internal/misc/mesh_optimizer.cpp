@@ -0,0 +1,330 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+// Simulated LRU cache of the vertex cache optimisation. Larger than real FIFO caches so the order also holds up on them.
+static constexpr uint32_t s_lru_cache_size = 32;
+// FIFO cache the overdraw clusters are measured against.
+static constexpr uint32_t s_fifo_cache_size = 16;
+static constexpr uint32_t s_min_cluster_triangle_count = 16;
+
+// Recently used vertices score high (the last triangle's slightly less, to avoid strips), vertices with few triangles
+// left score high so they are finished off instead of leaving isolated triangles behind.
+static float get_vertex_score(const int32_t cache_pos, const uint32_t live_triangle_count)
+{
+    if (live_triangle_count == 0)
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+
+    if (cache_pos >= 0)
+    {
+        score = cache_pos < 3 ? 0.75f : powf(1.0f - static_cast<float>(cache_pos - 3) / static_cast<float>(s_lru_cache_size - 3), 1.5f);
+    }
+
+    return score + 2.0f / sqrtf(static_cast<float>(live_triangle_count));
+}
+
+namespace mesh_optimizer
+{
+
+float compute_acmr(const uint32_t* const index_data, const uint32_t index_count, const uint32_t vertex_count, const uint32_t cache_size)
+{
+    const uint32_t triangle_count = index_count / 3;
+
+    if (triangle_count == 0)
+    {
+        return 0.0f;
+    }
+
+    // A vertex is cached while fewer than cache_size vertices were pushed after it.
+    std::vector<uint32_t> cache_timestamp_list(vertex_count, 0);
+    uint32_t timestamp = cache_size + 1;
+    uint32_t miss_count = 0;
+
+    for (uint32_t i = 0; i < index_count; i++)
+    {
+        const uint32_t vertex = index_data[i];
+
+        if (timestamp - cache_timestamp_list[vertex] > cache_size)
+        {
+            cache_timestamp_list[vertex] = timestamp++;
+            miss_count++;
+        }
+    }
+
+    return static_cast<float>(miss_count) / static_cast<float>(triangle_count);
+}
+
+void optimize_vertex_cache(uint32_t* const dst_index_data, const uint32_t* const index_data, const uint32_t index_count, const uint32_t vertex_count)
+{
+    const uint32_t triangle_count = index_count / 3;
+
+    // Triangles of every vertex, the first live_triangle_count_list[vertex] of its range are not emitted yet.
+    std::vector<uint32_t> live_triangle_count_list(vertex_count, 0);
+
+    for (uint32_t i = 0; i < triangle_count * 3; i++)
+    {
+        live_triangle_count_list[index_data[i]]++;
+    }
+
+    std::vector<uint32_t> adjacency_offset_list(vertex_count + 1, 0);
+    std::inclusive_scan(live_triangle_count_list.begin(), live_triangle_count_list.end(), adjacency_offset_list.begin() + 1);
+
+    std::vector<uint32_t> adjacency_list(triangle_count * 3);
+    std::vector<uint32_t> adjacency_fill_list(adjacency_offset_list.begin(), adjacency_offset_list.end() - 1);
+
+    for (uint32_t i = 0; i < triangle_count * 3; i++)
+    {
+        adjacency_list[adjacency_fill_list[index_data[i]]++] = i / 3;
+    }
+
+    std::vector<int32_t> cache_pos_list(vertex_count, -1);
+    std::vector<float> vertex_score_list(vertex_count);
+
+    for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        vertex_score_list[vertex] = get_vertex_score(-1, live_triangle_count_list[vertex]);
+    }
+
+    std::vector<bool> is_emitted_list(triangle_count, false);
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(s_lru_cache_size + 3);
+    next_cache.reserve(s_lru_cache_size + 3);
+
+    uint32_t best_triangle = UINT32_MAX;
+    uint32_t input_cursor = 0;
+
+    for (uint32_t dst_triangle = 0; dst_triangle < triangle_count; dst_triangle++)
+    {
+        // Nothing in the cache has triangles left, continue with the next triangle in input order.
+        if (best_triangle == UINT32_MAX)
+        {
+            while (is_emitted_list[input_cursor])
+            {
+                input_cursor++;
+            }
+
+            best_triangle = input_cursor;
+        }
+
+        const uint32_t* const triangle = index_data + static_cast<size_t>(best_triangle) * 3;
+        memcpy(dst_index_data + static_cast<size_t>(dst_triangle) * 3, triangle, 3 * sizeof(uint32_t));
+        is_emitted_list[best_triangle] = true;
+
+        next_cache.clear();
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint32_t vertex = triangle[k];
+            uint32_t* const adjacency = adjacency_list.data() + adjacency_offset_list[vertex];
+            const uint32_t live_triangle_count = live_triangle_count_list[vertex];
+
+            for (uint32_t j = 0; j < live_triangle_count; j++)
+            {
+                if (adjacency[j] == best_triangle)
+                {
+                    std::swap(adjacency[j], adjacency[live_triangle_count - 1]);
+                    live_triangle_count_list[vertex]--;
+                    break;
+                }
+            }
+
+            if (std::find(next_cache.begin(), next_cache.end(), vertex) == next_cache.end())
+            {
+                next_cache.push_back(vertex);
+            }
+        }
+
+        for (const uint32_t vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+            {
+                next_cache.push_back(vertex);
+            }
+        }
+
+        // Rescore the cached vertices (and the ones just evicted), then the triangles they still belong to.
+        for (uint32_t i = 0; i < next_cache.size(); i++)
+        {
+            const uint32_t vertex = next_cache[i];
+            cache_pos_list[vertex] = i < s_lru_cache_size ? static_cast<int32_t>(i) : -1;
+            vertex_score_list[vertex] = get_vertex_score(cache_pos_list[vertex], live_triangle_count_list[vertex]);
+        }
+
+        best_triangle = UINT32_MAX;
+        float best_score = -1.0f;
+
+        for (const uint32_t vertex : next_cache)
+        {
+            const uint32_t* const adjacency = adjacency_list.data() + adjacency_offset_list[vertex];
+
+            for (uint32_t j = 0; j < live_triangle_count_list[vertex]; j++)
+            {
+                const uint32_t* const candidate = index_data + static_cast<size_t>(adjacency[j]) * 3;
+                const float score = vertex_score_list[candidate[0]] + vertex_score_list[candidate[1]] + vertex_score_list[candidate[2]];
+
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best_triangle = adjacency[j];
+                }
+            }
+        }
+
+        if (next_cache.size() > s_lru_cache_size)
+        {
+            next_cache.resize(s_lru_cache_size);
+        }
+
+        cache.swap(next_cache);
+    }
+}
+
+uint32_t optimize_overdraw(uint32_t* const index_data, const uint32_t index_count, const float* const position_data, const uint32_t vertex_count, const float threshold)
+{
+    const uint32_t triangle_count = index_count / 3;
+
+    if (triangle_count == 0)
+    {
+        return 0;
+    }
+
+    // Split where a cluster, simulated with a cold cache, gets within threshold of the list's ACMR.
+    const float max_cluster_acmr = threshold * compute_acmr(index_data, index_count, vertex_count, s_fifo_cache_size);
+
+    std::vector<uint32_t> cluster_begin_list { 0 };
+    std::vector<uint32_t> cache_timestamp_list(vertex_count, 0);
+    uint32_t timestamp = s_fifo_cache_size + 1;
+    uint32_t cluster_miss_count = 0;
+
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        const uint32_t cluster_triangle_count = triangle - cluster_begin_list.back();
+
+        if (cluster_triangle_count >= s_min_cluster_triangle_count && static_cast<float>(cluster_miss_count) <= max_cluster_acmr * static_cast<float>(cluster_triangle_count))
+        {
+            cluster_begin_list.push_back(triangle);
+            timestamp += s_fifo_cache_size + 1;
+            cluster_miss_count = 0;
+        }
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint32_t vertex = index_data[triangle * 3 + k];
+
+            if (timestamp - cache_timestamp_list[vertex] > s_fifo_cache_size)
+            {
+                cache_timestamp_list[vertex] = timestamp++;
+                cluster_miss_count++;
+            }
+        }
+    }
+
+    const uint32_t cluster_count = static_cast<uint32_t>(cluster_begin_list.size());
+    cluster_begin_list.push_back(triangle_count);
+
+    // Area weighted centroid and normal of every cluster and the mesh.
+    struct Cluster
+    {
+        float centroid[3] = { 0.0f, 0.0f, 0.0f };
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+    };
+
+    std::vector<Cluster> cluster_list(cluster_count);
+    Cluster mesh {};
+
+    for (uint32_t cluster_idx = 0; cluster_idx < cluster_count; cluster_idx++)
+    {
+        Cluster& cluster = cluster_list[cluster_idx];
+
+        for (uint32_t triangle = cluster_begin_list[cluster_idx]; triangle < cluster_begin_list[cluster_idx + 1]; triangle++)
+        {
+            const float* const p0 = position_data + static_cast<size_t>(index_data[triangle * 3 + 0]) * 3;
+            const float* const p1 = position_data + static_cast<size_t>(index_data[triangle * 3 + 1]) * 3;
+            const float* const p2 = position_data + static_cast<size_t>(index_data[triangle * 3 + 2]) * 3;
+
+            const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            const float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float area = 0.5f * sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const float centroid = (p0[i] + p1[i] + p2[i]) / 3.0f;
+                cluster.centroid[i] += centroid * area;
+                cluster.normal[i] += normal[i];
+                mesh.centroid[i] += centroid * area;
+            }
+
+            cluster.area += area;
+            mesh.area += area;
+        }
+    }
+
+    // Clusters facing away from the mesh center (and far from it) first.
+    std::vector<float> sort_key_list(cluster_count, 0.0f);
+
+    for (uint32_t cluster_idx = 0; cluster_idx < cluster_count; cluster_idx++)
+    {
+        const Cluster& cluster = cluster_list[cluster_idx];
+        const float normal_length = sqrtf(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+
+        if (cluster.area == 0.0f || mesh.area == 0.0f || normal_length == 0.0f)
+        {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            sort_key_list[cluster_idx] += (cluster.centroid[i] / cluster.area - mesh.centroid[i] / mesh.area) * cluster.normal[i] / normal_length;
+        }
+    }
+
+    std::vector<uint32_t> cluster_order(cluster_count);
+    std::iota(cluster_order.begin(), cluster_order.end(), 0);
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&sort_key_list](const uint32_t a, const uint32_t b) { return sort_key_list[a] > sort_key_list[b]; });
+
+    const std::vector<uint32_t> src_index_list(index_data, index_data + static_cast<size_t>(triangle_count) * 3);
+    uint32_t* dst = index_data;
+
+    for (const uint32_t cluster_idx : cluster_order)
+    {
+        const uint32_t begin = cluster_begin_list[cluster_idx] * 3;
+        const uint32_t end = cluster_begin_list[cluster_idx + 1] * 3;
+        dst = std::copy(src_index_list.begin() + begin, src_index_list.begin() + end, dst);
+    }
+
+    return cluster_count;
+}
+
+uint32_t optimize_vertex_fetch(uint8_t* const dst_vertex_data, uint32_t* const index_data, const uint32_t index_count, const uint8_t* const vertex_data, const uint32_t vertex_count, const uint32_t vertex_stride)
+{
+    std::vector<uint32_t> remap_list(vertex_count, UINT32_MAX);
+    uint32_t dst_vertex_count = 0;
+
+    for (uint32_t i = 0; i < index_count; i++)
+    {
+        uint32_t& remap = remap_list[index_data[i]];
+
+        if (remap == UINT32_MAX)
+        {
+            remap = dst_vertex_count++;
+            memcpy(dst_vertex_data + static_cast<size_t>(remap) * vertex_stride, vertex_data + static_cast<size_t>(index_data[i]) * vertex_stride, vertex_stride);
+        }
+
+        index_data[i] = remap;
+    }
+
+    return dst_vertex_count;
+}
+
+}; // mesh_optimizer
@@ -0,0 +1,28 @@
+#ifndef RENDERER_MESH_OPTIMIZER_HPP
+#define RENDERER_MESH_OPTIMIZER_HPP
+
+#include <inttypes.h>
+
+// Ingest time reordering of indexed triangle lists. All functions take 32 bit indices, narrowing happens afterwards.
+namespace mesh_optimizer
+{
+    // Average cache miss ratio, vertex shader invocations per triangle of a FIFO post-transform cache of cache_size
+    // entries. 0.5 is the best a regular grid can do, 3 means no vertex is ever reused.
+    float compute_acmr(const uint32_t* const index_data, const uint32_t index_count, const uint32_t vertex_count, const uint32_t cache_size);
+
+    // Orders triangles so vertices are reused while still in the post-transform cache (linear-speed vertex cache
+    // optimisation, Forsyth 2006). dst_index_data must not alias index_data.
+    void optimize_vertex_cache(uint32_t* const dst_index_data, const uint32_t* const index_data, const uint32_t index_count, const uint32_t vertex_count);
+
+    // Reorders clusters of an optimize_vertex_cache'd triangle list so surfaces facing away from the mesh center are drawn
+    // first and occlude the rest (Sander, Nehab & Barczak 2007). Clusters end once their ACMR is within threshold
+    // (e.g. 1.05) of the whole list's, bounding the cache efficiency given up. position_data is xyz per vertex.
+    // Returns the cluster count.
+    uint32_t optimize_overdraw(uint32_t* const index_data, const uint32_t index_count, const float* const position_data, const uint32_t vertex_count, const float threshold);
+
+    // Reorders vertices by first use in the index list and remaps the indices, so vertex fetches walk memory forward.
+    // Unreferenced vertices are dropped, returns the vertex count written to dst_vertex_data.
+    uint32_t optimize_vertex_fetch(uint8_t* const dst_vertex_data, uint32_t* const index_data, const uint32_t index_count, const uint8_t* const vertex_data, const uint32_t vertex_count, const uint32_t vertex_stride);
+}; // mesh_optimizer
+
+#endif // RENDERER_MESH_OPTIMIZER_HPP
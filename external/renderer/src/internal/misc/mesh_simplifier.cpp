@@ -0,0 +1,411 @@
+#include "mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Border planes are weighted well above the area weight of the faces, so borders only slide along themselves.
+static constexpr double s_border_weight = 10.0;
+
+// Sum of squared distances to weighted planes, Q(p) = p^T A p + 2 b.p + c, A symmetric.
+struct Quadric
+{
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+
+    void add_plane(const double* const normal, const double distance, const double plane_weight)
+    {
+        a00 += plane_weight * normal[0] * normal[0];
+        a01 += plane_weight * normal[0] * normal[1];
+        a02 += plane_weight * normal[0] * normal[2];
+        a11 += plane_weight * normal[1] * normal[1];
+        a12 += plane_weight * normal[1] * normal[2];
+        a22 += plane_weight * normal[2] * normal[2];
+        b0 += plane_weight * normal[0] * distance;
+        b1 += plane_weight * normal[1] * distance;
+        b2 += plane_weight * normal[2] * distance;
+        c += plane_weight * distance * distance;
+        weight += plane_weight;
+    }
+
+    void add(const Quadric& other)
+    {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    // Weighted mean squared distance of p to the planes.
+    double evaluate(const float* const p) const
+    {
+        const double x = p[0], y = p[1], z = p[2];
+        const double value = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+        return weight > 0.0 ? std::max(value, 0.0) / weight : 0.0;
+    }
+};
+
+struct Collapse
+{
+    double cost;
+    uint32_t src_vertex;
+    uint32_t dst_vertex;
+};
+
+static uint64_t get_edge_key(const uint32_t a, const uint32_t b)
+{
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+static void get_triangle_normal(const float* const p0, const float* const p1, const float* const p2, double* const normal)
+{
+    const double e0[3] = { static_cast<double>(p1[0]) - p0[0], static_cast<double>(p1[1]) - p0[1], static_cast<double>(p1[2]) - p0[2] };
+    const double e1[3] = { static_cast<double>(p2[0]) - p0[0], static_cast<double>(p2[1]) - p0[1], static_cast<double>(p2[2]) - p0[2] };
+
+    normal[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    normal[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    normal[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+namespace mesh_simplifier
+{
+
+uint32_t simplify(uint32_t* const dst_index_data, const uint32_t* const index_data, const uint32_t index_count,
+    const float* const position_data, const uint32_t vertex_count,
+    const uint32_t target_index_count, const float max_error, float& result_error)
+{
+    const auto get_position = [position_data](const uint32_t vertex) { return position_data + static_cast<size_t>(vertex) * 3; };
+
+    std::vector<uint32_t> index_list(index_data, index_data + index_count);
+    result_error = 0.0f;
+
+    // Vertices sharing a position differ in other attributes, moving one would tear the surface open.
+    std::vector<bool> is_locked_list(vertex_count, false);
+    {
+        std::vector<uint32_t> sorted_vertex_list(vertex_count);
+
+        for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+        {
+            sorted_vertex_list[vertex] = vertex;
+        }
+
+        const auto is_position_less = [&get_position](const uint32_t lhs, const uint32_t rhs)
+        {
+            return std::lexicographical_compare(get_position(lhs), get_position(lhs) + 3, get_position(rhs), get_position(rhs) + 3);
+        };
+
+        std::sort(sorted_vertex_list.begin(), sorted_vertex_list.end(), is_position_less);
+
+        for (uint32_t i = 1; i < vertex_count; i++)
+        {
+            if (!is_position_less(sorted_vertex_list[i - 1], sorted_vertex_list[i]))
+            {
+                is_locked_list[sorted_vertex_list[i - 1]] = true;
+                is_locked_list[sorted_vertex_list[i]] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadric_list(vertex_count);
+    std::vector<uint64_t> directed_edge_list; // sorted a << 32 | b for every triangle edge a -> b
+
+    const auto gather_directed_edges = [&index_list, &directed_edge_list](const uint32_t current_index_count)
+    {
+        directed_edge_list.clear();
+
+        for (uint32_t i = 0; i < current_index_count; i += 3)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                directed_edge_list.push_back(get_edge_key(index_list[i + k], index_list[i + (k + 1) % 3]));
+            }
+        }
+
+        std::sort(directed_edge_list.begin(), directed_edge_list.end());
+    };
+
+    const auto has_directed_edge = [&directed_edge_list](const uint32_t a, const uint32_t b)
+    {
+        return std::binary_search(directed_edge_list.begin(), directed_edge_list.end(), get_edge_key(a, b));
+    };
+
+    gather_directed_edges(index_count);
+
+    for (uint32_t i = 0; i < index_count; i += 3)
+    {
+        const float* const p[3] = { get_position(index_list[i]), get_position(index_list[i + 1]), get_position(index_list[i + 2]) };
+
+        double normal[3];
+        get_triangle_normal(p[0], p[1], p[2], normal);
+
+        const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+        if (length == 0.0)
+        {
+            continue;
+        }
+
+        for (double& component : normal)
+        {
+            component /= length;
+        }
+
+        const double distance = -(normal[0] * p[0][0] + normal[1] * p[0][1] + normal[2] * p[0][2]);
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            quadric_list[index_list[i + k]].add_plane(normal, distance, length * 0.5);
+        }
+
+        // Open edges get a plane through them perpendicular to the triangle.
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint32_t a = index_list[i + k];
+            const uint32_t b = index_list[i + (k + 1) % 3];
+
+            if (has_directed_edge(b, a))
+            {
+                continue;
+            }
+
+            const double edge[3] = { static_cast<double>(p[(k + 1) % 3][0]) - p[k][0], static_cast<double>(p[(k + 1) % 3][1]) - p[k][1], static_cast<double>(p[(k + 1) % 3][2]) - p[k][2] };
+            double border_normal[3] = { edge[1] * normal[2] - edge[2] * normal[1], edge[2] * normal[0] - edge[0] * normal[2], edge[0] * normal[1] - edge[1] * normal[0] };
+            const double border_length = sqrt(border_normal[0] * border_normal[0] + border_normal[1] * border_normal[1] + border_normal[2] * border_normal[2]);
+
+            if (border_length == 0.0)
+            {
+                continue;
+            }
+
+            for (double& component : border_normal)
+            {
+                component /= border_length;
+            }
+
+            const double border_distance = -(border_normal[0] * p[k][0] + border_normal[1] * p[k][1] + border_normal[2] * p[k][2]);
+            const double border_weight = s_border_weight * border_length * border_length;
+
+            quadric_list[a].add_plane(border_normal, border_distance, border_weight);
+            quadric_list[b].add_plane(border_normal, border_distance, border_weight);
+        }
+    }
+
+    const double max_cost = static_cast<double>(max_error) * max_error;
+    double applied_cost = 0.0;
+    uint32_t current_index_count = index_count;
+
+    std::vector<uint64_t> edge_list;
+    std::vector<Collapse> collapse_list;
+    std::vector<bool> is_border_list(vertex_count);
+    std::vector<bool> is_touched_list(vertex_count);
+    std::vector<uint32_t> remap_list(vertex_count);
+    std::vector<uint32_t> adjacency_offset_list(vertex_count + 1);
+    std::vector<uint32_t> adjacency_list; // triangle starts by vertex
+
+    // Every pass collapses a set of edges whose neighbourhoods do not overlap, so each flip test sees final positions.
+    while (current_index_count > target_index_count)
+    {
+        gather_directed_edges(current_index_count);
+
+        edge_list.clear();
+        std::fill(is_border_list.begin(), is_border_list.end(), false);
+
+        for (const uint64_t directed_edge : directed_edge_list)
+        {
+            const uint32_t a = static_cast<uint32_t>(directed_edge >> 32);
+            const uint32_t b = static_cast<uint32_t>(directed_edge);
+
+            if (!has_directed_edge(b, a))
+            {
+                is_border_list[a] = true;
+                is_border_list[b] = true;
+            }
+
+            edge_list.push_back(get_edge_key(std::min(a, b), std::max(a, b)));
+        }
+
+        std::sort(edge_list.begin(), edge_list.end());
+        edge_list.erase(std::unique(edge_list.begin(), edge_list.end()), edge_list.end());
+
+        const auto is_border_edge = [&has_directed_edge](const uint32_t a, const uint32_t b)
+        {
+            return has_directed_edge(a, b) != has_directed_edge(b, a);
+        };
+
+        const auto get_cost = [&](const uint32_t src_vertex, const uint32_t dst_vertex)
+        {
+            if (is_locked_list[src_vertex] || (is_border_list[src_vertex] && !is_border_edge(src_vertex, dst_vertex)))
+            {
+                return DBL_MAX;
+            }
+
+            Quadric quadric = quadric_list[src_vertex];
+            quadric.add(quadric_list[dst_vertex]);
+
+            return quadric.evaluate(get_position(dst_vertex));
+        };
+
+        collapse_list.clear();
+
+        for (const uint64_t edge : edge_list)
+        {
+            const uint32_t a = static_cast<uint32_t>(edge >> 32);
+            const uint32_t b = static_cast<uint32_t>(edge);
+            const double cost_ab = get_cost(a, b);
+            const double cost_ba = get_cost(b, a);
+            const Collapse collapse = cost_ab <= cost_ba ? Collapse { cost_ab, a, b } : Collapse { cost_ba, b, a };
+
+            if (collapse.cost <= max_cost)
+            {
+                collapse_list.push_back(collapse);
+            }
+        }
+
+        if (collapse_list.empty())
+        {
+            break;
+        }
+
+        std::sort(collapse_list.begin(), collapse_list.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.cost < rhs.cost; });
+
+        std::fill(adjacency_offset_list.begin(), adjacency_offset_list.end(), 0);
+
+        for (uint32_t i = 0; i < current_index_count; i++)
+        {
+            adjacency_offset_list[index_list[i] + 1]++;
+        }
+
+        for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+        {
+            adjacency_offset_list[vertex + 1] += adjacency_offset_list[vertex];
+        }
+
+        adjacency_list.resize(current_index_count);
+        {
+            std::vector<uint32_t> fill_offset_list(adjacency_offset_list.begin(), adjacency_offset_list.end() - 1);
+
+            for (uint32_t i = 0; i < current_index_count; i++)
+            {
+                adjacency_list[fill_offset_list[index_list[i]]++] = i - i % 3;
+            }
+        }
+
+        // Moving src_vertex onto dst_vertex must not turn any remaining triangle around src_vertex over.
+        const auto is_flipping = [&](const uint32_t src_vertex, const uint32_t dst_vertex)
+        {
+            for (uint32_t adjacency_idx = adjacency_offset_list[src_vertex]; adjacency_idx < adjacency_offset_list[src_vertex + 1]; adjacency_idx++)
+            {
+                const uint32_t* const triangle = &index_list[adjacency_list[adjacency_idx]];
+
+                if (triangle[0] == dst_vertex || triangle[1] == dst_vertex || triangle[2] == dst_vertex)
+                {
+                    continue;
+                }
+
+                const float* p[3] = { get_position(triangle[0]), get_position(triangle[1]), get_position(triangle[2]) };
+
+                double old_normal[3];
+                get_triangle_normal(p[0], p[1], p[2], old_normal);
+
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    p[k] = triangle[k] == src_vertex ? get_position(dst_vertex) : p[k];
+                }
+
+                double new_normal[3];
+                get_triangle_normal(p[0], p[1], p[2], new_normal);
+
+                const double old_length_sq = old_normal[0] * old_normal[0] + old_normal[1] * old_normal[1] + old_normal[2] * old_normal[2];
+                const double dot = old_normal[0] * new_normal[0] + old_normal[1] * new_normal[1] + old_normal[2] * new_normal[2];
+
+                if (old_length_sq > 0.0 && dot <= 0.0)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+        {
+            remap_list[vertex] = vertex;
+        }
+
+        std::fill(is_touched_list.begin(), is_touched_list.end(), false);
+
+        uint32_t removed_index_count = 0;
+        uint32_t collapse_count = 0;
+
+        for (const Collapse& collapse : collapse_list)
+        {
+            if (current_index_count - removed_index_count <= target_index_count)
+            {
+                break;
+            }
+
+            if (is_touched_list[collapse.src_vertex] || is_touched_list[collapse.dst_vertex] || is_flipping(collapse.src_vertex, collapse.dst_vertex))
+            {
+                continue;
+            }
+
+            for (uint32_t adjacency_idx = adjacency_offset_list[collapse.src_vertex]; adjacency_idx < adjacency_offset_list[collapse.src_vertex + 1]; adjacency_idx++)
+            {
+                const uint32_t* const triangle = &index_list[adjacency_list[adjacency_idx]];
+
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    is_touched_list[triangle[k]] = true;
+                }
+
+                if (triangle[0] == collapse.dst_vertex || triangle[1] == collapse.dst_vertex || triangle[2] == collapse.dst_vertex)
+                {
+                    removed_index_count += 3;
+                }
+            }
+
+            remap_list[collapse.src_vertex] = collapse.dst_vertex;
+            quadric_list[collapse.dst_vertex].add(quadric_list[collapse.src_vertex]);
+            applied_cost = std::max(applied_cost, collapse.cost);
+            collapse_count++;
+        }
+
+        if (collapse_count == 0)
+        {
+            break;
+        }
+
+        uint32_t write_count = 0;
+
+        for (uint32_t i = 0; i < current_index_count; i += 3)
+        {
+            const uint32_t a = remap_list[index_list[i]];
+            const uint32_t b = remap_list[index_list[i + 1]];
+            const uint32_t c = remap_list[index_list[i + 2]];
+
+            if (a == b || b == c || c == a)
+            {
+                continue;
+            }
+
+            index_list[write_count++] = a;
+            index_list[write_count++] = b;
+            index_list[write_count++] = c;
+        }
+
+        current_index_count = write_count;
+    }
+
+    result_error = static_cast<float>(sqrt(applied_cost));
+    memcpy(dst_index_data, index_list.data(), static_cast<size_t>(current_index_count) * sizeof(uint32_t));
+
+    return current_index_count;
+}
+
+}; // mesh_simplifier
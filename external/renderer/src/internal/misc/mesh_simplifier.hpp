@@ -0,0 +1,20 @@
+#ifndef RENDERER_MESH_SIMPLIFIER_HPP
+#define RENDERER_MESH_SIMPLIFIER_HPP
+
+#include <inttypes.h>
+
+// Ingest time simplification of indexed triangle lists into LODs that keep using the source vertices.
+namespace mesh_simplifier
+{
+    // Collapses edges onto one of their vertices in order of quadric error (Garland & Heckbert 1997) until the list is
+    // down to target_index_count or the next collapse would move the surface further than max_error. position_data is
+    // xyz per vertex. Collapses that flip a triangle are rejected, open borders only collapse along themselves and
+    // vertices sharing their position with another one (attribute seams) never move.
+    // Writes at most index_count indices to dst_index_data and returns their count. result_error is the largest
+    // distance a collapse moved the surface by, in position units.
+    uint32_t simplify(uint32_t* const dst_index_data, const uint32_t* const index_data, const uint32_t index_count,
+        const float* const position_data, const uint32_t vertex_count,
+        const uint32_t target_index_count, const float max_error, float& result_error);
+}; // mesh_simplifier
+
+#endif // RENDERER_MESH_SIMPLIFIER_HPP
@@ -0,0 +1,316 @@
+#include "sortbin_compatibility.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+struct SignatureBinding
+{
+    uint32_t binding;
+    uint32_t stride;
+    uint32_t input_rate;
+
+    auto operator<=>(const SignatureBinding&) const = default;
+};
+
+struct SignatureAttribute
+{
+    std::string usage;
+    uint32_t location;
+    uint32_t binding;
+    uint32_t format;
+    uint32_t offset;
+
+    auto operator<=>(const SignatureAttribute&) const = default;
+};
+
+struct Signature
+{
+    const sortbin_compatibility::SortBinState* p_state;
+    std::vector<SignatureBinding> binding_list; // sorted
+    std::vector<SignatureAttribute> attribute_list; // sorted, unique
+    std::vector<uint64_t> attribute_hash_list; // by attribute_list idx, binding_hash included
+    uint64_t binding_hash;
+    uint64_t material_hash; // 0 without a definition
+    uint64_t draw_hash; // 0 without a definition
+    uint64_t hash;
+
+    bool operator==(const Signature& other) const
+    {
+        return hash == other.hash &&
+               binding_list == other.binding_list &&
+               attribute_list == other.attribute_list &&
+               *p_state->p_definition_material_data == *other.p_state->p_definition_material_data &&
+               *p_state->p_definition_draw_data == *other.p_state->p_definition_draw_data;
+    }
+};
+
+static uint64_t hash_combine(const uint64_t seed, const uint64_t value)
+{
+    // splitmix64 finalizer
+    uint64_t hash = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+static uint64_t hash_desc_variable_list(const std::vector<JSONInfo_DescriptorVariable>& desc_var_list)
+{
+    uint64_t hash = desc_var_list.size();
+
+    for (const JSONInfo_DescriptorVariable& desc_var : desc_var_list)
+    {
+        hash = hash_combine(hash, std::hash<std::string>()(desc_var.name));
+        hash = hash_combine(hash, desc_var.offset);
+        hash = hash_combine(hash, desc_var.size);
+        hash = hash_combine(hash, desc_var.count);
+        hash = hash_combine(hash, hash_desc_variable_list(desc_var.internal_structure));
+    }
+
+    return hash;
+}
+
+static uint64_t hash_definition(const std::vector<JSONInfo_DescriptorVariable>& desc_var_list)
+{
+    return desc_var_list.empty() ? 0 : (hash_desc_variable_list(desc_var_list) | 0x1);
+}
+
+static Signature create_signature(const sortbin_compatibility::SortBinState& state)
+{
+    Signature signature {
+        .p_state = &state,
+        .binding_list = {},
+        .attribute_list = {},
+        .attribute_hash_list = {},
+        .binding_hash = 0,
+        .material_hash = hash_definition(*state.p_definition_material_data),
+        .draw_hash = hash_definition(*state.p_definition_draw_data),
+        .hash = 0,
+    };
+
+    for (const VkVertexInputBindingDescription& binding_description : state.p_vertex_input_state->binding_description_list)
+    {
+        signature.binding_list.push_back({ binding_description.binding, binding_description.stride, binding_description.inputRate });
+    }
+
+    for (const JSONInfo_SortBinPipelineState::VertexInputAttributeDescription& attribute_description : state.p_vertex_input_state->attribute_description_list)
+    {
+        signature.attribute_list.push_back({
+            attribute_description.usage,
+            attribute_description.attribute_desctiption.location,
+            attribute_description.attribute_desctiption.binding,
+            attribute_description.attribute_desctiption.format,
+            attribute_description.attribute_desctiption.offset,
+        });
+    }
+
+    std::sort(signature.binding_list.begin(), signature.binding_list.end());
+    std::sort(signature.attribute_list.begin(), signature.attribute_list.end());
+    signature.attribute_list.erase(std::unique(signature.attribute_list.begin(), signature.attribute_list.end()), signature.attribute_list.end());
+
+    signature.binding_hash = signature.binding_list.size();
+
+    for (const SignatureBinding& binding : signature.binding_list)
+    {
+        signature.binding_hash = hash_combine(signature.binding_hash, binding.binding);
+        signature.binding_hash = hash_combine(signature.binding_hash, binding.stride);
+        signature.binding_hash = hash_combine(signature.binding_hash, binding.input_rate);
+    }
+
+    signature.hash = hash_combine(hash_combine(signature.binding_hash, signature.material_hash), signature.draw_hash);
+
+    for (const SignatureAttribute& attribute : signature.attribute_list)
+    {
+        uint64_t attribute_hash = hash_combine(signature.binding_hash, std::hash<std::string>()(attribute.usage));
+        attribute_hash = hash_combine(attribute_hash, attribute.location);
+        attribute_hash = hash_combine(attribute_hash, attribute.binding);
+        attribute_hash = hash_combine(attribute_hash, attribute.format);
+        attribute_hash = hash_combine(attribute_hash, attribute.offset);
+
+        signature.attribute_hash_list.push_back(attribute_hash);
+        signature.hash = hash_combine(signature.hash, attribute_hash);
+    }
+
+    return signature;
+}
+
+static bool is_signature_compatible(const Signature& signature_a, const Signature& signature_b)
+{
+    if (signature_a.binding_hash != signature_b.binding_hash || signature_a.binding_list != signature_b.binding_list)
+    {
+        return false;
+    }
+
+    if (signature_a.material_hash != 0 && signature_b.material_hash != 0 &&
+        (signature_a.material_hash != signature_b.material_hash || *signature_a.p_state->p_definition_material_data != *signature_b.p_state->p_definition_material_data))
+    {
+        return false;
+    }
+
+    if (signature_a.draw_hash != 0 && signature_b.draw_hash != 0 &&
+        (signature_a.draw_hash != signature_b.draw_hash || *signature_a.p_state->p_definition_draw_data != *signature_b.p_state->p_definition_draw_data))
+    {
+        return false;
+    }
+
+    const bool is_a_smaller = signature_a.attribute_list.size() <= signature_b.attribute_list.size();
+    const std::vector<SignatureAttribute>& small_attribute_list = is_a_smaller ? signature_a.attribute_list : signature_b.attribute_list;
+    const std::vector<SignatureAttribute>& large_attribute_list = is_a_smaller ? signature_b.attribute_list : signature_a.attribute_list;
+
+    return std::includes(large_attribute_list.begin(), large_attribute_list.end(), small_attribute_list.begin(), small_attribute_list.end());
+}
+
+namespace sortbin_compatibility
+{
+
+std::vector<uint16_t> classify(const std::vector<SortBinState>& state_list, ClassifyStats& stats)
+{
+    const auto classify_start = std::chrono::steady_clock::now();
+
+    stats = {};
+
+    std::vector<Signature> signature_list;
+    signature_list.reserve(state_list.size());
+
+    for (const SortBinState& state : state_list)
+    {
+        signature_list.push_back(create_signature(state));
+    }
+
+    std::vector<uint16_t> class_list(state_list.size());
+    std::vector<uint32_t> founder_list; // by class, signature_list idx
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> signature_umap; // hash -> signature_list idx of each distinct signature
+    std::unordered_map<uint64_t, std::vector<uint16_t>> attribute_class_umap; // attribute hash -> classes whose founder has it
+    std::unordered_map<uint64_t, std::vector<uint16_t>> binding_class_umap; // binding hash -> classes
+    std::unordered_map<uint64_t, std::vector<uint16_t>> binding_empty_class_umap; // binding hash -> classes of founders without attributes
+
+    std::vector<uint32_t> hit_count_list; // by class
+    std::vector<uint16_t> hit_class_list;
+
+    for (uint32_t signature_idx = 0; signature_idx < signature_list.size(); signature_idx++)
+    {
+        const Signature& signature = signature_list[signature_idx];
+
+        std::vector<uint32_t>& same_hash_list = signature_umap[signature.hash];
+        const auto same_iter = std::find_if(same_hash_list.begin(), same_hash_list.end(), [&](const uint32_t other_idx) { return signature_list[other_idx] == signature; });
+
+        // Same candidates as the earlier sortbin and no class founded since can be an earlier one.
+        if (same_iter != same_hash_list.end())
+        {
+            class_list[signature_idx] = class_list[*same_iter];
+            stats.signature_hit_count++;
+            continue;
+        }
+
+        same_hash_list.push_back(signature_idx);
+
+        uint32_t class_ID = UINT32_MAX;
+
+        const auto check_candidate = [&](const uint16_t candidate_class_ID)
+        {
+            if (candidate_class_ID < class_ID)
+            {
+                stats.candidate_count++;
+
+                if (is_signature_compatible(signature_list[founder_list[candidate_class_ID]], signature))
+                {
+                    class_ID = candidate_class_ID;
+                }
+            }
+        };
+
+        const auto find_class_list = [](const std::unordered_map<uint64_t, std::vector<uint16_t>>& umap, const uint64_t key) -> const std::vector<uint16_t>*
+        {
+            const auto iter = umap.find(key);
+            return iter == umap.end() ? nullptr : &iter->second;
+        };
+
+        if (signature.attribute_list.empty())
+        {
+            // Subset of every founder with the same bindings.
+            if (const std::vector<uint16_t>* p_class_list = find_class_list(binding_class_umap, signature.binding_hash))
+            {
+                for (const uint16_t candidate_class_ID : *p_class_list)
+                {
+                    check_candidate(candidate_class_ID);
+                }
+            }
+        }
+        else
+        {
+            for (const uint64_t attribute_hash : signature.attribute_hash_list)
+            {
+                if (const std::vector<uint16_t>* p_class_list = find_class_list(attribute_class_umap, attribute_hash))
+                {
+                    for (const uint16_t candidate_class_ID : *p_class_list)
+                    {
+                        if (hit_count_list[candidate_class_ID]++ == 0)
+                        {
+                            hit_class_list.push_back(candidate_class_ID);
+                        }
+                    }
+                }
+            }
+
+            for (const uint16_t candidate_class_ID : hit_class_list)
+            {
+                const uint32_t hit_count = hit_count_list[candidate_class_ID];
+                const uint32_t founder_attribute_count = static_cast<uint32_t>(signature_list[founder_list[candidate_class_ID]].attribute_list.size());
+
+                if (hit_count == founder_attribute_count || hit_count == signature.attribute_list.size())
+                {
+                    check_candidate(candidate_class_ID);
+                }
+
+                hit_count_list[candidate_class_ID] = 0;
+            }
+
+            hit_class_list.clear();
+
+            if (const std::vector<uint16_t>* p_class_list = find_class_list(binding_empty_class_umap, signature.binding_hash))
+            {
+                for (const uint16_t candidate_class_ID : *p_class_list)
+                {
+                    check_candidate(candidate_class_ID);
+                }
+            }
+        }
+
+        if (class_ID == UINT32_MAX)
+        {
+            ASSERT(founder_list.size() < UINT16_MAX, "Too many incompatible sortbins!\n");
+
+            class_ID = static_cast<uint32_t>(founder_list.size());
+            founder_list.push_back(signature_idx);
+            hit_count_list.push_back(0);
+
+            binding_class_umap[signature.binding_hash].push_back(static_cast<uint16_t>(class_ID));
+
+            if (signature.attribute_list.empty())
+            {
+                binding_empty_class_umap[signature.binding_hash].push_back(static_cast<uint16_t>(class_ID));
+            }
+
+            for (const uint64_t attribute_hash : signature.attribute_hash_list)
+            {
+                attribute_class_umap[attribute_hash].push_back(static_cast<uint16_t>(class_ID));
+            }
+        }
+
+        class_list[signature_idx] = static_cast<uint16_t>(class_ID);
+    }
+
+    stats.class_count = static_cast<uint32_t>(founder_list.size());
+    stats.classify_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - classify_start).count());
+
+    return class_list;
+}
+
+bool is_compatible(const SortBinState& state_a, const SortBinState& state_b)
+{
+    return is_signature_compatible(create_signature(state_a), create_signature(state_b));
+}
+
+}; // sortbin_compatibility
@@ -0,0 +1,43 @@
+#ifndef RENDERER_SORTBIN_COMPATIBILITY_HPP
+#define RENDERER_SORTBIN_COMPATIBILITY_HPP
+
+#include "json_structures.hpp"
+
+#include <inttypes.h>
+#include <vector>
+
+// Groups sortbins whose renderables can move between each other, reading the same vertices and material and draw data.
+//
+// Two sortbins are compatible when their vertex bindings match, the vertex attributes of one are a subset of the
+// other's, compared by usage, location, binding, format and offset regardless of declaration order, and their
+// material and draw data definitions are equal or either one is empty. The relation is not transitive, so each
+// sortbin in turn joins the first class whose founding sortbin it is compatible with, or founds a new one.
+//
+// Every sortbin gets a canonical signature once, sorted attributes and 64 bit hashes of all of the above. Sortbins
+// with the signature of an earlier one take its class from a hash map. The others look their candidate classes up in
+// an index from attribute to the classes whose founder has it: a founder sharing all of the sortbin's attributes is
+// a superset, one whose attributes are all shared a subset. Only those candidates are compared in full.
+namespace sortbin_compatibility
+{
+    struct SortBinState
+    {
+        const JSONInfo_SortBinPipelineState::VertexInputState* p_vertex_input_state;
+        const std::vector<JSONInfo_DescriptorVariable>* p_definition_material_data;
+        const std::vector<JSONInfo_DescriptorVariable>* p_definition_draw_data;
+    };
+
+    struct ClassifyStats
+    {
+        uint32_t class_count = 0;
+        uint32_t signature_hit_count = 0; // sortbins classified by an earlier identical signature
+        uint64_t candidate_count = 0; // classes compared in full
+        uint64_t classify_ns = 0;
+    };
+
+    // Returns the class of each state, numbered in order of first appearance.
+    std::vector<uint16_t> classify(const std::vector<SortBinState>& state_list, ClassifyStats& stats);
+
+    bool is_compatible(const SortBinState& state_a, const SortBinState& state_b);
+}; // sortbin_compatibility
+
+#endif // RENDERER_SORTBIN_COMPATIBILITY_HPP
@@ -0,0 +1,1004 @@
+#include "logger.hpp"
+#include "state_bundle.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <unordered_set>
+
+enum BundleSectionID : uint32_t
+{
+    eStrings,
+    eDescVariables,
+    eFrameBindings,
+    eSortBinReflections,
+    ePushConstants,
+    eSortBinPipelines,
+    eShaderNames,
+    eVertexBindings,
+    eVertexAttributes,
+    eAttachments,
+    eReadAttachments,
+    eWriteAttachments,
+    ePasses,
+    eSortBins,
+    eSectionCount
+};
+
+struct BundleHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t byte_count;
+    uint32_t section_count;
+    uint32_t reserved;
+};
+
+struct BundleSection
+{
+    uint32_t record_size;
+    uint32_t record_count;
+    uint64_t offset; // from the start of the bundle
+};
+
+struct BundleString
+{
+    uint32_t offset; // into eStrings
+    uint32_t size;
+};
+
+struct BundleRange
+{
+    uint32_t first;
+    uint32_t count;
+};
+
+struct BundleDescVariable
+{
+    BundleString name;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t count;
+    BundleRange internal_structure; // eDescVariables, always after the variable itself
+};
+
+struct BundleFrameBinding
+{
+    BundleString name;
+    uint32_t binding_ID;
+    uint32_t descriptor_type;
+    uint32_t descriptor_count;
+    uint32_t stage_flags;
+    BundleRange buffer_variables; // eDescVariables
+};
+
+struct BundleBlockDefinition
+{
+    uint32_t size;
+    uint32_t end_padding;
+    BundleRange members; // eDescVariables
+};
+
+struct BundleSortBinReflection
+{
+    BundleString sortbin_name;
+    BundleBlockDefinition definition_material_data;
+    BundleBlockDefinition definition_draw_data;
+    BundleRange push_consts; // ePushConstants
+};
+
+struct BundlePushConstant
+{
+    uint32_t shader_stage_flags;
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct BundleSortBinPipeline
+{
+    BundleString sortbin_name;
+    BundleRange shader_names; // eShaderNames
+    BundleRange vertex_bindings; // eVertexBindings
+    BundleRange vertex_attributes; // eVertexAttributes
+    uint32_t topology;
+    uint32_t polygon_mode;
+    uint32_t cull_mode;
+    uint32_t front_face;
+    uint32_t depth_test_enable;
+    uint32_t depth_write_enable;
+    uint32_t depth_compare_op;
+    uint32_t stencil_test_enable;
+};
+
+struct BundleVertexBinding
+{
+    uint32_t binding;
+    uint32_t stride;
+    uint32_t input_rate;
+};
+
+struct BundleVertexAttribute
+{
+    BundleString usage;
+    uint32_t location;
+    uint32_t binding;
+    uint32_t format;
+    uint32_t offset;
+};
+
+// The first record is the shared state, present_mask has a bit per optional member in declaration order.
+struct BundleAttachment
+{
+    BundleString name;
+    uint32_t present_mask;
+    uint32_t format;
+    uint32_t num_samples;
+    uint32_t tiling;
+    uint32_t usage;
+    uint32_t sharing_mode;
+    uint32_t initial_layout;
+};
+
+struct BundleReadAttachment
+{
+    BundleString name;
+    uint32_t image_layout;
+};
+
+struct BundleWriteAttachment
+{
+    BundleString name;
+    uint32_t image_layout;
+    uint32_t load_op;
+    uint32_t store_op;
+    uint32_t clear_value[4]; // VkClearValue bits
+};
+
+struct BundlePass
+{
+    BundleString name;
+    BundleRange input_attachments; // eReadAttachments
+    BundleRange color_attachments; // eWriteAttachments
+    uint32_t depth_attachment; // eWriteAttachments idx, UINT32_MAX without one
+    uint32_t flags;
+    float max_screen_error;
+    uint32_t draw_order;
+};
+
+struct BundleSortBin
+{
+    BundleString name;
+    BundleString render_pass_name;
+};
+
+static_assert(sizeof(VkClearValue) == sizeof(BundleWriteAttachment::clear_value));
+
+static constexpr uint32_t s_record_size_list[eSectionCount] = {
+    1,
+    sizeof(BundleDescVariable),
+    sizeof(BundleFrameBinding),
+    sizeof(BundleSortBinReflection),
+    sizeof(BundlePushConstant),
+    sizeof(BundleSortBinPipeline),
+    sizeof(BundleString),
+    sizeof(BundleVertexBinding),
+    sizeof(BundleVertexAttribute),
+    sizeof(BundleAttachment),
+    sizeof(BundleReadAttachment),
+    sizeof(BundleWriteAttachment),
+    sizeof(BundlePass),
+    sizeof(BundleSortBin),
+};
+
+static constexpr uint32_t s_pass_flag_occlusion_culling = 0x1;
+static constexpr uint32_t s_pass_flag_two_phase = 0x2;
+static constexpr uint32_t s_pass_flag_reverse_z = 0x4;
+static constexpr uint32_t s_pass_flag_lod_selection = 0x8;
+
+static constexpr uint32_t s_max_desc_variable_depth = 16;
+
+static uint64_t align_offset(const uint64_t offset)
+{
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+static nlohmann::json read_json_file(const char* const filepath)
+{
+    std::ifstream file(filepath);
+    ASSERT(file.is_open(), "Failed to vulkan init config file: %s\n", filepath);
+
+    const nlohmann::json json_data = nlohmann::json::parse(file);
+
+    file.close();
+
+    return json_data;
+}
+
+struct BundleWriter
+{
+    std::vector<uint8_t> section_data_list[eSectionCount];
+
+    uint32_t get_record_count(const BundleSectionID section_ID) const
+    {
+        return static_cast<uint32_t>(section_data_list[section_ID].size() / s_record_size_list[section_ID]);
+    }
+
+    template<typename Record>
+    uint32_t push(const BundleSectionID section_ID, const Record& record)
+    {
+        const uint32_t record_idx = get_record_count(section_ID);
+        const uint8_t* const p_record = reinterpret_cast<const uint8_t*>(&record);
+
+        section_data_list[section_ID].insert(section_data_list[section_ID].end(), p_record, p_record + sizeof(Record));
+
+        return record_idx;
+    }
+
+    template<typename Record>
+    void set(const BundleSectionID section_ID, const uint32_t record_idx, const Record& record)
+    {
+        memcpy(section_data_list[section_ID].data() + record_idx * sizeof(Record), &record, sizeof(Record));
+    }
+
+    BundleString push_string(const std::string& str)
+    {
+        std::vector<uint8_t>& string_data = section_data_list[eStrings];
+        const BundleString bundle_string { .offset = static_cast<uint32_t>(string_data.size()), .size = static_cast<uint32_t>(str.size()) };
+
+        string_data.insert(string_data.end(), str.begin(), str.end());
+
+        return bundle_string;
+    }
+
+    // Reserves the whole list first so it stays contiguous, members' own lists land after it.
+    BundleRange push_desc_variable_list(const std::vector<JSONInfo_DescriptorVariable>& desc_var_list)
+    {
+        const BundleRange range { .first = get_record_count(eDescVariables), .count = static_cast<uint32_t>(desc_var_list.size()) };
+
+        for (uint32_t i = 0; i < range.count; i++)
+        {
+            push(eDescVariables, BundleDescVariable {});
+        }
+
+        for (uint32_t i = 0; i < range.count; i++)
+        {
+            const JSONInfo_DescriptorVariable& desc_var = desc_var_list[i];
+
+            const BundleDescVariable record {
+                .name = push_string(desc_var.name),
+                .offset = desc_var.offset,
+                .size = desc_var.size,
+                .count = desc_var.count,
+                .internal_structure = push_desc_variable_list(desc_var.internal_structure),
+            };
+
+            set(eDescVariables, range.first + i, record);
+        }
+
+        return range;
+    }
+
+    BundleBlockDefinition push_block_definition(const JSONInfo_SortBinReflection::BlockDefinition& block_definition)
+    {
+        return {
+            .size = block_definition.size,
+            .end_padding = block_definition.end_padding,
+            .members = push_desc_variable_list(block_definition.members),
+        };
+    }
+
+    BundleAttachment push_attachment(const JSONInfo_RenderAttachment::ImageState& image_state)
+    {
+        return {
+            .name = push_string(image_state.name),
+            .present_mask = (image_state.format.has_value() ? 0x1u : 0x0u) |
+                            (image_state.num_samples.has_value() ? 0x2u : 0x0u) |
+                            (image_state.tiling.has_value() ? 0x4u : 0x0u) |
+                            (image_state.usage.has_value() ? 0x8u : 0x0u) |
+                            (image_state.sharing_mode.has_value() ? 0x10u : 0x0u) |
+                            (image_state.initial_layout.has_value() ? 0x20u : 0x0u),
+            .format = image_state.format.value_or(VK_FORMAT_UNDEFINED),
+            .num_samples = image_state.num_samples.value_or(VK_SAMPLE_COUNT_1_BIT),
+            .tiling = image_state.tiling.value_or(VK_IMAGE_TILING_OPTIMAL),
+            .usage = image_state.usage.value_or(0x0),
+            .sharing_mode = image_state.sharing_mode.value_or(VK_SHARING_MODE_EXCLUSIVE),
+            .initial_layout = image_state.initial_layout.value_or(VK_IMAGE_LAYOUT_UNDEFINED),
+        };
+    }
+
+    BundleWriteAttachment push_write_attachment(const JSONInfo_RenderPass::WriteAttachmentState& attachment_state)
+    {
+        BundleWriteAttachment record {
+            .name = push_string(attachment_state.name),
+            .image_layout = attachment_state.image_layout,
+            .load_op = attachment_state.load_op,
+            .store_op = attachment_state.store_op,
+            .clear_value = {},
+        };
+
+        memcpy(record.clear_value, &attachment_state.clear_value, sizeof(record.clear_value));
+
+        return record;
+    }
+};
+
+// Bounds checks every record, string and range it hands out. A failed check marks the bundle invalid and returns an
+// empty value, so reading carries on and is rejected as a whole at the end.
+struct BundleReader
+{
+    const uint8_t* p_data;
+    uint64_t byte_count;
+    BundleSection section_list[eSectionCount];
+    bool is_valid;
+
+    template<typename Record>
+    Record get(const BundleSectionID section_ID, const uint32_t record_idx)
+    {
+        Record record {};
+
+        if (record_idx < section_list[section_ID].record_count)
+        {
+            memcpy(&record, p_data + section_list[section_ID].offset + static_cast<uint64_t>(record_idx) * sizeof(Record), sizeof(Record));
+        }
+        else
+        {
+            is_valid = false;
+        }
+
+        return record;
+    }
+
+    bool is_range_valid(const BundleSectionID section_ID, const BundleRange& range)
+    {
+        is_valid &= static_cast<uint64_t>(range.first) + range.count <= section_list[section_ID].record_count;
+        return is_valid;
+    }
+
+    std::string get_string(const BundleString& bundle_string)
+    {
+        if (static_cast<uint64_t>(bundle_string.offset) + bundle_string.size > section_list[eStrings].record_count)
+        {
+            is_valid = false;
+            return {};
+        }
+
+        return std::string(reinterpret_cast<const char*>(p_data + section_list[eStrings].offset + bundle_string.offset), bundle_string.size);
+    }
+
+    std::vector<JSONInfo_DescriptorVariable> get_desc_variable_list(const BundleRange& range, const uint32_t depth)
+    {
+        std::vector<JSONInfo_DescriptorVariable> desc_var_list;
+
+        if (!is_range_valid(eDescVariables, range) || depth > s_max_desc_variable_depth)
+        {
+            is_valid = false;
+            return desc_var_list;
+        }
+
+        desc_var_list.reserve(range.count);
+
+        for (uint32_t record_idx = range.first; record_idx < range.first + range.count; record_idx++)
+        {
+            const BundleDescVariable record = get<BundleDescVariable>(eDescVariables, record_idx);
+
+            desc_var_list.push_back({
+                .name = get_string(record.name),
+                .offset = record.offset,
+                .size = record.size,
+                .count = record.count,
+                .internal_structure = get_desc_variable_list(record.internal_structure, depth + 1),
+            });
+        }
+
+        return desc_var_list;
+    }
+
+    JSONInfo_SortBinReflection::BlockDefinition get_block_definition(const BundleBlockDefinition& record)
+    {
+        return {
+            .size = record.size,
+            .end_padding = record.end_padding,
+            .members = get_desc_variable_list(record.members, 0),
+        };
+    }
+
+    JSONInfo_RenderAttachment::ImageState get_attachment(const uint32_t record_idx)
+    {
+        const BundleAttachment record = get<BundleAttachment>(eAttachments, record_idx);
+
+        JSONInfo_RenderAttachment::ImageState image_state;
+        image_state.name = get_string(record.name);
+
+        if (record.present_mask & 0x1) image_state.format = static_cast<VkFormat>(record.format);
+        if (record.present_mask & 0x2) image_state.num_samples = static_cast<VkSampleCountFlagBits>(record.num_samples);
+        if (record.present_mask & 0x4) image_state.tiling = static_cast<VkImageTiling>(record.tiling);
+        if (record.present_mask & 0x8) image_state.usage = record.usage;
+        if (record.present_mask & 0x10) image_state.sharing_mode = static_cast<VkSharingMode>(record.sharing_mode);
+        if (record.present_mask & 0x20) image_state.initial_layout = static_cast<VkImageLayout>(record.initial_layout);
+
+        return image_state;
+    }
+
+    JSONInfo_RenderPass::WriteAttachmentState get_write_attachment(const uint32_t record_idx)
+    {
+        const BundleWriteAttachment record = get<BundleWriteAttachment>(eWriteAttachments, record_idx);
+
+        JSONInfo_RenderPass::WriteAttachmentState attachment_state {
+            .name = get_string(record.name),
+            .image_layout = static_cast<VkImageLayout>(record.image_layout),
+            .load_op = static_cast<VkAttachmentLoadOp>(record.load_op),
+            .store_op = static_cast<VkAttachmentStoreOp>(record.store_op),
+            .clear_value = {},
+        };
+
+        memcpy(&attachment_state.clear_value, record.clear_value, sizeof(record.clear_value));
+
+        return attachment_state;
+    }
+};
+
+namespace state_bundle
+{
+
+StateDescription parse_json_files(const char* const refl_file_frame_desc_set_def,
+    const char* const refl_file_sortbin_mat_draw_def,
+    const char* const file_sortbin_pipeline_state,
+    const char* const file_app_state)
+{
+    const nlohmann::json json_data_app_state = read_json_file(file_app_state);
+
+    StateDescription description;
+    description.frame_desc_set_binding_list = read_json_file(refl_file_frame_desc_set_def).at("bindings").get<std::vector<JSONInfo_DescriptorBinding>>();
+    description.sortbin_reflection_info = read_json_file(refl_file_sortbin_mat_draw_def).at("sortbin-reflections").get<JSONInfo_SortBinReflection>();
+    description.sortbin_pipeline_state_info = read_json_file(file_sortbin_pipeline_state).at("sortbins").get<JSONInfo_SortBinPipelineState>();
+    description.render_attachment_info = json_data_app_state.at("render-attachments").get<JSONInfo_RenderAttachment>();
+    description.render_pass_info = json_data_app_state.at("render-passes").get<JSONInfo_RenderPass>();
+    description.sortbin_info = json_data_app_state.at("sortbins").get<JSONInfo_AppSortBin>();
+
+    return description;
+}
+
+std::vector<std::string> validate(const StateDescription& description)
+{
+    std::vector<std::string> error_list;
+
+    std::unordered_set<std::string> attachment_name_uset;
+    for (const JSONInfo_RenderAttachment::ImageState& image_state : description.render_attachment_info.image_state_list)
+    {
+        if (!attachment_name_uset.insert(image_state.name).second)
+        {
+            error_list.push_back("Render attachment " + image_state.name + " already exists");
+        }
+    }
+
+    std::unordered_set<std::string> pass_name_uset;
+    for (const JSONInfo_RenderPass::State& render_pass_state : description.render_pass_info.state_list)
+    {
+        if (!pass_name_uset.insert(render_pass_state.name).second)
+        {
+            error_list.push_back("Render pass " + render_pass_state.name + " already exists");
+        }
+
+        std::vector<std::string> attachment_name_list;
+
+        for (const JSONInfo_RenderPass::ReadAttachmentState& attachment_state : render_pass_state.input_attachment_list)
+        {
+            attachment_name_list.push_back(attachment_state.name);
+        }
+
+        for (const JSONInfo_RenderPass::WriteAttachmentState& attachment_state : render_pass_state.color_attachment_list)
+        {
+            attachment_name_list.push_back(attachment_state.name);
+        }
+
+        if (render_pass_state.depth_attachment.has_value())
+        {
+            attachment_name_list.push_back(render_pass_state.depth_attachment.value().name);
+        }
+
+        for (const std::string& attachment_name : attachment_name_list)
+        {
+            if (!attachment_name_uset.contains(attachment_name))
+            {
+                error_list.push_back("Render pass " + render_pass_state.name + " uses unregistered render attachment " + attachment_name);
+            }
+        }
+    }
+
+    std::unordered_set<std::string> sortbin_name_uset;
+    for (const JSONInfo_AppSortBin::State& sortbin_state : description.sortbin_info.sortbin_list)
+    {
+        if (!sortbin_name_uset.insert(sortbin_state.name).second)
+        {
+            error_list.push_back("Sortbin " + sortbin_state.name + " already exists");
+        }
+
+        if (!pass_name_uset.contains(sortbin_state.render_pass_name))
+        {
+            error_list.push_back("Sortbin " + sortbin_state.name + " uses unregistered render pass " + sortbin_state.render_pass_name);
+        }
+
+        const auto pipeline_state_iter = description.sortbin_pipeline_state_info.state_umap.find(sortbin_state.name);
+
+        if (pipeline_state_iter == description.sortbin_pipeline_state_info.state_umap.end())
+        {
+            error_list.push_back("Sortbin " + sortbin_state.name + " has no pipeline state");
+        }
+        else if (pipeline_state_iter->second.pipeline_state.shader_state.shader_names.empty())
+        {
+            error_list.push_back("Sortbin " + sortbin_state.name + " has no shaders");
+        }
+
+        if (!description.sortbin_reflection_info.state_umap.contains(sortbin_state.name))
+        {
+            error_list.push_back("Sortbin " + sortbin_state.name + " has no reflection");
+        }
+    }
+
+    std::unordered_set<uint32_t> binding_ID_uset;
+    for (const JSONInfo_DescriptorBinding& binding : description.frame_desc_set_binding_list)
+    {
+        if (!binding_ID_uset.insert(binding.binding_ID).second)
+        {
+            error_list.push_back("Frame descriptor binding " + binding.name + " reuses binding " + std::to_string(binding.binding_ID));
+        }
+    }
+
+    return error_list;
+}
+
+bool write(const StateDescription& description, const char* const file_path)
+{
+    BundleWriter writer;
+
+    for (const JSONInfo_DescriptorBinding& binding : description.frame_desc_set_binding_list)
+    {
+        writer.push(eFrameBindings, BundleFrameBinding {
+            .name = writer.push_string(binding.name),
+            .binding_ID = binding.binding_ID,
+            .descriptor_type = binding.descriptor_type,
+            .descriptor_count = binding.descriptor_count,
+            .stage_flags = binding.stage_flags,
+            .buffer_variables = writer.push_desc_variable_list(binding.buffer_variables),
+        });
+    }
+
+    for (const auto& [sortbin_name, reflection_state] : description.sortbin_reflection_info.state_umap)
+    {
+        const BundleRange push_const_range { .first = writer.get_record_count(ePushConstants), .count = static_cast<uint32_t>(reflection_state.push_const_state_list.size()) };
+
+        for (const JSONInfo_SortBinReflection::PushConstantState& push_const_state : reflection_state.push_const_state_list)
+        {
+            writer.push(ePushConstants, BundlePushConstant {
+                .shader_stage_flags = push_const_state.shader_stage_flags,
+                .offset = push_const_state.offset,
+                .size = push_const_state.size,
+            });
+        }
+
+        writer.push(eSortBinReflections, BundleSortBinReflection {
+            .sortbin_name = writer.push_string(sortbin_name),
+            .definition_material_data = writer.push_block_definition(reflection_state.definition_material_data),
+            .definition_draw_data = writer.push_block_definition(reflection_state.definition_draw_data),
+            .push_consts = push_const_range,
+        });
+    }
+
+    for (const auto& [sortbin_name, sortbin_state] : description.sortbin_pipeline_state_info.state_umap)
+    {
+        const JSONInfo_SortBinPipelineState::PipelineState& pipeline_state = sortbin_state.pipeline_state;
+
+        const BundleRange shader_name_range { .first = writer.get_record_count(eShaderNames), .count = static_cast<uint32_t>(pipeline_state.shader_state.shader_names.size()) };
+        for (const std::string& shader_name : pipeline_state.shader_state.shader_names)
+        {
+            writer.push(eShaderNames, writer.push_string(shader_name));
+        }
+
+        const BundleRange vertex_binding_range { .first = writer.get_record_count(eVertexBindings), .count = static_cast<uint32_t>(pipeline_state.vertex_input_state.binding_description_list.size()) };
+        for (const VkVertexInputBindingDescription& binding_description : pipeline_state.vertex_input_state.binding_description_list)
+        {
+            writer.push(eVertexBindings, BundleVertexBinding {
+                .binding = binding_description.binding,
+                .stride = binding_description.stride,
+                .input_rate = binding_description.inputRate,
+            });
+        }
+
+        const BundleRange vertex_attribute_range { .first = writer.get_record_count(eVertexAttributes), .count = static_cast<uint32_t>(pipeline_state.vertex_input_state.attribute_description_list.size()) };
+        for (const JSONInfo_SortBinPipelineState::VertexInputAttributeDescription& attribute_description : pipeline_state.vertex_input_state.attribute_description_list)
+        {
+            writer.push(eVertexAttributes, BundleVertexAttribute {
+                .usage = writer.push_string(attribute_description.usage),
+                .location = attribute_description.attribute_desctiption.location,
+                .binding = attribute_description.attribute_desctiption.binding,
+                .format = attribute_description.attribute_desctiption.format,
+                .offset = attribute_description.attribute_desctiption.offset,
+            });
+        }
+
+        writer.push(eSortBinPipelines, BundleSortBinPipeline {
+            .sortbin_name = writer.push_string(sortbin_name),
+            .shader_names = shader_name_range,
+            .vertex_bindings = vertex_binding_range,
+            .vertex_attributes = vertex_attribute_range,
+            .topology = pipeline_state.input_assembly_state.topology,
+            .polygon_mode = pipeline_state.rasterization_state.polygon_mode,
+            .cull_mode = pipeline_state.rasterization_state.cull_mode,
+            .front_face = pipeline_state.rasterization_state.front_face,
+            .depth_test_enable = pipeline_state.depth_stencil_state.depth_test_enable,
+            .depth_write_enable = pipeline_state.depth_stencil_state.depth_write_enable,
+            .depth_compare_op = pipeline_state.depth_stencil_state.depth_compare_op,
+            .stencil_test_enable = pipeline_state.depth_stencil_state.stencil_test_enable,
+        });
+    }
+
+    writer.push(eAttachments, writer.push_attachment(description.render_attachment_info.shared_image_state));
+    for (const JSONInfo_RenderAttachment::ImageState& image_state : description.render_attachment_info.image_state_list)
+    {
+        writer.push(eAttachments, writer.push_attachment(image_state));
+    }
+
+    for (const JSONInfo_RenderPass::State& render_pass_state : description.render_pass_info.state_list)
+    {
+        const BundleRange input_attachment_range { .first = writer.get_record_count(eReadAttachments), .count = static_cast<uint32_t>(render_pass_state.input_attachment_list.size()) };
+        for (const JSONInfo_RenderPass::ReadAttachmentState& attachment_state : render_pass_state.input_attachment_list)
+        {
+            writer.push(eReadAttachments, BundleReadAttachment {
+                .name = writer.push_string(attachment_state.name),
+                .image_layout = attachment_state.image_layout,
+            });
+        }
+
+        const BundleRange color_attachment_range { .first = writer.get_record_count(eWriteAttachments), .count = static_cast<uint32_t>(render_pass_state.color_attachment_list.size()) };
+        for (const JSONInfo_RenderPass::WriteAttachmentState& attachment_state : render_pass_state.color_attachment_list)
+        {
+            writer.push(eWriteAttachments, writer.push_write_attachment(attachment_state));
+        }
+
+        const uint32_t depth_attachment_idx = render_pass_state.depth_attachment.has_value() ?
+            writer.push(eWriteAttachments, writer.push_write_attachment(render_pass_state.depth_attachment.value())) : UINT32_MAX;
+
+        const uint32_t flags = (render_pass_state.occlusion_culling.has_value() ? s_pass_flag_occlusion_culling : 0x0) |
+                               (render_pass_state.occlusion_culling.has_value() && render_pass_state.occlusion_culling.value().is_two_phase ? s_pass_flag_two_phase : 0x0) |
+                               (render_pass_state.occlusion_culling.has_value() && render_pass_state.occlusion_culling.value().is_reverse_z ? s_pass_flag_reverse_z : 0x0) |
+                               (render_pass_state.lod_selection.has_value() ? s_pass_flag_lod_selection : 0x0);
+
+        writer.push(ePasses, BundlePass {
+            .name = writer.push_string(render_pass_state.name),
+            .input_attachments = input_attachment_range,
+            .color_attachments = color_attachment_range,
+            .depth_attachment = depth_attachment_idx,
+            .flags = flags,
+            .max_screen_error = render_pass_state.lod_selection.has_value() ? render_pass_state.lod_selection.value().max_screen_error : 0.0f,
+            .draw_order = static_cast<uint32_t>(render_pass_state.draw_order),
+        });
+    }
+
+    for (const JSONInfo_AppSortBin::State& sortbin_state : description.sortbin_info.sortbin_list)
+    {
+        writer.push(eSortBins, BundleSortBin {
+            .name = writer.push_string(sortbin_state.name),
+            .render_pass_name = writer.push_string(sortbin_state.render_pass_name),
+        });
+    }
+
+    // Layout
+
+    BundleSection section_list[eSectionCount];
+    uint64_t byte_count = sizeof(BundleHeader) + sizeof(section_list);
+
+    for (uint32_t section_ID = 0; section_ID < eSectionCount; section_ID++)
+    {
+        byte_count = align_offset(byte_count);
+
+        section_list[section_ID] = {
+            .record_size = s_record_size_list[section_ID],
+            .record_count = writer.get_record_count(static_cast<BundleSectionID>(section_ID)),
+            .offset = byte_count,
+        };
+
+        byte_count += writer.section_data_list[section_ID].size();
+    }
+
+    byte_count = align_offset(byte_count);
+
+    const BundleHeader header {
+        .magic = s_magic,
+        .version = s_version,
+        .byte_count = byte_count,
+        .section_count = eSectionCount,
+        .reserved = 0,
+    };
+
+    std::vector<uint8_t> data(byte_count, 0);
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + sizeof(header), section_list, sizeof(section_list));
+
+    for (uint32_t section_ID = 0; section_ID < eSectionCount; section_ID++)
+    {
+        if (!writer.section_data_list[section_ID].empty())
+        {
+            memcpy(data.data() + section_list[section_ID].offset, writer.section_data_list[section_ID].data(), writer.section_data_list[section_ID].size());
+        }
+    }
+
+    const std::string tmp_file_path = std::string(file_path) + ".tmp";
+    FILE* const file = fopen(tmp_file_path.c_str(), "wb");
+
+    if (!file)
+    {
+        LOG("Warning - Could not write state bundle %s\n", tmp_file_path.c_str());
+        return false;
+    }
+
+    const bool is_written = fwrite(data.data(), 1, data.size(), file) == data.size();
+
+    if (fclose(file) != 0 || !is_written || rename(tmp_file_path.c_str(), file_path) != 0)
+    {
+        LOG("Warning - Could not write state bundle %s\n", file_path);
+        remove(tmp_file_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool read(const char* const file_path, StateDescription& description)
+{
+    const int fd = open(file_path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        LOG("Warning - Could not open state bundle %s\n", file_path);
+        return false;
+    }
+
+    struct stat file_stat {};
+    const bool is_stat = fstat(fd, &file_stat) == 0;
+    const uint64_t file_byte_count = is_stat ? static_cast<uint64_t>(file_stat.st_size) : 0;
+
+    if (file_byte_count < sizeof(BundleHeader) + sizeof(BundleSection) * eSectionCount)
+    {
+        close(fd);
+        LOG("Warning - %s is not a state bundle\n", file_path);
+        return false;
+    }
+
+    void* const p_mapping = mmap(nullptr, file_byte_count, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (p_mapping == MAP_FAILED)
+    {
+        LOG("Warning - Could not map state bundle %s\n", file_path);
+        return false;
+    }
+
+    BundleReader reader {
+        .p_data = static_cast<const uint8_t*>(p_mapping),
+        .byte_count = file_byte_count,
+        .section_list = {},
+        .is_valid = true,
+    };
+
+    BundleHeader header;
+    memcpy(&header, reader.p_data, sizeof(header));
+
+    if (header.magic != s_magic || header.version != s_version || header.byte_count != file_byte_count || header.section_count != eSectionCount)
+    {
+        munmap(p_mapping, file_byte_count);
+        LOG("Warning - State bundle %s is not of version %u\n", file_path, s_version);
+        return false;
+    }
+
+    memcpy(reader.section_list, reader.p_data + sizeof(header), sizeof(reader.section_list));
+
+    for (uint32_t section_ID = 0; section_ID < eSectionCount; section_ID++)
+    {
+        const BundleSection& section = reader.section_list[section_ID];
+
+        reader.is_valid &= section.record_size == s_record_size_list[section_ID] &&
+                           section.offset % 8 == 0 &&
+                           section.offset <= file_byte_count &&
+                           static_cast<uint64_t>(section.record_size) * section.record_count <= file_byte_count - section.offset;
+    }
+
+    // The attachment list always holds the shared state.
+    reader.is_valid &= reader.section_list[eAttachments].record_count > 0;
+
+    description = {};
+
+    if (reader.is_valid)
+    {
+        for (uint32_t record_idx = 0; record_idx < reader.section_list[eFrameBindings].record_count; record_idx++)
+        {
+            const BundleFrameBinding record = reader.get<BundleFrameBinding>(eFrameBindings, record_idx);
+
+            description.frame_desc_set_binding_list.push_back({
+                .name = reader.get_string(record.name),
+                .binding_ID = record.binding_ID,
+                .descriptor_type = static_cast<VkDescriptorType>(record.descriptor_type),
+                .descriptor_count = record.descriptor_count,
+                .stage_flags = record.stage_flags,
+                .buffer_variables = reader.get_desc_variable_list(record.buffer_variables, 0),
+            });
+        }
+
+        for (uint32_t record_idx = 0; record_idx < reader.section_list[eSortBinReflections].record_count; record_idx++)
+        {
+            const BundleSortBinReflection record = reader.get<BundleSortBinReflection>(eSortBinReflections, record_idx);
+
+            JSONInfo_SortBinReflection::State reflection_state {
+                .sortbin_name = reader.get_string(record.sortbin_name),
+                .definition_material_data = reader.get_block_definition(record.definition_material_data),
+                .definition_draw_data = reader.get_block_definition(record.definition_draw_data),
+                .push_const_state_list = {},
+            };
+
+            if (reader.is_range_valid(ePushConstants, record.push_consts))
+            {
+                for (uint32_t push_const_idx = record.push_consts.first; push_const_idx < record.push_consts.first + record.push_consts.count; push_const_idx++)
+                {
+                    const BundlePushConstant push_const_record = reader.get<BundlePushConstant>(ePushConstants, push_const_idx);
+
+                    reflection_state.push_const_state_list.push_back({
+                        .shader_stage_flags = push_const_record.shader_stage_flags,
+                        .offset = push_const_record.offset,
+                        .size = push_const_record.size,
+                    });
+                }
+            }
+
+            description.sortbin_reflection_info.state_umap.insert({ reflection_state.sortbin_name, reflection_state });
+        }
+
+        for (uint32_t record_idx = 0; record_idx < reader.section_list[eSortBinPipelines].record_count; record_idx++)
+        {
+            const BundleSortBinPipeline record = reader.get<BundleSortBinPipeline>(eSortBinPipelines, record_idx);
+
+            JSONInfo_SortBinPipelineState::State sortbin_state;
+            sortbin_state.sortbin_name = reader.get_string(record.sortbin_name);
+
+            JSONInfo_SortBinPipelineState::PipelineState& pipeline_state = sortbin_state.pipeline_state;
+
+            if (reader.is_range_valid(eShaderNames, record.shader_names))
+            {
+                for (uint32_t name_idx = record.shader_names.first; name_idx < record.shader_names.first + record.shader_names.count; name_idx++)
+                {
+                    pipeline_state.shader_state.shader_names.push_back(reader.get_string(reader.get<BundleString>(eShaderNames, name_idx)));
+                }
+            }
+
+            if (reader.is_range_valid(eVertexBindings, record.vertex_bindings))
+            {
+                for (uint32_t binding_idx = record.vertex_bindings.first; binding_idx < record.vertex_bindings.first + record.vertex_bindings.count; binding_idx++)
+                {
+                    const BundleVertexBinding binding_record = reader.get<BundleVertexBinding>(eVertexBindings, binding_idx);
+
+                    pipeline_state.vertex_input_state.binding_description_list.push_back({
+                        .binding = binding_record.binding,
+                        .stride = binding_record.stride,
+                        .inputRate = static_cast<VkVertexInputRate>(binding_record.input_rate),
+                    });
+                }
+            }
+
+            if (reader.is_range_valid(eVertexAttributes, record.vertex_attributes))
+            {
+                for (uint32_t attribute_idx = record.vertex_attributes.first; attribute_idx < record.vertex_attributes.first + record.vertex_attributes.count; attribute_idx++)
+                {
+                    const BundleVertexAttribute attribute_record = reader.get<BundleVertexAttribute>(eVertexAttributes, attribute_idx);
+
+                    pipeline_state.vertex_input_state.attribute_description_list.push_back({
+                        .usage = reader.get_string(attribute_record.usage),
+                        .attribute_desctiption = {
+                            .location = attribute_record.location,
+                            .binding = attribute_record.binding,
+                            .format = static_cast<VkFormat>(attribute_record.format),
+                            .offset = attribute_record.offset,
+                        },
+                    });
+                }
+            }
+
+            pipeline_state.input_assembly_state.topology = static_cast<VkPrimitiveTopology>(record.topology);
+            pipeline_state.rasterization_state = {
+                .polygon_mode = static_cast<VkPolygonMode>(record.polygon_mode),
+                .cull_mode = record.cull_mode,
+                .front_face = static_cast<VkFrontFace>(record.front_face),
+            };
+            pipeline_state.depth_stencil_state = {
+                .depth_test_enable = record.depth_test_enable != 0,
+                .depth_write_enable = record.depth_write_enable != 0,
+                .depth_compare_op = static_cast<VkCompareOp>(record.depth_compare_op),
+                .stencil_test_enable = record.stencil_test_enable != 0,
+            };
+
+            description.sortbin_pipeline_state_info.state_umap.insert({ sortbin_state.sortbin_name, sortbin_state });
+        }
+
+        description.render_attachment_info.shared_image_state = reader.get_attachment(0);
+        for (uint32_t record_idx = 1; record_idx < reader.section_list[eAttachments].record_count; record_idx++)
+        {
+            description.render_attachment_info.image_state_list.push_back(reader.get_attachment(record_idx));
+        }
+
+        for (uint32_t record_idx = 0; record_idx < reader.section_list[ePasses].record_count; record_idx++)
+        {
+            const BundlePass record = reader.get<BundlePass>(ePasses, record_idx);
+
+            JSONInfo_RenderPass::State render_pass_state;
+            render_pass_state.name = reader.get_string(record.name);
+
+            if (reader.is_range_valid(eReadAttachments, record.input_attachments))
+            {
+                for (uint32_t attachment_idx = record.input_attachments.first; attachment_idx < record.input_attachments.first + record.input_attachments.count; attachment_idx++)
+                {
+                    const BundleReadAttachment attachment_record = reader.get<BundleReadAttachment>(eReadAttachments, attachment_idx);
+
+                    render_pass_state.input_attachment_list.push_back({
+                        .name = reader.get_string(attachment_record.name),
+                        .image_layout = static_cast<VkImageLayout>(attachment_record.image_layout),
+                    });
+                }
+            }
+
+            if (reader.is_range_valid(eWriteAttachments, record.color_attachments))
+            {
+                for (uint32_t attachment_idx = record.color_attachments.first; attachment_idx < record.color_attachments.first + record.color_attachments.count; attachment_idx++)
+                {
+                    render_pass_state.color_attachment_list.push_back(reader.get_write_attachment(attachment_idx));
+                }
+            }
+
+            if (record.depth_attachment != UINT32_MAX)
+            {
+                render_pass_state.depth_attachment = reader.get_write_attachment(record.depth_attachment);
+            }
+
+            if (record.flags & s_pass_flag_occlusion_culling)
+            {
+                render_pass_state.occlusion_culling = JSONInfo_RenderPass::OcclusionCullingState {
+                    .is_two_phase = (record.flags & s_pass_flag_two_phase) != 0,
+                    .is_reverse_z = (record.flags & s_pass_flag_reverse_z) != 0,
+                };
+            }
+
+            if (record.flags & s_pass_flag_lod_selection)
+            {
+                render_pass_state.lod_selection = JSONInfo_RenderPass::LodSelectionState { .max_screen_error = record.max_screen_error };
+            }
+
+            reader.is_valid &= record.draw_order <= static_cast<uint32_t>(DrawOrder::eBackToFront);
+            render_pass_state.draw_order = static_cast<DrawOrder>(record.draw_order);
+
+            description.render_pass_info.state_list.push_back(render_pass_state);
+        }
+
+        for (uint32_t record_idx = 0; record_idx < reader.section_list[eSortBins].record_count; record_idx++)
+        {
+            const BundleSortBin record = reader.get<BundleSortBin>(eSortBins, record_idx);
+
+            description.sortbin_info.sortbin_list.push_back({
+                .name = reader.get_string(record.name),
+                .render_pass_name = reader.get_string(record.render_pass_name),
+            });
+        }
+    }
+
+    munmap(p_mapping, file_byte_count);
+
+    if (!reader.is_valid)
+    {
+        description = {};
+        LOG("Warning - State bundle %s is corrupt\n", file_path);
+        return false;
+    }
+
+    return true;
+}
+
+}; // state_bundle
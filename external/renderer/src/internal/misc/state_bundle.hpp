@@ -0,0 +1,38 @@
+#ifndef RENDERER_STATE_BUNDLE_HPP
+#define RENDERER_STATE_BUNDLE_HPP
+
+#include "StateDescription.hpp"
+
+#include <inttypes.h>
+#include <string>
+#include <vector>
+
+// Loading of the renderer's StateDescription, from its JSON files during development or from a state bundle, a binary
+// image of it compiled offline by tools/state_bundle_compiler.cpp.
+//
+// A bundle is a header, a table of sections and the sections themselves, 8 byte aligned. Every section is a flat
+// array of fixed size records, in the byte order of the machine that compiled it: attachments, passes, sortbins,
+// descriptor variables, vertex layouts and a string table. Nested lists are first/count ranges into another section,
+// strings are offset/size ranges into the string table. Reading maps the file and copies the records out.
+namespace state_bundle
+{
+    static constexpr uint32_t s_magic = 0x4C425352; // "RSBL"
+    static constexpr uint32_t s_version = 1; // bump with any record layout change
+
+    // Throws nlohmann::json::exception on malformed JSON.
+    StateDescription parse_json_files(const char* const refl_file_frame_desc_set_def,
+        const char* const refl_file_sortbin_mat_draw_def,
+        const char* const file_sortbin_pipeline_state,
+        const char* const file_app_state);
+
+    // Cross file consistency: unique names, passes only using registered attachments, every sortbin in a registered
+    // pass and with both a pipeline state and a reflection. Returns one message per problem, empty when valid.
+    std::vector<std::string> validate(const StateDescription& description);
+
+    bool write(const StateDescription& description, const char* const file_path);
+
+    // Fails on a missing file, another format version or records out of the file's bounds, logging why.
+    bool read(const char* const file_path, StateDescription& description);
+}; // state_bundle
+
+#endif // RENDERER_STATE_BUNDLE_HPP
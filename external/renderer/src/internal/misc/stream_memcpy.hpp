@@ -0,0 +1,58 @@
+#ifndef RENDERER_STREAM_MEMCPY_HPP
+#define RENDERER_STREAM_MEMCPY_HPP
+
+#include <cstring>
+#include <inttypes.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// memcpy variant for write-combined (host visible, uncached) destinations such as mapped staging memory.
+// Uses non-temporal 16 byte stores in 64 byte bursts so full WC lines are written and the source does not
+// evict useful cache lines. Falls back to plain memcpy on targets without SSE2.
+inline void stream_memcpy(void* const dst, const void* const src, const size_t size)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    uint8_t* d = static_cast<uint8_t*>(dst);
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    size_t remaining = size;
+
+    const size_t head = (16 - (reinterpret_cast<uintptr_t>(d) & 15)) & 15;
+
+    if (remaining < head + 64)
+    {
+        memcpy(d, s, remaining);
+        return;
+    }
+
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    remaining -= head;
+
+    while (remaining >= 64)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s +  0));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+        const __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d +  0), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 48), e);
+        d += 64;
+        s += 64;
+        remaining -= 64;
+    }
+
+    memcpy(d, s, remaining);
+
+    // Non-temporal stores are weakly ordered, make them visible before the copy is submitted.
+    _mm_sfence();
+#else
+    memcpy(dst, src, size);
+#endif
+}
+
+#endif // RENDERER_STREAM_MEMCPY_HPP
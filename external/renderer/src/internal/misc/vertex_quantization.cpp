@@ -0,0 +1,294 @@
+#include "vertex_quantization.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+static uint32_t get_float_component_count(const VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R32G32_SFLOAT: return 2;
+        case VK_FORMAT_R32G32B32_SFLOAT: return 3;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return 4;
+        default: return 0;
+    }
+}
+
+uint32_t vertex_quantization::get_format_size(const VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8G8_SNORM: return 2;
+        case VK_FORMAT_R8G8B8_SNORM: return 3;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R16G16_UNORM:
+        case VK_FORMAT_R16G16_SNORM: return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R16G16B16A16_SNORM: return 8;
+        default: return get_float_component_count(format) * static_cast<uint32_t>(sizeof(float));
+    }
+}
+
+// Round to nearest, overflow to infinity, underflow through half denormals to zero.
+static uint16_t float_to_half(const float value)
+{
+    const uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if ((bits & 0x7F800000) == 0x7F800000)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+
+    if (exponent >= 31)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+        {
+            return static_cast<uint16_t>(sign);
+        }
+
+        mantissa |= 0x800000;
+        const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        const uint32_t half = (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // A rounding carry out of the mantissa correctly bumps the exponent.
+    const uint32_t half = (sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1);
+    return static_cast<uint16_t>(half);
+}
+
+static uint16_t float_to_unorm16(const float value)
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+static int16_t float_to_snorm16(const float value)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static int8_t float_to_snorm8(const float value)
+{
+    return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+}
+
+// Unit vector projected onto the octahedron |x| + |y| + |z| = 1, the lower half folded over the diagonals.
+static void encode_octahedral(const float* const normal, float* const encoded)
+{
+    const float l1_length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+
+    if (l1_length == 0.0f)
+    {
+        encoded[0] = 0.0f;
+        encoded[1] = 0.0f;
+        return;
+    }
+
+    const float u = normal[0] / l1_length;
+    const float v = normal[1] / l1_length;
+
+    if (normal[2] >= 0.0f)
+    {
+        encoded[0] = u;
+        encoded[1] = v;
+        return;
+    }
+
+    encoded[0] = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+    encoded[1] = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+}
+
+namespace vertex_quantization
+{
+
+bool is_supported(const std::string& usage, const VkFormat src_format, const VkFormat dst_format)
+{
+    if (src_format == dst_format)
+    {
+        return get_format_size(src_format) != 0;
+    }
+
+    const uint32_t src_component_count = get_float_component_count(src_format);
+
+    if (src_component_count == 0)
+    {
+        return false;
+    }
+
+    if (get_float_component_count(dst_format) != 0)
+    {
+        return true;
+    }
+
+    if (usage == "vertex_pos")
+    {
+        return dst_format == VK_FORMAT_R16G16B16A16_SFLOAT || dst_format == VK_FORMAT_R16G16B16A16_UNORM || dst_format == VK_FORMAT_R16G16B16A16_SNORM;
+    }
+
+    if (usage == "vertex_normal")
+    {
+        return src_component_count >= 3 && (dst_format == VK_FORMAT_R16G16_SNORM || dst_format == VK_FORMAT_R8G8_SNORM);
+    }
+
+    if (usage == "vertex_texcoord")
+    {
+        return dst_format == VK_FORMAT_R16G16_SFLOAT || dst_format == VK_FORMAT_R16G16_UNORM;
+    }
+
+    return false;
+}
+
+PositionTransform get_position_transform(const VkFormat dst_format, const BoundingBox& bounds)
+{
+    PositionTransform position_transform {};
+
+    if (!bounds.is_valid())
+    {
+        return position_transform;
+    }
+
+    switch (dst_format)
+    {
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R16G16B16A16_SNORM:
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                position_transform.scale[i] = bounds.extent[i];
+                position_transform.bias[i] = bounds.center[i];
+            }
+            break;
+        }
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                position_transform.scale[i] = 2.0f * bounds.extent[i];
+                position_transform.bias[i] = bounds.center[i] - bounds.extent[i];
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    return position_transform;
+}
+
+void convert_attribute(const std::string& usage,
+    const uint8_t* const src_vertex_data, const uint32_t src_stride, const VkFormat src_format,
+    uint8_t* const dst_vertex_data, const uint32_t dst_stride, const VkFormat dst_format,
+    const uint32_t vertex_count,
+    const PositionTransform& position_transform)
+{
+    const uint32_t src_component_count = get_float_component_count(src_format);
+    const uint32_t dst_component_count = get_float_component_count(dst_format);
+    const bool is_position = usage == "vertex_pos";
+
+    for (uint32_t vertex_idx = 0; vertex_idx < vertex_count; vertex_idx++)
+    {
+        const uint8_t* const src = src_vertex_data + static_cast<size_t>(vertex_idx) * src_stride;
+        uint8_t* const dst = dst_vertex_data + static_cast<size_t>(vertex_idx) * dst_stride;
+
+        if (src_format == dst_format)
+        {
+            memcpy(dst, src, get_format_size(src_format));
+            continue;
+        }
+
+        // Missing components read as 0, a position's w as 1.
+        float value[4] = { 0.0f, 0.0f, 0.0f, is_position ? 1.0f : 0.0f };
+        memcpy(value, src, std::min(src_component_count, 4u) * sizeof(float));
+
+        if (dst_component_count != 0)
+        {
+            memcpy(dst, value, dst_component_count * sizeof(float));
+            continue;
+        }
+
+        if (is_position)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                value[i] = position_transform.scale[i] != 0.0f ? (value[i] - position_transform.bias[i]) / position_transform.scale[i] : 0.0f;
+            }
+
+            value[3] = 1.0f;
+        }
+
+        switch (dst_format)
+        {
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+            case VK_FORMAT_R16G16_SFLOAT:
+            {
+                const uint32_t component_count = dst_format == VK_FORMAT_R16G16_SFLOAT ? 2 : 4;
+
+                for (uint32_t i = 0; i < component_count; i++)
+                {
+                    const uint16_t half = float_to_half(value[i]);
+                    memcpy(dst + i * sizeof(uint16_t), &half, sizeof(uint16_t));
+                }
+                break;
+            }
+            case VK_FORMAT_R16G16B16A16_UNORM:
+            case VK_FORMAT_R16G16_UNORM:
+            {
+                const uint32_t component_count = dst_format == VK_FORMAT_R16G16_UNORM ? 2 : 4;
+
+                for (uint32_t i = 0; i < component_count; i++)
+                {
+                    const uint16_t unorm = float_to_unorm16(value[i]);
+                    memcpy(dst + i * sizeof(uint16_t), &unorm, sizeof(uint16_t));
+                }
+                break;
+            }
+            case VK_FORMAT_R16G16B16A16_SNORM:
+            {
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    const int16_t snorm = float_to_snorm16(value[i]);
+                    memcpy(dst + i * sizeof(int16_t), &snorm, sizeof(int16_t));
+                }
+                break;
+            }
+            case VK_FORMAT_R16G16_SNORM:
+            {
+                float encoded[2];
+                encode_octahedral(value, encoded);
+
+                const int16_t snorm[2] = { float_to_snorm16(encoded[0]), float_to_snorm16(encoded[1]) };
+                memcpy(dst, snorm, sizeof(snorm));
+                break;
+            }
+            case VK_FORMAT_R8G8_SNORM:
+            {
+                float encoded[2];
+                encode_octahedral(value, encoded);
+
+                const int8_t snorm[2] = { float_to_snorm8(encoded[0]), float_to_snorm8(encoded[1]) };
+                memcpy(dst, snorm, sizeof(snorm));
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+}
+
+}; // vertex_quantization
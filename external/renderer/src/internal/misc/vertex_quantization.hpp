@@ -0,0 +1,45 @@
+#ifndef RENDERER_VERTEX_QUANTIZATION_HPP
+#define RENDERER_VERTEX_QUANTIZATION_HPP
+
+#include "../pod/BoundingBox.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <inttypes.h>
+#include <string>
+
+// Ingest time conversion of float vertex attributes into the compact formats a sortbin's vertex-input state declares.
+// Conversions by the attribute's JSON "usage":
+//
+//   vertex_pos       R16G16B16A16_SFLOAT / _SNORM    (position - center) / extent of the mesh bounds, w = 1
+//                    R16G16B16A16_UNORM              (position - min) / (max - min), w = 1
+//   vertex_normal    R16G16_SNORM / R8G8_SNORM       octahedral encoding
+//   vertex_texcoord  R16G16_SFLOAT                   half floats
+//                    R16G16_UNORM                    clamped to [0, 1]
+//
+// Any usage also copies identical formats and converts between the 32 bit float formats.
+namespace vertex_quantization
+{
+    // Object space position = stored position * scale + bias. Identity for unquantized positions.
+    struct PositionTransform
+    {
+        float scale[3] = { 1.0f, 1.0f, 1.0f };
+        float bias[3] = { 0.0f, 0.0f, 0.0f };
+    };
+
+    // Bytes of one attribute of a format the conversions know, 0 otherwise.
+    uint32_t get_format_size(const VkFormat format);
+
+    bool is_supported(const std::string& usage, const VkFormat src_format, const VkFormat dst_format);
+
+    PositionTransform get_position_transform(const VkFormat dst_format, const BoundingBox& bounds);
+
+    // Converts the attribute of vertex_count vertices. src_format must be a 32 bit float format.
+    void convert_attribute(const std::string& usage,
+        const uint8_t* const src_vertex_data, const uint32_t src_stride, const VkFormat src_format,
+        uint8_t* const dst_vertex_data, const uint32_t dst_stride, const VkFormat dst_format,
+        const uint32_t vertex_count,
+        const PositionTransform& position_transform);
+}; // vertex_quantization
+
+#endif // RENDERER_VERTEX_QUANTIZATION_HPP
@@ -5,7 +5,7 @@
 
 #include <unordered_map>
 
-VkImageType string_to_enum_VkImageType(const std::string& str)
+inline VkImageType string_to_enum_VkImageType(const std::string& str)
 {
     const std::unordered_map<std::string, VkImageType> mapping {
         { "VK_IMAGE_TYPE_1D"             , VK_IMAGE_TYPE_1D },
@@ -16,7 +16,7 @@ VkImageType string_to_enum_VkImageType(const std::string& str)
     return mapping.at(str);
 }
 
-VkImageTiling string_to_enum_VkImageTiling(const std::string& str)
+inline VkImageTiling string_to_enum_VkImageTiling(const std::string& str)
 {
     const std::unordered_map<std::string, VkImageTiling> mapping {
         { "VK_IMAGE_TILING_OPTIMAL", VK_IMAGE_TILING_OPTIMAL },
@@ -26,7 +26,7 @@ VkImageTiling string_to_enum_VkImageTiling(const std::string& str)
     return mapping.at(str);
 }
 
-VkSharingMode string_to_enum_VkSharingMode(const std::string& str)
+inline VkSharingMode string_to_enum_VkSharingMode(const std::string& str)
 {
     const std::unordered_map<std::string, VkSharingMode> mapping {
         { "VK_SHARING_MODE_EXCLUSIVE"  , VK_SHARING_MODE_EXCLUSIVE  },
@@ -36,7 +36,7 @@ VkSharingMode string_to_enum_VkSharingMode(const std::string& str)
     return mapping.at(str);
 }
 
-VkImageLayout string_to_enum_VkImageLayout(const std::string& str)
+inline VkImageLayout string_to_enum_VkImageLayout(const std::string& str)
 {
     const std::unordered_map<std::string, VkImageLayout> mapping {
         { "VK_IMAGE_LAYOUT_UNDEFINED"                                  , VK_IMAGE_LAYOUT_UNDEFINED                                  },
@@ -62,7 +62,7 @@ VkImageLayout string_to_enum_VkImageLayout(const std::string& str)
     return mapping.at(str);
 }
 
-VkImageUsageFlags string_to_enum_VkImageUsageFlags(const std::string& str)
+inline VkImageUsageFlags string_to_enum_VkImageUsageFlags(const std::string& str)
 {
     const std::unordered_map<std::string, VkImageUsageFlags> mapping {
         { "VK_IMAGE_USAGE_TRANSFER_SRC_BIT"             , VK_IMAGE_USAGE_TRANSFER_SRC_BIT             }, 
@@ -78,7 +78,7 @@ VkImageUsageFlags string_to_enum_VkImageUsageFlags(const std::string& str)
     return mapping.at(str);
 }
 
-VkAttachmentLoadOp string_to_enum_VkAttachmentLoadOp(const std::string& str)
+inline VkAttachmentLoadOp string_to_enum_VkAttachmentLoadOp(const std::string& str)
 {
     const std::unordered_map<std::string, VkAttachmentLoadOp> mapping {
         { "VK_ATTACHMENT_LOAD_OP_LOAD"      , VK_ATTACHMENT_LOAD_OP_LOAD      },    
@@ -89,7 +89,7 @@ VkAttachmentLoadOp string_to_enum_VkAttachmentLoadOp(const std::string& str)
     return mapping.at(str);
 }
 
-VkAttachmentStoreOp string_to_enum_VkAttachmentStoreOp(const std::string& str)
+inline VkAttachmentStoreOp string_to_enum_VkAttachmentStoreOp(const std::string& str)
 {
     const std::unordered_map<std::string, VkAttachmentStoreOp> mapping {
         { "VK_ATTACHMENT_STORE_OP_STORE"     , VK_ATTACHMENT_STORE_OP_STORE     },    
@@ -99,7 +99,7 @@ VkAttachmentStoreOp string_to_enum_VkAttachmentStoreOp(const std::string& str)
     return mapping.at(str);
 }
 
-VkFormat string_to_enum_VkFormat(const std::string& str)
+inline VkFormat string_to_enum_VkFormat(const std::string& str)
 {
     const std::unordered_map<std::string, VkFormat> mapping {
         { "VK_FORMAT_R8G8B8A8_UNORM"  , VK_FORMAT_R8G8B8A8_UNORM },
@@ -107,12 +107,20 @@ VkFormat string_to_enum_VkFormat(const std::string& str)
         { "VK_FORMAT_R32G32B32_SFLOAT", VK_FORMAT_R32G32B32_SFLOAT },
         { "VK_FORMAT_R32G32_SFLOAT"   , VK_FORMAT_R32G32_SFLOAT },
         { "VK_FORMAT_R8G8B8_SNORM"    , VK_FORMAT_R8G8B8_SNORM },
+        { "VK_FORMAT_R32G32B32A32_SFLOAT", VK_FORMAT_R32G32B32A32_SFLOAT },
+        { "VK_FORMAT_R16G16B16A16_SFLOAT", VK_FORMAT_R16G16B16A16_SFLOAT },
+        { "VK_FORMAT_R16G16B16A16_UNORM" , VK_FORMAT_R16G16B16A16_UNORM },
+        { "VK_FORMAT_R16G16B16A16_SNORM" , VK_FORMAT_R16G16B16A16_SNORM },
+        { "VK_FORMAT_R16G16_SFLOAT"      , VK_FORMAT_R16G16_SFLOAT },
+        { "VK_FORMAT_R16G16_UNORM"       , VK_FORMAT_R16G16_UNORM },
+        { "VK_FORMAT_R16G16_SNORM"       , VK_FORMAT_R16G16_SNORM },
+        { "VK_FORMAT_R8G8_SNORM"         , VK_FORMAT_R8G8_SNORM },
     };
 
     return mapping.at(str);
 }
 
-VkSampleCountFlagBits uint32_to_enum_VkSampleCountFlagBits(const uint32_t val)
+inline VkSampleCountFlagBits uint32_to_enum_VkSampleCountFlagBits(const uint32_t val)
 {
     const std::unordered_map<uint32_t, VkSampleCountFlagBits> mapping {
         { 1  , VK_SAMPLE_COUNT_1_BIT  },
@@ -127,7 +135,7 @@ VkSampleCountFlagBits uint32_to_enum_VkSampleCountFlagBits(const uint32_t val)
     return mapping.at(val);
 }
 
-VkCompareOp string_to_enum_VkCompareOp(const std::string& str)
+inline VkCompareOp string_to_enum_VkCompareOp(const std::string& str)
 {
     const std::unordered_map<std::string, VkCompareOp> mapping {
         { "VK_COMPARE_OP_ALWAYS"          , VK_COMPARE_OP_ALWAYS },
@@ -143,7 +151,7 @@ VkCompareOp string_to_enum_VkCompareOp(const std::string& str)
     return mapping.at(str);
 }
 
-VkPolygonMode string_to_enum_VkPolygonMode(const std::string& str)
+inline VkPolygonMode string_to_enum_VkPolygonMode(const std::string& str)
 {
     const std::unordered_map<std::string, VkPolygonMode> mapping {
         { "VK_POLYGON_MODE_FILL"             , VK_POLYGON_MODE_FILL },
@@ -155,7 +163,7 @@ VkPolygonMode string_to_enum_VkPolygonMode(const std::string& str)
     return mapping.at(str);
 }
 
-VkCullModeFlags string_to_enum_VkCullModeFlagBits(const std::string& str)
+inline VkCullModeFlags string_to_enum_VkCullModeFlagBits(const std::string& str)
 {
     const std::unordered_map<std::string, VkCullModeFlags> mapping {
 
@@ -168,7 +176,7 @@ VkCullModeFlags string_to_enum_VkCullModeFlagBits(const std::string& str)
     return mapping.at(str);
 }
 
-VkFrontFace string_to_enum_VkFrontFace(const std::string& str)
+inline VkFrontFace string_to_enum_VkFrontFace(const std::string& str)
 {
     const std::unordered_map<std::string, VkFrontFace> mapping {
         { "VK_FRONT_FACE_CLOCKWISE"        , VK_FRONT_FACE_CLOCKWISE },
@@ -178,7 +186,7 @@ VkFrontFace string_to_enum_VkFrontFace(const std::string& str)
     return mapping.at(str);
 }
 
-VkPrimitiveTopology string_to_enum_VkPrimitiveTopology(const std::string& str)
+inline VkPrimitiveTopology string_to_enum_VkPrimitiveTopology(const std::string& str)
 {
     const std::unordered_map<std::string, VkPrimitiveTopology> mapping {
         { "VK_PRIMITIVE_TOPOLOGY_POINT_LIST"                   , VK_PRIMITIVE_TOPOLOGY_POINT_LIST },
@@ -198,7 +206,7 @@ VkPrimitiveTopology string_to_enum_VkPrimitiveTopology(const std::string& str)
     return mapping.at(str);
 }
 
-VkVertexInputRate string_to_enum_VkVertexInputRate(const std::string& str)
+inline VkVertexInputRate string_to_enum_VkVertexInputRate(const std::string& str)
 {
     const std::unordered_map<std::string, VkVertexInputRate> mapping {
         { "VK_VERTEX_INPUT_RATE_VERTEX"  , VK_VERTEX_INPUT_RATE_VERTEX },
@@ -208,7 +216,7 @@ VkVertexInputRate string_to_enum_VkVertexInputRate(const std::string& str)
     return mapping.at(str);
 }
 
-VkDescriptorType string_to_enum_VkDescriptorType(const std::string& str)
+inline VkDescriptorType string_to_enum_VkDescriptorType(const std::string& str)
 {
     const std::unordered_map<std::string, VkDescriptorType> mapping {
         { "VK_DESCRIPTOR_TYPE_SAMPLER"                , VK_DESCRIPTOR_TYPE_SAMPLER                }, 
@@ -227,7 +235,7 @@ VkDescriptorType string_to_enum_VkDescriptorType(const std::string& str)
     return mapping.at(str);
 }
 
-VkShaderStageFlags string_to_enum_VkShaderStageFlags(const std::string& str)
+inline VkShaderStageFlags string_to_enum_VkShaderStageFlags(const std::string& str)
 {
     const std::unordered_map<std::string, VkShaderStageFlags> mapping {
         { "VK_SHADER_STAGE_VERTEX_BIT"                  , VK_SHADER_STAGE_VERTEX_BIT                  }, 
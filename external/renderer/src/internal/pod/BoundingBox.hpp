@@ -0,0 +1,13 @@
+#ifndef RENDERER_BOUNDING_BOX_HPP
+#define RENDERER_BOUNDING_BOX_HPP
+
+// Axis aligned box as center / half extent. A negative extent marks unknown bounds, which are never culled.
+struct BoundingBox
+{
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float extent[3] = { -1.0f, -1.0f, -1.0f };
+
+    bool is_valid() const { return extent[0] >= 0.0f; }
+};
+
+#endif // RENDERER_BOUNDING_BOX_HPP
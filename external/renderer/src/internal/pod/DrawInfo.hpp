@@ -11,7 +11,9 @@ struct DrawInfo
     uint32_t first_index = 0; // doubles (first_vertex, first_index) for non-indexed and indexed draws
     uint32_t first_vertex = 0; // doubles (first_vertex, first_index) for non-indexed and indexed draws
     int32_t vertex_offset = 0;
-    uint32_t first_instance = 0; // doubles as draw id 
+    uint32_t first_instance = 0; // instance slot, the draw ID of each instance is read from the instance table
+    uint32_t mesh_id = 0;
+    uint32_t geometry_block_id = 0; // vertex / index buffer the offsets above refer to
 };
 
 #endif // RENDERER_DRAW_INFO_HPP
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef RENDERER_DRAW_ORDER_HPP
+#define RENDERER_DRAW_ORDER_HPP
+
+// Order a render pass records its culled draws in, "draw-order" in the app state.
+enum class DrawOrder
+{
+    eInsertion, // as added to the sortbins
+    eState, // grouped by geometry block and mesh
+    eFrontToBack, // by geometry block, then nearest first, for early depth rejection in opaque passes
+    eBackToFront, // farthest first regardless of geometry block, for blending
+};
+
+#endif // RENDERER_DRAW_ORDER_HPP
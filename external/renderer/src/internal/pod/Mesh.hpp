@@ -1,10 +1,23 @@
 #ifndef RENDERER_MESH_HPP
 #define RENDERER_MESH_HPP
 
+#include "BoundingBox.hpp"
+#include "../misc/vertex_quantization.hpp"
+
 #include <inttypes.h>
 
+// Simplified index range of a mesh, drawn with the mesh's vertices.
+struct MeshLod
+{
+    uint32_t first_index; // relative to Mesh::first_index
+    uint32_t index_count;
+    float    error; // object space distance the simplification moved the surface by
+};
+
 struct Mesh
 {
+    static constexpr uint32_t s_max_lod_count = 8;
+
     uint32_t sortbin_id;
     uint32_t index_count;
     uint32_t vertex_count;
@@ -12,6 +25,15 @@ struct Mesh
     uint32_t first_index;
     int32_t  vertex_offset;
     uint32_t index_stride;
+    uint32_t vertex_stride;
+    uint32_t geometry_block_id;
+    BoundingBox bounds; // object space, from the vertex_pos attribute
+    uint16_t vertex_layout_sortbin_id = UINT16_MAX; // sortbin the vertices were quantized for, UINT16_MAX for the caller's layout
+    vertex_quantization::PositionTransform position_transform {}; // dequantizes vertex_pos
+    // LOD chain, lod_list[0] being the full index range. The simplified ranges follow it in the same index allocation.
+    uint32_t lod_count = 1;
+    uint32_t lod_index_count = 0; // indices of every level after the first
+    MeshLod  lod_list[s_max_lod_count] {};
 };
 
 #endif // RENDERER_MESH_HPP
\ No newline at end of file
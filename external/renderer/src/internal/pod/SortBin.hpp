@@ -20,19 +20,61 @@ struct SortBin
     const uint64_t material_data_block_end_padding_size;
     const uint64_t draw_data_block_size;
     const uint64_t draw_data_block_end_padding_size;
+    const uint32_t draw_model_mat_offset; // draw data "model_mat" (mat4) the culling bounds derive from, UINT32_MAX without one
 
     // Vulkan Handles
-    const VkPipeline vk_handle_pipeline;
+    const VkPipeline vk_handle_pipeline; // shared by sortbins whose pipelines would only differ in dynamic_state
     const VkPipelineLayout vk_handle_pipeline_layout;
     const VkDescriptorSet vk_handle_desc_set;
+    const bool is_pipeline_owner; // first sortbin using vk_handle_pipeline, destroys it
 
-    const uint8_t compatible_sort_bin_set_ID;
+    const uint16_t compatible_sort_bin_set_ID; // RendererState::compatible_sortbin_ID_lut
+
+    // Vertex Input
+    struct VertexAttribute
+    {
+        std::string usage; // "vertex_pos", "vertex_normal", "vertex_texcoord", ...
+        VkVertexInputAttributeDescription description;
+    };
+
+    const uint32_t vertex_stride; // binding 0
+    const VkVertexInputAttributeDescription vertex_pos_attribute; // format is VK_FORMAT_UNDEFINED without a vertex_pos attribute
+    const std::vector<VertexAttribute> vertex_attribute_list; // binding 0
+
+    // Raster and depth state. Set with vkCmdSet* whenever the sortbin is bound when the renderer runs with extended
+    // dynamic state, baked into vk_handle_pipeline otherwise.
+    struct DynamicState
+    {
+        VkPrimitiveTopology topology;
+        VkCullModeFlags cull_mode;
+        VkFrontFace front_face;
+        VkBool32 depth_test_enable;
+        VkBool32 depth_write_enable;
+        VkCompareOp depth_compare_op;
+
+        bool operator==(const DynamicState&) const = default;
+    };
+
+    const DynamicState dynamic_state;
 
     // Runtime
     std::vector<DrawInfo> draw_list_u32;
     std::vector<DrawInfo> draw_list_u16;
     std::vector<DrawInfo> draw_list_u8;
     std::vector<DrawInfo> draw_list;
+    uint64_t generation = 0; // bumped whenever a draw list changes, invalidating recordings of it
+
+    // Every draw instances one mesh. Its instances occupy the instance slots [first_instance, first_instance +
+    // instance_count) of RendererState::instance_buffer, whose draw IDs the shaders read at gl_InstanceIndex, so
+    // renderables of a mesh share its draw whatever their draw IDs. An emptied draw stays until its mesh is destroyed.
+    struct InstanceGroup
+    {
+        VkIndexType index_type; // draw list the draw lives in, VK_INDEX_TYPE_MAX_ENUM for draw_list
+        uint32_t draw_idx;
+        uint32_t slot_capacity; // power of two, the slots are instance_buffer block first_instance / slot_capacity
+    };
+
+    std::unordered_map<uint32_t, InstanceGroup> instance_group_umap; // by mesh ID
 };
 
 #endif // RENDERER_SORT_BIN_HPP
\ No newline at end of file
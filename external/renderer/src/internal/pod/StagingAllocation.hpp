@@ -0,0 +1,20 @@
+#ifndef RENDERER_STAGING_ALLOCATION_HPP
+#define RENDERER_STAGING_ALLOCATION_HPP
+
+#include <vulkan/vulkan.h>
+
+#include <inttypes.h>
+
+// Range of persistently mapped staging memory handed out by StagingBuffer::allocate.
+// Only valid until the region it lives in is flushed/submitted.
+struct StagingAllocation
+{
+    uint8_t*     mapped_ptr;
+    VkDeviceSize src_offset;
+    VkDeviceSize size;
+    uint32_t     region_idx;
+    uint32_t     chunk_idx;
+    uint64_t     region_generation;
+};
+
+#endif // RENDERER_STAGING_ALLOCATION_HPP
@@ -0,0 +1,17 @@
+#ifndef RENDERER_VISIBLE_DRAW_LISTS_HPP
+#define RENDERER_VISIBLE_DRAW_LISTS_HPP
+
+#include "DrawInfo.hpp"
+
+#include <vector>
+
+// Culled copy of a sortbin's draw lists. Instanced draws only keep (and are split around) their visible instances.
+struct VisibleDrawLists
+{
+    std::vector<DrawInfo> draw_list_u32;
+    std::vector<DrawInfo> draw_list_u16;
+    std::vector<DrawInfo> draw_list_u8;
+    std::vector<DrawInfo> draw_list;
+};
+
+#endif // RENDERER_VISIBLE_DRAW_LISTS_HPP
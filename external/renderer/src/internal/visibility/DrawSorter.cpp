@@ -0,0 +1,236 @@
+#include "DrawSorter.hpp"
+#include "FrustumCuller.hpp"
+#include "../misc/WorkerPool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <chrono>
+
+static constexpr uint32_t s_depth_bit_count = 22;
+static constexpr uint32_t s_depth_max = (1u << s_depth_bit_count) - 1;
+
+// Non-negative floats order like their bits. Dropping the sign bit and the low mantissa bits leaves 22 bits that still
+// separate depths about 0.05% apart.
+static uint32_t quantize_depth(const float depth)
+{
+    return std::bit_cast<uint32_t>(std::max(depth, 0.0f)) >> (31 - s_depth_bit_count);
+}
+
+DrawSorter::DrawSorter(WorkerPool& worker_pool)
+    : m_worker_pool { worker_pool }
+{
+}
+
+void DrawSorter::sort(const float* const view_proj_mat,
+    const DrawOrder draw_order,
+    const std::vector<uint16_t>& sortbin_ID_list,
+    const FrustumCuller& frustum_culler,
+    const std::span<const uint32_t> instance_draw_ID_list,
+    std::vector<VisibleDrawLists>& visible_draw_lists_list)
+{
+    m_stats = {};
+
+    if (draw_order == DrawOrder::eInsertion)
+    {
+        return;
+    }
+
+    const auto key_start = std::chrono::steady_clock::now();
+
+    // Gathered in recording order, which the top key bits reproduce.
+    std::vector<std::vector<DrawInfo>*> draw_list_list;
+
+    for (const uint16_t sortbin_ID : sortbin_ID_list)
+    {
+        VisibleDrawLists& visible_draw_lists = visible_draw_lists_list[sortbin_ID];
+
+        draw_list_list.push_back(&visible_draw_lists.draw_list_u32);
+        draw_list_list.push_back(&visible_draw_lists.draw_list_u16);
+        draw_list_list.push_back(&visible_draw_lists.draw_list_u8);
+        draw_list_list.push_back(&visible_draw_lists.draw_list);
+    }
+
+    m_draw_list.clear();
+    m_key_list.clear();
+
+    for (uint32_t list_idx = 0; list_idx < draw_list_list.size(); list_idx++)
+    {
+        const std::vector<DrawInfo>& draw_list = *draw_list_list[list_idx];
+        m_draw_list.insert(m_draw_list.end(), draw_list.begin(), draw_list.end());
+        m_key_list.resize(m_draw_list.size(), static_cast<uint64_t>(list_idx) << 46);
+    }
+
+    const uint32_t draw_count = static_cast<uint32_t>(m_draw_list.size());
+    m_stats.draw_count = draw_count;
+
+    if (draw_count < 2)
+    {
+        return;
+    }
+
+    // Orthographic projections leave w at 1, clip space z then orders by depth instead.
+    const bool is_perspective = view_proj_mat[3] != 0.0f || view_proj_mat[7] != 0.0f || view_proj_mat[11] != 0.0f;
+    const uint32_t depth_row = is_perspective ? 3 : 2;
+
+    const auto get_depth = [&](const DrawInfo& draw_info)
+    {
+        float nearest_depth = draw_order == DrawOrder::eBackToFront ? 0.0f : FLT_MAX;
+        float farthest_depth = 0.0f;
+
+        for (uint32_t instance = draw_info.first_instance; instance < draw_info.first_instance + draw_info.instance_count; instance++)
+        {
+            const BoundingBox world_bounds = frustum_culler.get_world_bounds(instance_draw_ID_list[instance]);
+
+            if (!world_bounds.is_valid())
+            {
+                nearest_depth = 0.0f;
+                continue;
+            }
+
+            const float depth = view_proj_mat[depth_row] * world_bounds.center[0] +
+                view_proj_mat[4 + depth_row] * world_bounds.center[1] +
+                view_proj_mat[8 + depth_row] * world_bounds.center[2] +
+                view_proj_mat[12 + depth_row];
+
+            nearest_depth = std::min(nearest_depth, depth);
+            farthest_depth = std::max(farthest_depth, depth);
+        }
+
+        return draw_order == DrawOrder::eBackToFront ? s_depth_max - quantize_depth(farthest_depth) : quantize_depth(nearest_depth);
+    };
+
+    const uint32_t task_count = (draw_count + s_task_size - 1) / s_task_size;
+
+    m_worker_pool.run(task_count, [&](const uint32_t task_idx, const uint32_t)
+    {
+        const uint32_t end = std::min((task_idx + 1) * s_task_size, draw_count);
+
+        for (uint32_t draw_idx = task_idx * s_task_size; draw_idx < end; draw_idx++)
+        {
+            const DrawInfo& draw_info = m_draw_list[draw_idx];
+            const uint64_t geometry_block = std::min(draw_info.geometry_block_id, 0xFFu);
+            const uint64_t mesh = draw_info.mesh_id;
+
+            uint64_t key = 0;
+
+            switch (draw_order)
+            {
+                case DrawOrder::eState:
+                {
+                    key = (geometry_block << 38) | ((mesh & s_depth_max) << 16);
+                    break;
+                }
+                case DrawOrder::eFrontToBack:
+                {
+                    key = (geometry_block << 38) | (static_cast<uint64_t>(get_depth(draw_info)) << 16) | (mesh & 0xFFFF);
+                    break;
+                }
+                case DrawOrder::eBackToFront:
+                {
+                    key = (static_cast<uint64_t>(get_depth(draw_info)) << 24) | (geometry_block << 16) | (mesh & 0xFFFF);
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
+            }
+
+            m_key_list[draw_idx] |= key;
+        }
+    });
+
+    const auto sort_start = std::chrono::steady_clock::now();
+
+    radix_sort();
+
+    // Every list keeps its size and position, only its draws move.
+    uint32_t draw_idx = 0;
+
+    for (std::vector<DrawInfo>* const p_draw_list : draw_list_list)
+    {
+        for (DrawInfo& draw_info : *p_draw_list)
+        {
+            draw_info = m_draw_list[m_draw_idx_list[draw_idx++]];
+        }
+    }
+
+    const auto sort_end = std::chrono::steady_clock::now();
+
+    m_stats.key_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sort_start - key_start).count());
+    m_stats.sort_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sort_end - sort_start).count());
+}
+
+void DrawSorter::radix_sort()
+{
+    const uint32_t key_count = static_cast<uint32_t>(m_key_list.size());
+    const uint32_t task_count = (key_count + s_task_size - 1) / s_task_size;
+
+    m_key_scratch_list.resize(key_count);
+    m_draw_idx_list.resize(key_count);
+    m_draw_idx_scratch_list.resize(key_count);
+    m_histogram_list.resize(static_cast<size_t>(task_count) * s_radix_size);
+
+    for (uint32_t key_idx = 0; key_idx < key_count; key_idx++)
+    {
+        m_draw_idx_list[key_idx] = key_idx;
+    }
+
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::fill(m_histogram_list.begin(), m_histogram_list.end(), 0);
+
+        m_worker_pool.run(task_count, [&](const uint32_t task_idx, const uint32_t)
+        {
+            uint32_t* const histogram = m_histogram_list.data() + static_cast<size_t>(task_idx) * s_radix_size;
+            const uint32_t end = std::min((task_idx + 1) * s_task_size, key_count);
+
+            for (uint32_t key_idx = task_idx * s_task_size; key_idx < end; key_idx++)
+            {
+                histogram[(m_key_list[key_idx] >> shift) & 0xFF]++;
+            }
+        });
+
+        // Digit major, task minor exclusive scan, so each task scatters its keys after those of earlier tasks.
+        uint32_t offset = 0;
+        bool is_constant_digit = false;
+
+        for (uint32_t digit = 0; digit < s_radix_size; digit++)
+        {
+            const uint32_t digit_begin = offset;
+
+            for (uint32_t task_idx = 0; task_idx < task_count; task_idx++)
+            {
+                uint32_t& count = m_histogram_list[static_cast<size_t>(task_idx) * s_radix_size + digit];
+                const uint32_t task_count_of_digit = count;
+                count = offset;
+                offset += task_count_of_digit;
+            }
+
+            is_constant_digit |= offset - digit_begin == key_count;
+        }
+
+        if (is_constant_digit)
+        {
+            continue;
+        }
+
+        m_worker_pool.run(task_count, [&](const uint32_t task_idx, const uint32_t)
+        {
+            uint32_t* const scatter_offset = m_histogram_list.data() + static_cast<size_t>(task_idx) * s_radix_size;
+            const uint32_t end = std::min((task_idx + 1) * s_task_size, key_count);
+
+            for (uint32_t key_idx = task_idx * s_task_size; key_idx < end; key_idx++)
+            {
+                const uint32_t dst_idx = scatter_offset[(m_key_list[key_idx] >> shift) & 0xFF]++;
+                m_key_scratch_list[dst_idx] = m_key_list[key_idx];
+                m_draw_idx_scratch_list[dst_idx] = m_draw_idx_list[key_idx];
+            }
+        });
+
+        m_key_list.swap(m_key_scratch_list);
+        m_draw_idx_list.swap(m_draw_idx_scratch_list);
+        m_stats.radix_pass_count++;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef RENDERER_DRAW_SORTER_HPP
+#define RENDERER_DRAW_SORTER_HPP
+
+#include "../pod/DrawInfo.hpp"
+#include "../pod/DrawOrder.hpp"
+#include "../pod/VisibleDrawLists.hpp"
+
+#include <inttypes.h>
+#include <span>
+#include <vector>
+
+struct WorkerPool;
+struct FrustumCuller;
+
+struct DrawSortStats
+{
+    uint32_t draw_count = 0; // draws sorted by the last sort()
+    uint32_t radix_pass_count = 0; // 8 bit digit passes run, constant digits are skipped
+    uint64_t key_ns = 0;
+    uint64_t sort_ns = 0;
+};
+
+// Reorders culled draws by a 64 bit key, most significant field first:
+//
+//   [63:48] sortbin rank in the pass  [47:46] index type  [45:0] DrawOrder dependent
+//
+//   eState        [45:38] geometry block  [37:16] mesh ID
+//   eFrontToBack  [45:38] geometry block  [37:16] nearest instance depth  [15:0] mesh ID
+//   eBackToFront  [45:24] inverted farthest instance depth  [23:16] geometry block  [15:0] mesh ID
+//
+// The top bits reproduce the order draws are recorded in (sortbin, then u32 / u16 / u8 / non-indexed list), so one
+// sort over every draw of the pass leaves each list's draws in place and only reorders them within the list.
+// Sorting by geometry block keeps the vertex / index buffer rebinds and the indirect geometry block runs at one per
+// block. Depth is the clip space w (view depth) of an instance's world box center, or z for orthographic projections,
+// quantized through its float bits.
+//
+// The sort is a least significant digit radix sort over 8 bit digits. Every pass histograms fixed size chunks of
+// the keys on the worker pool and scatters them in chunk order, which keeps it stable.
+struct DrawSorter
+{
+private:
+protected:
+
+    static constexpr uint32_t s_radix_size = 256;
+    static constexpr uint32_t s_task_size = 1 << 14; // keys per histogram / scatter task
+
+    WorkerPool& m_worker_pool;
+
+    std::vector<DrawInfo> m_draw_list; // gathered draws of every sorted list
+    std::vector<uint64_t> m_key_list;
+    std::vector<uint64_t> m_key_scratch_list;
+    std::vector<uint32_t> m_draw_idx_list; // into m_draw_list, permuted along with the keys
+    std::vector<uint32_t> m_draw_idx_scratch_list;
+    std::vector<uint32_t> m_histogram_list; // [task][digit], turned into scatter offsets in place
+
+    DrawSortStats m_stats {};
+
+    void radix_sort();
+
+public:
+    explicit DrawSorter(WorkerPool& worker_pool);
+
+    DrawSorter(const DrawSorter&) = delete;
+    DrawSorter& operator=(const DrawSorter&) = delete;
+    DrawSorter(DrawSorter&&) = delete;
+    DrawSorter& operator=(DrawSorter&&) = delete;
+
+    // Reorders the draw lists of visible_draw_lists_list[sortbin_ID_list] by draw_order. view_proj_mat is column major,
+    // instance depths come from frustum_culler's world boxes of the draw IDs instance_draw_ID_list holds for their
+    // slots, unbounded instances counting as nearest.
+    void sort(const float* const view_proj_mat,
+        const DrawOrder draw_order,
+        const std::vector<uint16_t>& sortbin_ID_list,
+        const FrustumCuller& frustum_culler,
+        const std::span<const uint32_t> instance_draw_ID_list,
+        std::vector<VisibleDrawLists>& visible_draw_lists_list);
+
+    const DrawSortStats& get_stats() const { return m_stats; }
+};
+
+#endif // RENDERER_DRAW_SORTER_HPP
@@ -0,0 +1,381 @@
+#include "FrustumCuller.hpp"
+#include "../misc/WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Large enough to pass every plane, small enough that |n| * extent sums stay finite.
+static constexpr float s_unbounded_extent = 1e30f;
+
+FrustumCuller::FrustumCuller(WorkerPool& worker_pool)
+    : m_worker_pool { worker_pool }
+{
+}
+
+void FrustumCuller::reserve_draw_ID(const uint32_t draw_ID)
+{
+    if (draw_ID < m_center_x.size())
+    {
+        return;
+    }
+
+    const size_t size = (static_cast<size_t>(draw_ID) / s_lane_count + 1) * s_lane_count * 2;
+
+    m_center_x.resize(size, 0.0f);
+    m_center_y.resize(size, 0.0f);
+    m_center_z.resize(size, 0.0f);
+    m_extent_x.resize(size, s_unbounded_extent);
+    m_extent_y.resize(size, s_unbounded_extent);
+    m_extent_z.resize(size, s_unbounded_extent);
+    m_visibility_list.resize(size, 1);
+}
+
+void FrustumCuller::set_bounds(const uint32_t draw_ID, const BoundingBox& object_bounds, const float* const model_mat)
+{
+    if (!object_bounds.is_valid())
+    {
+        clear_bounds(draw_ID);
+        return;
+    }
+
+    reserve_draw_ID(draw_ID);
+
+    // center' = M * center, extent'_row = sum_col |M_row_col| * extent_col
+    float center[3];
+    float extent[3];
+
+    for (uint32_t row = 0; row < 3; row++)
+    {
+        center[row] = model_mat[12 + row];
+        extent[row] = 0.0f;
+
+        for (uint32_t col = 0; col < 3; col++)
+        {
+            center[row] += model_mat[col * 4 + row] * object_bounds.center[col];
+            extent[row] += std::fabs(model_mat[col * 4 + row]) * object_bounds.extent[col];
+        }
+    }
+
+    m_center_x[draw_ID] = center[0];
+    m_center_y[draw_ID] = center[1];
+    m_center_z[draw_ID] = center[2];
+    m_extent_x[draw_ID] = extent[0];
+    m_extent_y[draw_ID] = extent[1];
+    m_extent_z[draw_ID] = extent[2];
+}
+
+void FrustumCuller::clear_bounds(const uint32_t draw_ID)
+{
+    if (draw_ID >= m_center_x.size())
+    {
+        return;
+    }
+
+    m_center_x[draw_ID] = 0.0f;
+    m_center_y[draw_ID] = 0.0f;
+    m_center_z[draw_ID] = 0.0f;
+    m_extent_x[draw_ID] = s_unbounded_extent;
+    m_extent_y[draw_ID] = s_unbounded_extent;
+    m_extent_z[draw_ID] = s_unbounded_extent;
+}
+
+BoundingBox FrustumCuller::get_world_bounds(const uint32_t draw_ID) const
+{
+    BoundingBox world_bounds {};
+
+    if (draw_ID >= m_center_x.size() || m_extent_x[draw_ID] == s_unbounded_extent)
+    {
+        return world_bounds;
+    }
+
+    world_bounds.center[0] = m_center_x[draw_ID];
+    world_bounds.center[1] = m_center_y[draw_ID];
+    world_bounds.center[2] = m_center_z[draw_ID];
+    world_bounds.extent[0] = m_extent_x[draw_ID];
+    world_bounds.extent[1] = m_extent_y[draw_ID];
+    world_bounds.extent[2] = m_extent_z[draw_ID];
+
+    return world_bounds;
+}
+
+// A box is outside when it lies entirely on the negative side of any plane: n.c + w + |n|.e < 0.
+void FrustumCuller::test_range(const float (&plane_list)[6][4], const uint32_t begin, const uint32_t end)
+{
+    uint32_t draw_ID = begin;
+
+#if defined(__AVX__)
+    for (; draw_ID + 8 <= end; draw_ID += 8)
+    {
+        const __m256 cx = _mm256_loadu_ps(&m_center_x[draw_ID]);
+        const __m256 cy = _mm256_loadu_ps(&m_center_y[draw_ID]);
+        const __m256 cz = _mm256_loadu_ps(&m_center_z[draw_ID]);
+        const __m256 ex = _mm256_loadu_ps(&m_extent_x[draw_ID]);
+        const __m256 ey = _mm256_loadu_ps(&m_extent_y[draw_ID]);
+        const __m256 ez = _mm256_loadu_ps(&m_extent_z[draw_ID]);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (const float (&plane)[4] : plane_list)
+        {
+            __m256 dist = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[0]), cx), _mm256_set1_ps(plane[3]));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(plane[1]), cy));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(plane[2]), cz));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane[0])), ex));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane[1])), ey));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane[2])), ez));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        const int inside_mask = _mm256_movemask_ps(inside);
+
+        for (uint32_t lane = 0; lane < 8; lane++)
+        {
+            m_visibility_list[draw_ID + lane] = static_cast<uint8_t>((inside_mask >> lane) & 1);
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for (; draw_ID + 4 <= end; draw_ID += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(&m_center_x[draw_ID]);
+        const __m128 cy = _mm_loadu_ps(&m_center_y[draw_ID]);
+        const __m128 cz = _mm_loadu_ps(&m_center_z[draw_ID]);
+        const __m128 ex = _mm_loadu_ps(&m_extent_x[draw_ID]);
+        const __m128 ey = _mm_loadu_ps(&m_extent_y[draw_ID]);
+        const __m128 ez = _mm_loadu_ps(&m_extent_z[draw_ID]);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (const float (&plane)[4] : plane_list)
+        {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), cx), _mm_set1_ps(plane[3]));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(plane[1]), cy));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(plane[2]), cz));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(std::fabs(plane[0])), ex));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(std::fabs(plane[1])), ey));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(std::fabs(plane[2])), ez));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, _mm_setzero_ps()));
+        }
+
+        const int inside_mask = _mm_movemask_ps(inside);
+
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            m_visibility_list[draw_ID + lane] = static_cast<uint8_t>((inside_mask >> lane) & 1);
+        }
+    }
+#endif
+
+    for (; draw_ID < end; draw_ID++)
+    {
+        bool is_inside = true;
+
+        for (const float (&plane)[4] : plane_list)
+        {
+            const float dist = plane[0] * m_center_x[draw_ID] + plane[1] * m_center_y[draw_ID] + plane[2] * m_center_z[draw_ID] + plane[3] +
+                std::fabs(plane[0]) * m_extent_x[draw_ID] + std::fabs(plane[1]) * m_extent_y[draw_ID] + std::fabs(plane[2]) * m_extent_z[draw_ID];
+
+            is_inside = is_inside && dist >= 0.0f;
+        }
+
+        m_visibility_list[draw_ID] = static_cast<uint8_t>(is_inside);
+    }
+}
+
+void FrustumCuller::compact(const CompactTask& task, const std::span<const uint32_t> instance_draw_ID_list, std::vector<DrawInfo>& visible_draw_list) const
+{
+    visible_draw_list.clear();
+
+    // IDs past the bounds storage were never given bounds.
+    const auto is_visible = [&](const uint32_t slot)
+    {
+        const uint32_t draw_ID = instance_draw_ID_list[slot];
+        return draw_ID >= m_visibility_list.size() || m_visibility_list[draw_ID] != 0;
+    };
+
+    for (uint32_t draw_idx = task.begin; draw_idx < task.end; draw_idx++)
+    {
+        const DrawInfo& draw_info = (*task.p_draw_list)[draw_idx];
+        const uint32_t end_instance = draw_info.first_instance + (draw_idx + 1 == task.end ? task.instance_end : draw_info.instance_count);
+
+        uint32_t instance = draw_info.first_instance + (draw_idx == task.begin ? task.instance_begin : 0);
+
+        while (instance < end_instance)
+        {
+            while (instance < end_instance && !is_visible(instance))
+            {
+                instance++;
+            }
+
+            const uint32_t first_visible_instance = instance;
+
+            while (instance < end_instance && is_visible(instance))
+            {
+                instance++;
+            }
+
+            if (instance > first_visible_instance)
+            {
+                DrawInfo visible_draw_info = draw_info;
+                visible_draw_info.first_instance = first_visible_instance;
+                visible_draw_info.instance_count = instance - first_visible_instance;
+                visible_draw_list.push_back(visible_draw_info);
+            }
+        }
+    }
+}
+
+void FrustumCuller::cull(const float* const view_proj_mat,
+    const std::vector<SortBin>& sortbin_list,
+    const std::vector<uint16_t>& sortbin_ID_list,
+    const std::span<const uint32_t> instance_draw_ID_list,
+    std::vector<VisibleDrawLists>& visible_draw_lists_list)
+{
+    const auto test_start = std::chrono::steady_clock::now();
+
+    // Gribb / Hartmann plane extraction from the rows of the column major matrix.
+    const auto element = [view_proj_mat](const uint32_t row_idx, const uint32_t col_idx) { return view_proj_mat[col_idx * 4 + row_idx]; };
+
+    float plane_list[6][4];
+
+    for (uint32_t col = 0; col < 4; col++)
+    {
+        plane_list[0][col] = element(3, col) + element(0, col); // left
+        plane_list[1][col] = element(3, col) - element(0, col); // right
+        plane_list[2][col] = element(3, col) + element(1, col); // bottom
+        plane_list[3][col] = element(3, col) - element(1, col); // top
+        plane_list[4][col] = element(2, col);               // near
+        plane_list[5][col] = element(3, col) - element(2, col); // far
+    }
+
+    const uint32_t draw_ID_count = static_cast<uint32_t>(m_center_x.size());
+    const uint32_t test_task_count = (draw_ID_count + s_test_task_size - 1) / s_test_task_size;
+
+    m_worker_pool.run(test_task_count, [&](const uint32_t task_idx, const uint32_t)
+    {
+        const uint32_t begin = task_idx * s_test_task_size;
+        test_range(plane_list, begin, std::min(begin + s_test_task_size, draw_ID_count));
+    });
+
+    const auto compact_start = std::chrono::steady_clock::now();
+
+    visible_draw_lists_list.resize(sortbin_list.size());
+
+    std::vector<std::vector<DrawInfo>*> output_draw_list_list;
+    std::vector<uint32_t> output_first_task_list; // first compaction task of each output list
+    m_compact_task_list.clear();
+
+    uint32_t instance_count = 0;
+
+    const auto add_draw_list = [&](const std::vector<DrawInfo>& draw_list, std::vector<DrawInfo>& visible_draw_list)
+    {
+        output_draw_list_list.push_back(&visible_draw_list);
+        output_first_task_list.push_back(static_cast<uint32_t>(m_compact_task_list.size()));
+
+        // A draw of one mesh may hold most instances of the list, tasks end mid draw when it passes the task size.
+        CompactTask task { &draw_list, 0, 0, 0, 0 };
+        uint32_t task_instance_count = 0;
+
+        for (uint32_t draw_idx = 0; draw_idx < draw_list.size(); draw_idx++)
+        {
+            const uint32_t draw_instance_count = draw_list[draw_idx].instance_count;
+            uint32_t instance = 0;
+
+            while (draw_instance_count - instance > s_compact_task_size - task_instance_count)
+            {
+                instance += s_compact_task_size - task_instance_count;
+                task.end = draw_idx + 1;
+                task.instance_end = instance;
+                m_compact_task_list.push_back(task);
+
+                task = { &draw_list, draw_idx, draw_idx, instance, 0 };
+                task_instance_count = 0;
+            }
+
+            task_instance_count += draw_instance_count - instance;
+            task.end = draw_idx + 1;
+            task.instance_end = draw_instance_count;
+            instance_count += draw_instance_count;
+        }
+
+        if (task.end > task.begin)
+        {
+            m_compact_task_list.push_back(task);
+        }
+    };
+
+    for (const uint16_t sortbin_ID : sortbin_ID_list)
+    {
+        const SortBin& sortbin = sortbin_list[sortbin_ID];
+        VisibleDrawLists& visible_draw_lists = visible_draw_lists_list[sortbin_ID];
+
+        add_draw_list(sortbin.draw_list_u32, visible_draw_lists.draw_list_u32);
+        add_draw_list(sortbin.draw_list_u16, visible_draw_lists.draw_list_u16);
+        add_draw_list(sortbin.draw_list_u8, visible_draw_lists.draw_list_u8);
+        add_draw_list(sortbin.draw_list, visible_draw_lists.draw_list);
+    }
+
+    output_first_task_list.push_back(static_cast<uint32_t>(m_compact_task_list.size()));
+
+    if (m_compact_output_list.size() < m_compact_task_list.size())
+    {
+        m_compact_output_list.resize(m_compact_task_list.size());
+    }
+
+    m_worker_pool.run(static_cast<uint32_t>(m_compact_task_list.size()), [&](const uint32_t task_idx, const uint32_t)
+    {
+        compact(m_compact_task_list[task_idx], instance_draw_ID_list, m_compact_output_list[task_idx]);
+    });
+
+    uint32_t visible_instance_count = 0;
+    uint32_t visible_draw_count = 0;
+
+    for (uint32_t output_idx = 0; output_idx < output_draw_list_list.size(); output_idx++)
+    {
+        std::vector<DrawInfo>& visible_draw_list = *output_draw_list_list[output_idx];
+        visible_draw_list.clear();
+
+        for (uint32_t task_idx = output_first_task_list[output_idx]; task_idx < output_first_task_list[output_idx + 1]; task_idx++)
+        {
+            const std::vector<DrawInfo>& task_output = m_compact_output_list[task_idx];
+            auto task_output_iter = task_output.begin();
+
+            // Rejoins a visible run split between the tasks of one draw.
+            if (task_output_iter != task_output.end() && !visible_draw_list.empty() &&
+                visible_draw_list.back().mesh_id == task_output_iter->mesh_id &&
+                visible_draw_list.back().first_instance + visible_draw_list.back().instance_count == task_output_iter->first_instance)
+            {
+                visible_draw_list.back().instance_count += task_output_iter->instance_count;
+                ++task_output_iter;
+            }
+
+            visible_draw_list.insert(visible_draw_list.end(), task_output_iter, task_output.end());
+        }
+
+        for (const DrawInfo& draw_info : visible_draw_list)
+        {
+            visible_instance_count += draw_info.instance_count;
+        }
+
+        visible_draw_count += static_cast<uint32_t>(visible_draw_list.size());
+    }
+
+    const auto compact_end = std::chrono::steady_clock::now();
+
+    m_stats = {
+        .tested_count = draw_ID_count,
+        .instance_count = instance_count,
+        .visible_instance_count = visible_instance_count,
+        .visible_draw_count = visible_draw_count,
+        .test_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(compact_start - test_start).count()),
+        .compact_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(compact_end - compact_start).count()),
+    };
+}
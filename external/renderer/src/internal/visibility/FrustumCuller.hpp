@@ -0,0 +1,99 @@
+#ifndef RENDERER_FRUSTUM_CULLER_HPP
+#define RENDERER_FRUSTUM_CULLER_HPP
+
+#include "../pod/BoundingBox.hpp"
+#include "../pod/SortBin.hpp"
+#include "../pod/VisibleDrawLists.hpp"
+
+#include <inttypes.h>
+#include <span>
+#include <vector>
+
+struct WorkerPool;
+
+struct FrustumCullStats
+{
+    uint32_t tested_count = 0; // draw IDs tested against the frustum
+    uint32_t instance_count = 0; // instances in the culled sortbins
+    uint32_t visible_instance_count = 0;
+    uint32_t visible_draw_count = 0; // instanced draws left after compaction
+    uint64_t test_ns = 0;
+    uint64_t compact_ns = 0;
+};
+
+// CPU frustum culling of renderables by draw ID.
+//
+// World space boxes are stored structure of arrays, padded to s_lane_count, so each iteration tests 8 (AVX) or
+// 4 (SSE) consecutive draw IDs against the 6 frustum planes. The test is split into fixed size draw ID ranges run
+// on the worker pool, writing one visibility byte per draw ID. Compaction then walks the instances of the sortbin
+// draw lists in chunks, again on the pool, looks up the draw ID of every instance slot in the instance table and
+// keeps the visible runs of slots.
+//
+// Draw IDs without bounds (set_bounds never called, or clear_bounds) are always visible.
+struct FrustumCuller
+{
+private:
+protected:
+
+    static constexpr uint32_t s_lane_count = 8;
+    static constexpr uint32_t s_test_task_size = 1 << 14; // draw IDs per test task, multiple of s_lane_count
+    static constexpr uint32_t s_compact_task_size = 1 << 13; // instances per compaction task, large draws are split
+
+    // Instances [instance_begin, ...) of draw begin up to [..., instance_end) of draw end - 1.
+    struct CompactTask
+    {
+        const std::vector<DrawInfo>* p_draw_list;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t instance_begin;
+        uint32_t instance_end;
+    };
+
+    WorkerPool& m_worker_pool;
+
+    // World space bounds by draw ID.
+    std::vector<float> m_center_x;
+    std::vector<float> m_center_y;
+    std::vector<float> m_center_z;
+    std::vector<float> m_extent_x;
+    std::vector<float> m_extent_y;
+    std::vector<float> m_extent_z;
+
+    std::vector<uint8_t> m_visibility_list; // by draw ID, 1 when inside the frustum
+
+    std::vector<CompactTask> m_compact_task_list;
+    std::vector<std::vector<DrawInfo>> m_compact_output_list; // by compaction task
+
+    FrustumCullStats m_stats {};
+
+    void reserve_draw_ID(const uint32_t draw_ID);
+    void test_range(const float (&plane_list)[6][4], const uint32_t begin, const uint32_t end);
+    void compact(const CompactTask& task, const std::span<const uint32_t> instance_draw_ID_list, std::vector<DrawInfo>& visible_draw_list) const;
+
+public:
+    explicit FrustumCuller(WorkerPool& worker_pool);
+
+    FrustumCuller(const FrustumCuller&) = delete;
+    FrustumCuller& operator=(const FrustumCuller&) = delete;
+    FrustumCuller(FrustumCuller&&) = delete;
+    FrustumCuller& operator=(FrustumCuller&&) = delete;
+
+    // model_mat is column major. Invalid object bounds leave the draw ID unbounded.
+    void set_bounds(const uint32_t draw_ID, const BoundingBox& object_bounds, const float* const model_mat);
+    void clear_bounds(const uint32_t draw_ID);
+    // World space box of draw_ID, invalid when the draw ID is unbounded.
+    BoundingBox get_world_bounds(const uint32_t draw_ID) const;
+
+    // Tests every draw ID against view_proj_mat (column major, clip space z in [0, 1]) and writes the visible part of
+    // the draw lists of sortbin_list[sortbin_ID_list] into visible_draw_lists_list, indexed by sortbin ID.
+    // instance_draw_ID_list holds the draw ID of every instance slot the draws cover.
+    void cull(const float* const view_proj_mat,
+        const std::vector<SortBin>& sortbin_list,
+        const std::vector<uint16_t>& sortbin_ID_list,
+        const std::span<const uint32_t> instance_draw_ID_list,
+        std::vector<VisibleDrawLists>& visible_draw_lists_list);
+
+    const FrustumCullStats& get_stats() const { return m_stats; }
+};
+
+#endif // RENDERER_FRUSTUM_CULLER_HPP
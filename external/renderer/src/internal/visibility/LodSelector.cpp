@@ -0,0 +1,152 @@
+#include "LodSelector.hpp"
+#include "FrustumCuller.hpp"
+#include "../misc/WorkerPool.hpp"
+
+#include <chrono>
+#include <cmath>
+
+static float get_radius(const BoundingBox& bounds)
+{
+    return sqrtf(bounds.extent[0] * bounds.extent[0] + bounds.extent[1] * bounds.extent[1] + bounds.extent[2] * bounds.extent[2]);
+}
+
+LodSelector::LodSelector(WorkerPool& worker_pool)
+    : m_worker_pool { worker_pool }
+{
+}
+
+void LodSelector::select(const float* const view_proj_mat,
+    const float error_scale,
+    const std::vector<uint16_t>& sortbin_ID_list,
+    const std::vector<Mesh>& mesh_vec,
+    const FrustumCuller& frustum_culler,
+    const std::span<const uint32_t> instance_draw_ID_list,
+    std::vector<VisibleDrawLists>& visible_draw_lists_list)
+{
+    m_stats = {};
+
+    const auto select_start = std::chrono::steady_clock::now();
+
+    // Non-indexed draws have no index ranges to switch between.
+    m_draw_list_list.clear();
+
+    for (const uint16_t sortbin_ID : sortbin_ID_list)
+    {
+        VisibleDrawLists& visible_draw_lists = visible_draw_lists_list[sortbin_ID];
+
+        m_draw_list_list.push_back(&visible_draw_lists.draw_list_u32);
+        m_draw_list_list.push_back(&visible_draw_lists.draw_list_u16);
+        m_draw_list_list.push_back(&visible_draw_lists.draw_list_u8);
+    }
+
+    const uint32_t task_count = static_cast<uint32_t>(m_draw_list_list.size());
+
+    m_output_list.resize(task_count);
+    m_task_stats_list.assign(task_count, {});
+
+    const float y_scale = sqrtf(view_proj_mat[1] * view_proj_mat[1] + view_proj_mat[5] * view_proj_mat[5] + view_proj_mat[9] * view_proj_mat[9]);
+
+    const auto select_lod = [&](const Mesh& mesh, const float object_radius, const uint32_t draw_ID) -> uint32_t
+    {
+        const BoundingBox world_bounds = frustum_culler.get_world_bounds(draw_ID);
+
+        if (!world_bounds.is_valid() || object_radius <= 0.0f)
+        {
+            return 0;
+        }
+
+        const float center_w = view_proj_mat[3] * world_bounds.center[0] + view_proj_mat[7] * world_bounds.center[1] + view_proj_mat[11] * world_bounds.center[2] + view_proj_mat[15];
+        const float nearest_w = center_w - (fabsf(view_proj_mat[3]) * world_bounds.extent[0] + fabsf(view_proj_mat[7]) * world_bounds.extent[1] + fabsf(view_proj_mat[11]) * world_bounds.extent[2]);
+
+        if (nearest_w <= 0.0f)
+        {
+            return 0;
+        }
+
+        const float error_factor = get_radius(world_bounds) / object_radius * y_scale * error_scale / nearest_w;
+
+        for (uint32_t lod = mesh.lod_count - 1; lod > 0; lod--)
+        {
+            if (mesh.lod_list[lod].error * error_factor <= 1.0f)
+            {
+                return lod;
+            }
+        }
+
+        return 0;
+    };
+
+    m_worker_pool.run(task_count, [&](const uint32_t task_idx, const uint32_t)
+    {
+        std::vector<DrawInfo>& draw_list = *m_draw_list_list[task_idx];
+        std::vector<DrawInfo>& output_list = m_output_list[task_idx];
+        LodSelectStats& stats = m_task_stats_list[task_idx];
+
+        output_list.clear();
+
+        for (const DrawInfo& draw_info : draw_list)
+        {
+            const Mesh& mesh = mesh_vec[draw_info.mesh_id];
+            const uint64_t full_detail_triangle_count = static_cast<uint64_t>(draw_info.index_count / 3) * draw_info.instance_count;
+
+            stats.full_detail_triangle_count += full_detail_triangle_count;
+
+            if (mesh.lod_count <= 1 || error_scale <= 0.0f)
+            {
+                stats.triangle_count += full_detail_triangle_count;
+                output_list.push_back(draw_info);
+                continue;
+            }
+
+            const float object_radius = get_radius(mesh.bounds);
+
+            DrawInfo lod_draw_info = draw_info;
+            lod_draw_info.instance_count = 0;
+            uint32_t run_lod = UINT32_MAX;
+
+            for (uint32_t instance = draw_info.first_instance; instance < draw_info.first_instance + draw_info.instance_count; instance++)
+            {
+                const uint32_t lod = select_lod(mesh, object_radius, instance_draw_ID_list[instance]);
+                const MeshLod& mesh_lod = mesh.lod_list[lod];
+
+                stats.instance_count++;
+                stats.lod_instance_count += lod != 0;
+                stats.triangle_count += mesh_lod.index_count / 3;
+
+                if (lod != run_lod)
+                {
+                    if (lod_draw_info.instance_count != 0)
+                    {
+                        output_list.push_back(lod_draw_info);
+                    }
+
+                    // The sortbin draw points at the full detail range, the levels follow it.
+                    lod_draw_info.index_count = mesh_lod.index_count;
+                    lod_draw_info.first_index = draw_info.first_index + mesh_lod.first_index;
+                    lod_draw_info.first_instance = instance;
+                    lod_draw_info.instance_count = 0;
+                    run_lod = lod;
+                }
+
+                lod_draw_info.instance_count++;
+            }
+
+            if (lod_draw_info.instance_count != 0)
+            {
+                output_list.push_back(lod_draw_info);
+            }
+        }
+
+        draw_list.swap(output_list);
+    });
+
+    for (const LodSelectStats& task_stats : m_task_stats_list)
+    {
+        m_stats.instance_count += task_stats.instance_count;
+        m_stats.lod_instance_count += task_stats.lod_instance_count;
+        m_stats.triangle_count += task_stats.triangle_count;
+        m_stats.full_detail_triangle_count += task_stats.full_detail_triangle_count;
+    }
+
+    m_stats.select_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - select_start).count());
+}
@@ -0,0 +1,68 @@
+#ifndef RENDERER_LOD_SELECTOR_HPP
+#define RENDERER_LOD_SELECTOR_HPP
+
+#include "../pod/DrawInfo.hpp"
+#include "../pod/Mesh.hpp"
+#include "../pod/VisibleDrawLists.hpp"
+
+#include <inttypes.h>
+#include <span>
+#include <vector>
+
+struct WorkerPool;
+struct FrustumCuller;
+
+struct LodSelectStats
+{
+    uint32_t instance_count = 0; // visible instances of meshes with a LOD chain
+    uint32_t lod_instance_count = 0; // of those, drawn at a simplified level
+    uint64_t triangle_count = 0; // of every visible indexed instance, at the selected levels
+    uint64_t full_detail_triangle_count = 0; // the same instances at full detail
+    uint64_t select_ns = 0;
+};
+
+// Picks a Mesh::lod_list level per visible instance from its projected error and rewrites the indexed draw lists of
+// the culled sortbins to draw it. An instanced draw is split wherever consecutive instances pick different levels.
+//
+// A level's error in pixels is its object space error, scaled from the mesh box radius to the instance's world box
+// radius, times the projection's y scale over the clip space w of the world box's nearest point, times half the
+// target height. The y scale is the length of the second row of view_proj, exact for rigid views. The coarsest level
+// within the tolerated error is drawn, instances without bounds or reaching the camera plane draw full detail.
+//
+// Lists are processed as separate tasks on the worker pool.
+struct LodSelector
+{
+private:
+protected:
+
+    WorkerPool& m_worker_pool;
+
+    std::vector<std::vector<DrawInfo>*> m_draw_list_list;
+    std::vector<std::vector<DrawInfo>> m_output_list; // by task
+    std::vector<LodSelectStats> m_task_stats_list;
+
+    LodSelectStats m_stats {};
+
+public:
+    explicit LodSelector(WorkerPool& worker_pool);
+
+    LodSelector(const LodSelector&) = delete;
+    LodSelector& operator=(const LodSelector&) = delete;
+    LodSelector(LodSelector&&) = delete;
+    LodSelector& operator=(LodSelector&&) = delete;
+
+    // view_proj_mat is column major. error_scale is the render target height / (2 * tolerated error in pixels),
+    // 0 leaves every draw at full detail and only counts triangles. The bounds of an instance are those of the draw ID
+    // instance_draw_ID_list holds for its slot.
+    void select(const float* const view_proj_mat,
+        const float error_scale,
+        const std::vector<uint16_t>& sortbin_ID_list,
+        const std::vector<Mesh>& mesh_vec,
+        const FrustumCuller& frustum_culler,
+        const std::span<const uint32_t> instance_draw_ID_list,
+        std::vector<VisibleDrawLists>& visible_draw_lists_list);
+
+    const LodSelectStats& get_stats() const { return m_stats; }
+};
+
+#endif // RENDERER_LOD_SELECTOR_HPP
@@ -0,0 +1,856 @@
+#include "OcclusionCuller.hpp"
+#include "FrustumCuller.hpp"
+#include "../misc/logger.hpp"
+#include "../misc/ShaderModuleCache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+static constexpr uint32_t s_cull_flag_reverse_z = 1 << 0;
+static constexpr uint32_t s_cull_flag_pyramid_valid = 1 << 1;
+static constexpr uint32_t s_cull_flag_two_phase = 1 << 2;
+static constexpr uint32_t s_cull_flag_early_phase = 1 << 3;
+
+// Mirror the push constant blocks of hiz_build.comp and occlusion_cull.comp.
+struct BuildPushConstants
+{
+    int32_t src_size[2];
+    int32_t dst_size[2];
+    uint32_t is_reverse_z;
+};
+
+struct CullPushConstants
+{
+    float view_proj_mat[16];
+    float pyramid_size[2];
+    uint32_t pyramid_level_count;
+    uint32_t candidate_count;
+    uint32_t command_base; // in uint32 words
+    uint32_t count_base; // in uint32 words
+    uint32_t flags;
+    uint32_t padding;
+};
+
+static VkPipeline create_compute_pipeline(ShaderModuleCache& shader_module_cache, const std::string& shader_root_path, const std::string& shader_name, const VkPipelineLayout vk_handle_pipeline_layout)
+{
+    const VkShaderModule vk_handle_shader_module = shader_module_cache.get(shader_root_path + shader_name + ".spv");
+
+    const VkComputePipelineCreateInfo create_info {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0x0,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = vk_handle_shader_module,
+            .pName = "main",
+            .pSpecializationInfo = nullptr,
+        },
+        .layout = vk_handle_pipeline_layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    return vk_core::create_compute_pipeline(create_info);
+}
+
+static VkImageAspectFlags get_depth_aspect_mask(const VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        {
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+        default:
+        {
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        }
+    }
+}
+
+static void record_memory_barrier(const VkCommandBuffer vk_handle_cmd_buff,
+    const VkPipelineStageFlags src_stage_flags, const VkAccessFlags src_access_flags,
+    const VkPipelineStageFlags dst_stage_flags, const VkAccessFlags dst_access_flags)
+{
+    const VkMemoryBarrier memory_barrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = src_access_flags,
+        .dstAccessMask = dst_access_flags,
+    };
+
+    vkCmdPipelineBarrier(vk_handle_cmd_buff, src_stage_flags, dst_stage_flags, 0x0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+}
+
+static VkExtent2D get_level_extent(const VkExtent2D extent, const uint32_t level)
+{
+    return { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+}
+
+OcclusionCuller::OcclusionCuller(const CreateInfo& create_info)
+    : m_frame_resource_count { create_info.frame_resource_count }
+    , m_is_two_phase { create_info.is_two_phase }
+    , m_is_reverse_z { create_info.is_reverse_z }
+    , m_vk_handle_depth_image_list { create_info.vk_handle_depth_image_list }
+    , m_depth_image_layout { create_info.depth_image_layout }
+    , m_depth_aspect_mask { get_depth_aspect_mask(create_info.depth_format) }
+    , m_depth_extent { create_info.depth_extent }
+{
+    m_frame_list.resize(m_frame_resource_count);
+
+    for (FrameResources& frame : m_frame_list)
+    {
+        frame.stream_list.resize(static_cast<size_t>(create_info.sortbin_count) * s_stream_per_sortbin_count);
+    }
+
+    create_pyramid();
+    create_pipelines(create_info.shader_root_path, *create_info.p_shader_module_cache);
+    create_desc_sets(create_info.vk_handle_depth_image_view_list);
+
+    m_stats.pyramid_width = m_pyramid_extent.width;
+    m_stats.pyramid_height = m_pyramid_extent.height;
+    m_stats.pyramid_level_count = m_pyramid_level_count;
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    for (const FrameResources& frame : m_frame_list)
+    {
+        destroy_buffer(frame.candidate_buffer);
+        destroy_buffer(frame.output_buffer);
+        destroy_buffer(frame.readback_buffer);
+    }
+
+    for (const RetiredBuffer& retired_buffer : m_retired_buffer_list)
+    {
+        destroy_buffer(retired_buffer.buffer);
+    }
+
+    destroy_buffer(m_visibility_buffer);
+
+    vk_core::destroy_pipeline(m_vk_handle_build_pipeline);
+    vk_core::destroy_pipeline(m_vk_handle_cull_pipeline);
+    vk_core::destroy_pipeline_layout(m_vk_handle_build_pipeline_layout);
+    vk_core::destroy_pipeline_layout(m_vk_handle_cull_pipeline_layout);
+    vk_core::destroy_desc_pool(m_vk_handle_desc_pool);
+    vk_core::destroy_desc_set_layout(m_vk_handle_build_desc_set_layout);
+    vk_core::destroy_desc_set_layout(m_vk_handle_cull_desc_set_layout);
+    vk_core::destroy_sampler(m_vk_handle_sampler);
+
+    for (const VkImageView vk_handle_level_view : m_vk_handle_pyramid_level_view_list)
+    {
+        vk_core::destroy_image_view(vk_handle_level_view);
+    }
+
+    vk_core::destroy_image_view(m_vk_handle_pyramid_view);
+    vk_core::destroy_image(m_vk_handle_pyramid_image);
+    vk_core::free_allocation(m_pyramid_memory_allocation);
+}
+
+uint32_t OcclusionCuller::get_stream_idx(const uint16_t sortbin_id, const VkIndexType index_type)
+{
+    uint32_t type_idx = 0;
+
+    switch (index_type)
+    {
+        case VK_INDEX_TYPE_UINT32:
+        {
+            type_idx = 0;
+            break;
+        }
+        case VK_INDEX_TYPE_UINT16:
+        {
+            type_idx = 1;
+            break;
+        }
+        case VK_INDEX_TYPE_UINT8_EXT:
+        {
+            type_idx = 2;
+            break;
+        }
+        default:
+        {
+            type_idx = 3;
+            break;
+        }
+    }
+
+    return static_cast<uint32_t>(sortbin_id) * s_stream_per_sortbin_count + type_idx;
+}
+
+OcclusionCuller::Buffer OcclusionCuller::create_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags, const VkMemoryPropertyFlags memory_property_flags)
+{
+    Buffer buffer {};
+    buffer.size = std::bit_ceil(std::max(size, s_min_buffer_size));
+
+    const VkBufferCreateInfo buffer_create_info {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .size = buffer.size,
+        .usage = usage_flags,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+    };
+
+    buffer.vk_handle_buffer = vk_core::create_buffer(buffer_create_info);
+    buffer.memory_allocation = vk_core::allocate_and_bind_buffer_memory(buffer.vk_handle_buffer, memory_property_flags);
+
+    return buffer;
+}
+
+void OcclusionCuller::destroy_buffer(const Buffer& buffer)
+{
+    if (buffer.vk_handle_buffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vk_core::destroy_buffer(buffer.vk_handle_buffer);
+    vk_core::free_allocation(buffer.memory_allocation);
+}
+
+void OcclusionCuller::create_pyramid()
+{
+    // Rounding down keeps every level exactly half the previous one, level 0 covering at most 2x2 (3x3 when misaligned)
+    // depth texels per texel.
+    m_pyramid_extent = { std::bit_floor(std::max(m_depth_extent.width, 1u)), std::bit_floor(std::max(m_depth_extent.height, 1u)) };
+    m_pyramid_level_count = std::bit_width(std::max(m_pyramid_extent.width, m_pyramid_extent.height));
+
+    const VkImageCreateInfo image_create_info {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .extent = { m_pyramid_extent.width, m_pyramid_extent.height, 1 },
+        .mipLevels = m_pyramid_level_count,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    m_vk_handle_pyramid_image = vk_core::create_image(image_create_info);
+    m_pyramid_memory_allocation = vk_core::allocate_and_bind_image_memory(m_vk_handle_pyramid_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkImageViewCreateInfo image_view_create_info {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .image = m_vk_handle_pyramid_image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = m_pyramid_level_count,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        }
+    };
+
+    m_vk_handle_pyramid_view = vk_core::create_image_view(image_view_create_info);
+
+    for (uint32_t level = 0; level < m_pyramid_level_count; level++)
+    {
+        image_view_create_info.subresourceRange.baseMipLevel = level;
+        image_view_create_info.subresourceRange.levelCount = 1;
+        m_vk_handle_pyramid_level_view_list.push_back(vk_core::create_image_view(image_view_create_info));
+    }
+
+    // Texels are fetched, never filtered.
+    const VkSamplerCreateInfo sampler_create_info {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    m_vk_handle_sampler = vk_core::create_sampler(sampler_create_info);
+}
+
+void OcclusionCuller::create_pipelines(const std::string& shader_root_path, ShaderModuleCache& shader_module_cache)
+{
+    const VkDescriptorSetLayoutBinding build_binding_list[] {
+        { .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .pImmutableSamplers = nullptr },
+        { .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .pImmutableSamplers = nullptr },
+    };
+
+    const VkDescriptorSetLayoutBinding cull_binding_list[] {
+        { .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .pImmutableSamplers = nullptr },
+        { .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .pImmutableSamplers = nullptr },
+        { .binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .pImmutableSamplers = nullptr },
+        { .binding = 3, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .pImmutableSamplers = nullptr },
+    };
+
+    const VkDescriptorSetLayoutCreateInfo build_desc_set_layout_create_info {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .bindingCount = 2,
+        .pBindings = build_binding_list,
+    };
+
+    const VkDescriptorSetLayoutCreateInfo cull_desc_set_layout_create_info {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .bindingCount = 4,
+        .pBindings = cull_binding_list,
+    };
+
+    m_vk_handle_build_desc_set_layout = vk_core::create_desc_set_layout(build_desc_set_layout_create_info);
+    m_vk_handle_cull_desc_set_layout = vk_core::create_desc_set_layout(cull_desc_set_layout_create_info);
+
+    const VkPushConstantRange build_push_const_range { .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .offset = 0, .size = sizeof(BuildPushConstants) };
+    const VkPushConstantRange cull_push_const_range { .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .offset = 0, .size = sizeof(CullPushConstants) };
+
+    const VkPipelineLayoutCreateInfo build_pipeline_layout_create_info {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_vk_handle_build_desc_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &build_push_const_range,
+    };
+
+    const VkPipelineLayoutCreateInfo cull_pipeline_layout_create_info {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_vk_handle_cull_desc_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &cull_push_const_range,
+    };
+
+    m_vk_handle_build_pipeline_layout = vk_core::create_pipeline_layout(build_pipeline_layout_create_info);
+    m_vk_handle_cull_pipeline_layout = vk_core::create_pipeline_layout(cull_pipeline_layout_create_info);
+
+    m_vk_handle_build_pipeline = create_compute_pipeline(shader_module_cache, shader_root_path, "hiz_build.comp", m_vk_handle_build_pipeline_layout);
+    m_vk_handle_cull_pipeline = create_compute_pipeline(shader_module_cache, shader_root_path, "occlusion_cull.comp", m_vk_handle_cull_pipeline_layout);
+}
+
+void OcclusionCuller::create_desc_sets(const std::vector<VkImageView>& vk_handle_depth_image_view_list)
+{
+    const uint32_t level_set_count = m_pyramid_level_count - 1;
+
+    const VkDescriptorPoolSize desc_pool_size_list[] {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_frame_resource_count * 2 + level_set_count },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_frame_resource_count + level_set_count },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_frame_resource_count * 3 },
+    };
+
+    const VkDescriptorPoolCreateInfo desc_pool_create_info {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .maxSets = m_frame_resource_count * 2 + level_set_count,
+        .poolSizeCount = 3,
+        .pPoolSizes = desc_pool_size_list,
+    };
+
+    m_vk_handle_desc_pool = vk_core::create_desc_pool(desc_pool_create_info);
+
+    const auto allocate_desc_sets = [&](const VkDescriptorSetLayout vk_handle_desc_set_layout, const uint32_t desc_set_count)
+    {
+        const std::vector<VkDescriptorSetLayout> vk_handle_desc_set_layout_list(desc_set_count, vk_handle_desc_set_layout);
+
+        const VkDescriptorSetAllocateInfo alloc_info {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .descriptorPool = m_vk_handle_desc_pool,
+            .descriptorSetCount = desc_set_count,
+            .pSetLayouts = vk_handle_desc_set_layout_list.data(),
+        };
+
+        return vk_core::allocate_desc_sets(alloc_info);
+    };
+
+    const std::vector<VkDescriptorSet> depth_build_desc_set_list = allocate_desc_sets(m_vk_handle_build_desc_set_layout, m_frame_resource_count);
+    const std::vector<VkDescriptorSet> cull_desc_set_list = allocate_desc_sets(m_vk_handle_cull_desc_set_layout, m_frame_resource_count);
+
+    if (level_set_count > 0)
+    {
+        m_vk_handle_level_build_desc_set_list = allocate_desc_sets(m_vk_handle_build_desc_set_layout, level_set_count);
+    }
+
+    // Image infos are referenced by the writes, so they are sized up front and never reallocated.
+    std::vector<VkDescriptorImageInfo> image_info_list;
+    image_info_list.reserve(m_frame_resource_count * 3 + level_set_count * 2);
+
+    std::vector<VkWriteDescriptorSet> write_desc_set_list;
+
+    const auto add_image_write = [&](const VkDescriptorSet vk_handle_desc_set, const uint32_t binding, const VkDescriptorType desc_type, const VkImageView vk_handle_image_view, const VkImageLayout image_layout)
+    {
+        image_info_list.push_back({
+            .sampler = desc_type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ? m_vk_handle_sampler : VK_NULL_HANDLE,
+            .imageView = vk_handle_image_view,
+            .imageLayout = image_layout,
+        });
+
+        write_desc_set_list.push_back({
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = vk_handle_desc_set,
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = desc_type,
+            .pImageInfo = &image_info_list.back(),
+            .pBufferInfo = nullptr,
+            .pTexelBufferView = nullptr,
+        });
+    };
+
+    for (uint32_t frame_idx = 0; frame_idx < m_frame_resource_count; frame_idx++)
+    {
+        FrameResources& frame = m_frame_list[frame_idx];
+        frame.vk_handle_depth_build_desc_set = depth_build_desc_set_list[frame_idx];
+        frame.vk_handle_cull_desc_set = cull_desc_set_list[frame_idx];
+
+        add_image_write(frame.vk_handle_depth_build_desc_set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, vk_handle_depth_image_view_list[frame_idx], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        add_image_write(frame.vk_handle_depth_build_desc_set, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_vk_handle_pyramid_level_view_list[0], VK_IMAGE_LAYOUT_GENERAL);
+        add_image_write(frame.vk_handle_cull_desc_set, 3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_vk_handle_pyramid_view, VK_IMAGE_LAYOUT_GENERAL);
+    }
+
+    for (uint32_t level = 1; level < m_pyramid_level_count; level++)
+    {
+        const VkDescriptorSet vk_handle_desc_set = m_vk_handle_level_build_desc_set_list[level - 1];
+
+        add_image_write(vk_handle_desc_set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_vk_handle_pyramid_level_view_list[level - 1], VK_IMAGE_LAYOUT_GENERAL);
+        add_image_write(vk_handle_desc_set, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_vk_handle_pyramid_level_view_list[level], VK_IMAGE_LAYOUT_GENERAL);
+    }
+
+    vk_core::update_desc_sets(static_cast<uint32_t>(write_desc_set_list.size()), write_desc_set_list.data(), 0, nullptr);
+}
+
+void OcclusionCuller::update_cull_desc_set(FrameResources& frame)
+{
+    const VkDescriptorBufferInfo buffer_info_list[] {
+        { .buffer = frame.candidate_buffer.vk_handle_buffer, .offset = 0, .range = VK_WHOLE_SIZE },
+        { .buffer = frame.output_buffer.vk_handle_buffer, .offset = 0, .range = VK_WHOLE_SIZE },
+        { .buffer = m_visibility_buffer.vk_handle_buffer, .offset = 0, .range = VK_WHOLE_SIZE },
+    };
+
+    const VkWriteDescriptorSet write_desc_set {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = frame.vk_handle_cull_desc_set,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 3,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pImageInfo = nullptr,
+        .pBufferInfo = buffer_info_list,
+        .pTexelBufferView = nullptr,
+    };
+
+    vk_core::update_desc_sets(1, &write_desc_set, 0, nullptr);
+
+    frame.vk_handle_bound_visibility_buffer = m_visibility_buffer.vk_handle_buffer;
+}
+
+void OcclusionCuller::read_back_counts(const FrameResources& frame)
+{
+    const uint32_t* const p_count_list = static_cast<const uint32_t*>(frame.readback_buffer.memory_allocation.mapped_ptr);
+
+    m_stats.early_visible_count = 0;
+    m_stats.late_visible_count = 0;
+
+    for (uint32_t run_idx = 0; run_idx < frame.readback_run_count; run_idx++)
+    {
+        m_stats.early_visible_count += p_count_list[run_idx];
+        m_stats.late_visible_count += p_count_list[frame.readback_run_count + run_idx];
+    }
+}
+
+void OcclusionCuller::set_candidates(const uint32_t frame_resource_idx,
+    const float* const view_proj_mat,
+    const std::vector<uint16_t>& sortbin_ID_list,
+    const std::vector<VisibleDrawLists>& visible_draw_lists_list,
+    const FrustumCuller& frustum_culler,
+    const std::span<const uint32_t> instance_draw_ID_list)
+{
+    FrameResources& frame = m_frame_list[frame_resource_idx];
+
+    // The previous submission of this frame resource has completed.
+    if (frame.has_pending_readback)
+    {
+        read_back_counts(frame);
+        frame.has_pending_readback = false;
+    }
+
+    memcpy(frame.view_proj_mat, view_proj_mat, sizeof(frame.view_proj_mat));
+
+    for (StreamRuns& stream : frame.stream_list)
+    {
+        stream.run_list.clear();
+        stream.instance_count = 0;
+    }
+
+    // Candidates are laid out in draw order, so every run owns the output commands [first_command, first_command + command_count)
+    // of a phase region and never outgrows them.
+    m_candidate_list.clear();
+    uint32_t run_count = 0;
+    uint32_t draw_ID_end = 0;
+
+    for (const uint16_t sortbin_ID : sortbin_ID_list)
+    {
+        const VisibleDrawLists& visible_draw_lists = visible_draw_lists_list[sortbin_ID];
+
+        const std::pair<const std::vector<DrawInfo>*, VkIndexType> draw_list_list[] {
+            { &visible_draw_lists.draw_list_u32, VK_INDEX_TYPE_UINT32 },
+            { &visible_draw_lists.draw_list_u16, VK_INDEX_TYPE_UINT16 },
+            { &visible_draw_lists.draw_list_u8, VK_INDEX_TYPE_UINT8_EXT },
+            { &visible_draw_lists.draw_list, VK_INDEX_TYPE_MAX_ENUM },
+        };
+
+        for (const auto& [p_draw_list, index_type] : draw_list_list)
+        {
+            StreamRuns& stream = frame.stream_list[get_stream_idx(sortbin_ID, index_type)];
+            const bool is_indexed = index_type != VK_INDEX_TYPE_MAX_ENUM;
+
+            for (const DrawInfo& draw_info : *p_draw_list)
+            {
+                if (stream.run_list.empty() || stream.run_list.back().geometry_block_id != draw_info.geometry_block_id)
+                {
+                    stream.run_list.push_back({ draw_info.geometry_block_id, static_cast<uint32_t>(m_candidate_list.size()), 0, run_count++ });
+                }
+
+                IndirectDrawRun& run = stream.run_list.back();
+                run.command_count += draw_info.instance_count;
+                stream.instance_count += draw_info.instance_count;
+
+                for (uint32_t instance_idx = 0; instance_idx < draw_info.instance_count; instance_idx++)
+                {
+                    const uint32_t slot = draw_info.first_instance + instance_idx;
+                    const uint32_t draw_ID = instance_draw_ID_list[slot];
+                    const BoundingBox world_bounds = frustum_culler.get_world_bounds(draw_ID);
+
+                    Candidate candidate {};
+                    memcpy(candidate.center, world_bounds.center, sizeof(candidate.center));
+                    memcpy(candidate.extent, world_bounds.extent, sizeof(candidate.extent));
+                    candidate.slot_base = run.first_command;
+                    candidate.count_slot = run.count_slot;
+                    candidate.draw_ID = draw_ID;
+
+                    if (is_indexed)
+                    {
+                        candidate.command[0] = draw_info.index_count;
+                        candidate.command[1] = 1;
+                        candidate.command[2] = draw_info.first_index;
+                        candidate.command[3] = static_cast<uint32_t>(draw_info.vertex_offset);
+                        candidate.command[4] = slot;
+                    }
+                    else
+                    {
+                        candidate.command[0] = draw_info.vertex_count;
+                        candidate.command[1] = 1;
+                        candidate.command[2] = draw_info.first_vertex;
+                        candidate.command[3] = slot;
+                    }
+
+                    m_candidate_list.push_back(candidate);
+                    draw_ID_end = std::max(draw_ID_end, draw_ID + 1);
+                }
+            }
+        }
+    }
+
+    frame.candidate_count = static_cast<uint32_t>(m_candidate_list.size());
+    frame.run_count = run_count;
+
+    // Counts of both phases, padded so the commands start 16 byte aligned and the count clear is never empty.
+    const VkDeviceSize count_size = (static_cast<VkDeviceSize>(s_phase_count) * run_count * sizeof(uint32_t) + 15) / 16 * 16;
+    frame.command_offset = std::max(count_size, VkDeviceSize { 16 });
+
+    bool is_desc_set_dirty = frame.vk_handle_bound_visibility_buffer != m_visibility_buffer.vk_handle_buffer;
+
+    const VkDeviceSize candidate_size = static_cast<VkDeviceSize>(frame.candidate_count) * sizeof(Candidate);
+    if (frame.candidate_buffer.size < candidate_size || frame.candidate_buffer.vk_handle_buffer == VK_NULL_HANDLE)
+    {
+        destroy_buffer(frame.candidate_buffer);
+        frame.candidate_buffer = create_buffer(candidate_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        is_desc_set_dirty = true;
+    }
+
+    const VkDeviceSize output_size = frame.command_offset + static_cast<VkDeviceSize>(s_phase_count) * frame.candidate_count * s_command_stride;
+    if (frame.output_buffer.size < output_size || frame.output_buffer.vk_handle_buffer == VK_NULL_HANDLE)
+    {
+        destroy_buffer(frame.output_buffer);
+        frame.output_buffer = create_buffer(output_size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        is_desc_set_dirty = true;
+    }
+
+    if (frame.readback_buffer.size < count_size || frame.readback_buffer.vk_handle_buffer == VK_NULL_HANDLE)
+    {
+        destroy_buffer(frame.readback_buffer);
+        frame.readback_buffer = create_buffer(count_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+
+    // Shared by every frame resource, so a replaced buffer may still be in use. Losing the visibility of last frame
+    // only costs efficiency: phase 1 still tests and draws everything phase 0 left out.
+    const VkDeviceSize visibility_size = static_cast<VkDeviceSize>(draw_ID_end) * sizeof(uint32_t);
+    if (m_visibility_buffer.size < visibility_size || m_visibility_buffer.vk_handle_buffer == VK_NULL_HANDLE)
+    {
+        if (m_visibility_buffer.vk_handle_buffer != VK_NULL_HANDLE)
+        {
+            m_retired_buffer_list.push_back({ m_visibility_buffer, m_frame_epoch });
+        }
+
+        m_visibility_buffer = create_buffer(visibility_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        m_is_visibility_cleared = false;
+        is_desc_set_dirty = true;
+    }
+
+    if (is_desc_set_dirty)
+    {
+        update_cull_desc_set(frame);
+    }
+
+    if (!m_candidate_list.empty())
+    {
+        memcpy(frame.candidate_buffer.memory_allocation.mapped_ptr, m_candidate_list.data(), candidate_size);
+    }
+
+    m_stats.candidate_count = frame.candidate_count;
+    m_stats.run_count = frame.run_count;
+}
+
+void OcclusionCuller::record_cull(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx, const uint32_t phase)
+{
+    const FrameResources& frame = m_frame_list[frame_resource_idx];
+
+    if (phase == 0)
+    {
+        if (!m_is_visibility_cleared)
+        {
+            vkCmdFillBuffer(vk_handle_cmd_buff, m_visibility_buffer.vk_handle_buffer, 0, VK_WHOLE_SIZE, 0);
+            m_is_visibility_cleared = true;
+        }
+
+        vkCmdFillBuffer(vk_handle_cmd_buff, frame.output_buffer.vk_handle_buffer, 0, frame.command_offset, 0);
+    }
+
+    // Orders the count clear, the pyramid build and the previous visibility writes before the test.
+    record_memory_barrier(vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    if (frame.candidate_count > 0)
+    {
+        uint32_t flags = 0;
+        flags |= m_is_reverse_z ? s_cull_flag_reverse_z : 0;
+        flags |= m_is_pyramid_valid ? s_cull_flag_pyramid_valid : 0;
+        flags |= m_is_two_phase ? s_cull_flag_two_phase : 0;
+        flags |= (m_is_two_phase && phase == 0) ? s_cull_flag_early_phase : 0;
+
+        CullPushConstants push_constants {
+            .view_proj_mat = {},
+            .pyramid_size = { static_cast<float>(m_pyramid_extent.width), static_cast<float>(m_pyramid_extent.height) },
+            .pyramid_level_count = m_pyramid_level_count,
+            .candidate_count = frame.candidate_count,
+            .command_base = static_cast<uint32_t>(frame.command_offset / sizeof(uint32_t)) + phase * frame.candidate_count * s_command_word_count,
+            .count_base = phase * frame.run_count,
+            .flags = flags,
+            .padding = 0,
+        };
+
+        memcpy(push_constants.view_proj_mat, frame.view_proj_mat, sizeof(push_constants.view_proj_mat));
+
+        vkCmdBindPipeline(vk_handle_cmd_buff, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_handle_cull_pipeline);
+        vkCmdBindDescriptorSets(vk_handle_cmd_buff, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_handle_cull_pipeline_layout, 0, 1, &frame.vk_handle_cull_desc_set, 0, nullptr);
+        vkCmdPushConstants(vk_handle_cmd_buff, m_vk_handle_cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), &push_constants);
+        vkCmdDispatch(vk_handle_cmd_buff, (frame.candidate_count + s_cull_group_size - 1) / s_cull_group_size, 1, 1);
+    }
+
+    record_memory_barrier(vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void OcclusionCuller::record_depth_pyramid(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx)
+{
+    const FrameResources& frame = m_frame_list[frame_resource_idx];
+
+    VkImageMemoryBarrier image_memory_barrier_list[] {
+        {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .oldLayout = m_depth_image_layout,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = m_vk_handle_depth_image_list[frame_resource_idx],
+            .subresourceRange = { .aspectMask = m_depth_aspect_mask, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 },
+        },
+        {
+            // Earlier cull dispatches read the pyramid, overwriting it only needs them finished.
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = 0x0,
+            .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .oldLayout = m_is_pyramid_valid ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = m_vk_handle_pyramid_image,
+            .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = m_pyramid_level_count, .baseArrayLayer = 0, .layerCount = 1 },
+        },
+    };
+
+    vkCmdPipelineBarrier(vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0x0,
+        0, nullptr,
+        0, nullptr,
+        2, image_memory_barrier_list);
+
+    vkCmdBindPipeline(vk_handle_cmd_buff, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_handle_build_pipeline);
+
+    for (uint32_t level = 0; level < m_pyramid_level_count; level++)
+    {
+        const VkExtent2D src_extent = level == 0 ? m_depth_extent : get_level_extent(m_pyramid_extent, level - 1);
+        const VkExtent2D dst_extent = get_level_extent(m_pyramid_extent, level);
+        const VkDescriptorSet vk_handle_desc_set = level == 0 ? frame.vk_handle_depth_build_desc_set : m_vk_handle_level_build_desc_set_list[level - 1];
+
+        const BuildPushConstants push_constants {
+            .src_size = { static_cast<int32_t>(src_extent.width), static_cast<int32_t>(src_extent.height) },
+            .dst_size = { static_cast<int32_t>(dst_extent.width), static_cast<int32_t>(dst_extent.height) },
+            .is_reverse_z = m_is_reverse_z ? 1u : 0u,
+        };
+
+        vkCmdBindDescriptorSets(vk_handle_cmd_buff, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_handle_build_pipeline_layout, 0, 1, &vk_handle_desc_set, 0, nullptr);
+        vkCmdPushConstants(vk_handle_cmd_buff, m_vk_handle_build_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), &push_constants);
+        vkCmdDispatch(vk_handle_cmd_buff,
+            (dst_extent.width + s_build_group_size - 1) / s_build_group_size,
+            (dst_extent.height + s_build_group_size - 1) / s_build_group_size,
+            1);
+
+        if (level + 1 < m_pyramid_level_count)
+        {
+            record_memory_barrier(vk_handle_cmd_buff,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        }
+    }
+
+    // Hand the depth attachment back in the layout the pass expects.
+    const VkImageMemoryBarrier depth_restore_barrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = 0x0,
+        .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .newLayout = m_depth_image_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_vk_handle_depth_image_list[frame_resource_idx],
+        .subresourceRange = { .aspectMask = m_depth_aspect_mask, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 },
+    };
+
+    vkCmdPipelineBarrier(vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        0x0,
+        0, nullptr,
+        0, nullptr,
+        1, &depth_restore_barrier);
+
+    m_is_pyramid_valid = true;
+}
+
+void OcclusionCuller::record_readback(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx)
+{
+    FrameResources& frame = m_frame_list[frame_resource_idx];
+
+    if (frame.run_count == 0)
+    {
+        return;
+    }
+
+    record_memory_barrier(vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    const VkBufferCopy copy_region {
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = static_cast<VkDeviceSize>(s_phase_count) * frame.run_count * sizeof(uint32_t),
+    };
+
+    vkCmdCopyBuffer(vk_handle_cmd_buff, frame.output_buffer.vk_handle_buffer, frame.readback_buffer.vk_handle_buffer, 1, &copy_region);
+
+    record_memory_barrier(vk_handle_cmd_buff,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+
+    frame.has_pending_readback = true;
+    frame.readback_run_count = frame.run_count;
+}
+
+void OcclusionCuller::advance_frame()
+{
+    m_frame_epoch++;
+
+    std::erase_if(m_retired_buffer_list, [this](const RetiredBuffer& retired_buffer) {
+        if (retired_buffer.frame_epoch + m_frame_resource_count < m_frame_epoch)
+        {
+            destroy_buffer(retired_buffer.buffer);
+            return true;
+        }
+        return false;
+    });
+}
+
+IndirectDrawStream OcclusionCuller::get_stream(const uint16_t sortbin_id, const VkIndexType index_type, const uint32_t frame_resource_idx, const uint32_t phase) const
+{
+    const FrameResources& frame = m_frame_list[frame_resource_idx];
+    const StreamRuns& stream = frame.stream_list[get_stream_idx(sortbin_id, index_type)];
+
+    const IndirectDrawStream indirect_draw_stream {
+        .vk_handle_buffer = frame.output_buffer.vk_handle_buffer,
+        .count_offset = static_cast<VkDeviceSize>(phase) * frame.run_count * sizeof(uint32_t),
+        .command_offset = frame.command_offset + static_cast<VkDeviceSize>(phase) * frame.candidate_count * s_command_stride,
+        .command_stride = s_command_stride,
+        .command_count = stream.instance_count,
+        .instance_count = stream.instance_count,
+        .p_run_list = &stream.run_list,
+    };
+
+    return indirect_draw_stream;
+}
@@ -0,0 +1,211 @@
+#ifndef RENDERER_OCCLUSION_CULLER_HPP
+#define RENDERER_OCCLUSION_CULLER_HPP
+
+#include "../buffers/IndirectDrawBuffer.hpp"
+#include "../pod/SortBin.hpp"
+#include "../pod/VisibleDrawLists.hpp"
+
+#include "vk_core.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <inttypes.h>
+#include <span>
+#include <string>
+#include <vector>
+
+struct FrustumCuller;
+struct ShaderModuleCache;
+
+struct OcclusionCullerStats
+{
+    uint32_t candidate_count = 0; // instances handed to the GPU by the last set_candidates
+    uint32_t run_count = 0; // geometry block runs, each drawn with one count buffer draw per phase
+    // GPU counts read back from the frame resource's previous recording, frame_resource_count frames old.
+    uint32_t early_visible_count = 0; // drawn by the first phase
+    uint32_t late_visible_count = 0; // drawn by the second phase, two phase only
+    uint32_t pyramid_width = 0;
+    uint32_t pyramid_height = 0;
+    uint32_t pyramid_level_count = 0;
+};
+
+// GPU occlusion culling of one render pass against a hierarchical depth buffer (Hi-Z pyramid).
+//
+// The pyramid is built with a compute shader from the pass's depth attachment right after the pass. Level 0 is the
+// attachment extent rounded down to powers of two, each texel holding the farthest depth of the attachment texels it
+// covers, so a box whose nearest depth lies behind the farthest depth of its 2x2 texel footprint is hidden.
+//
+// set_candidates() writes one candidate per frustum visible instance (world box + its indirect command) to a host
+// visible buffer of the frame resource. record_cull() tests them in a compute pass and appends the visible ones to
+// per geometry block run regions of a device local output buffer, counting them in a count slot per run, so the
+// pass draws them through vkCmdDraw*IndirectCount (get_stream()).
+//
+// Single phase: phase 0 tests against the pyramid built after the previous frame's pass.
+// Two phase: phase 0 draws what the visibility buffer marked visible last frame, the pyramid is rebuilt from that
+// depth, and phase 1 tests every candidate against it, drawing the disoccluded ones that phase 0 skipped and
+// refreshing the visibility buffer.
+//
+// Only core Vulkan 1.2 compute, multiDrawIndirect and drawIndirectCount are required, so it runs on lavapipe.
+struct OcclusionCuller
+{
+private:
+protected:
+
+    static constexpr uint32_t s_stream_per_sortbin_count = 4; // u32, u16, u8, non-indexed
+    static constexpr uint32_t s_phase_count = 2;
+    static constexpr uint32_t s_command_word_count = 5; // VkDrawIndexedIndirectCommand, non-indexed commands leave the last word unused
+    static constexpr uint32_t s_command_stride = s_command_word_count * sizeof(uint32_t);
+    static constexpr uint32_t s_cull_group_size = 64;
+    static constexpr uint32_t s_build_group_size = 8;
+    static constexpr VkDeviceSize s_min_buffer_size = 1 << 12;
+
+    // Mirrors Candidate in occlusion_cull.comp (std430).
+    struct Candidate
+    {
+        float center[3];
+        uint32_t slot_base; // first output command of the candidate's run
+        float extent[3]; // negative when unbounded, never culled
+        uint32_t count_slot;
+        uint32_t command[s_command_word_count]; // instanceCount 1, firstInstance the instance slot
+        uint32_t draw_ID; // of the slot, indexes the visibility buffer
+        uint32_t padding[2];
+    };
+
+    static_assert(sizeof(Candidate) == 64);
+
+    struct StreamRuns
+    {
+        std::vector<IndirectDrawRun> run_list; // first_command relative to the phase region, count_slot relative to the phase counts
+        uint32_t instance_count = 0;
+    };
+
+    struct Buffer
+    {
+        VkBuffer vk_handle_buffer = VK_NULL_HANDLE;
+        vk_core::MemoryAllocation memory_allocation {};
+        VkDeviceSize size = 0;
+    };
+
+    struct RetiredBuffer
+    {
+        Buffer buffer;
+        uint64_t frame_epoch;
+    };
+
+    struct FrameResources
+    {
+        Buffer candidate_buffer; // host visible
+        Buffer output_buffer; // [run counts, phase 0 | phase 1][commands, phase 0 | phase 1]
+        Buffer readback_buffer; // host visible copy of the run counts
+
+        uint32_t candidate_count = 0;
+        uint32_t run_count = 0;
+        VkDeviceSize command_offset = 0;
+        float view_proj_mat[16] {};
+        std::vector<StreamRuns> stream_list; // by sortbin ID * s_stream_per_sortbin_count + index type
+
+        bool has_pending_readback = false;
+        uint32_t readback_run_count = 0;
+
+        VkBuffer vk_handle_bound_visibility_buffer = VK_NULL_HANDLE;
+        VkDescriptorSet vk_handle_cull_desc_set = VK_NULL_HANDLE;
+        VkDescriptorSet vk_handle_depth_build_desc_set = VK_NULL_HANDLE; // depth attachment -> level 0
+    };
+
+    const uint32_t m_frame_resource_count;
+    const bool m_is_two_phase;
+    const bool m_is_reverse_z;
+
+    const std::vector<VkImage> m_vk_handle_depth_image_list; // by frame resource
+    const VkImageLayout m_depth_image_layout;
+    const VkImageAspectFlags m_depth_aspect_mask;
+    const VkExtent2D m_depth_extent;
+
+    VkExtent2D m_pyramid_extent {};
+    uint32_t m_pyramid_level_count = 0;
+    VkImage m_vk_handle_pyramid_image = VK_NULL_HANDLE;
+    vk_core::MemoryAllocation m_pyramid_memory_allocation {};
+    VkImageView m_vk_handle_pyramid_view = VK_NULL_HANDLE; // all levels, sampled by the cull shader
+    std::vector<VkImageView> m_vk_handle_pyramid_level_view_list;
+    bool m_is_pyramid_valid = false;
+
+    VkSampler m_vk_handle_sampler = VK_NULL_HANDLE;
+    VkDescriptorPool m_vk_handle_desc_pool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_vk_handle_build_desc_set_layout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_vk_handle_cull_desc_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout m_vk_handle_build_pipeline_layout = VK_NULL_HANDLE;
+    VkPipelineLayout m_vk_handle_cull_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_vk_handle_build_pipeline = VK_NULL_HANDLE;
+    VkPipeline m_vk_handle_cull_pipeline = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> m_vk_handle_level_build_desc_set_list; // level - 1 -> level, for levels >= 1
+
+    Buffer m_visibility_buffer; // uint32 per draw ID, 1 when visible after the last phase 1
+    bool m_is_visibility_cleared = false;
+
+    std::vector<FrameResources> m_frame_list;
+    std::vector<Candidate> m_candidate_list; // scratch, copied to the frame resource's candidate buffer in one go
+
+    uint64_t m_frame_epoch = 0;
+    std::vector<RetiredBuffer> m_retired_buffer_list;
+
+    OcclusionCullerStats m_stats {};
+
+    static uint32_t get_stream_idx(const uint16_t sortbin_id, const VkIndexType index_type);
+    static Buffer create_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags, const VkMemoryPropertyFlags memory_property_flags);
+    static void destroy_buffer(const Buffer& buffer);
+
+    void create_pyramid();
+    void create_pipelines(const std::string& shader_root_path, ShaderModuleCache& shader_module_cache);
+    void create_desc_sets(const std::vector<VkImageView>& vk_handle_depth_image_view_list);
+    void update_cull_desc_set(FrameResources& frame);
+    void read_back_counts(const FrameResources& frame);
+
+public:
+    struct CreateInfo
+    {
+        uint32_t frame_resource_count;
+        uint32_t sortbin_count;
+        bool is_two_phase;
+        bool is_reverse_z; // depth cleared to 0 and tested with GREATER, the farthest depth being the minimum
+        std::vector<VkImage> vk_handle_depth_image_list; // by frame resource
+        std::vector<VkImageView> vk_handle_depth_image_view_list;
+        VkFormat depth_format;
+        VkExtent2D depth_extent;
+        VkImageLayout depth_image_layout; // layout the pass renders in, restored after the pyramid build
+        std::string shader_root_path;
+        ShaderModuleCache* p_shader_module_cache; // only used during construction
+    };
+
+    explicit OcclusionCuller(const CreateInfo& create_info);
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+    OcclusionCuller(OcclusionCuller&&) = delete;
+    OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+
+    // Replaces the frame resource's candidates with the instances of visible_draw_lists_list[sortbin_ID_list],
+    // boxes taken from frustum_culler for the draw IDs instance_draw_ID_list holds for their slots.
+    // Must only be called while no submission using frame_resource_idx is pending.
+    void set_candidates(const uint32_t frame_resource_idx,
+        const float* const view_proj_mat,
+        const std::vector<uint16_t>& sortbin_ID_list,
+        const std::vector<VisibleDrawLists>& visible_draw_lists_list,
+        const FrustumCuller& frustum_culler,
+        const std::span<const uint32_t> instance_draw_ID_list);
+
+    // Outside of rendering. Phase 0 also resets the run counts of both phases.
+    void record_cull(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx, const uint32_t phase);
+    // After the pass, with the depth attachment in the pass's layout, which it is left in.
+    void record_depth_pyramid(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx);
+    // After the last phase's draws, copies the run counts for get_stats().
+    void record_readback(const VkCommandBuffer vk_handle_cmd_buff, const uint32_t frame_resource_idx);
+    void advance_frame();
+
+    IndirectDrawStream get_stream(const uint16_t sortbin_id, const VkIndexType index_type, const uint32_t frame_resource_idx, const uint32_t phase) const;
+
+    bool is_two_phase() const { return m_is_two_phase; }
+    const OcclusionCullerStats& get_stats() const { return m_stats; }
+};
+
+#endif // RENDERER_OCCLUSION_CULLER_HPP
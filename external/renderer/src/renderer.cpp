@@ -19,43 +19,72 @@
 
 #include "GlobalState.hpp"
 #include "internal/misc/logger.hpp"
+#include "internal/misc/mesh_optimizer.hpp"
+#include "internal/misc/mesh_simplifier.hpp"
+#include "internal/misc/state_bundle.hpp"
+#include "internal/misc/stream_memcpy.hpp"
+#include "internal/misc/vertex_quantization.hpp"
 #include "internal/buffers/BufferPool_VariableBlock.hpp"
 #include "internal/buffers/GeometryBuffer.hpp"
+#include "internal/buffers/IndirectDrawBuffer.hpp"
 #include "internal/buffers/StagingBuffer.hpp"
 #include "internal/buffers/UniformBuffer.hpp"
+#include "internal/visibility/DrawSorter.hpp"
+#include "internal/visibility/FrustumCuller.hpp"
+#include "internal/visibility/LodSelector.hpp"
+#include "internal/visibility/OcclusionCuller.hpp"
+#include "vk_core.hpp"
 
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <inttypes.h>
 
 constexpr bool DEBUG = true;
 
-static bool queue_uploads_to_staging_buffer(GeometryBuffer* const buffer, StagingBuffer* const staging_buffer)
+static bool queue_uploads_to_staging_buffer(BufferPool_VariableBlock* buffer, StagingBuffer* staging_buffer, const uint32_t frame_resource_idx)
 {
-    const std::vector<UploadInfo> queued_uploads = buffer->get_queued_uploads();
+    const std::vector<UploadInfo> queued_uploads = buffer->get_queued_uploads(frame_resource_idx);
 
     for (const UploadInfo& upload_info : queued_uploads)
     {
         const void* const data_ptr = upload_info.data_pointer ? upload_info.data_pointer : (void*)upload_info.data_vector.data();
-        staging_buffer->queue_upload(buffer->get_vk_handle_buffer(), upload_info.dst_offset, upload_info.size, data_ptr);
-        // LOG("Geometry queued upload to staging buffer (%lu, %lu)\n", upload_info.dst_offset, upload_info.size);
+        staging_buffer->queue_upload(buffer->get_vk_handle_buffer(frame_resource_idx), upload_info.dst_offset, upload_info.size, data_ptr);
+        // LOG("Uniform queued upload to staging buffer (%lu, %lu)\n", upload_info.dst_offset, upload_info.size);
     }
 
     return !queued_uploads.empty();
 }
 
-static bool queue_uploads_to_staging_buffer(BufferPool_VariableBlock* buffer, StagingBuffer* staging_buffer, const uint32_t frame_resource_idx)
+// Grows the frame's copy of the pool if needed and points its frame descriptor set binding at the new buffer.
+static void sync_buffer_pool_capacity(BufferPool_VariableBlock* buffer, const uint32_t binding, const VkDescriptorSet vk_handle_frame_desc_set, const uint32_t frame_resource_idx, uint64_t& frame_desc_set_generation)
 {
-    const std::vector<UploadInfo> queued_uploads = buffer->get_queued_uploads(frame_resource_idx);
-
-    for (const UploadInfo& upload_info : queued_uploads)
+    if (!buffer->sync_frame_capacity(frame_resource_idx))
     {
-        const void* const data_ptr = upload_info.data_pointer ? upload_info.data_pointer : (void*)upload_info.data_vector.data();
-        staging_buffer->queue_upload(buffer->get_vk_handle_buffer(), upload_info.dst_offset, upload_info.size, data_ptr);
-        // LOG("Uniform queued upload to staging buffer (%lu, %lu)\n", upload_info.dst_offset, upload_info.size);
+        return;
     }
 
-    return !queued_uploads.empty();
+    const VkDescriptorBufferInfo desc_buffer_info = buffer->get_descriptor_buffer_info(frame_resource_idx);
+
+    const VkWriteDescriptorSet write_desc_set {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = vk_handle_frame_desc_set,
+        .dstBinding = binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pImageInfo = nullptr,
+        .pBufferInfo = &desc_buffer_info,
+        .pTexelBufferView = nullptr,
+    };
+
+    vk_core::update_desc_sets(1, &write_desc_set, 0, nullptr);
+    frame_desc_set_generation++;
 }
 
 static uint32_t upload_block(BufferPool_VariableBlock* buffer, const uint32_t block_size, const std::vector<uint8_t>& data, const uint32_t mat_ID = UINT32_MAX)
@@ -83,7 +112,7 @@ static uint32_t upload_block(BufferPool_VariableBlock* buffer, const uint32_t bl
 
     if ( mat_ID == UINT32_MAX )
     {
-        memcpy(block_ptr, data_ptr, block_size);
+        memcpy(block_ptr, data_ptr, data_size);
     }
     else
     {
@@ -121,177 +150,1340 @@ namespace renderer
 // A Renderable is the combination of a mesh_id, material_id, draw_id, and a supported_sortbin_set_idx. It is the summation
 // if all the data needed to render an object. 
 
-// A Entity is the combination of a renderable_id and a sortbin_id. We distinguish an Entitiy from a Renderable so that
-// sortbins can be changed at runtime if needed. A Renderable can be added to various sortbins, as long as the 
-// vertex input / mateiral / draw states match. The separation allows a toggling to wireframe or different shaders at runtime.
+// A Entity is the combination of a renderable_id and a sortbin_id. We distinguish an Entitiy from a Renderable so that
+// sortbins can be changed at runtime if needed. A Renderable can be added to various sortbins, as long as the 
+// vertex input / mateiral / draw states match. The separation allows a toggling to wireframe or different shaders at runtime.
+
+// Startup
+// -- Group sortbins into sets based on vertex input / material / draw states
+
+// Load a GLTF model (contains sortbin_id)
+// -- Create renderable_id
+// -- Create mesh_id
+// -- Create material_id
+// -- Create draw_id
+// -- Add supported_sortbin_set_id to renderable
+
+std::unique_ptr<RendererState> global_state = nullptr;
+
+static void bump_sortbin_generation(const uint16_t sortbin_id)
+{
+    global_state->sort_bin_vec[sortbin_id].generation++;
+
+    for (uint32_t render_pass_ID = 0; render_pass_ID < global_state->render_pass_vec.size(); render_pass_ID++)
+    {
+        const std::vector<uint16_t>& supported_sortbin_id_list = global_state->render_pass_vec[render_pass_ID].supported_sortbin_id_list;
+
+        if (std::find(supported_sortbin_id_list.begin(), supported_sortbin_id_list.end(), sortbin_id) != supported_sortbin_id_list.end())
+        {
+            global_state->render_pass_generation_vec[render_pass_ID]++;
+        }
+    }
+}
+
+// Applies edit to every draw list of every sortbin. Lists it reports as changed get their indirect stream rebuilt.
+// The edit must keep every draw at its index, SortBin::instance_group_umap refers to them by it.
+template<typename DrawListEdit>
+static void edit_sortbin_draw_lists(const DrawListEdit& edit)
+{
+    for (uint16_t sortbin_id = 0; sortbin_id < global_state->sort_bin_vec.size(); sortbin_id++)
+    {
+        SortBin& sort_bin = global_state->sort_bin_vec[sortbin_id];
+        bool is_edited = false;
+
+        const auto edit_draw_list = [&](const VkIndexType index_type, std::vector<DrawInfo>& draw_list)
+        {
+            if (edit(draw_list))
+            {
+                global_state->indirect_draw_buffer->rebuild(sortbin_id, index_type, draw_list);
+                is_edited = true;
+            }
+        };
+
+        edit_draw_list(VK_INDEX_TYPE_UINT32, sort_bin.draw_list_u32);
+        edit_draw_list(VK_INDEX_TYPE_UINT16, sort_bin.draw_list_u16);
+        edit_draw_list(VK_INDEX_TYPE_UINT8_EXT, sort_bin.draw_list_u8);
+        edit_draw_list(VK_INDEX_TYPE_MAX_ENUM, sort_bin.draw_list);
+
+        if (is_edited)
+        {
+            bump_sortbin_generation(sortbin_id);
+        }
+    }
+}
+
+// First sortbin consuming vertices of this stride with a 32 bit float vertex_pos, the layout create_mesh assumes for
+// callers that leave MeshInitInfo::vertex_attribute_list empty. Sortbins with quantized positions are skipped, nullptr when none matches.
+static const SortBin* find_float_vertex_layout_sortbin(const uint32_t vertex_stride)
+{
+    const auto sort_bin_iter = std::find_if(global_state->sort_bin_vec.begin(), global_state->sort_bin_vec.end(), [vertex_stride](const SortBin& sort_bin)
+    {
+        const VkFormat format = sort_bin.vertex_pos_attribute.format;
+        return sort_bin.vertex_stride == vertex_stride && (format == VK_FORMAT_R32G32_SFLOAT || format == VK_FORMAT_R32G32B32_SFLOAT || format == VK_FORMAT_R32G32B32A32_SFLOAT);
+    });
+
+    return sort_bin_iter == global_state->sort_bin_vec.end() ? nullptr : &(*sort_bin_iter);
+}
+
+// Float vertex_pos of the caller's vertices with its component count (2 or 3): from attribute_list when the caller
+// described its layout, find_float_vertex_layout_sortbin otherwise. False without one.
+static bool get_vertex_pos_attribute(const std::vector<VertexAttributeInfo>& attribute_list, const uint32_t vertex_stride, VkVertexInputAttributeDescription& pos_attribute, uint32_t& component_count)
+{
+    if (!attribute_list.empty())
+    {
+        const auto attribute_iter = std::find_if(attribute_list.begin(), attribute_list.end(), [](const VertexAttributeInfo& attribute) { return attribute.usage == "vertex_pos"; });
+
+        if (attribute_iter == attribute_list.end() || (attribute_iter->format != VK_FORMAT_R32G32_SFLOAT && attribute_iter->format != VK_FORMAT_R32G32B32_SFLOAT && attribute_iter->format != VK_FORMAT_R32G32B32A32_SFLOAT))
+        {
+            return false;
+        }
+
+        pos_attribute = { .location = 0, .binding = 0, .format = attribute_iter->format, .offset = attribute_iter->offset };
+    }
+    else
+    {
+        const SortBin* const p_sort_bin = find_float_vertex_layout_sortbin(vertex_stride);
+
+        if (!p_sort_bin)
+        {
+            return false;
+        }
+
+        pos_attribute = p_sort_bin->vertex_pos_attribute;
+    }
+
+    component_count = pos_attribute.format == VK_FORMAT_R32G32_SFLOAT ? 2 : 3;
+
+    return true;
+}
+
+// Object space bounds from the float vertex_pos attribute (see get_vertex_pos_attribute).
+// Meshes without float positions get invalid bounds and are never culled.
+static BoundingBox compute_mesh_bounds(const uint8_t* const vertex_data, const uint32_t vertex_count, const uint32_t vertex_stride, const std::vector<VertexAttributeInfo>& attribute_list)
+{
+    uint32_t component_count = 0;
+    VkVertexInputAttributeDescription pos_attribute {};
+
+    if (!get_vertex_pos_attribute(attribute_list, vertex_stride, pos_attribute, component_count) || vertex_count == 0)
+    {
+        return {};
+    }
+
+    float min[3] = { FLT_MAX, FLT_MAX, 0.0f };
+    float max[3] = { -FLT_MAX, -FLT_MAX, 0.0f };
+
+    if (component_count == 3)
+    {
+        min[2] = FLT_MAX;
+        max[2] = -FLT_MAX;
+    }
+
+    for (uint32_t vertex_idx = 0; vertex_idx < vertex_count; vertex_idx++)
+    {
+        float position[3];
+        memcpy(position, vertex_data + static_cast<size_t>(vertex_idx) * vertex_stride + pos_attribute.offset, component_count * sizeof(float));
+
+        for (uint32_t i = 0; i < component_count; i++)
+        {
+            min[i] = std::min(min[i], position[i]);
+            max[i] = std::max(max[i], position[i]);
+        }
+    }
+
+    BoundingBox bounds {};
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        bounds.center[i] = 0.5f * (min[i] + max[i]);
+        bounds.extent[i] = 0.5f * (max[i] - min[i]);
+    }
+
+    return bounds;
+}
+
+static std::vector<DrawInfo>& get_sortbin_draw_list(SortBin& sort_bin, const VkIndexType index_type)
+{
+    switch (index_type)
+    {
+        case VK_INDEX_TYPE_UINT32: return sort_bin.draw_list_u32;
+        case VK_INDEX_TYPE_UINT16: return sort_bin.draw_list_u16;
+        case VK_INDEX_TYPE_UINT8_EXT: return sort_bin.draw_list_u8;
+        default: return sort_bin.draw_list;
+    }
+}
+
+// Draw ID of every instance slot, the host copy of the instance table the shaders index with gl_InstanceIndex.
+static std::span<const uint32_t> get_instance_draw_ID_list()
+{
+    const std::vector<uint8_t>& cpu_data = global_state->instance_buffer->get_cpu_data();
+    return { reinterpret_cast<const uint32_t*>(cpu_data.data()), cpu_data.size() / sizeof(uint32_t) };
+}
+
+static void write_instance_slot(const SortBin::InstanceGroup& group, const DrawInfo& group_draw_info, const uint32_t instance_idx, const uint32_t draw_ID)
+{
+    const uint32_t block_size = group.slot_capacity * sizeof(uint32_t);
+    const uint32_t slot_offset = instance_idx * sizeof(uint32_t);
+    void* const block_ptr = global_state->instance_buffer->get_writable_range(block_size, group_draw_info.first_instance / group.slot_capacity, slot_offset, sizeof(uint32_t));
+    memcpy(static_cast<uint8_t*>(block_ptr) + slot_offset, &draw_ID, sizeof(uint32_t));
+}
+
+// Moves a full instance group into a block of twice the slots. Instances keep their index, only first_instance changes.
+static void grow_instance_group(SortBin::InstanceGroup& group, DrawInfo& group_draw_info)
+{
+    const uint32_t block_size = group.slot_capacity * sizeof(uint32_t);
+    const uint32_t block_ID = group_draw_info.first_instance / group.slot_capacity;
+    const uint32_t grown_slot_capacity = group.slot_capacity * 2;
+    const uint32_t grown_block_ID = global_state->instance_buffer->acquire_block(grown_slot_capacity * sizeof(uint32_t));
+
+    // Acquiring may have grown the host copy, read the old slots after it.
+    void* const grown_block_ptr = global_state->instance_buffer->get_writable_range(grown_slot_capacity * sizeof(uint32_t), grown_block_ID, 0, block_size);
+    memcpy(grown_block_ptr, global_state->instance_buffer->get_cpu_data().data() + static_cast<size_t>(block_ID) * block_size, block_size);
+
+    global_state->instance_buffer->release_block(block_size, block_ID);
+
+    group.slot_capacity = grown_slot_capacity;
+    group_draw_info.first_instance = grown_block_ID * grown_slot_capacity;
+}
+
+// Adds draw_ID as an instance of the draw of draw_info.mesh_id in the sortbin, the draw being created on the mesh's first
+// instance. Only that draw's indirect command is written.
+static void add_draw_instance(const uint16_t sortbin_id, const VkIndexType index_type, const DrawInfo& draw_info, const uint32_t draw_ID)
+{
+    static constexpr uint32_t s_min_slot_capacity = 4; // one 16 byte upload granule
+
+    SortBin& sort_bin = global_state->sort_bin_vec[sortbin_id];
+    std::vector<DrawInfo>& draw_list = get_sortbin_draw_list(sort_bin, index_type);
+    std::vector<RendererState::DrawInstance>& draw_instance_list = global_state->draw_instance_umap[draw_ID];
+
+    if constexpr (DEBUG)
+    {
+        for (const RendererState::DrawInstance& draw_instance : draw_instance_list)
+        {
+            ASSERT(draw_instance.sortbin_id != sortbin_id, "add_draw_instance - Draw ID %u already in sortbin %u!\n", draw_ID, sortbin_id);
+        }
+    }
+
+    // Even an instance count change alters the directly recorded draws.
+    bump_sortbin_generation(sortbin_id);
+
+    const auto [group_iter, is_new_group] = sort_bin.instance_group_umap.try_emplace(draw_info.mesh_id);
+    SortBin::InstanceGroup& group = group_iter->second;
+
+    if (is_new_group)
+    {
+        group = {
+            .index_type = index_type,
+            .draw_idx = static_cast<uint32_t>(draw_list.size()),
+            .slot_capacity = s_min_slot_capacity,
+        };
+
+        DrawInfo group_draw_info = draw_info;
+        group_draw_info.first_instance = global_state->instance_buffer->acquire_block(s_min_slot_capacity * sizeof(uint32_t)) * s_min_slot_capacity;
+        group_draw_info.instance_count = 0;
+        draw_list.push_back(group_draw_info);
+    }
+
+    DrawInfo& group_draw_info = draw_list[group.draw_idx];
+
+    if (group_draw_info.instance_count == group.slot_capacity)
+    {
+        grow_instance_group(group, group_draw_info);
+    }
+
+    const uint32_t instance_idx = group_draw_info.instance_count++;
+    write_instance_slot(group, group_draw_info, instance_idx, draw_ID);
+    draw_instance_list.push_back({ sortbin_id, instance_idx });
+
+    if (is_new_group)
+    {
+        global_state->indirect_draw_buffer->append(sortbin_id, index_type, group_draw_info);
+    }
+    else
+    {
+        global_state->indirect_draw_buffer->update(sortbin_id, index_type, group.draw_idx, group_draw_info);
+    }
+}
+
+// Drops an instance of draw_ID from the draw of mesh_ID. The last instance of the draw moves into its slot, so only that
+// draw's indirect command and one slot are written.
+static void remove_draw_instance(const RendererState::DrawInstance& draw_instance, const uint32_t mesh_ID)
+{
+    SortBin& sort_bin = global_state->sort_bin_vec[draw_instance.sortbin_id];
+    const SortBin::InstanceGroup& group = sort_bin.instance_group_umap.at(mesh_ID);
+    DrawInfo& group_draw_info = get_sortbin_draw_list(sort_bin, group.index_type)[group.draw_idx];
+
+    bump_sortbin_generation(draw_instance.sortbin_id);
+
+    const uint32_t last_instance_idx = --group_draw_info.instance_count;
+
+    if (draw_instance.instance_idx != last_instance_idx)
+    {
+        const uint32_t moved_draw_ID = get_instance_draw_ID_list()[group_draw_info.first_instance + last_instance_idx];
+        write_instance_slot(group, group_draw_info, draw_instance.instance_idx, moved_draw_ID);
+
+        for (RendererState::DrawInstance& moved_draw_instance : global_state->draw_instance_umap.at(moved_draw_ID))
+        {
+            if (moved_draw_instance.sortbin_id == draw_instance.sortbin_id)
+            {
+                moved_draw_instance.instance_idx = draw_instance.instance_idx;
+            }
+        }
+    }
+
+    global_state->indirect_draw_buffer->update(draw_instance.sortbin_id, group.index_type, group.draw_idx, group_draw_info);
+}
+
+// Removes the emptied draws of mesh_ID from every sortbin. The last draw of a list takes the freed index,
+// which changes the command count and geometry block runs of the stream, so it is rebuilt.
+static void remove_mesh_draws(const uint32_t mesh_ID)
+{
+    for (uint16_t sortbin_id = 0; sortbin_id < global_state->sort_bin_vec.size(); sortbin_id++)
+    {
+        SortBin& sort_bin = global_state->sort_bin_vec[sortbin_id];
+        const auto group_iter = sort_bin.instance_group_umap.find(mesh_ID);
+
+        if (group_iter == sort_bin.instance_group_umap.end())
+        {
+            continue;
+        }
+
+        const SortBin::InstanceGroup group = group_iter->second;
+        std::vector<DrawInfo>& draw_list = get_sortbin_draw_list(sort_bin, group.index_type);
+        ASSERT(draw_list[group.draw_idx].instance_count == 0, "remove_mesh_draws - Draw of mesh %u still has instances!\n", mesh_ID);
+
+        global_state->instance_buffer->release_block(group.slot_capacity * sizeof(uint32_t), draw_list[group.draw_idx].first_instance / group.slot_capacity);
+        sort_bin.instance_group_umap.erase(group_iter);
+
+        if (group.draw_idx + 1 != draw_list.size())
+        {
+            draw_list[group.draw_idx] = draw_list.back();
+            sort_bin.instance_group_umap.at(draw_list[group.draw_idx].mesh_id).draw_idx = group.draw_idx;
+        }
+
+        draw_list.pop_back();
+        global_state->indirect_draw_buffer->rebuild(sortbin_id, group.index_type, draw_list);
+        bump_sortbin_generation(sortbin_id);
+    }
+}
+
+static void advance_cull_state_frame()
+{
+    for (RendererState::RenderPassCullState& cull_state : global_state->render_pass_cull_state_vec)
+    {
+        if (cull_state.indirect_draw_buffer)
+        {
+            cull_state.indirect_draw_buffer->advance_frame();
+        }
+
+        if (cull_state.occlusion_culler)
+        {
+            cull_state.occlusion_culler->advance_frame();
+        }
+    }
+}
+
+void init(const InitInfo& init_info)
+{
+    const auto init_start = std::chrono::steady_clock::now();
+    const vk_core::PipelineCacheStats pipeline_cache_stats_before = vk_core::get_pipeline_cache_stats();
+
+    StateDescription state_description;
+    bool is_state_bundle = false;
+
+    if (init_info.file_state_bundle)
+    {
+        is_state_bundle = state_bundle::read(init_info.file_state_bundle, state_description);
+        ASSERT(is_state_bundle || init_info.file_app_state, "Failed to load state bundle %s!\n", init_info.file_state_bundle);
+    }
+
+    if (!is_state_bundle)
+    {
+        state_description = state_bundle::parse_json_files(init_info.refl_file_frame_desc_set_def,
+            init_info.refl_file_sortbin_mat_draw_def,
+            init_info.file_sortbin_pipeline_state,
+            init_info.file_app_state);
+    }
+
+    const uint64_t state_load_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - init_start).count());
+
+    const RendererState::CreateInfo renderer_internal_create_info {
+        .p_state_description = &state_description,
+        .path_shader_root = init_info.path_shader_root,
+        .frame_resource_count = init_info.frame_resource_count,
+        .window_x_dim = init_info.window_width,
+        .window_y_dim = init_info.window_height,
+        .worker_thread_count = init_info.worker_thread_count,
+        .is_parallel_recording = init_info.is_parallel_recording,
+        .is_record_caching = init_info.is_record_caching,
+        .is_extended_dynamic_state = init_info.is_extended_dynamic_state,
+    };
+
+    global_state = std::make_unique<RendererState>(renderer_internal_create_info);
+
+    const vk_core::PipelineCacheStats pipeline_cache_stats = vk_core::get_pipeline_cache_stats();
+
+    global_state->startup_stats = {
+        .init_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - init_start).count()),
+        .state_load_ns = state_load_ns,
+        .is_state_bundle = is_state_bundle,
+        .pipeline_count = pipeline_cache_stats.pipeline_count - pipeline_cache_stats_before.pipeline_count,
+        .pipeline_create_ns = pipeline_cache_stats.pipeline_create_ns - pipeline_cache_stats_before.pipeline_create_ns,
+        .is_pipeline_cache_warm = pipeline_cache_stats.is_warm,
+    };
+
+    LOG("App Info - Startup: init %.2f ms, state loaded from %s in %.2f ms, %u pipelines created in %.2f ms from a %s pipeline cache\n",
+        static_cast<double>(global_state->startup_stats.init_ns) * 1e-6,
+        global_state->startup_stats.is_state_bundle ? "bundle" : "JSON",
+        static_cast<double>(global_state->startup_stats.state_load_ns) * 1e-6,
+        global_state->startup_stats.pipeline_count,
+        static_cast<double>(global_state->startup_stats.pipeline_create_ns) * 1e-6,
+        global_state->startup_stats.is_pipeline_cache_warm ? "warm" : "cold");
+}
+
+StartupStats get_startup_stats()
+{
+    const RendererState::StartupStats& stats = global_state->startup_stats;
+
+    const StartupStats startup_stats {
+        .init_ns = stats.init_ns,
+        .state_load_ns = stats.state_load_ns,
+        .is_state_bundle = stats.is_state_bundle,
+        .pipeline_count = stats.pipeline_count,
+        .pipeline_create_ns = stats.pipeline_create_ns,
+        .is_pipeline_cache_warm = stats.is_pipeline_cache_warm,
+    };
+
+    return startup_stats;
+}
+
+void terminate()
+{
+    global_state.reset();
+}
+
+static std::vector<uint32_t> read_index_list(const uint8_t* const index_data, const uint32_t index_count, const uint32_t index_stride)
+{
+    std::vector<uint32_t> index_list(index_count);
+
+    for (uint32_t i = 0; i < index_count; i++)
+    {
+        switch (index_stride)
+        {
+            case 4:
+            {
+                memcpy(&index_list[i], index_data + i * 4, 4);
+                break;
+            }
+            case 2:
+            {
+                uint16_t index = 0;
+                memcpy(&index, index_data + i * 2, 2);
+                index_list[i] = index;
+                break;
+            }
+            default:
+            {
+                index_list[i] = index_data[i];
+                break;
+            }
+        }
+    }
+
+    return index_list;
+}
+
+static void write_index_list(const uint32_t* const index_list, const uint32_t index_count, const uint32_t index_stride, uint8_t* const index_data)
+{
+    for (uint32_t i = 0; i < index_count; i++)
+    {
+        switch (index_stride)
+        {
+            case 4:
+            {
+                memcpy(index_data + i * 4, &index_list[i], 4);
+                break;
+            }
+            case 2:
+            {
+                const uint16_t index = static_cast<uint16_t>(index_list[i]);
+                memcpy(index_data + i * 2, &index, 2);
+                break;
+            }
+            default:
+            {
+                index_data[i] = static_cast<uint8_t>(index_list[i]);
+                break;
+            }
+        }
+    }
+}
+
+// xyz per vertex, z = 0 for 2 component positions.
+static std::vector<float> read_position_list(const uint8_t* const vertex_data, const uint32_t vertex_count, const uint32_t vertex_stride, const VkVertexInputAttributeDescription& pos_attribute, const uint32_t component_count)
+{
+    std::vector<float> position_list(static_cast<size_t>(vertex_count) * 3, 0.0f);
+
+    for (uint32_t vertex_idx = 0; vertex_idx < vertex_count; vertex_idx++)
+    {
+        memcpy(&position_list[static_cast<size_t>(vertex_idx) * 3], vertex_data + static_cast<size_t>(vertex_idx) * vertex_stride + pos_attribute.offset, component_count * sizeof(float));
+    }
+
+    return position_list;
+}
+
+// Applies init_info.optimize_info to a copy of the mesh. The returned info points into vertex_list / index_list
+// (or at the caller's data where left unchanged) and fills last_mesh_optimize_stats.
+static MeshInitInfo optimize_mesh(const MeshInitInfo& init_info, std::vector<uint8_t>& vertex_list, std::vector<uint8_t>& index_list)
+{
+    const MeshOptimizeInfo& optimize_info = init_info.optimize_info;
+    RendererState::MeshOptimizeStats& stats = global_state->last_mesh_optimize_stats;
+
+    stats = {
+        .index_stride_before = init_info.index_stride,
+        .index_stride_after = init_info.index_stride,
+        .index_byte_count_before = static_cast<uint64_t>(init_info.index_count) * init_info.index_stride,
+        .index_byte_count_after = static_cast<uint64_t>(init_info.index_count) * init_info.index_stride,
+        .vertex_byte_count_before = static_cast<uint64_t>(init_info.vertex_count) * init_info.vertex_stride,
+        .vertex_byte_count_after = static_cast<uint64_t>(init_info.vertex_count) * init_info.vertex_stride,
+    };
+
+    if (!optimize_info.is_vertex_cache_optimized && !optimize_info.is_overdraw_optimized && !optimize_info.is_vertex_fetch_optimized && !optimize_info.is_index_narrowed)
+    {
+        return init_info;
+    }
+
+    if (init_info.index_count == 0 || init_info.index_count % 3 != 0 || (init_info.index_stride != 1 && init_info.index_stride != 2 && init_info.index_stride != 4))
+    {
+        LOG("Warning - create_mesh: only indexed triangle lists are optimized, mesh uploaded as is!\n");
+        return init_info;
+    }
+
+    const auto optimize_start = std::chrono::steady_clock::now();
+
+    std::vector<uint32_t> index_u32_list = read_index_list(init_info.index_data, init_info.index_count, init_info.index_stride);
+
+    stats.acmr_before = mesh_optimizer::compute_acmr(index_u32_list.data(), init_info.index_count, init_info.vertex_count, 16);
+
+    if (optimize_info.is_vertex_cache_optimized)
+    {
+        std::vector<uint32_t> cache_optimized_index_list(init_info.index_count);
+        mesh_optimizer::optimize_vertex_cache(cache_optimized_index_list.data(), index_u32_list.data(), init_info.index_count, init_info.vertex_count);
+        index_u32_list.swap(cache_optimized_index_list);
+    }
+
+    uint32_t component_count = 0;
+    VkVertexInputAttributeDescription pos_attribute {};
+
+    if (optimize_info.is_overdraw_optimized && get_vertex_pos_attribute(init_info.vertex_attribute_list, init_info.vertex_stride, pos_attribute, component_count))
+    {
+        const std::vector<float> position_list = read_position_list(init_info.vertex_data, init_info.vertex_count, init_info.vertex_stride, pos_attribute, component_count);
+        const float threshold = optimize_info.overdraw_threshold > 0.0f ? optimize_info.overdraw_threshold : 1.05f;
+        stats.overdraw_cluster_count = mesh_optimizer::optimize_overdraw(index_u32_list.data(), init_info.index_count, position_list.data(), init_info.vertex_count, threshold);
+    }
+
+    MeshInitInfo optimized_info = init_info;
+
+    if (optimize_info.is_vertex_fetch_optimized)
+    {
+        vertex_list.resize(static_cast<size_t>(init_info.vertex_count) * init_info.vertex_stride);
+        optimized_info.vertex_count = mesh_optimizer::optimize_vertex_fetch(vertex_list.data(), index_u32_list.data(), init_info.index_count, init_info.vertex_data, init_info.vertex_count, init_info.vertex_stride);
+        optimized_info.vertex_data = vertex_list.data();
+    }
+
+    if (optimize_info.is_index_narrowed)
+    {
+        optimized_info.index_stride = optimized_info.vertex_count <= (1u << 8) && vk_core::has_index_type_uint8() ? 1 : optimized_info.vertex_count <= (1u << 16) ? 2 : 4;
+    }
+
+    index_list.resize(static_cast<size_t>(init_info.index_count) * optimized_info.index_stride);
+    write_index_list(index_u32_list.data(), init_info.index_count, optimized_info.index_stride, index_list.data());
+
+    optimized_info.index_data = index_list.data();
+
+    stats.acmr_after = mesh_optimizer::compute_acmr(index_u32_list.data(), init_info.index_count, optimized_info.vertex_count, 16);
+    stats.index_stride_after = optimized_info.index_stride;
+    stats.index_byte_count_after = static_cast<uint64_t>(optimized_info.index_count) * optimized_info.index_stride;
+    stats.vertex_byte_count_after = static_cast<uint64_t>(optimized_info.vertex_count) * optimized_info.vertex_stride;
+    stats.optimize_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - optimize_start).count());
+
+    return optimized_info;
+}
+
+// Appends the simplified levels of init_info.lod_info to the mesh's indices, each simplified from the full detail
+// list. The returned info points into index_list and counts the indices of every level, lod_list[0, lod_count) ranges
+// over them. Fills the LOD part of last_mesh_optimize_stats.
+static MeshInitInfo generate_mesh_lods(const MeshInitInfo& init_info, const BoundingBox& bounds, std::vector<uint8_t>& index_list, MeshLod (&lod_list)[Mesh::s_max_lod_count], uint32_t& lod_count)
+{
+    const MeshLodInfo& lod_info = init_info.lod_info;
+    RendererState::MeshOptimizeStats& stats = global_state->last_mesh_optimize_stats;
+
+    lod_count = 1;
+    lod_list[0] = { .first_index = 0, .index_count = init_info.index_count, .error = 0.0f };
+    stats.lod_count = 1;
+    stats.coarsest_lod_index_count = init_info.index_count;
+
+    if (lod_info.lod_count == 0)
+    {
+        return init_info;
+    }
+
+    uint32_t component_count = 0;
+    VkVertexInputAttributeDescription pos_attribute {};
+    const bool has_pos_attribute = get_vertex_pos_attribute(init_info.vertex_attribute_list, init_info.vertex_stride, pos_attribute, component_count);
+
+    if (!has_pos_attribute || !bounds.is_valid() || init_info.index_count == 0 || init_info.index_count % 3 != 0 || (init_info.index_stride != 1 && init_info.index_stride != 2 && init_info.index_stride != 4))
+    {
+        LOG("Warning - create_mesh: LODs are only generated for indexed triangle lists with a float vertex_pos, none generated!\n");
+        return init_info;
+    }
+
+    const auto lod_start = std::chrono::steady_clock::now();
+
+    const std::vector<uint32_t> index_u32_list = read_index_list(init_info.index_data, init_info.index_count, init_info.index_stride);
+    const std::vector<float> position_list = read_position_list(init_info.vertex_data, init_info.vertex_count, init_info.vertex_stride, pos_attribute, component_count);
+
+    const float radius = sqrtf(bounds.extent[0] * bounds.extent[0] + bounds.extent[1] * bounds.extent[1] + bounds.extent[2] * bounds.extent[2]);
+    const float reduction = lod_info.reduction > 0.0f && lod_info.reduction < 1.0f ? lod_info.reduction : 0.5f;
+    const float max_error = (lod_info.max_error > 0.0f ? lod_info.max_error : 0.05f) * radius;
+    const uint32_t max_lod_count = std::min(lod_info.lod_count + 1, Mesh::s_max_lod_count);
+
+    std::vector<uint32_t> lod_index_u32_list = index_u32_list; // every level, LOD 0 first
+    std::vector<uint32_t> simplified_index_list(init_info.index_count);
+    std::vector<uint32_t> cache_optimized_index_list;
+    float target_index_count = static_cast<float>(init_info.index_count);
+
+    while (lod_count < max_lod_count)
+    {
+        target_index_count *= reduction;
+
+        float error = 0.0f;
+        const uint32_t simplified_index_count = mesh_simplifier::simplify(simplified_index_list.data(), index_u32_list.data(), init_info.index_count,
+            position_list.data(), init_info.vertex_count,
+            static_cast<uint32_t>(target_index_count) / 3 * 3, max_error, error);
+
+        // Held back by max_error, a level saving less than half the reduction is not worth switching to.
+        const float max_index_count = static_cast<float>(lod_list[lod_count - 1].index_count) * (1.0f + reduction) * 0.5f;
+
+        if (simplified_index_count == 0 || static_cast<float>(simplified_index_count) > max_index_count)
+        {
+            break;
+        }
+
+        const uint32_t* p_lod_index_data = simplified_index_list.data();
+
+        if (init_info.optimize_info.is_vertex_cache_optimized)
+        {
+            cache_optimized_index_list.resize(simplified_index_count);
+            mesh_optimizer::optimize_vertex_cache(cache_optimized_index_list.data(), simplified_index_list.data(), simplified_index_count, init_info.vertex_count);
+            p_lod_index_data = cache_optimized_index_list.data();
+        }
+
+        lod_list[lod_count] = {
+            .first_index = static_cast<uint32_t>(lod_index_u32_list.size()),
+            .index_count = simplified_index_count,
+            .error = error,
+        };
+
+        lod_index_u32_list.insert(lod_index_u32_list.end(), p_lod_index_data, p_lod_index_data + simplified_index_count);
+        lod_count++;
+    }
+
+    MeshInitInfo lod_init_info = init_info;
+    lod_init_info.index_count = static_cast<uint32_t>(lod_index_u32_list.size());
+
+    index_list.resize(static_cast<size_t>(lod_init_info.index_count) * init_info.index_stride);
+    write_index_list(lod_index_u32_list.data(), lod_init_info.index_count, init_info.index_stride, index_list.data());
+    lod_init_info.index_data = index_list.data();
+
+    stats.lod_count = lod_count;
+    stats.coarsest_lod_index_count = lod_list[lod_count - 1].index_count;
+    stats.coarsest_lod_error = lod_list[lod_count - 1].error;
+    stats.lod_index_byte_count = static_cast<uint64_t>(lod_init_info.index_count - init_info.index_count) * init_info.index_stride;
+    stats.lod_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - lod_start).count());
+
+    return lod_init_info;
+}
+
+// Converts the vertices of init_info from the layout the caller described in vertex_attribute_list to the vertex-input
+// state of sortbin_ID, matching attributes by usage. The returned info points into vertex_list.
+static MeshInitInfo quantize_mesh(const MeshInitInfo& init_info, const uint16_t sortbin_ID, const BoundingBox& bounds, std::vector<uint8_t>& vertex_list, vertex_quantization::PositionTransform& position_transform)
+{
+    const std::vector<VertexAttributeInfo>& src_attribute_list = init_info.vertex_attribute_list;
+    ASSERT(!src_attribute_list.empty(), "create_mesh - Quantizing to sortbin %s needs the source vertex_attribute_list!\n", init_info.quantize_sort_bin_name.c_str());
+    const SortBin& dst_sort_bin = global_state->sort_bin_vec[sortbin_ID];
+
+    vertex_list.assign(static_cast<size_t>(init_info.vertex_count) * dst_sort_bin.vertex_stride, 0);
+
+    for (const SortBin::VertexAttribute& dst_attribute : dst_sort_bin.vertex_attribute_list)
+    {
+        const auto src_attribute_iter = std::find_if(src_attribute_list.begin(), src_attribute_list.end(), [&dst_attribute](const VertexAttributeInfo& src_attribute)
+        {
+            return src_attribute.usage == dst_attribute.usage;
+        });
+
+        ASSERT(src_attribute_iter != src_attribute_list.end(), "create_mesh - Vertices have no %s attribute to quantize from!\n", dst_attribute.usage.c_str());
+        ASSERT(src_attribute_iter->offset + vertex_quantization::get_format_size(src_attribute_iter->format) <= init_info.vertex_stride, "create_mesh - Source %s attribute exceeds the vertex stride %u!\n", dst_attribute.usage.c_str(), init_info.vertex_stride);
+
+        const VkFormat src_format = src_attribute_iter->format;
+        const VkFormat dst_format = dst_attribute.description.format;
+        ASSERT(vertex_quantization::is_supported(dst_attribute.usage, src_format, dst_format), "create_mesh - %s can not be converted from format %d to %d!\n", dst_attribute.usage.c_str(), (int)src_format, (int)dst_format);
+
+        if (dst_attribute.usage == "vertex_pos")
+        {
+            position_transform = vertex_quantization::get_position_transform(dst_format, bounds);
+        }
+
+        vertex_quantization::convert_attribute(dst_attribute.usage,
+            init_info.vertex_data + src_attribute_iter->offset, init_info.vertex_stride, src_format,
+            vertex_list.data() + dst_attribute.description.offset, dst_sort_bin.vertex_stride, dst_format,
+            init_info.vertex_count,
+            position_transform);
+    }
+
+    MeshInitInfo quantized_info = init_info;
+    quantized_info.vertex_stride = dst_sort_bin.vertex_stride;
+    quantized_info.vertex_data = vertex_list.data();
+
+    return quantized_info;
+}
+
+uint32_t create_mesh(const MeshInitInfo& mesh_init_info)
+{
+    std::vector<uint8_t> optimized_vertex_list;
+    std::vector<uint8_t> optimized_index_list;
+    const MeshInitInfo optimized_info = optimize_mesh(mesh_init_info, optimized_vertex_list, optimized_index_list);
+
+    // Computed from the caller's copy, commit_mesh would otherwise read it back from uncached staging memory.
+    const BoundingBox bounds = compute_mesh_bounds(optimized_info.vertex_data, optimized_info.vertex_count, optimized_info.vertex_stride, optimized_info.vertex_attribute_list);
+
+    std::vector<uint8_t> lod_index_list;
+    MeshLod lod_list[Mesh::s_max_lod_count] {};
+    uint32_t lod_count = 1;
+    const MeshInitInfo lod_mesh_info = generate_mesh_lods(optimized_info, bounds, lod_index_list, lod_list, lod_count);
+
+    uint16_t vertex_layout_sortbin_ID = UINT16_MAX;
+    vertex_quantization::PositionTransform position_transform {};
+    std::vector<uint8_t> quantized_vertex_list;
+    MeshInitInfo init_info = lod_mesh_info;
+
+    if (!mesh_init_info.quantize_sort_bin_name.empty())
+    {
+        const auto sort_bin_lut_iter = global_state->name_id_lut_sort_bin.find(mesh_init_info.quantize_sort_bin_name);
+        ASSERT(sort_bin_lut_iter != global_state->name_id_lut_sort_bin.end(), "create_mesh - Quantization SortBin %s not found!\n", mesh_init_info.quantize_sort_bin_name.c_str());
+
+        vertex_layout_sortbin_ID = sort_bin_lut_iter->second;
+        init_info = quantize_mesh(lod_mesh_info, vertex_layout_sortbin_ID, bounds, quantized_vertex_list, position_transform);
+        global_state->last_mesh_optimize_stats.vertex_byte_count_after = static_cast<uint64_t>(init_info.vertex_count) * init_info.vertex_stride;
+    }
+
+    const MeshReserveInfo reserve_info {
+        .vertex_stride = init_info.vertex_stride,
+        .vertex_count = init_info.vertex_count,
+        .index_count = init_info.index_count,
+        .index_stride = init_info.index_stride,
+    };
+
+    const MeshUploadReservation reservation = reserve_mesh(reserve_info);
+
+    Mesh& mesh = global_state->mesh_vec[reservation.mesh_ID];
+    mesh.bounds = bounds;
+    mesh.vertex_layout_sortbin_id = vertex_layout_sortbin_ID;
+    mesh.position_transform = position_transform;
+
+    // The reservation covers every level, the mesh's own range is the full detail one.
+    mesh.index_count = lod_list[0].index_count;
+    mesh.lod_count = lod_count;
+    mesh.lod_index_count = init_info.index_count - lod_list[0].index_count;
+    std::copy(std::begin(lod_list), std::end(lod_list), std::begin(mesh.lod_list));
+
+    stream_memcpy(reservation.vertex_data, init_info.vertex_data, static_cast<size_t>(init_info.vertex_count) * init_info.vertex_stride);
+    stream_memcpy(reservation.index_data, init_info.index_data, static_cast<size_t>(init_info.index_count) * init_info.index_stride);
+
+    commit_mesh(reservation.mesh_ID);
+
+    return reservation.mesh_ID;
+}
+
+MeshUploadReservation reserve_mesh(const MeshReserveInfo& reserve_info)
+{
+    uint32_t mesh_ID = static_cast<uint32_t>(global_state->mesh_vec.size());
+    if (!global_state->mesh_free_ID_list.empty())
+    {
+        mesh_ID = global_state->mesh_free_ID_list.back();
+        global_state->mesh_free_ID_list.pop_back();
+    }
+
+    const VkDeviceSize vertex_size = static_cast<VkDeviceSize>(reserve_info.vertex_count) * reserve_info.vertex_stride;
+    const VkDeviceSize index_size = static_cast<VkDeviceSize>(reserve_info.index_count) * reserve_info.index_stride;
+
+    GeometryAllocation vertex_allocation {};
+    GeometryAllocation index_allocation {};
+    global_state->geometry_buffer->allocate_mesh(mesh_ID, reserve_info.vertex_stride, vertex_size, reserve_info.index_stride, index_size, vertex_allocation, index_allocation);
+
+    RendererState::PendingMeshUpload pending_upload {};
+    pending_upload.vertex_dst_offset = vertex_allocation.offset;
+    pending_upload.index_dst_offset = index_allocation.offset;
+    pending_upload.vertex_allocation = global_state->staging_buffer->allocate(vertex_size);
+    pending_upload.index_allocation = global_state->staging_buffer->allocate(index_size);
+
+    const Mesh mesh {
+        .index_count = reserve_info.index_count,
+        .vertex_count = reserve_info.vertex_count,
+        .first_vertex = 0,
+        .first_index = reserve_info.index_stride ? static_cast<uint32_t>(index_allocation.offset / reserve_info.index_stride) : 0,
+        .vertex_offset = static_cast<int32_t>(vertex_allocation.offset / reserve_info.vertex_stride),
+        .index_stride = reserve_info.index_stride,
+        .vertex_stride = reserve_info.vertex_stride,
+        .geometry_block_id = vertex_allocation.block_id,
+    };
+
+    if (mesh_ID == global_state->mesh_vec.size())
+    {
+        global_state->mesh_vec.push_back(mesh);
+    }
+    else
+    {
+        global_state->mesh_vec[mesh_ID] = mesh;
+    }
+
+    global_state->pending_mesh_upload_umap.emplace(mesh_ID, pending_upload);
+
+    const MeshUploadReservation reservation {
+        .mesh_ID = mesh_ID,
+        .vertex_data = pending_upload.vertex_allocation.mapped_ptr,
+        .index_data = pending_upload.index_allocation.mapped_ptr,
+    };
+
+    return reservation;
+}
+
+void commit_mesh(const uint32_t mesh_ID)
+{
+    const auto iter = global_state->pending_mesh_upload_umap.find(mesh_ID);
+    ASSERT(iter != global_state->pending_mesh_upload_umap.end(), "commit_mesh - Mesh %u has no pending reservation!\n", mesh_ID);
+
+    const RendererState::PendingMeshUpload& pending_upload = iter->second;
+    Mesh& mesh = global_state->mesh_vec[mesh_ID];
+    const VkBuffer vk_handle_geometry_buffer = global_state->geometry_buffer->get_vk_handle_buffer(mesh.geometry_block_id);
+
+    if (!mesh.bounds.is_valid())
+    {
+        mesh.bounds = compute_mesh_bounds(pending_upload.vertex_allocation.mapped_ptr, mesh.vertex_count, mesh.vertex_stride, {});
+    }
+
+    global_state->staging_buffer->commit(pending_upload.vertex_allocation, vk_handle_geometry_buffer, pending_upload.vertex_dst_offset);
+    global_state->staging_buffer->commit(pending_upload.index_allocation, vk_handle_geometry_buffer, pending_upload.index_dst_offset);
+
+    global_state->pending_mesh_upload_umap.erase(iter);
+}
+
+void destroy_mesh(const uint32_t mesh_ID)
+{
+    ASSERT(mesh_ID < global_state->mesh_vec.size(), "destroy_mesh - Mesh ID %u out of range!\n", mesh_ID);
+    ASSERT(!global_state->pending_mesh_upload_umap.contains(mesh_ID), "destroy_mesh - Mesh %u has an uncommitted reservation!\n", mesh_ID);
+
+    Mesh& mesh = global_state->mesh_vec[mesh_ID];
+    ASSERT(mesh.vertex_stride != 0, "destroy_mesh - Mesh %u already destroyed!\n", mesh_ID);
+
+    // The ID is recycled by the next reserve_mesh, a renderable still holding it would silently draw that mesh.
+    // Renderables must be destroyed first, which empties the draws of the mesh in every sortbin.
+    if constexpr (DEBUG)
+    {
+        for (const Renderable& renderable : global_state->renderable_vec)
+        {
+            ASSERT(renderable.draw_id == UINT32_MAX || renderable.mesh_id != mesh_ID, "destroy_mesh - Mesh %u still used by a renderable!\n", mesh_ID);
+        }
+    }
+
+    const GeometryAllocation vertex_allocation {
+        .block_id = mesh.geometry_block_id,
+        .offset = static_cast<VkDeviceSize>(mesh.vertex_offset) * mesh.vertex_stride,
+        .size = static_cast<VkDeviceSize>(mesh.vertex_count) * mesh.vertex_stride,
+    };
+
+    const GeometryAllocation index_allocation {
+        .block_id = mesh.geometry_block_id,
+        .offset = static_cast<VkDeviceSize>(mesh.first_index) * mesh.index_stride,
+        .size = static_cast<VkDeviceSize>(mesh.index_count + mesh.lod_index_count) * mesh.index_stride,
+    };
+
+    global_state->geometry_buffer->free(vertex_allocation);
+    global_state->geometry_buffer->free(index_allocation);
+    remove_mesh_draws(mesh_ID);
+
+    mesh = Mesh {};
+    global_state->mesh_free_ID_list.push_back(mesh_ID);
+}
+
+uint64_t defragment_geometry(const VkCommandBuffer vk_handle_cmd_buff, const uint64_t max_move_byte_count)
+{
+    const std::vector<GeometryMove> move_list = global_state->geometry_buffer->defragment(vk_handle_cmd_buff, max_move_byte_count);
+
+    uint64_t moved_byte_count = 0;
+    std::unordered_map<uint32_t, uint32_t> patched_mesh_umap; // mesh ID -> move count
+
+    for (const GeometryMove& move : move_list)
+    {
+        Mesh& mesh = global_state->mesh_vec[move.owner_id];
+
+        if (move.src_offset == static_cast<VkDeviceSize>(mesh.vertex_offset) * mesh.vertex_stride)
+        {
+            mesh.vertex_offset = static_cast<int32_t>(move.dst_offset / mesh.vertex_stride);
+        }
+        else
+        {
+            ASSERT(move.src_offset == static_cast<VkDeviceSize>(mesh.first_index) * mesh.index_stride, "defragment_geometry - Move does not match mesh %u!\n", move.owner_id);
+            mesh.first_index = static_cast<uint32_t>(move.dst_offset / mesh.index_stride);
+        }
+
+        patched_mesh_umap[move.owner_id]++;
+        moved_byte_count += move.size;
+    }
+
+    if (patched_mesh_umap.empty())
+    {
+        return 0;
+    }
+
+    // Indirect commands already uploaded for in-flight frames keep pointing at the vacated ranges,
+    // which stay intact until the geometry buffer retires them.
+    edit_sortbin_draw_lists([&patched_mesh_umap](std::vector<DrawInfo>& draw_list)
+    {
+        bool is_patched = false;
+
+        for (DrawInfo& draw_info : draw_list)
+        {
+            if (patched_mesh_umap.contains(draw_info.mesh_id))
+            {
+                const Mesh& mesh = global_state->mesh_vec[draw_info.mesh_id];
+                draw_info.first_index = mesh.first_index;
+                draw_info.vertex_offset = mesh.vertex_offset;
+                is_patched = true;
+            }
+        }
+
+        return is_patched;
+    });
+
+    return moved_byte_count;
+}
+
+GeometryStats get_geometry_stats()
+{
+    const GeometryHeapStats stats = global_state->geometry_buffer->get_stats();
+
+    const GeometryStats geometry_stats {
+        .block_count = stats.block_count,
+        .total_byte_count = stats.total_byte_count,
+        .used_byte_count = stats.used_byte_count,
+        .free_byte_count = stats.free_byte_count,
+        .pending_free_byte_count = stats.pending_free_byte_count,
+        .largest_free_range = stats.largest_free_range,
+        .free_range_count = stats.free_range_count,
+        .fragmentation = stats.free_byte_count ? 1.0f - static_cast<float>(stats.largest_free_range) / static_cast<float>(stats.free_byte_count) : 0.0f,
+        .allocation_count = stats.allocation_count,
+        .free_count = stats.free_count,
+        .moved_byte_count = stats.moved_byte_count,
+        .total_allocation_ns = stats.total_allocation_ns,
+    };
+
+    return geometry_stats;
+}
+
+uint32_t create_material(const MaterialInitInfo& init_info, const uint32_t frame_resource_idx)
+{
+    const auto iter = global_state->name_id_lut_material.find(init_info.name);
+
+    if (iter != global_state->name_id_lut_material.end())
+    {
+        LOG("create_material - Attempting to create already existing material %s!\n", init_info.name.c_str());
+        return iter->second;
+    }
+
+    const auto sort_bin_iter = global_state->name_id_lut_sort_bin.find(init_info.default_sort_bin_name);
+    ASSERT(sort_bin_iter != global_state->name_id_lut_sort_bin.end(), "create_material - Default SortBin %s not found!\n", init_info.default_sort_bin_name.c_str());
+    const uint16_t sort_bin_ID = sort_bin_iter->second;
+
+    ASSERT(global_state->sort_bin_vec.size() > sort_bin_ID, "Default sortbin ID out of range!\n");
+    const SortBin& sort_bin = global_state->sort_bin_vec[sort_bin_ID];
+
+    ASSERT(sort_bin.material_data_block_size - sort_bin.material_data_block_end_padding_size == init_info.material_data_size, "Material data size mismatch!\n");
+    const uint32_t block_ID = upload_block(global_state->material_data_buffer.get(), sort_bin.material_data_block_size, init_info.material_data_size, init_info.material_data_ptr);
+
+    queue_uploads_to_staging_buffer(global_state->material_data_buffer.get(), global_state->staging_buffer.get(), frame_resource_idx);
+
+    const Material mat {
+        .ID = block_ID,
+        .default_sort_bin_ID = sort_bin_ID
+    };
+
+    uint32_t mat_ID = static_cast<uint32_t>(global_state->material_vec.size());
+    if (!global_state->material_free_ID_list.empty())
+    {
+        mat_ID = global_state->material_free_ID_list.back();
+        global_state->material_free_ID_list.pop_back();
+        global_state->material_vec[mat_ID] = mat;
+    }
+    else
+    {
+        global_state->material_vec.push_back(mat);
+    }
+
+    global_state->name_id_lut_material.emplace_hint(iter, init_info.name, mat_ID);
+
+    return mat_ID;
+}
+
+void destroy_material(const uint32_t material_ID)
+{
+    ASSERT(material_ID < global_state->material_vec.size(), "destroy_material - Material ID %u out of range!\n", material_ID);
+    Material& material = global_state->material_vec[material_ID];
+    ASSERT(material.ID != UINT32_MAX, "destroy_material - Material %u already destroyed!\n", material_ID);
+
+    if constexpr (DEBUG)
+    {
+        for (const Renderable& renderable : global_state->renderable_vec)
+        {
+            ASSERT(renderable.draw_id == UINT32_MAX || renderable.material_id != material_ID, "destroy_material - Material %u still used by a renderable!\n", material_ID);
+        }
+    }
+
+    const SortBin& sort_bin = global_state->sort_bin_vec[material.default_sort_bin_ID];
+    global_state->material_data_buffer->release_block(sort_bin.material_data_block_size, material.ID);
+
+    std::erase_if(global_state->name_id_lut_material, [material_ID](const auto& name_id) { return name_id.second == material_ID; });
+
+    material.ID = UINT32_MAX;
+    global_state->material_free_ID_list.push_back(material_ID);
+}
+
+std::pair<uint32_t, uint16_t> create_renderable(const RenderableInitInfo& init_info, const uint32_t frame_resource_idx)
+{
+    const auto sort_bin_lut_iter = global_state->name_id_lut_sort_bin.find(init_info.default_sort_bin_name);
+    ASSERT(sort_bin_lut_iter != global_state->name_id_lut_sort_bin.end(), "create_renderable - Default SortBin %s not found!\n", init_info.default_sort_bin_name.c_str());
+    const uint16_t sort_bin_ID = sort_bin_lut_iter->second;
+
+    ASSERT(init_info.material_ID < global_state->material_vec.size(), "create_renderable - Material ID %u out of range!\n", init_info.material_ID);
+    const Material& material = global_state->material_vec[init_info.material_ID];
+    ASSERT(material.ID != UINT32_MAX, "create_renderable - Material %u was destroyed!\n", init_info.material_ID);
+    ASSERT(init_info.mesh_ID < global_state->mesh_vec.size(), "create_renderable - Mesh ID %u out of range!\n", init_info.mesh_ID);
+    ASSERT(global_state->mesh_vec[init_info.mesh_ID].vertex_stride != 0, "create_renderable - Mesh %u was destroyed!\n", init_info.mesh_ID);
+    const SortBin& material_sort_bin = global_state->sort_bin_vec[material.default_sort_bin_ID]; 
+    const SortBin& sort_bin = global_state->sort_bin_vec[sort_bin_ID];
+    ASSERT(sort_bin.compatible_sort_bin_set_ID == material_sort_bin.compatible_sort_bin_set_ID, "create_renderable - SortBin %s not supported by Material %u!\n", init_info.default_sort_bin_name.c_str(), init_info.material_ID);
+    ASSERT(sort_bin.draw_data_block_size - sort_bin.draw_data_block_end_padding_size == init_info.draw_data_size + sizeof(uint32_t), "Draw data size mismatch!\n");
+
+    // The draw block references the material by its block in the material SSBO.
+    const uint32_t draw_ID = upload_block(global_state->draw_data_buffer.get(), sort_bin.draw_data_block_size, init_info.draw_data_size, init_info.draw_data_ptr, material.ID);
+
+    const Renderable renderable {
+        .mesh_id = init_info.mesh_ID,
+        .material_id = init_info.material_ID,
+        .draw_id = draw_ID,
+        .default_sortbin_id = sort_bin_ID,
+    };
+
+    uint32_t renderable_ID = static_cast<uint32_t>(global_state->renderable_vec.size());
+    if (!global_state->renderable_free_ID_list.empty())
+    {
+        renderable_ID = global_state->renderable_free_ID_list.back();
+        global_state->renderable_free_ID_list.pop_back();
+        global_state->renderable_vec[renderable_ID] = renderable;
+    }
+    else
+    {
+        global_state->renderable_vec.push_back(renderable);
+    }
+
+    queue_uploads_to_staging_buffer(global_state->draw_data_buffer.get(), global_state->staging_buffer.get(), frame_resource_idx);
+
+    // Quantized positions are dequantized by the shader with the mesh's transform, when its draw data declares one.
+    const Mesh& mesh = global_state->mesh_vec[init_info.mesh_ID];
+
+    if (mesh.vertex_layout_sortbin_id != UINT16_MAX)
+    {
+        ASSERT(global_state->compatible_sortbin_ID_lut[mesh.vertex_layout_sortbin_id] == global_state->compatible_sortbin_ID_lut[sort_bin_ID], "create_renderable - SortBin %s does not read the quantized vertices of mesh %u!\n", init_info.default_sort_bin_name.c_str(), init_info.mesh_ID);
+
+        const auto write_draw_member = [&](const char* const member_name, const float* const value)
+        {
+            const auto it = sort_bin.descriptor_variable_draw_umap.find(member_name);
+
+            if (it != sort_bin.descriptor_variable_draw_umap.end())
+            {
+                void* const draw_data_ptr = global_state->draw_data_buffer->get_writable_range(sort_bin.draw_data_block_size, draw_ID, it->second.offset, it->second.size);
+                memcpy(static_cast<uint8_t*>(draw_data_ptr) + it->second.offset, value, std::min<size_t>(it->second.size, 3 * sizeof(float)));
+            }
+        };
+
+        write_draw_member("vertex_pos_scale", mesh.position_transform.scale);
+        write_draw_member("vertex_pos_bias", mesh.position_transform.bias);
+    }
+
+    // The culling bounds follow the draw data's model matrix. The draw ID may have belonged to a destroyed renderable,
+    // without a model matrix its bounds are cleared and it stays unculled until a transform is set.
+    if (sort_bin.draw_model_mat_offset != UINT32_MAX)
+    {
+        float model_mat[16];
+        memcpy(model_mat, init_info.draw_data_ptr + sort_bin.draw_model_mat_offset, sizeof(model_mat));
+        global_state->frustum_culler->set_bounds(draw_ID, mesh.bounds, model_mat);
+    }
+    else
+    {
+        global_state->frustum_culler->clear_bounds(draw_ID);
+    }
+
+    return {renderable_ID, renderable.default_sortbin_id};
+}
 
-// Startup
-// -- Group sortbins into sets based on vertex input / material / draw states
+void set_renderable_transform(const uint32_t renderable_ID, const float* const model_mat)
+{
+    ASSERT(renderable_ID < global_state->renderable_vec.size(), "set_renderable_transform - Renderable ID %u out of range!\n", renderable_ID);
+    const Renderable& renderable = global_state->renderable_vec[renderable_ID];
+    ASSERT(renderable.draw_id != UINT32_MAX, "set_renderable_transform - Renderable %u was destroyed!\n", renderable_ID);
 
-// Load a GLTF model (contains sortbin_id)
-// -- Create renderable_id
-// -- Create mesh_id
-// -- Create material_id
-// -- Create draw_id
-// -- Add supported_sortbin_set_id to renderable
+    const SortBin& sort_bin = global_state->sort_bin_vec[renderable.default_sortbin_id];
 
-std::unique_ptr<RendererState> global_state = nullptr;
+    if (sort_bin.draw_model_mat_offset == UINT32_MAX)
+    {
+        update_renderable_bounds(renderable_ID, model_mat);
+        return;
+    }
 
-void init(const InitInfo& init_info)
-{
-    const RendererState::CreateInfo renderer_internal_create_info {
-        .refl_file_frame_desc_set_def = init_info.refl_file_frame_desc_set_def,
-        .refl_file_sortbin_mat_draw_def = init_info.refl_file_sortbin_mat_draw_def,
-        .file_sortbin_pipeline_state = init_info.file_sortbin_pipeline_state,
-        .file_app_state = init_info.file_app_state,
-        .path_shader_root = init_info.path_shader_root,
-        .frame_resource_count = init_info.frame_resource_count,
-        .window_x_dim = init_info.window_width,
-        .window_y_dim = init_info.window_height
+    // Goes through the regular draw data write, which derives the bounds from the written matrix.
+    const UniformHandle handle {
+        .buffer_type = BufferType::eDraw,
+        .member_idx = UINT32_MAX,
+        .block_size = static_cast<uint32_t>(sort_bin.draw_data_block_size),
+        .offset = sort_bin.draw_model_mat_offset,
+        .size = 16 * sizeof(float),
     };
 
-    global_state = std::make_unique<RendererState>(renderer_internal_create_info);
+    update_uniforms(handle, std::span<const uint32_t>(&renderable_ID, 1), model_mat, 0);
 }
 
-void terminate()
+void update_renderable_bounds(const uint32_t renderable_ID, const float* const model_mat)
 {
-    global_state.reset();
+    ASSERT(renderable_ID < global_state->renderable_vec.size(), "update_renderable_bounds - Renderable ID %u out of range!\n", renderable_ID);
+    const Renderable& renderable = global_state->renderable_vec[renderable_ID];
+    ASSERT(renderable.draw_id != UINT32_MAX, "update_renderable_bounds - Renderable %u was destroyed!\n", renderable_ID);
+
+    global_state->frustum_culler->set_bounds(renderable.draw_id, global_state->mesh_vec[renderable.mesh_id].bounds, model_mat);
 }
 
-uint32_t create_mesh(const MeshInitInfo& init_info)
+void destroy_renderable(const uint32_t renderable_ID)
 {
-    const int32_t vertex_offset = global_state->geometry_buffer->queue_upload(
-        init_info.vertex_stride,
-        init_info.vertex_count,
-        std::vector<uint8_t>(init_info.vertex_data, init_info.vertex_data + init_info.vertex_count * init_info.vertex_stride));
+    ASSERT(renderable_ID < global_state->renderable_vec.size(), "destroy_renderable - Renderable ID %u out of range!\n", renderable_ID);
+    Renderable& renderable = global_state->renderable_vec[renderable_ID];
+    ASSERT(renderable.draw_id != UINT32_MAX, "destroy_renderable - Renderable %u already destroyed!\n", renderable_ID);
 
-    const uint32_t first_index = static_cast<uint32_t>(global_state->geometry_buffer->queue_upload(
-        init_info.index_stride,
-        init_info.index_count,
-        std::vector<uint8_t>(init_info.index_data, init_info.index_data + init_info.index_count * init_info.index_stride)));
+    const uint32_t draw_ID = renderable.draw_id;
+    const auto draw_instance_iter = global_state->draw_instance_umap.find(draw_ID);
 
-    const uint32_t mesh_ID = static_cast<uint32_t>(global_state->mesh_vec.size());
-
-    const Mesh mesh {
-        .index_count = init_info.index_count,
-        .vertex_count = init_info.vertex_count,
-        .first_vertex = 0,
-        .first_index = first_index,
-        .vertex_offset = vertex_offset,
-        .index_stride = init_info.index_stride,
-    };
+    if (draw_instance_iter != global_state->draw_instance_umap.end())
+    {
+        for (const RendererState::DrawInstance& draw_instance : draw_instance_iter->second)
+        {
+            remove_draw_instance(draw_instance, renderable.mesh_id);
+        }
 
-    global_state->mesh_vec.push_back(mesh);
+        global_state->draw_instance_umap.erase(draw_instance_iter);
+    }
 
-    queue_uploads_to_staging_buffer(global_state->geometry_buffer.get(), global_state->staging_buffer.get());
+    const SortBin& sort_bin = global_state->sort_bin_vec[renderable.default_sortbin_id];
+    global_state->draw_data_buffer->release_block(sort_bin.draw_data_block_size, draw_ID);
 
-    return mesh_ID;
+    renderable.draw_id = UINT32_MAX;
+    global_state->renderable_free_ID_list.push_back(renderable_ID);
 }
 
-uint32_t create_material(const MaterialInitInfo& init_info, const uint32_t frame_resource_idx)
+void update_uniform(const BufferType buffer_type, const std::string& uniform_name, const void* const value, const uint32_t data_id)
 {
-    const auto iter = global_state->name_id_lut_material.find(init_info.name);
+    uint16_t sortbin_ID = UINT16_MAX;
 
-    if (iter != global_state->name_id_lut_material.end())
+    if (buffer_type == BufferType::eMaterial)
     {
-        LOG("create_material - Attempting to create already existing material %s!\n", init_info.name.c_str());
-        return iter->second;
+        ASSERT(global_state->material_vec.size() > data_id, "update_uniform - Material ID out of range!\n");
+        sortbin_ID = global_state->material_vec[data_id].default_sort_bin_ID;
+    }
+    else if (buffer_type == BufferType::eDraw)
+    {
+        ASSERT(global_state->renderable_vec.size() > data_id, "update_uniform - Renderable ID out of range!\n");
+        sortbin_ID = global_state->renderable_vec[data_id].default_sortbin_id;
     }
 
-    const auto sort_bin_iter = global_state->name_id_lut_sort_bin.find(init_info.default_sort_bin_name);
-    ASSERT(sort_bin_iter != global_state->name_id_lut_sort_bin.end(), "create_material - Default SortBin %s not found!\n", init_info.default_sort_bin_name.c_str());
-    const uint16_t sort_bin_ID = sort_bin_iter->second;
+    update_uniform(get_uniform_handle(buffer_type, uniform_name, sortbin_ID), value, data_id);
+}
 
-    ASSERT(global_state->sort_bin_vec.size() > sort_bin_ID, "Default sortbin ID out of range!\n");
-    const SortBin& sort_bin = global_state->sort_bin_vec[sort_bin_ID];
+UniformHandle get_uniform_handle(const BufferType buffer_type, const std::string& uniform_name, const uint16_t sortbin_ID)
+{
+    UniformHandle handle {
+        .buffer_type = buffer_type,
+        .member_idx = UINT32_MAX,
+        .block_size = 0,
+        .offset = 0,
+        .size = 0,
+    };
 
-    ASSERT(sort_bin.material_data_block_size - sort_bin.material_data_block_end_padding_size == init_info.material_data_size, "Material data size mismatch!\n");
-    const uint32_t mat_ID = upload_block(global_state->material_data_buffer.get(), sort_bin.material_data_block_size, init_info.material_data_size, init_info.material_data_ptr);
+    switch (buffer_type)
+    {
+        case BufferType::eFrame:
+        {
+            handle.member_idx = global_state->frame_general_ubo->find_member(uniform_name);
+            ASSERT(handle.member_idx != UINT32_MAX, "Member variable %s not found in uniform buffer!\n", uniform_name.c_str());
 
-    queue_uploads_to_staging_buffer(global_state->material_data_buffer.get(), global_state->staging_buffer.get(), frame_resource_idx);
+            if (handle.member_idx != UINT32_MAX)
+            {
+                const DescriptorVariable& member_var_refl = global_state->frame_general_ubo->get_member(handle.member_idx);
+                handle.offset = member_var_refl.offset;
+                handle.size = member_var_refl.size;
+            }
+            break;
+        }
+        case BufferType::eMaterial:
+        case BufferType::eDraw:
+        {
+            ASSERT(global_state->sort_bin_vec.size() > sortbin_ID, "get_uniform_handle - Sortbin ID out of range!\n");
+            const SortBin& sort_bin = global_state->sort_bin_vec[sortbin_ID];
+            const bool is_material = buffer_type == BufferType::eMaterial;
 
-    const Material mat {
-        .ID = mat_ID,
-        .default_sort_bin_ID = sort_bin_ID
-    };
+            const std::unordered_map<std::string, DescriptorVariable>& desc_var_umap = is_material ? sort_bin.descriptor_variable_material_umap : sort_bin.descriptor_variable_draw_umap;
+            handle.block_size = static_cast<uint32_t>(is_material ? sort_bin.material_data_block_size : sort_bin.draw_data_block_size);
 
-    global_state->name_id_lut_material.emplace_hint(iter, init_info.name, mat_ID);
-    global_state->material_vec.push_back(mat);
+            const auto it = desc_var_umap.find(uniform_name);
+            ASSERT(it != desc_var_umap.end(), "Member name `%s` not found in sortbin descriptor variable list!\n", uniform_name.c_str());
 
-    return mat_ID;
+            if (it != desc_var_umap.end())
+            {
+                handle.offset = it->second.offset;
+                handle.size = it->second.size;
+            }
+            break;
+        }
+        case BufferType::eSortbin:
+        default:
+        {
+            LOG("Warning - Buffer type %d does not support uniform updates!\n", (int)buffer_type);
+            break;
+        }
+    };
+
+    return handle;
 }
 
-std::pair<uint32_t, uint16_t> create_renderable(const RenderableInitInfo& init_info, const uint32_t frame_resource_idx)
+void update_uniform(const UniformHandle& handle, const void* const value, const uint32_t data_id)
 {
-    const auto sort_bin_lut_iter = global_state->name_id_lut_sort_bin.find(init_info.default_sort_bin_name);
-    ASSERT(sort_bin_lut_iter != global_state->name_id_lut_sort_bin.end(), "create_renderable - Default SortBin %s not found!\n", init_info.default_sort_bin_name.c_str());
-    const uint16_t sort_bin_ID = sort_bin_lut_iter->second;
-
-    ASSERT(init_info.material_ID < global_state->material_vec.size(), "create_renderable - Material ID %u out of range!\n", init_info.material_ID);
-    const Material& material = global_state->material_vec[init_info.material_ID];
-    const SortBin& material_sort_bin = global_state->sort_bin_vec[material.default_sort_bin_ID]; 
-    const SortBin& sort_bin = global_state->sort_bin_vec[sort_bin_ID];
-    ASSERT(sort_bin.compatible_sort_bin_set_ID == material_sort_bin.compatible_sort_bin_set_ID, "create_renderable - SortBin %s not supported by Material %u!\n", init_info.default_sort_bin_name.c_str(), init_info.material_ID);
-    ASSERT(sort_bin.draw_data_block_size - sort_bin.draw_data_block_end_padding_size == init_info.draw_data_size + sizeof(uint32_t), "Draw data size mismatch!\n");
-
-    const uint32_t draw_ID = upload_block(global_state->draw_data_buffer.get(), sort_bin.draw_data_block_size, init_info.draw_data_size, init_info.draw_data_ptr, init_info.material_ID);
-    const uint32_t renderable_ID = static_cast<uint32_t>(global_state->renderable_vec.size());
+    if (handle.buffer_type == BufferType::eFrame)
+    {
+        if (handle.size != 0)
+        {
+            global_state->frame_general_ubo->update_member(handle.member_idx, value);
+        }
+        return;
+    }
 
-    const Renderable renderable {
-        .mesh_id = init_info.mesh_ID,
-        .material_id = init_info.material_ID,
-        .draw_id = draw_ID,
-        .default_sortbin_id = sort_bin_ID,
-    };
+    update_uniforms(handle, std::span<const uint32_t>(&data_id, 1), value, 0);
+}
 
-    global_state->renderable_vec.push_back(renderable);
+void* get_uniform_write_ptr(const UniformHandle& handle, const uint32_t data_id)
+{
+    switch (handle.buffer_type)
+    {
+        case BufferType::eFrame:
+        {
+            ASSERT(handle.member_idx < UINT32_MAX && global_state->frame_general_ubo->get_member(handle.member_idx).offset == handle.offset, "get_uniform_write_ptr - Handle does not match the frame UBO!\n");
+            return global_state->frame_general_ubo->get_writable_member(handle.member_idx);
+        }
+        case BufferType::eMaterial:
+        {
+            ASSERT(global_state->material_vec.size() > data_id, "get_uniform_write_ptr - Material ID out of range!\n");
+            const Material& material = global_state->material_vec[data_id];
+            ASSERT(global_state->sort_bin_vec[material.default_sort_bin_ID].material_data_block_size == handle.block_size, "get_uniform_write_ptr - Material %u does not use the handle's block layout!\n", data_id);
 
-    queue_uploads_to_staging_buffer(global_state->draw_data_buffer.get(), global_state->staging_buffer.get(), frame_resource_idx);
+            return static_cast<uint8_t*>(global_state->material_data_buffer->get_writable_range(handle.block_size, material.ID, handle.offset, handle.size)) + handle.offset;
+        }
+        case BufferType::eDraw:
+        {
+            ASSERT(global_state->renderable_vec.size() > data_id, "get_uniform_write_ptr - Renderable ID out of range!\n");
+            const Renderable& renderable = global_state->renderable_vec[data_id];
+            ASSERT(global_state->sort_bin_vec[renderable.default_sortbin_id].draw_data_block_size == handle.block_size, "get_uniform_write_ptr - Renderable %u does not use the handle's block layout!\n", data_id);
 
-    return {renderable_ID, renderable.default_sortbin_id};
+            return static_cast<uint8_t*>(global_state->draw_data_buffer->get_writable_range(handle.block_size, renderable.draw_id, handle.offset, handle.size)) + handle.offset;
+        }
+        case BufferType::eSortbin:
+        default:
+        {
+            EXIT("get_uniform_write_ptr - Buffer type %d does not support uniform updates!\n", (int)handle.buffer_type);
+            return nullptr;
+        }
+    };
 }
 
-void update_uniform(const BufferType buffer_type, const std::string& uniform_name, const void* const value, const uint32_t data_id)
+void update_uniforms(const UniformHandle& handle, const std::span<const uint32_t> data_id_span, const void* const data, const uint32_t data_stride)
 {
-    switch (buffer_type)
+    if (handle.size == 0 || data_id_span.empty())
+    {
+        return;
+    }
+
+    std::vector<uint32_t>& block_ID_list = global_state->uniform_block_ID_list;
+    block_ID_list.clear();
+
+    switch (handle.buffer_type)
     {
         case BufferType::eFrame:
         {
-            global_state->frame_general_ubo->update_member(uniform_name, value);
+            // One UBO, the last value wins.
+            const uint64_t last_idx = data_id_span.size() - 1;
+            global_state->frame_general_ubo->update_member(handle.member_idx, static_cast<const uint8_t*>(data) + last_idx * data_stride);
             break;
         }
         case BufferType::eMaterial:
         {
-            ASSERT(global_state->material_vec.size() > data_id, "update_uniform - Material ID out of range!\n");
-            const Material& material = global_state->material_vec[data_id];
-            const SortBin& sort_bin = global_state->sort_bin_vec[material.default_sort_bin_ID];
+            for (const uint32_t data_id : data_id_span)
+            {
+                ASSERT(global_state->material_vec.size() > data_id, "update_uniforms - Material ID out of range!\n");
+                const Material& material = global_state->material_vec[data_id];
+                ASSERT(global_state->sort_bin_vec[material.default_sort_bin_ID].material_data_block_size == handle.block_size, "update_uniforms - Material %u does not use the handle's block layout!\n", data_id);
 
-            const auto it = sort_bin.descriptor_variable_material_umap.find(uniform_name);
-            ASSERT(it != sort_bin.descriptor_variable_material_umap.end(), "Member name `%s` not found in sortbin descriptor variable list!\n", uniform_name.c_str());
+                block_ID_list.push_back(material.ID);
+            }
 
-            void* mat_data_ptr = global_state->material_data_buffer->get_writable_block(sort_bin.material_data_block_size, material.ID);
-            memcpy(static_cast<uint8_t*>(mat_data_ptr) + it->second.offset, value, it->second.size);
-            // LOG("Updating material uniform member (%u, %s, %u, %u)\n", data_id, uniform_name.c_str(), it->second.offset, it->second.size);
+            global_state->material_data_buffer->write_member_list(handle.block_size, block_ID_list.data(), static_cast<uint32_t>(block_ID_list.size()),
+                handle.offset, handle.size, static_cast<const uint8_t*>(data), data_stride);
             break;
         }
         case BufferType::eDraw:
         {
-            ASSERT(global_state->renderable_vec.size() > data_id, "update_uniform - Renderable ID out of range!\n");
-            const Renderable& renderable = global_state->renderable_vec[data_id];
-            const SortBin& sort_bin = global_state->sort_bin_vec[renderable.default_sortbin_id];
+            for (const uint32_t data_id : data_id_span)
+            {
+                ASSERT(global_state->renderable_vec.size() > data_id, "update_uniforms - Renderable ID out of range!\n");
+                const Renderable& renderable = global_state->renderable_vec[data_id];
+                ASSERT(global_state->sort_bin_vec[renderable.default_sortbin_id].draw_data_block_size == handle.block_size, "update_uniforms - Renderable %u does not use the handle's block layout!\n", data_id);
+
+                block_ID_list.push_back(renderable.draw_id);
+            }
 
-            const auto it = sort_bin.descriptor_variable_draw_umap.find(uniform_name);
-            ASSERT(it != sort_bin.descriptor_variable_draw_umap.end(), "Member name `%s` not found in sortbin descriptor variable list!\n", uniform_name.c_str());
+            global_state->draw_data_buffer->write_member_list(handle.block_size, block_ID_list.data(), static_cast<uint32_t>(block_ID_list.size()),
+                handle.offset, handle.size, static_cast<const uint8_t*>(data), data_stride);
 
-            void* draw_data_ptr = global_state->draw_data_buffer->get_writable_block(sort_bin.draw_data_block_size, renderable.draw_id);
-            memcpy(static_cast<uint8_t*>(draw_data_ptr) + it->second.offset, value, it->second.size);
-            // LOG("Updating draw uniform member (%u, %s, %u, %u)\n", data_id, uniform_name.c_str(), it->second.offset, it->second.size);
+            // Writes of the model matrix keep the culling bounds in step with what the shader reads.
+            for (uint64_t i = 0; i < data_id_span.size(); i++)
+            {
+                const Renderable& renderable = global_state->renderable_vec[data_id_span[i]];
+
+                if (handle.offset == global_state->sort_bin_vec[renderable.default_sortbin_id].draw_model_mat_offset)
+                {
+                    float model_mat[16];
+                    memcpy(model_mat, static_cast<const uint8_t*>(data) + i * data_stride, sizeof(model_mat));
+                    global_state->frustum_culler->set_bounds(renderable.draw_id, global_state->mesh_vec[renderable.mesh_id].bounds, model_mat);
+                }
+            }
             break;
         }
         case BufferType::eSortbin:
         default:
         {
-            LOG("Warning - Buffer type %d does not support uniform updates!\n", (int)buffer_type);
+            LOG("Warning - Buffer type %d does not support uniform updates!\n", (int)handle.buffer_type);
             break;
         }
     };
@@ -321,17 +1513,33 @@ bool flush_buffer_uploads_to_staging(const BufferType buffer_type, const uint32_
     {
         case BufferType::eGeometry:
         {
-            has_uploads = queue_uploads_to_staging_buffer(global_state->geometry_buffer.get(), global_state->staging_buffer.get());
+            // Geometry is written straight into staging memory by reserve_mesh / commit_mesh.
             break;
         }
         case BufferType::eMaterial:
         {
+            sync_buffer_pool_capacity(global_state->material_data_buffer.get(), 1, global_state->vk_handle_frame_desc_set_vec[frame_resource_idx], frame_resource_idx,
+                global_state->frame_desc_set_generation_vec[frame_resource_idx]);
             has_uploads = queue_uploads_to_staging_buffer(global_state->material_data_buffer.get(), global_state->staging_buffer.get(), frame_resource_idx);
             break;
         }
         case BufferType::eDraw:
         {
+            sync_buffer_pool_capacity(global_state->draw_data_buffer.get(), 2, global_state->vk_handle_frame_desc_set_vec[frame_resource_idx], frame_resource_idx,
+                global_state->frame_desc_set_generation_vec[frame_resource_idx]);
             has_uploads = queue_uploads_to_staging_buffer(global_state->draw_data_buffer.get(), global_state->staging_buffer.get(), frame_resource_idx);
+            sync_buffer_pool_capacity(global_state->instance_buffer.get(), 4, global_state->vk_handle_frame_desc_set_vec[frame_resource_idx], frame_resource_idx,
+                global_state->frame_desc_set_generation_vec[frame_resource_idx]);
+            has_uploads |= queue_uploads_to_staging_buffer(global_state->instance_buffer.get(), global_state->staging_buffer.get(), frame_resource_idx);
+            has_uploads |= global_state->indirect_draw_buffer->queue_uploads(frame_resource_idx, *global_state->staging_buffer);
+
+            for (RendererState::RenderPassCullState& cull_state : global_state->render_pass_cull_state_vec)
+            {
+                if (cull_state.indirect_draw_buffer)
+                {
+                    has_uploads |= cull_state.indirect_draw_buffer->queue_uploads(frame_resource_idx, *global_state->staging_buffer);
+                }
+            }
             break;
         }
         case BufferType::eSortbin:
@@ -345,9 +1553,97 @@ bool flush_buffer_uploads_to_staging(const BufferType buffer_type, const uint32_
     return has_uploads;
 }
 
-void flush_staging_to_device(const VkCommandBuffer vk_handle_cmd_buff)
+uint64_t flush_staging_to_device(const VkCommandBuffer vk_handle_cmd_buff)
+{
+    global_state->geometry_buffer->advance_frame();
+    global_state->indirect_draw_buffer->advance_frame();
+    advance_cull_state_frame();
+    global_state->material_data_buffer->advance_frame();
+    global_state->draw_data_buffer->advance_frame();
+    global_state->instance_buffer->advance_frame();
+    return global_state->staging_buffer->flush(vk_handle_cmd_buff);
+}
+
+VkSemaphore get_staging_retire_semaphore()
+{
+    return global_state->staging_buffer->get_vk_handle_retire_semaphore();
+}
+
+uint64_t submit_staging_to_transfer_queue()
+{
+    global_state->geometry_buffer->advance_frame();
+    global_state->indirect_draw_buffer->advance_frame();
+    advance_cull_state_frame();
+    global_state->material_data_buffer->advance_frame();
+    global_state->draw_data_buffer->advance_frame();
+    global_state->instance_buffer->advance_frame();
+    return global_state->staging_buffer->submit();
+}
+
+void record_upload_acquire_barriers(const VkCommandBuffer vk_handle_cmd_buff)
+{
+    global_state->staging_buffer->record_acquire_barriers(vk_handle_cmd_buff);
+}
+
+VkSemaphore get_upload_timeline_semaphore()
+{
+    return global_state->staging_buffer->get_vk_handle_timeline_semaphore();
+}
+
+VkPipelineStageFlags get_upload_wait_stage_mask()
+{
+    return StagingBuffer::s_upload_consumer_stage_mask;
+}
+
+UploadStats get_upload_stats(const BufferType buffer_type)
+{
+    const BufferPool_VariableBlock* buffer = nullptr;
+
+    switch (buffer_type)
+    {
+        case BufferType::eMaterial:
+        {
+            buffer = global_state->material_data_buffer.get();
+            break;
+        }
+        case BufferType::eDraw:
+        {
+            buffer = global_state->draw_data_buffer.get();
+            break;
+        }
+        default:
+        {
+            LOG("Warning - Buffer type %d does not track upload stats!\n", (int)buffer_type);
+            return {};
+        }
+    };
+
+    const BufferPoolUploadStats& stats = buffer->get_upload_stats();
+
+    const UploadStats upload_stats {
+        .last_copy_region_count = stats.last_copy_region_count,
+        .last_staged_byte_count = stats.last_staged_byte_count,
+        .total_copy_region_count = stats.total_copy_region_count,
+        .total_staged_byte_count = stats.total_staged_byte_count,
+    };
+
+    return upload_stats;
+}
+
+AttachmentMemoryStats get_attachment_memory_stats()
 {
-    global_state->staging_buffer->flush(vk_handle_cmd_buff);
+    const RendererState::AttachmentMemoryStats& stats = global_state->render_attachment_memory_stats;
+
+    const AttachmentMemoryStats attachment_memory_stats {
+        .naive_byte_count = stats.naive_byte_count,
+        .allocated_byte_count = stats.allocated_byte_count,
+        .alias_group_count = stats.alias_group_count,
+        .aliased_attachment_count = stats.aliased_attachment_count,
+        .transient_attachment_count = stats.transient_attachment_count,
+        .lazily_allocated_attachment_count = stats.lazily_allocated_attachment_count,
+    };
+
+    return attachment_memory_stats;
 }
 
 void add_renderable_to_sortbin(const uint32_t renderable_id, const uint16_t sortbin_id)
@@ -368,29 +1664,31 @@ void add_renderable_to_sortbin(const uint32_t renderable_id, const uint16_t sort
         .first_index = mesh.first_index,
         .first_vertex = mesh.first_vertex,
         .vertex_offset = mesh.vertex_offset,
-        .first_instance = renderable.draw_id
+        .first_instance = 0,
+        .mesh_id = renderable.mesh_id,
+        .geometry_block_id = mesh.geometry_block_id,
     };
 
     switch (mesh.index_stride)
     {
         case 4:
         {
-            global_state->sort_bin_vec[sortbin_id].draw_list_u32.push_back(draw_info);
+            add_draw_instance(sortbin_id, VK_INDEX_TYPE_UINT32, draw_info, renderable.draw_id);
             break;
         }
         case 2:
         {
-            global_state->sort_bin_vec[sortbin_id].draw_list_u16.push_back(draw_info);
+            add_draw_instance(sortbin_id, VK_INDEX_TYPE_UINT16, draw_info, renderable.draw_id);
             break;
         }
         case 1:
         {
-            global_state->sort_bin_vec[sortbin_id].draw_list_u8.push_back(draw_info);
+            add_draw_instance(sortbin_id, VK_INDEX_TYPE_UINT8_EXT, draw_info, renderable.draw_id);
             break;
         }
         default:
         {
-            global_state->sort_bin_vec[sortbin_id].draw_list.push_back(draw_info);
+            add_draw_instance(sortbin_id, VK_INDEX_TYPE_MAX_ENUM, draw_info, renderable.draw_id);
             break;
         }
     };
@@ -417,25 +1715,230 @@ void record_render_pass(const std::string& render_pass_name, const VkCommandBuff
     const uint32_t render_pass_ID = global_state->name_id_lut_render_pass.at(render_pass_name);
     const RenderPass& render_pass = global_state->render_pass_vec[render_pass_ID];
 
-    const RenderPass::RecordInfo record_info {
-        .frame_idx = frame_resource_idx,
-        .vk_handle_cmd_buff = vk_handle_cmd_buff,
-        .global_attachment_list = global_state->render_attachment_vec,
-        .global_sortbin_list = global_state->sort_bin_vec,
-        .render_area = render_area,
-        .vk_handle_index_buffer_list = { 
-            global_state->geometry_buffer->get_vk_handle_buffer(),
-            global_state->geometry_buffer->get_vk_handle_buffer(),
-            global_state->geometry_buffer->get_vk_handle_buffer()
-        },
-        .vk_handle_global_desc_set = global_state->vk_handle_frame_desc_set_vec[frame_resource_idx],
+    RendererState::RenderPassCullState& cull_state = global_state->render_pass_cull_state_vec[render_pass_ID];
+    const bool is_culled = cull_state.is_frame_culled_vec.size() > frame_resource_idx && cull_state.is_frame_culled_vec[frame_resource_idx];
+
+    if (is_culled)
+    {
+        cull_state.is_frame_culled_vec[frame_resource_idx] = false;
+    }
+
+    OcclusionCuller* const p_occlusion_culler = is_culled ? cull_state.occlusion_culler.get() : nullptr;
+
+    // Culled draws differ every frame, only the full sortbin lists are worth keeping.
+    RenderPass::RecordCache* const p_record_cache = !is_culled && !global_state->record_cache_vec.empty() ? global_state->record_cache_vec[render_pass_ID].get() : nullptr;
+
+    const RenderPass::RecordCacheKey record_cache_key {
+        .render_pass_generation = global_state->render_pass_generation_vec[render_pass_ID],
+        .indirect_draw_generation = global_state->indirect_draw_buffer->get_frame_generation(frame_resource_idx),
+        .frame_desc_set_generation = global_state->frame_desc_set_generation_vec[frame_resource_idx],
+        .render_area_x = render_area.offset.x,
+        .render_area_y = render_area.offset.y,
+        .render_area_width = render_area.extent.width,
+        .render_area_height = render_area.extent.height,
+    };
+
+    const auto record_phase = [&](const uint32_t occlusion_phase)
+    {
+        const RenderPass::RecordInfo record_info {
+            .frame_idx = frame_resource_idx,
+            .vk_handle_cmd_buff = vk_handle_cmd_buff,
+            .global_attachment_list = global_state->render_attachment_vec,
+            .global_sortbin_list = global_state->sort_bin_vec,
+            .render_area = render_area,
+            .is_extended_dynamic_state = global_state->is_extended_dynamic_state,
+            .vk_handle_geometry_buffer_list = global_state->geometry_buffer->get_vk_handle_buffer_list(),
+            .vk_handle_global_desc_set = global_state->vk_handle_frame_desc_set_vec[frame_resource_idx],
+            .indirect_draw_buffer = is_culled ? *cull_state.indirect_draw_buffer : *global_state->indirect_draw_buffer,
+            .p_visible_draw_lists_list = is_culled ? &cull_state.visible_draw_lists_vec : nullptr,
+            .p_occlusion_culler = p_occlusion_culler,
+            .occlusion_phase = occlusion_phase,
+            .is_resumed = occlusion_phase > 0,
+            .p_worker_pool = global_state->secondary_cmd_pools_vec.empty() ? nullptr : global_state->worker_pool.get(),
+            .p_secondary_cmd_pools = global_state->secondary_cmd_pools_vec.empty() ? nullptr : global_state->secondary_cmd_pools_vec[render_pass_ID].get(),
+            .p_record_cache = p_record_cache,
+            .record_cache_key = record_cache_key,
+        };
+
+        return render_pass.record(record_info);
+    };
+
+    const auto record_start = std::chrono::steady_clock::now();
+
+    if (p_occlusion_culler)
+    {
+        p_occlusion_culler->record_cull(vk_handle_cmd_buff, frame_resource_idx, 0);
+    }
+
+    RenderPass::RecordStats record_stats = record_phase(0);
+
+    if (p_occlusion_culler)
+    {
+        p_occlusion_culler->record_depth_pyramid(vk_handle_cmd_buff, frame_resource_idx);
+
+        if (p_occlusion_culler->is_two_phase())
+        {
+            p_occlusion_culler->record_cull(vk_handle_cmd_buff, frame_resource_idx, 1);
+
+            const RenderPass::RecordStats late_record_stats = record_phase(1);
+            record_stats.draw_command_count += late_record_stats.draw_command_count;
+            record_stats.draw_call_count += late_record_stats.draw_call_count;
+            record_stats.instance_count += late_record_stats.instance_count;
+            record_stats.secondary_cmd_buff_count += late_record_stats.secondary_cmd_buff_count;
+            record_stats.thread_count = std::max(record_stats.thread_count, late_record_stats.thread_count);
+            record_stats.pipeline_bind_count += late_record_stats.pipeline_bind_count;
+        }
+
+        p_occlusion_culler->record_readback(vk_handle_cmd_buff, frame_resource_idx);
+    }
+
+    const auto record_end = std::chrono::steady_clock::now();
+
+    global_state->last_record_stats = {
+        .record_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(record_end - record_start).count()),
+        .draw_command_count = record_stats.draw_command_count,
+        .draw_call_count = record_stats.draw_call_count,
+        .instance_count = record_stats.instance_count,
+        .secondary_cmd_buff_count = record_stats.secondary_cmd_buff_count,
+        .thread_count = record_stats.thread_count,
+        .pipeline_bind_count = record_stats.pipeline_bind_count,
+        .is_replayed = record_stats.is_replayed,
+    };
+}
+
+void cull_render_pass(const std::string& render_pass_name, const float* const view_proj_mat, const uint32_t frame_resource_idx)
+{
+    const auto render_pass_iter = global_state->name_id_lut_render_pass.find(render_pass_name);
+    ASSERT(render_pass_iter != global_state->name_id_lut_render_pass.end(), "cull_render_pass - Render pass %s not found!\n", render_pass_name.c_str());
+
+    const uint16_t render_pass_ID = render_pass_iter->second;
+    const RenderPass& render_pass = global_state->render_pass_vec[render_pass_ID];
+    RendererState::RenderPassCullState& cull_state = global_state->render_pass_cull_state_vec[render_pass_ID];
+
+    if (!cull_state.indirect_draw_buffer)
+    {
+        const uint32_t frame_resource_count = static_cast<uint32_t>(global_state->vk_handle_frame_desc_set_vec.size());
+        cull_state.indirect_draw_buffer = std::make_unique<IndirectDrawBuffer>(static_cast<uint32_t>(global_state->sort_bin_vec.size()), frame_resource_count);
+        cull_state.is_frame_culled_vec.resize(frame_resource_count, false);
+    }
+
+    const std::span<const uint32_t> instance_draw_ID_list = get_instance_draw_ID_list();
+
+    global_state->frustum_culler->cull(view_proj_mat, global_state->sort_bin_vec, render_pass.supported_sortbin_id_list, instance_draw_ID_list, cull_state.visible_draw_lists_vec);
+    global_state->lod_selector->select(view_proj_mat, cull_state.lod_error_scale, render_pass.supported_sortbin_id_list, global_state->mesh_vec, *global_state->frustum_culler, instance_draw_ID_list, cull_state.visible_draw_lists_vec);
+    global_state->draw_sorter->sort(view_proj_mat, cull_state.draw_order, render_pass.supported_sortbin_id_list, *global_state->frustum_culler, instance_draw_ID_list, cull_state.visible_draw_lists_vec);
+
+    // The GPU writes the occlusion culled commands itself.
+    if (cull_state.occlusion_culler)
+    {
+        cull_state.occlusion_culler->set_candidates(frame_resource_idx, view_proj_mat, render_pass.supported_sortbin_id_list, cull_state.visible_draw_lists_vec, *global_state->frustum_culler, instance_draw_ID_list);
+        cull_state.is_frame_culled_vec[frame_resource_idx] = true;
+        return;
+    }
+
+    for (const uint16_t sortbin_ID : render_pass.supported_sortbin_id_list)
+    {
+        const VisibleDrawLists& visible_draw_lists = cull_state.visible_draw_lists_vec[sortbin_ID];
+        cull_state.indirect_draw_buffer->rebuild(sortbin_ID, VK_INDEX_TYPE_UINT32, visible_draw_lists.draw_list_u32);
+        cull_state.indirect_draw_buffer->rebuild(sortbin_ID, VK_INDEX_TYPE_UINT16, visible_draw_lists.draw_list_u16);
+        cull_state.indirect_draw_buffer->rebuild(sortbin_ID, VK_INDEX_TYPE_UINT8_EXT, visible_draw_lists.draw_list_u8);
+        cull_state.indirect_draw_buffer->rebuild(sortbin_ID, VK_INDEX_TYPE_MAX_ENUM, visible_draw_lists.draw_list);
+    }
+
+    cull_state.is_frame_culled_vec[frame_resource_idx] = true;
+}
+
+CullStats get_cull_stats()
+{
+    const FrustumCullStats& stats = global_state->frustum_culler->get_stats();
+    const DrawSortStats& sort_stats = global_state->draw_sorter->get_stats();
+    const LodSelectStats& lod_stats = global_state->lod_selector->get_stats();
+
+    const CullStats cull_stats {
+        .tested_count = stats.tested_count,
+        .instance_count = stats.instance_count,
+        .visible_instance_count = stats.visible_instance_count,
+        .visible_draw_count = stats.visible_draw_count,
+        .test_ns = stats.test_ns,
+        .compact_ns = stats.compact_ns,
+        .sorted_draw_count = sort_stats.draw_count,
+        .sort_ns = sort_stats.key_ns + sort_stats.sort_ns,
+        .lod_instance_count = lod_stats.lod_instance_count,
+        .triangle_count = lod_stats.triangle_count,
+        .full_detail_triangle_count = lod_stats.full_detail_triangle_count,
+        .lod_select_ns = lod_stats.select_ns,
+    };
+
+    return cull_stats;
+}
+
+OcclusionCullStats get_occlusion_cull_stats(const std::string& render_pass_name)
+{
+    const auto render_pass_iter = global_state->name_id_lut_render_pass.find(render_pass_name);
+    ASSERT(render_pass_iter != global_state->name_id_lut_render_pass.end(), "get_occlusion_cull_stats - Render pass %s not found!\n", render_pass_name.c_str());
+
+    const OcclusionCuller* const p_occlusion_culler = global_state->render_pass_cull_state_vec[render_pass_iter->second].occlusion_culler.get();
+
+    if (!p_occlusion_culler)
+    {
+        return {};
+    }
+
+    const OcclusionCullerStats& stats = p_occlusion_culler->get_stats();
+
+    const OcclusionCullStats occlusion_cull_stats {
+        .candidate_count = stats.candidate_count,
+        .early_visible_count = stats.early_visible_count,
+        .late_visible_count = stats.late_visible_count,
+        .pyramid_width = stats.pyramid_width,
+        .pyramid_height = stats.pyramid_height,
+        .pyramid_level_count = stats.pyramid_level_count,
+    };
+
+    return occlusion_cull_stats;
+}
+
+MeshOptimizeStats get_mesh_optimize_stats()
+{
+    const RendererState::MeshOptimizeStats& stats = global_state->last_mesh_optimize_stats;
+
+    const MeshOptimizeStats mesh_optimize_stats {
+        .acmr_before = stats.acmr_before,
+        .acmr_after = stats.acmr_after,
+        .overdraw_cluster_count = stats.overdraw_cluster_count,
+        .index_stride_before = stats.index_stride_before,
+        .index_stride_after = stats.index_stride_after,
+        .index_byte_count_before = stats.index_byte_count_before,
+        .index_byte_count_after = stats.index_byte_count_after,
+        .vertex_byte_count_before = stats.vertex_byte_count_before,
+        .vertex_byte_count_after = stats.vertex_byte_count_after,
+        .optimize_ns = stats.optimize_ns,
+        .lod_count = stats.lod_count,
+        .coarsest_lod_index_count = stats.coarsest_lod_index_count,
+        .coarsest_lod_error = stats.coarsest_lod_error,
+        .lod_index_byte_count = stats.lod_index_byte_count,
+        .lod_ns = stats.lod_ns,
     };
 
-    const VkBuffer vk_handle_geometry_buffer = global_state->geometry_buffer->get_vk_handle_buffer();
-    const VkDeviceSize offset = 0;
-    vkCmdBindVertexBuffers(vk_handle_cmd_buff, 0, 1, &vk_handle_geometry_buffer, &offset);
+    return mesh_optimize_stats;
+}
+
+RecordStats get_record_stats()
+{
+    const RendererState::RecordStats& stats = global_state->last_record_stats;
+
+    const RecordStats record_stats {
+        .record_ns = stats.record_ns,
+        .draw_command_count = stats.draw_command_count,
+        .draw_call_count = stats.draw_call_count,
+        .instance_count = stats.instance_count,
+        .secondary_command_buffer_count = stats.secondary_cmd_buff_count,
+        .thread_count = stats.thread_count,
+        .pipeline_bind_count = stats.pipeline_bind_count,
+        .is_replayed = stats.is_replayed,
+    };
 
-    render_pass.record(record_info);
+    return record_stats;
 }
 
 VkImage get_attachment_image(const uint32_t attachment_id, const uint32_t frame_resource_idx)
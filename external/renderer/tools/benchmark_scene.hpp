@@ -0,0 +1,147 @@
+#ifndef RENDERER_BENCHMARK_SCENE_HPP
+#define RENDERER_BENCHMARK_SCENE_HPP
+
+// Synthetic scenes shared by the CPU-only benchmark tools: a sortbin without Vulkan objects whose draw list holds
+// instanced draws of consecutive instance slots, an instance table mapping slot i to draw ID i, the world boxes of
+// those draw IDs and a camera looking into them.
+
+#include "internal/pod/BoundingBox.hpp"
+#include "internal/pod/DrawInfo.hpp"
+#include "internal/pod/SortBin.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace benchmark_scene
+{
+    struct SceneInfo
+    {
+        uint32_t object_count; // draw IDs [0, object_count)
+        uint32_t instances_per_draw; // consecutive instance slots drawn by one instanced draw, as renderables of one mesh
+        uint32_t mesh_count;
+        uint32_t geometry_block_count;
+        float    half_size; // objects are scattered over [-half_size, half_size]^3
+        uint32_t seed;
+    };
+
+    // vk_handle_pipeline only tells sortbins apart when recording, it is never dereferenced.
+    inline SortBin create_sortbin(const std::string& name, const VkPipeline vk_handle_pipeline = VK_NULL_HANDLE)
+    {
+        return SortBin {
+            .name = name,
+            .descriptor_variable_material_umap = {},
+            .descriptor_variable_draw_umap = {},
+            .material_data_block_size = 16,
+            .material_data_block_end_padding_size = 0,
+            .draw_data_block_size = 80,
+            .draw_data_block_end_padding_size = 12,
+            .draw_model_mat_offset = 0,
+            .vk_handle_pipeline = vk_handle_pipeline,
+            .vk_handle_pipeline_layout = VK_NULL_HANDLE,
+            .vk_handle_desc_set = VK_NULL_HANDLE,
+            .is_pipeline_owner = false,
+            .compatible_sort_bin_set_ID = 0,
+            .vertex_stride = 12,
+            .vertex_pos_attribute = { .location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = 0 },
+            .vertex_attribute_list = {},
+            .dynamic_state = {},
+        };
+    }
+
+    // Column major translation * uniform scale of every object, 16 floats each.
+    inline std::vector<float> create_model_mat_list(const SceneInfo& info)
+    {
+        std::mt19937 rng(info.seed);
+        std::uniform_real_distribution<float> position_dist(-info.half_size, info.half_size);
+        std::uniform_real_distribution<float> scale_dist(0.5f, 4.0f);
+
+        std::vector<float> model_mat_list(static_cast<size_t>(info.object_count) * 16, 0.0f);
+
+        for (uint32_t object_idx = 0; object_idx < info.object_count; object_idx++)
+        {
+            float* const model_mat = model_mat_list.data() + static_cast<size_t>(object_idx) * 16;
+            const float scale = scale_dist(rng);
+
+            model_mat[0] = scale;
+            model_mat[5] = scale;
+            model_mat[10] = scale;
+            model_mat[12] = position_dist(rng);
+            model_mat[13] = position_dist(rng);
+            model_mat[14] = position_dist(rng);
+            model_mat[15] = 1.0f;
+        }
+
+        return model_mat_list;
+    }
+
+    // Instance table of the slots fill_draw_list covers, slot i holding draw ID i.
+    inline std::vector<uint32_t> create_instance_draw_ID_list(const uint32_t object_count)
+    {
+        std::vector<uint32_t> instance_draw_ID_list(object_count);
+
+        for (uint32_t slot = 0; slot < object_count; slot++)
+        {
+            instance_draw_ID_list[slot] = slot;
+        }
+
+        return instance_draw_ID_list;
+    }
+
+    // Unit box around the origin, the object space bounds of every mesh.
+    inline BoundingBox get_object_bounds()
+    {
+        return BoundingBox { .center = { 0.0f, 0.0f, 0.0f }, .extent = { 0.5f, 0.5f, 0.5f } };
+    }
+
+    // Instanced indexed draws covering instance slots [0, object_count), appended to draw_list.
+    inline void fill_draw_list(const SceneInfo& info, std::vector<DrawInfo>& draw_list)
+    {
+        std::mt19937 rng(info.seed ^ 0x9E3779B9u);
+
+        for (uint32_t first_draw_ID = 0; first_draw_ID < info.object_count; first_draw_ID += info.instances_per_draw)
+        {
+            const uint32_t mesh_ID = rng() % info.mesh_count;
+
+            draw_list.push_back({
+                .index_count = 36,
+                .vertex_count = 8,
+                .instance_count = std::min(info.instances_per_draw, info.object_count - first_draw_ID),
+                .first_index = mesh_ID * 36,
+                .first_vertex = 0,
+                .vertex_offset = static_cast<int32_t>(mesh_ID * 8),
+                .first_instance = first_draw_ID,
+                .mesh_id = mesh_ID,
+                .geometry_block_id = mesh_ID % info.geometry_block_count,
+            });
+        }
+    }
+
+    // Perspective (60 degrees, square, Vulkan clip z in [0, 1]) of a camera at the origin looking down -z.
+    inline void get_view_proj_mat(const float far_plane, float (&view_proj_mat)[16])
+    {
+        const float near_plane = 0.1f;
+        const float f = 1.0f / std::tan(0.5f * 60.0f * 3.14159265f / 180.0f);
+
+        for (float& element : view_proj_mat)
+        {
+            element = 0.0f;
+        }
+
+        view_proj_mat[0] = f;
+        view_proj_mat[5] = f;
+        view_proj_mat[10] = far_plane / (near_plane - far_plane);
+        view_proj_mat[11] = -1.0f;
+        view_proj_mat[14] = -(far_plane * near_plane) / (far_plane - near_plane);
+    }
+
+    inline double get_elapsed_ms(const std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) * 1e-6;
+    }
+}; // benchmark_scene
+
+#endif // RENDERER_BENCHMARK_SCENE_HPP
@@ -0,0 +1,206 @@
+// Records the draws of synthetic sortbins with RenderPass::record(), once straight into the primary on the calling
+// thread and once split into secondaries on a WorkerPool of 1 .. max threads, see RenderPass::RecordInfo. Built with
+// VK_CORE_HOST_STUB, whose vkCmd* are no-ops, so the times are the renderer's share of recording without the driver's
+// encoding. The stub device has no multiDrawIndirect, so every draw is its own vkCmdDraw* call, the path whose cost
+// scales with the draw count. The draw call and instance counts of every recording are checked against the draw lists.
+//
+// renderer_draw_record_benchmark [max draw count, 100000] [max thread count, 16] [iterations, 10] [sortbin count, 16]
+
+#include "benchmark_scene.hpp"
+
+#include "RenderPass.hpp"
+#include "internal/buffers/StagingBuffer.hpp"
+#include "internal/misc/SecondaryCommandPools.hpp"
+#include "internal/misc/WorkerPool.hpp"
+#include "internal/visibility/OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Referenced by RenderPass and IndirectDrawBuffer, never reached without an occlusion culler or a queue_uploads() call.
+IndirectDrawStream OcclusionCuller::get_stream(const uint16_t, const VkIndexType, const uint32_t, const uint32_t) const
+{
+    return {};
+}
+
+void StagingBuffer::queue_upload(const VkBuffer, const VkDeviceSize, const VkDeviceSize, const void* const)
+{
+}
+
+struct RecordResult
+{
+    double best_ms = 1e30;
+    RenderPass::RecordStats record_stats {};
+};
+
+static RecordResult run_record(const RenderPass& render_pass,
+    const std::vector<SortBin>& sortbin_list,
+    const std::vector<VkBuffer>& vk_handle_geometry_buffer_list,
+    const IndirectDrawBuffer& indirect_draw_buffer,
+    const VkCommandBuffer vk_handle_primary_cmd_buff,
+    WorkerPool* const p_worker_pool,
+    SecondaryCommandPools* const p_secondary_cmd_pools,
+    const uint32_t iteration_count)
+{
+    const VkCommandBufferBeginInfo cmd_buff_begin_info {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr,
+    };
+
+    const RenderPass::RecordInfo record_info {
+        .frame_idx = 0,
+        .vk_handle_cmd_buff = vk_handle_primary_cmd_buff,
+        .global_attachment_list = {},
+        .global_sortbin_list = sortbin_list,
+        .render_area = { .offset = { 0, 0 }, .extent = { 1920, 1080 } },
+        .is_extended_dynamic_state = true,
+        .vk_handle_geometry_buffer_list = vk_handle_geometry_buffer_list,
+        .vk_handle_global_desc_set = VK_NULL_HANDLE,
+        .indirect_draw_buffer = indirect_draw_buffer,
+        .p_visible_draw_lists_list = nullptr,
+        .p_occlusion_culler = nullptr,
+        .occlusion_phase = 0,
+        .is_resumed = false,
+        .p_worker_pool = p_worker_pool,
+        .p_secondary_cmd_pools = p_secondary_cmd_pools,
+        .p_record_cache = nullptr,
+        .record_cache_key = {},
+    };
+
+    RecordResult result {};
+
+    for (uint32_t iteration = 0; iteration < iteration_count; iteration++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        vkBeginCommandBuffer(vk_handle_primary_cmd_buff, &cmd_buff_begin_info);
+        result.record_stats = render_pass.record(record_info);
+        vkEndCommandBuffer(vk_handle_primary_cmd_buff);
+
+        result.best_ms = std::min(result.best_ms, benchmark_scene::get_elapsed_ms(start));
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t max_draw_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+    const uint32_t max_thread_count = argc > 2 ? std::max(static_cast<uint32_t>(atoi(argv[2])), 1u) : 16;
+    const uint32_t iteration_count = argc > 3 ? std::max(static_cast<uint32_t>(atoi(argv[3])), 1u) : 10;
+    const uint32_t sortbin_count = argc > 4 ? std::clamp(static_cast<uint32_t>(atoi(argv[4])), 1u, static_cast<uint32_t>(UINT16_MAX)) : 16;
+
+    // Sortbins pair up on pipelines, as sortbins only differing in dynamic state do.
+    std::vector<SortBin> sortbin_list;
+    std::vector<uint16_t> sortbin_id_list;
+
+    for (uint32_t sortbin_idx = 0; sortbin_idx < sortbin_count; sortbin_idx++)
+    {
+        sortbin_list.push_back(benchmark_scene::create_sortbin("sortbin_" + std::to_string(sortbin_idx), reinterpret_cast<VkPipeline>(static_cast<uintptr_t>(sortbin_idx / 2 + 1))));
+        sortbin_id_list.push_back(static_cast<uint16_t>(sortbin_idx));
+    }
+
+    const RenderPass render_pass({
+        .frame_resource_count = 1,
+        .supported_sortbin_id_list = sortbin_id_list,
+        .read_attachment_pass_info_list = {},
+        .write_color_attachment_pass_info_list = {},
+        .write_depth_attachment_pass_info = std::nullopt,
+    });
+
+    const IndirectDrawBuffer indirect_draw_buffer(sortbin_count, 1);
+
+    const uint32_t geometry_block_count = 8;
+    std::vector<VkBuffer> vk_handle_geometry_buffer_list;
+
+    for (uint32_t block_idx = 0; block_idx < geometry_block_count; block_idx++)
+    {
+        vk_handle_geometry_buffer_list.push_back(reinterpret_cast<VkBuffer>(static_cast<uintptr_t>(block_idx + 1)));
+    }
+
+    const VkCommandPool vk_handle_primary_cmd_pool = vk_core::create_command_pool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    const VkCommandBuffer vk_handle_primary_cmd_buff = vk_core::allocate_command_buffer(vk_handle_primary_cmd_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+    printf("%u sortbins, %u iterations, best ms\n", sortbin_count, iteration_count);
+    printf("   draws  threads  secondaries  threads used  draw calls  pipeline binds        ms  speedup\n");
+
+    bool is_valid = true;
+
+    for (uint32_t draw_count = 1000; draw_count <= max_draw_count; draw_count *= 10)
+    {
+        const benchmark_scene::SceneInfo scene_info {
+            .object_count = draw_count,
+            .instances_per_draw = 1,
+            .mesh_count = 4096,
+            .geometry_block_count = geometry_block_count,
+            .half_size = 500.0f,
+            .seed = draw_count,
+        };
+
+        std::vector<DrawInfo> draw_list;
+        benchmark_scene::fill_draw_list(scene_info, draw_list);
+
+        uint32_t instance_count = 0;
+
+        for (SortBin& sortbin : sortbin_list)
+        {
+            sortbin.draw_list_u32.clear();
+        }
+
+        for (uint32_t draw_idx = 0; draw_idx < draw_count; draw_idx++)
+        {
+            sortbin_list[draw_idx % sortbin_count].draw_list_u32.push_back(draw_list[draw_idx]);
+            instance_count += draw_list[draw_idx].instance_count;
+        }
+
+        // Draws of a sortbin are recorded in state order, one vertex / index buffer bind per geometry block.
+        for (SortBin& sortbin : sortbin_list)
+        {
+            std::stable_sort(sortbin.draw_list_u32.begin(), sortbin.draw_list_u32.end(), [](const DrawInfo& lhs, const DrawInfo& rhs) {
+                return lhs.geometry_block_id < rhs.geometry_block_id;
+            });
+        }
+
+        const auto print_result = [&](const uint32_t thread_count, const RecordResult& result, const double primary_ms)
+        {
+            printf("%8u  %7u  %11u  %12u  %10u  %14u  %8.3f  %7.2f\n",
+                draw_count, thread_count, result.record_stats.secondary_cmd_buff_count, result.record_stats.thread_count,
+                result.record_stats.draw_call_count, result.record_stats.pipeline_bind_count, result.best_ms, primary_ms / result.best_ms);
+
+            is_valid = is_valid && result.record_stats.draw_call_count == draw_count && result.record_stats.instance_count == instance_count;
+        };
+
+        // Single threaded, straight into the primary.
+        const RecordResult primary_result = run_record(render_pass, sortbin_list, vk_handle_geometry_buffer_list, indirect_draw_buffer,
+            vk_handle_primary_cmd_buff, nullptr, nullptr, iteration_count);
+
+        print_result(0, primary_result, primary_result.best_ms);
+
+        for (uint32_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+        {
+            WorkerPool worker_pool(thread_count);
+            SecondaryCommandPools secondary_cmd_pools(1, thread_count);
+
+            const RecordResult result = run_record(render_pass, sortbin_list, vk_handle_geometry_buffer_list, indirect_draw_buffer,
+                vk_handle_primary_cmd_buff, &worker_pool, &secondary_cmd_pools, iteration_count);
+
+            print_result(thread_count, result, primary_result.best_ms);
+        }
+    }
+
+    vk_core::destroy_command_pool(vk_handle_primary_cmd_pool);
+
+    printf("threads 0 records into the primary on the calling thread\n");
+
+    if (!is_valid)
+    {
+        printf("MISMATCH: recorded draw call / instance counts differ from the draw lists\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Sorts synthetic draw lists of growing size into state order with DrawSorter's radix sort and with std::sort /
+// std::stable_sort by (geometry block, mesh ID), see internal/visibility/DrawSorter.hpp. The radix sort is stable,
+// so its output must match std::stable_sort draw for draw. Radix times are of the whole DrawSorter::sort, which also
+// builds the keys and gathers / writes back the draw lists.
+//
+// renderer_draw_sort_benchmark [max draw count, 1000000] [thread count, 0 = hardware] [iterations, 10] [mesh count, 4096]
+
+#include "benchmark_scene.hpp"
+
+#include "internal/misc/WorkerPool.hpp"
+#include "internal/visibility/DrawSorter.hpp"
+#include "internal/visibility/FrustumCuller.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool is_state_ordered(const DrawInfo& lhs, const DrawInfo& rhs)
+{
+    return lhs.geometry_block_id != rhs.geometry_block_id ? lhs.geometry_block_id < rhs.geometry_block_id : lhs.mesh_id < rhs.mesh_id;
+}
+
+static bool is_same_draw(const DrawInfo& lhs, const DrawInfo& rhs)
+{
+    return lhs.first_instance == rhs.first_instance && lhs.mesh_id == rhs.mesh_id && lhs.geometry_block_id == rhs.geometry_block_id;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t max_draw_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+    const uint32_t thread_count = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 0;
+    const uint32_t iteration_count = argc > 3 ? std::max(static_cast<uint32_t>(atoi(argv[3])), 1u) : 10;
+    const uint32_t mesh_count = argc > 4 ? std::max(static_cast<uint32_t>(atoi(argv[4])), 1u) : 4096;
+
+    WorkerPool worker_pool(thread_count);
+    FrustumCuller frustum_culler(worker_pool); // state order never reads the bounds
+    DrawSorter draw_sorter(worker_pool);
+
+    float view_proj_mat[16];
+    benchmark_scene::get_view_proj_mat(500.0f, view_proj_mat);
+
+    const std::vector<uint16_t> sortbin_ID_list = { 0 };
+
+    printf("%u threads, %u meshes, %u iterations, best ms\n", worker_pool.get_worker_count(), mesh_count, iteration_count);
+    printf("   draws      radix  radix passes   std::sort  std::stable_sort\n");
+
+    bool is_matching = true;
+
+    for (uint32_t draw_count = 1000; draw_count <= max_draw_count; draw_count *= 10)
+    {
+        const benchmark_scene::SceneInfo scene_info {
+            .object_count = draw_count,
+            .instances_per_draw = 1,
+            .mesh_count = mesh_count,
+            .geometry_block_count = 8,
+            .half_size = 500.0f,
+            .seed = draw_count,
+        };
+
+        std::vector<DrawInfo> input_draw_list;
+        benchmark_scene::fill_draw_list(scene_info, input_draw_list);
+        const std::vector<uint32_t> instance_draw_ID_list = benchmark_scene::create_instance_draw_ID_list(draw_count);
+
+        std::vector<VisibleDrawLists> visible_draw_lists_list(1);
+        std::vector<DrawInfo> reference_draw_list;
+
+        double best_radix_ms = 1e30;
+        double best_sort_ms = 1e30;
+        double best_stable_sort_ms = 1e30;
+
+        for (uint32_t iteration = 0; iteration < iteration_count; iteration++)
+        {
+            visible_draw_lists_list[0].draw_list_u32 = input_draw_list;
+
+            auto start = std::chrono::steady_clock::now();
+            draw_sorter.sort(view_proj_mat, DrawOrder::eState, sortbin_ID_list, frustum_culler, instance_draw_ID_list, visible_draw_lists_list);
+            best_radix_ms = std::min(best_radix_ms, benchmark_scene::get_elapsed_ms(start));
+
+            reference_draw_list = input_draw_list;
+
+            start = std::chrono::steady_clock::now();
+            std::sort(reference_draw_list.begin(), reference_draw_list.end(), is_state_ordered);
+            best_sort_ms = std::min(best_sort_ms, benchmark_scene::get_elapsed_ms(start));
+
+            reference_draw_list = input_draw_list;
+
+            start = std::chrono::steady_clock::now();
+            std::stable_sort(reference_draw_list.begin(), reference_draw_list.end(), is_state_ordered);
+            best_stable_sort_ms = std::min(best_stable_sort_ms, benchmark_scene::get_elapsed_ms(start));
+        }
+
+        const std::vector<DrawInfo>& sorted_draw_list = visible_draw_lists_list[0].draw_list_u32;
+        const bool is_match = std::equal(sorted_draw_list.begin(), sorted_draw_list.end(), reference_draw_list.begin(), reference_draw_list.end(), is_same_draw);
+
+        printf("%8u  %9.3f  %12u  %10.3f  %16.3f%s\n",
+            draw_count, best_radix_ms, draw_sorter.get_stats().radix_pass_count, best_sort_ms, best_stable_sort_ms, is_match ? "" : "  MISMATCH");
+
+        is_matching = is_matching && is_match;
+    }
+
+    return is_matching ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Culls a synthetic scene of unit boxes scattered around a camera with FrustumCuller at 1, 2, 4, ... worker threads
+// and reports the test / compaction times of each, see internal/visibility/FrustumCuller.hpp. Every thread count must
+// produce the same visible instances and draws.
+//
+// renderer_frustum_cull_benchmark [object count, 1000000] [max thread count, 16] [iterations, 20] [instances per draw, 1]
+
+#include "benchmark_scene.hpp"
+
+#include "internal/misc/WorkerPool.hpp"
+#include "internal/visibility/FrustumCuller.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    const uint32_t object_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+    const uint32_t max_thread_count = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 16;
+    const uint32_t iteration_count = argc > 3 ? std::max(static_cast<uint32_t>(atoi(argv[3])), 1u) : 20;
+    const uint32_t instances_per_draw = argc > 4 ? std::max(static_cast<uint32_t>(atoi(argv[4])), 1u) : 1;
+
+    const benchmark_scene::SceneInfo scene_info {
+        .object_count = object_count,
+        .instances_per_draw = instances_per_draw,
+        .mesh_count = 256,
+        .geometry_block_count = 4,
+        .half_size = 500.0f,
+        .seed = 1,
+    };
+
+    std::vector<SortBin> sortbin_list;
+    sortbin_list.push_back(benchmark_scene::create_sortbin("benchmark"));
+    benchmark_scene::fill_draw_list(scene_info, sortbin_list[0].draw_list_u32);
+
+    const std::vector<uint16_t> sortbin_ID_list = { 0 };
+    const std::vector<uint32_t> instance_draw_ID_list = benchmark_scene::create_instance_draw_ID_list(object_count);
+    const std::vector<float> model_mat_list = benchmark_scene::create_model_mat_list(scene_info);
+    const BoundingBox object_bounds = benchmark_scene::get_object_bounds();
+
+    float view_proj_mat[16];
+    benchmark_scene::get_view_proj_mat(scene_info.half_size, view_proj_mat);
+
+    printf("%u objects, %zu draws, %u iterations, %u hardware threads\n",
+        object_count, sortbin_list[0].draw_list_u32.size(), iteration_count, std::thread::hardware_concurrency());
+    printf("threads  test best / mean ms  compact best / mean ms  visible instances  visible draws\n");
+
+    uint32_t reference_visible_instance_count = UINT32_MAX;
+    uint32_t reference_visible_draw_count = UINT32_MAX;
+    bool is_consistent = true;
+
+    for (uint32_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+    {
+        WorkerPool worker_pool(thread_count);
+        FrustumCuller frustum_culler(worker_pool);
+
+        for (uint32_t object_idx = 0; object_idx < object_count; object_idx++)
+        {
+            frustum_culler.set_bounds(object_idx, object_bounds, model_mat_list.data() + static_cast<size_t>(object_idx) * 16);
+        }
+
+        std::vector<VisibleDrawLists> visible_draw_lists_list(sortbin_list.size());
+
+        // Warm up, sizes the visibility and compaction scratch.
+        frustum_culler.cull(view_proj_mat, sortbin_list, sortbin_ID_list, instance_draw_ID_list, visible_draw_lists_list);
+
+        uint64_t best_test_ns = UINT64_MAX;
+        uint64_t best_compact_ns = UINT64_MAX;
+        uint64_t total_test_ns = 0;
+        uint64_t total_compact_ns = 0;
+
+        for (uint32_t iteration = 0; iteration < iteration_count; iteration++)
+        {
+            frustum_culler.cull(view_proj_mat, sortbin_list, sortbin_ID_list, instance_draw_ID_list, visible_draw_lists_list);
+
+            const FrustumCullStats& stats = frustum_culler.get_stats();
+
+            best_test_ns = std::min(best_test_ns, stats.test_ns);
+            best_compact_ns = std::min(best_compact_ns, stats.compact_ns);
+            total_test_ns += stats.test_ns;
+            total_compact_ns += stats.compact_ns;
+        }
+
+        const FrustumCullStats& stats = frustum_culler.get_stats();
+
+        printf("%7u  %8.3f / %8.3f     %8.3f / %8.3f        %10u     %10u\n",
+            worker_pool.get_worker_count(),
+            static_cast<double>(best_test_ns) * 1e-6, static_cast<double>(total_test_ns) * 1e-6 / iteration_count,
+            static_cast<double>(best_compact_ns) * 1e-6, static_cast<double>(total_compact_ns) * 1e-6 / iteration_count,
+            stats.visible_instance_count, stats.visible_draw_count);
+
+        if (reference_visible_instance_count == UINT32_MAX)
+        {
+            reference_visible_instance_count = stats.visible_instance_count;
+            reference_visible_draw_count = stats.visible_draw_count;
+        }
+        else if (stats.visible_instance_count != reference_visible_instance_count || stats.visible_draw_count != reference_visible_draw_count)
+        {
+            is_consistent = false;
+        }
+    }
+
+    if (!is_consistent)
+    {
+        printf("MISMATCH: visible counts differ between thread counts\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Churns a GeometryBuffer: fills it with meshes of random size and layout, then every frame frees a share of them at
+// random, allocates as many new ones and defragments within a byte budget, see internal/buffers/GeometryBuffer.hpp.
+// Runs once without and once with defragmentation and reports timings and fragmentation. Live ranges are checked for
+// alignment and overlap after every frame, with the moves reported by defragment() applied.
+//
+// renderer_geometry_heap_benchmark [mesh count, 20000] [frames, 200] [churn percent per frame, 2] [defragment MiB per frame, 4]
+
+#include "internal/buffers/GeometryBuffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct MeshEntry
+{
+    uint32_t vertex_stride;
+    uint32_t index_stride;
+    GeometryAllocation vertex_allocation;
+    GeometryAllocation index_allocation;
+};
+
+static double get_elapsed_ms(const std::chrono::steady_clock::time_point start)
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) * 1e-6;
+}
+
+static void allocate_mesh(GeometryBuffer& geometry_buffer, std::mt19937& rng, const uint32_t owner_id, MeshEntry& mesh_entry)
+{
+    static constexpr uint32_t s_vertex_stride_list[] = { 8, 12, 16, 20, 24, 32, 48 };
+
+    // Vertex counts spread over 64 .. 16k, log uniform, about 1.5 indices per vertex.
+    const uint32_t vertex_count = 64u << (rng() % 9) | (rng() % 64);
+    const uint32_t index_count = rng() % 8 == 0 ? 0 : (vertex_count * 3 / 2 / 3) * 3;
+
+    mesh_entry.vertex_stride = s_vertex_stride_list[rng() % 7];
+    mesh_entry.index_stride = rng() % 2 == 0 ? 2 : 4;
+
+    geometry_buffer.allocate_mesh(owner_id,
+        mesh_entry.vertex_stride, static_cast<VkDeviceSize>(vertex_count) * mesh_entry.vertex_stride,
+        mesh_entry.index_stride, static_cast<VkDeviceSize>(index_count) * mesh_entry.index_stride,
+        mesh_entry.vertex_allocation, mesh_entry.index_allocation);
+}
+
+static bool is_heap_valid(const std::vector<MeshEntry>& mesh_entry_list)
+{
+    struct Range
+    {
+        uint32_t block_id;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    std::vector<Range> range_list;
+
+    for (const MeshEntry& mesh_entry : mesh_entry_list)
+    {
+        if (mesh_entry.vertex_allocation.offset % mesh_entry.vertex_stride != 0 || mesh_entry.index_allocation.offset % mesh_entry.index_stride != 0)
+        {
+            return false;
+        }
+
+        if (mesh_entry.index_allocation.size != 0 && mesh_entry.index_allocation.block_id != mesh_entry.vertex_allocation.block_id)
+        {
+            return false;
+        }
+
+        range_list.push_back({ mesh_entry.vertex_allocation.block_id, mesh_entry.vertex_allocation.offset, mesh_entry.vertex_allocation.size });
+
+        if (mesh_entry.index_allocation.size != 0)
+        {
+            range_list.push_back({ mesh_entry.index_allocation.block_id, mesh_entry.index_allocation.offset, mesh_entry.index_allocation.size });
+        }
+    }
+
+    std::sort(range_list.begin(), range_list.end(), [](const Range& lhs, const Range& rhs) {
+        return lhs.block_id != rhs.block_id ? lhs.block_id < rhs.block_id : lhs.offset < rhs.offset;
+    });
+
+    for (uint32_t range_idx = 1; range_idx < range_list.size(); range_idx++)
+    {
+        const Range& prev_range = range_list[range_idx - 1];
+        const Range& range = range_list[range_idx];
+
+        if (prev_range.block_id == range.block_id && prev_range.offset + prev_range.size > range.offset)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t mesh_count = argc > 1 ? std::max(static_cast<uint32_t>(atoi(argv[1])), 1u) : 20000;
+    const uint32_t frame_count = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 200;
+    const uint32_t churn_percent = argc > 3 ? std::min(static_cast<uint32_t>(atoi(argv[3])), 100u) : 2;
+    const VkDeviceSize defragment_budget = (argc > 4 ? static_cast<VkDeviceSize>(atoi(argv[4])) : 4) << 20;
+
+    const uint32_t churn_count = std::max(mesh_count * churn_percent / 100, 1u);
+
+    printf("%u meshes, %u frames, %u meshes replaced per frame\n", mesh_count, frame_count, churn_count);
+    printf("defrag MiB  fill ms  alloc us  free ms  defrag ms  moved MiB  blocks  used MiB  free MiB  free ranges  largest free MiB\n");
+
+    bool is_valid = true;
+
+    for (const VkDeviceSize max_move_byte_count : { VkDeviceSize { 0 }, defragment_budget })
+    {
+        GeometryBuffer geometry_buffer(64 << 20, 2);
+        std::vector<MeshEntry> mesh_entry_list(mesh_count);
+        std::mt19937 rng(1);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t mesh_idx = 0; mesh_idx < mesh_count; mesh_idx++)
+        {
+            allocate_mesh(geometry_buffer, rng, mesh_idx, mesh_entry_list[mesh_idx]);
+        }
+
+        const double fill_ms = get_elapsed_ms(start);
+        geometry_buffer.advance_frame();
+
+        double free_ms = 0.0;
+        double defragment_ms = 0.0;
+
+        for (uint32_t frame = 0; frame < frame_count; frame++)
+        {
+            // Owner ids double as mesh_entry_list indices, a replaced mesh reuses its slot.
+            std::vector<uint32_t> replaced_idx_list(churn_count);
+
+            for (uint32_t& mesh_idx : replaced_idx_list)
+            {
+                mesh_idx = rng() % mesh_count;
+            }
+
+            std::sort(replaced_idx_list.begin(), replaced_idx_list.end());
+            replaced_idx_list.erase(std::unique(replaced_idx_list.begin(), replaced_idx_list.end()), replaced_idx_list.end());
+
+            start = std::chrono::steady_clock::now();
+
+            for (const uint32_t mesh_idx : replaced_idx_list)
+            {
+                geometry_buffer.free(mesh_entry_list[mesh_idx].vertex_allocation);
+                geometry_buffer.free(mesh_entry_list[mesh_idx].index_allocation);
+            }
+
+            free_ms += get_elapsed_ms(start);
+
+            for (const uint32_t mesh_idx : replaced_idx_list)
+            {
+                allocate_mesh(geometry_buffer, rng, mesh_idx, mesh_entry_list[mesh_idx]);
+            }
+
+            if (max_move_byte_count > 0)
+            {
+                start = std::chrono::steady_clock::now();
+                const std::vector<GeometryMove> move_list = geometry_buffer.defragment(VK_NULL_HANDLE, max_move_byte_count);
+                defragment_ms += get_elapsed_ms(start);
+
+                for (const GeometryMove& move : move_list)
+                {
+                    MeshEntry& mesh_entry = mesh_entry_list[move.owner_id];
+                    GeometryAllocation& allocation = mesh_entry.vertex_allocation.offset == move.src_offset && mesh_entry.vertex_allocation.size == move.size ?
+                        mesh_entry.vertex_allocation : mesh_entry.index_allocation;
+
+                    allocation.offset = move.dst_offset;
+                }
+            }
+
+            geometry_buffer.advance_frame();
+
+            is_valid = is_valid && is_heap_valid(mesh_entry_list);
+        }
+
+        // Let the last frees retire before measuring fragmentation.
+        geometry_buffer.advance_frame();
+        geometry_buffer.advance_frame();
+
+        const GeometryHeapStats stats = geometry_buffer.get_stats();
+        const double mib = 1.0 / (1 << 20);
+
+        printf("%10.1f  %7.2f  %8.3f  %7.2f  %9.2f  %9.1f  %6u  %8.1f  %8.1f  %11u  %16.2f\n",
+            static_cast<double>(max_move_byte_count) * mib, fill_ms,
+            static_cast<double>(stats.total_allocation_ns) * 1e-3 / static_cast<double>(std::max<uint64_t>(stats.allocation_count, 1)),
+            free_ms, defragment_ms, static_cast<double>(stats.moved_byte_count) * mib, stats.block_count,
+            static_cast<double>(stats.used_byte_count) * mib, static_cast<double>(stats.free_byte_count) * mib,
+            stats.free_range_count, static_cast<double>(stats.largest_free_range) * mib);
+    }
+
+    if (!is_valid)
+    {
+        printf("MISMATCH: live ranges overlap, are misaligned or split across blocks\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Builds the indirect draw streams of synthetic sortbins with IndirectDrawBuffer: draw by draw through append() and
+// whole streams through rebuild(), followed by instance count updates of a share of the commands, each followed by
+// queue_uploads(), see internal/buffers/IndirectDrawBuffer.hpp. Every stream's uploaded command / instance counts
+// and geometry block runs are checked against its draw list.
+//
+// renderer_indirect_build_benchmark [max draw count, 100000] [sortbin count, 16] [iterations, 10] [updated percent, 1]
+
+#include "benchmark_scene.hpp"
+
+#include "internal/buffers/IndirectDrawBuffer.hpp"
+#include "internal/buffers/StagingBuffer.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+// IndirectDrawBuffer only queues uploads, so these host-only definitions stand in for StagingBuffer.cpp and count
+// what would be staged.
+static uint64_t s_upload_count = 0;
+static uint64_t s_upload_byte_count = 0;
+
+StagingBuffer::StagingBuffer(const VkDeviceSize region_size, const uint32_t)
+    : m_region_size { region_size }
+{
+}
+
+StagingBuffer::~StagingBuffer()
+{
+}
+
+void StagingBuffer::queue_upload(const VkBuffer, const VkDeviceSize, const VkDeviceSize upload_size, const void* const)
+{
+    s_upload_count++;
+    s_upload_byte_count += upload_size;
+}
+
+static bool is_stream_valid(const IndirectDrawStream& stream, const std::vector<DrawInfo>& draw_list)
+{
+    uint32_t instance_count = 0;
+    uint32_t run_count = 0;
+
+    for (uint32_t draw_idx = 0; draw_idx < draw_list.size(); draw_idx++)
+    {
+        instance_count += draw_list[draw_idx].instance_count;
+        run_count += draw_idx == 0 || draw_list[draw_idx].geometry_block_id != draw_list[draw_idx - 1].geometry_block_id;
+    }
+
+    bool is_valid = stream.command_count == draw_list.size() && stream.instance_count == instance_count && stream.p_run_list->size() == run_count;
+    uint32_t next_command = 0;
+
+    for (const IndirectDrawRun& run : *stream.p_run_list)
+    {
+        is_valid = is_valid && run.first_command == next_command && draw_list[run.first_command].geometry_block_id == run.geometry_block_id;
+        next_command += run.command_count;
+    }
+
+    return is_valid && next_command == draw_list.size();
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t max_draw_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+    const uint32_t sortbin_count = argc > 2 ? std::max(static_cast<uint32_t>(atoi(argv[2])), 1u) : 16;
+    const uint32_t iteration_count = argc > 3 ? std::max(static_cast<uint32_t>(atoi(argv[3])), 1u) : 10;
+    const uint32_t update_percent = argc > 4 ? std::min(static_cast<uint32_t>(atoi(argv[4])), 100u) : 1;
+
+    StagingBuffer staging_buffer(64 << 20, 2);
+
+    printf("%u sortbins, %u%% of the commands updated, %u iterations, best ms\n", sortbin_count, update_percent, iteration_count);
+    printf("   draws    append  rebuild   update  first upload KiB  update upload KiB  uploads per update\n");
+
+    bool is_valid = true;
+
+    for (uint32_t draw_count = 1000; draw_count <= max_draw_count; draw_count *= 10)
+    {
+        const benchmark_scene::SceneInfo scene_info {
+            .object_count = draw_count,
+            .instances_per_draw = 1,
+            .mesh_count = 4096,
+            .geometry_block_count = 8,
+            .half_size = 500.0f,
+            .seed = draw_count,
+        };
+
+        std::vector<DrawInfo> draw_list;
+        benchmark_scene::fill_draw_list(scene_info, draw_list);
+
+        // Draws of a sortbin are recorded in state order, one run per geometry block.
+        std::vector<std::vector<DrawInfo>> draw_list_list(sortbin_count);
+
+        for (uint32_t draw_idx = 0; draw_idx < draw_count; draw_idx++)
+        {
+            draw_list_list[draw_idx % sortbin_count].push_back(draw_list[draw_idx]);
+        }
+
+        for (std::vector<DrawInfo>& sortbin_draw_list : draw_list_list)
+        {
+            std::stable_sort(sortbin_draw_list.begin(), sortbin_draw_list.end(), [](const DrawInfo& lhs, const DrawInfo& rhs) {
+                return lhs.geometry_block_id < rhs.geometry_block_id;
+            });
+        }
+
+        double best_append_ms = 1e30;
+        double best_rebuild_ms = 1e30;
+        double best_update_ms = 1e30;
+        uint64_t first_upload_byte_count = 0;
+        uint64_t update_upload_byte_count = 0;
+        uint64_t update_upload_count = 0;
+
+        std::mt19937 rng(draw_count);
+
+        for (uint32_t iteration = 0; iteration < iteration_count; iteration++)
+        {
+            IndirectDrawBuffer indirect_draw_buffer(sortbin_count, 1);
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (uint16_t sortbin_ID = 0; sortbin_ID < sortbin_count; sortbin_ID++)
+            {
+                for (const DrawInfo& draw_info : draw_list_list[sortbin_ID])
+                {
+                    indirect_draw_buffer.append(sortbin_ID, VK_INDEX_TYPE_UINT32, draw_info);
+                }
+            }
+
+            s_upload_byte_count = 0;
+            indirect_draw_buffer.queue_uploads(0, staging_buffer);
+            best_append_ms = std::min(best_append_ms, benchmark_scene::get_elapsed_ms(start));
+            first_upload_byte_count = s_upload_byte_count;
+
+            start = std::chrono::steady_clock::now();
+
+            for (uint16_t sortbin_ID = 0; sortbin_ID < sortbin_count; sortbin_ID++)
+            {
+                indirect_draw_buffer.rebuild(sortbin_ID, VK_INDEX_TYPE_UINT32, draw_list_list[sortbin_ID]);
+            }
+
+            indirect_draw_buffer.queue_uploads(0, staging_buffer);
+            best_rebuild_ms = std::min(best_rebuild_ms, benchmark_scene::get_elapsed_ms(start));
+
+            // Instance count changes of scattered draws, as renderables of instanced draws come and go.
+            const uint32_t update_count = static_cast<uint32_t>(static_cast<uint64_t>(draw_count) * update_percent / 100);
+            std::vector<std::pair<uint16_t, uint32_t>> update_list(update_count);
+
+            for (auto& [sortbin_ID, command_idx] : update_list)
+            {
+                sortbin_ID = static_cast<uint16_t>(rng() % sortbin_count);
+                command_idx = static_cast<uint32_t>(rng() % std::max<size_t>(draw_list_list[sortbin_ID].size(), 1));
+            }
+
+            std::erase_if(update_list, [&](const std::pair<uint16_t, uint32_t>& update) { return draw_list_list[update.first].empty(); });
+
+            s_upload_count = 0;
+            s_upload_byte_count = 0;
+            start = std::chrono::steady_clock::now();
+
+            for (const auto& [sortbin_ID, command_idx] : update_list)
+            {
+                DrawInfo& draw_info = draw_list_list[sortbin_ID][command_idx];
+                draw_info.instance_count = draw_info.instance_count % 4 + 1;
+
+                indirect_draw_buffer.update(sortbin_ID, VK_INDEX_TYPE_UINT32, command_idx, draw_info);
+            }
+
+            indirect_draw_buffer.queue_uploads(0, staging_buffer);
+            best_update_ms = std::min(best_update_ms, benchmark_scene::get_elapsed_ms(start));
+            update_upload_byte_count = s_upload_byte_count;
+            update_upload_count = s_upload_count;
+
+            for (uint16_t sortbin_ID = 0; sortbin_ID < sortbin_count; sortbin_ID++)
+            {
+                is_valid = is_valid && is_stream_valid(indirect_draw_buffer.get_stream(sortbin_ID, VK_INDEX_TYPE_UINT32, 0), draw_list_list[sortbin_ID]);
+            }
+        }
+
+        printf("%8u  %8.3f  %7.3f  %7.3f  %16.1f  %17.1f  %18llu\n",
+            draw_count, best_append_ms, best_rebuild_ms, best_update_ms,
+            static_cast<double>(first_upload_byte_count) / 1024.0, static_cast<double>(update_upload_byte_count) / 1024.0,
+            static_cast<unsigned long long>(update_upload_count));
+    }
+
+    if (!is_valid)
+    {
+        printf("MISMATCH: uploaded command / instance counts or runs differ from the draw lists\n");
+        return 1;
+    }
+
+    return 0;
+}
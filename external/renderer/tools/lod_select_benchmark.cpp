@@ -0,0 +1,287 @@
+// Simplifies a sphere into a LOD chain with mesh_simplifier the way create_mesh does for MeshInitInfo::lod_info, then
+// frustum culls instances of it spread through a 1080p view and picks their levels with LodSelector, see
+// internal/visibility/LodSelector.hpp. Reports the chain, the triangles drawn at full detail and at the selected
+// levels and the selection time. Every selected draw must cover one level's index range, and the selected draws must
+// add up to the visible instances and the reported triangle count.
+//
+// renderer_lod_select_benchmark [instance count, 100000] [max screen error px, 1] [thread count, 1] [iterations, 20] [sphere segments, 100]
+
+#include "benchmark_scene.hpp"
+
+#include "internal/misc/WorkerPool.hpp"
+#include "internal/misc/mesh_simplifier.hpp"
+#include "internal/pod/Mesh.hpp"
+#include "internal/visibility/FrustumCuller.hpp"
+#include "internal/visibility/LodSelector.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr uint32_t s_target_height = 1080;
+static constexpr uint32_t s_instances_per_draw = 64;
+static constexpr float s_far_plane = 2000.0f;
+
+// Unit sphere of segment_count longitudes and segment_count + 1 latitude bands without duplicated vertices, so no
+// vertex is locked as an attribute seam. 2 * segment_count^2 triangles.
+static void create_sphere(const uint32_t segment_count, std::vector<float>& position_list, std::vector<uint32_t>& index_list)
+{
+    const uint32_t ring_count = segment_count; // rings between the poles
+    const float pi = 3.14159265f;
+
+    position_list = { 0.0f, 1.0f, 0.0f };
+
+    for (uint32_t ring = 1; ring <= ring_count; ring++)
+    {
+        const float theta = pi * static_cast<float>(ring) / static_cast<float>(ring_count + 1);
+
+        for (uint32_t segment = 0; segment < segment_count; segment++)
+        {
+            const float phi = 2.0f * pi * static_cast<float>(segment) / static_cast<float>(segment_count);
+            position_list.insert(position_list.end(), { sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) });
+        }
+    }
+
+    position_list.insert(position_list.end(), { 0.0f, -1.0f, 0.0f });
+
+    const uint32_t bottom_pole = 1 + ring_count * segment_count;
+    const auto get_vertex = [&](const uint32_t ring, const uint32_t segment) { return 1 + (ring - 1) * segment_count + segment % segment_count; };
+
+    index_list.clear();
+
+    for (uint32_t segment = 0; segment < segment_count; segment++)
+    {
+        index_list.insert(index_list.end(), { 0, get_vertex(1, segment + 1), get_vertex(1, segment) });
+
+        for (uint32_t ring = 1; ring < ring_count; ring++)
+        {
+            const uint32_t v00 = get_vertex(ring, segment);
+            const uint32_t v01 = get_vertex(ring, segment + 1);
+            const uint32_t v10 = get_vertex(ring + 1, segment);
+            const uint32_t v11 = get_vertex(ring + 1, segment + 1);
+
+            index_list.insert(index_list.end(), { v00, v01, v11, v00, v11, v10 });
+        }
+
+        index_list.insert(index_list.end(), { bottom_pole, get_vertex(ring_count, segment), get_vertex(ring_count, segment + 1) });
+    }
+}
+
+// The chain create_mesh generates for MeshLodInfo { 7, 0.5, 0.05 }: every level simplified from the full detail list
+// to half the previous level's indices, ending once max_error holds a level back.
+static Mesh create_lod_mesh(const std::vector<float>& position_list, const std::vector<uint32_t>& index_list, std::vector<uint32_t>& lod_index_list)
+{
+    const uint32_t vertex_count = static_cast<uint32_t>(position_list.size() / 3);
+    const uint32_t index_count = static_cast<uint32_t>(index_list.size());
+
+    Mesh mesh {
+        .sortbin_id = 0,
+        .index_count = index_count,
+        .vertex_count = vertex_count,
+        .first_vertex = 0,
+        .first_index = 0,
+        .vertex_offset = 0,
+        .index_stride = 4,
+        .vertex_stride = 12,
+        .geometry_block_id = 0,
+        .bounds = { .center = { 0.0f, 0.0f, 0.0f }, .extent = { 1.0f, 1.0f, 1.0f } },
+    };
+
+    mesh.lod_list[0] = { .first_index = 0, .index_count = index_count, .error = 0.0f };
+
+    const float reduction = 0.5f;
+    const float max_error = 0.05f * sqrtf(3.0f);
+
+    lod_index_list = index_list;
+    std::vector<uint32_t> simplified_index_list(index_count);
+    float target_index_count = static_cast<float>(index_count);
+
+    while (mesh.lod_count < Mesh::s_max_lod_count)
+    {
+        target_index_count *= reduction;
+
+        float error = 0.0f;
+        const uint32_t simplified_index_count = mesh_simplifier::simplify(simplified_index_list.data(), index_list.data(), index_count,
+            position_list.data(), vertex_count, static_cast<uint32_t>(target_index_count) / 3 * 3, max_error, error);
+
+        const float max_index_count = static_cast<float>(mesh.lod_list[mesh.lod_count - 1].index_count) * (1.0f + reduction) * 0.5f;
+
+        if (simplified_index_count == 0 || static_cast<float>(simplified_index_count) > max_index_count)
+        {
+            break;
+        }
+
+        mesh.lod_list[mesh.lod_count++] = {
+            .first_index = static_cast<uint32_t>(lod_index_list.size()),
+            .index_count = simplified_index_count,
+            .error = error,
+        };
+
+        lod_index_list.insert(lod_index_list.end(), simplified_index_list.begin(), simplified_index_list.begin() + simplified_index_count);
+    }
+
+    mesh.lod_index_count = static_cast<uint32_t>(lod_index_list.size()) - index_count;
+
+    return mesh;
+}
+
+// Column major translation * uniform scale of instances spread evenly through the view volume down -z.
+static std::vector<float> create_model_mat_list(const uint32_t instance_count)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit_dist(0.0f, 1.0f);
+    std::uniform_real_distribution<float> scale_dist(0.5f, 4.0f);
+
+    const float tan_half_fov = tanf(0.5f * 60.0f * 3.14159265f / 180.0f);
+    std::vector<float> model_mat_list(static_cast<size_t>(instance_count) * 16, 0.0f);
+
+    for (uint32_t instance_idx = 0; instance_idx < instance_count; instance_idx++)
+    {
+        float* const model_mat = model_mat_list.data() + static_cast<size_t>(instance_idx) * 16;
+        const float scale = scale_dist(rng);
+        // Uniform in volume, the cross section grows with the square of the distance.
+        const float distance = 5.0f + (s_far_plane - 10.0f) * cbrtf(unit_dist(rng));
+        const float half_width = tan_half_fov * distance * 0.9f;
+
+        model_mat[0] = scale;
+        model_mat[5] = scale;
+        model_mat[10] = scale;
+        model_mat[12] = (unit_dist(rng) * 2.0f - 1.0f) * half_width;
+        model_mat[13] = (unit_dist(rng) * 2.0f - 1.0f) * half_width;
+        model_mat[14] = -distance;
+        model_mat[15] = 1.0f;
+    }
+
+    return model_mat_list;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t instance_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+    const float max_screen_error = argc > 2 ? static_cast<float>(atof(argv[2])) : 1.0f;
+    const uint32_t thread_count = argc > 3 ? std::max(static_cast<uint32_t>(atoi(argv[3])), 1u) : 1;
+    const uint32_t iteration_count = argc > 4 ? std::max(static_cast<uint32_t>(atoi(argv[4])), 1u) : 20;
+    const uint32_t segment_count = argc > 5 ? std::max(static_cast<uint32_t>(atoi(argv[5])), 3u) : 100;
+
+    std::vector<float> position_list;
+    std::vector<uint32_t> index_list;
+    create_sphere(segment_count, position_list, index_list);
+
+    std::vector<uint32_t> lod_index_list;
+    const auto lod_start = std::chrono::steady_clock::now();
+    const std::vector<Mesh> mesh_vec = { create_lod_mesh(position_list, index_list, lod_index_list) };
+    const double lod_ms = benchmark_scene::get_elapsed_ms(lod_start);
+    const Mesh& mesh = mesh_vec[0];
+
+    printf("sphere of %zu triangles, %u levels generated in %.1f ms\n", index_list.size() / 3, mesh.lod_count, lod_ms);
+    printf("level  triangles  error\n");
+
+    for (uint32_t lod = 0; lod < mesh.lod_count; lod++)
+    {
+        printf("%5u  %9u  %.5f\n", lod, mesh.lod_list[lod].index_count / 3, mesh.lod_list[lod].error);
+    }
+
+    // Instanced draws of the sphere over consecutive instance slots, slot i holding draw ID i.
+    std::vector<SortBin> sortbin_list;
+    sortbin_list.push_back(benchmark_scene::create_sortbin("benchmark"));
+
+    for (uint32_t first_slot = 0; first_slot < instance_count; first_slot += s_instances_per_draw)
+    {
+        sortbin_list[0].draw_list_u32.push_back({
+            .index_count = mesh.index_count,
+            .vertex_count = mesh.vertex_count,
+            .instance_count = std::min(s_instances_per_draw, instance_count - first_slot),
+            .first_index = 0,
+            .first_vertex = 0,
+            .vertex_offset = 0,
+            .first_instance = first_slot,
+            .mesh_id = 0,
+            .geometry_block_id = 0,
+        });
+    }
+
+    const std::vector<uint16_t> sortbin_ID_list = { 0 };
+    const std::vector<uint32_t> instance_draw_ID_list = benchmark_scene::create_instance_draw_ID_list(instance_count);
+    const std::vector<float> model_mat_list = create_model_mat_list(instance_count);
+
+    WorkerPool worker_pool(thread_count);
+    FrustumCuller frustum_culler(worker_pool);
+    LodSelector lod_selector(worker_pool);
+
+    for (uint32_t instance_idx = 0; instance_idx < instance_count; instance_idx++)
+    {
+        frustum_culler.set_bounds(instance_idx, mesh.bounds, model_mat_list.data() + static_cast<size_t>(instance_idx) * 16);
+    }
+
+    float view_proj_mat[16];
+    benchmark_scene::get_view_proj_mat(s_far_plane, view_proj_mat);
+
+    const float error_scale = static_cast<float>(s_target_height) / (2.0f * max_screen_error);
+    std::vector<VisibleDrawLists> visible_draw_lists_list(sortbin_list.size());
+
+    uint64_t best_select_ns = UINT64_MAX;
+    uint64_t total_select_ns = 0;
+
+    // Selection rewrites the visible lists, every iteration culls them again first.
+    for (uint32_t iteration = 0; iteration < iteration_count; iteration++)
+    {
+        frustum_culler.cull(view_proj_mat, sortbin_list, sortbin_ID_list, instance_draw_ID_list, visible_draw_lists_list);
+        lod_selector.select(view_proj_mat, error_scale, sortbin_ID_list, mesh_vec, frustum_culler, instance_draw_ID_list, visible_draw_lists_list);
+
+        best_select_ns = std::min(best_select_ns, lod_selector.get_stats().select_ns);
+        total_select_ns += lod_selector.get_stats().select_ns;
+    }
+
+    const LodSelectStats& stats = lod_selector.get_stats();
+
+    // Instances per selected level, the selected draws checked against the chain.
+    std::vector<uint32_t> level_instance_count_list(mesh.lod_count, 0);
+    uint32_t selected_instance_count = 0;
+    uint64_t selected_triangle_count = 0;
+    bool is_valid = true;
+
+    for (const DrawInfo& draw_info : visible_draw_lists_list[0].draw_list_u32)
+    {
+        uint32_t lod = 0;
+
+        while (lod < mesh.lod_count && (mesh.lod_list[lod].first_index != draw_info.first_index || mesh.lod_list[lod].index_count != draw_info.index_count))
+        {
+            lod++;
+        }
+
+        if (lod == mesh.lod_count)
+        {
+            is_valid = false;
+            continue;
+        }
+
+        level_instance_count_list[lod] += draw_info.instance_count;
+        selected_instance_count += draw_info.instance_count;
+        selected_triangle_count += static_cast<uint64_t>(draw_info.index_count / 3) * draw_info.instance_count;
+    }
+
+    is_valid = is_valid && selected_instance_count == stats.instance_count && selected_triangle_count == stats.triangle_count;
+
+    printf("\n%u instances, %u visible, %u per draw, %.1f px tolerated at %u px height, %u threads, %u iterations\n",
+        instance_count, stats.instance_count, s_instances_per_draw, static_cast<double>(max_screen_error), s_target_height, thread_count, iteration_count);
+    printf("full detail triangles  selected triangles  reduction  select best / mean ms\n");
+    printf("%21llu  %18llu  %8.1fx  %9.3f / %.3f\n",
+        static_cast<unsigned long long>(stats.full_detail_triangle_count), static_cast<unsigned long long>(stats.triangle_count),
+        static_cast<double>(stats.full_detail_triangle_count) / static_cast<double>(std::max<uint64_t>(stats.triangle_count, 1)),
+        static_cast<double>(best_select_ns) * 1e-6, static_cast<double>(total_select_ns) * 1e-6 / iteration_count);
+
+    printf("level  instances\n");
+
+    for (uint32_t lod = 0; lod < mesh.lod_count; lod++)
+    {
+        printf("%5u  %9u\n", lod, level_instance_count_list[lod]);
+    }
+
+    if (!is_valid)
+    {
+        printf("MISMATCH: selected draws do not cover level ranges, the visible instances or the reported triangles\n");
+        return 1;
+    }
+
+    return 0;
+}
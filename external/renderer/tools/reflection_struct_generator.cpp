@@ -0,0 +1,343 @@
+// Generates a header of C++ structs laid out exactly like the frame UBO and each sortbin's material and draw data blocks
+// of the reflection JSON, with static_asserted offsets and sizes, and the renderer::UniformLayout / UniformMember
+// specialisations the typed create_material, create_renderable and update_uniform overloads of renderer.hpp take.
+//
+// The reflection records offsets and sizes but no GLSL types, so members are arrays of 4 byte lanes: float unless
+// named with --uint (the material reference closing a draw block is always uint32_t). Members with an internal
+// structure become nested structs, members with a count std::arrays of their element. Gaps become padding bytes.
+//
+// renderer_reflection_struct_generator <frame desc set reflection> <sortbin reflection> <header> <namespace> [--uint <member name>]...
+
+#include "internal/misc/json_structures.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdio.h>
+
+static const char* const s_frame_ubo_name = "Frame_UBO"; // the binding renderer::update_uniform(BufferType::eFrame, ...) writes
+
+struct Generator
+{
+    std::set<std::string> uint_member_name_set;
+    std::vector<std::string> error_list;
+
+    std::ostringstream struct_stream;
+    std::ostringstream assert_stream;
+    std::ostringstream layout_stream;
+};
+
+static std::string to_identifier(const std::string& name)
+{
+    std::string identifier = name;
+    std::replace_if(identifier.begin(), identifier.end(), [](const char c) { return !isalnum(static_cast<unsigned char>(c)); }, '_');
+
+    return (identifier.empty() || isdigit(static_cast<unsigned char>(identifier[0]))) ? "_" + identifier : identifier;
+}
+
+static std::string to_type_name(const std::string& member_name)
+{
+    std::string type_name;
+    bool is_word_start = true;
+
+    for (const char c : to_identifier(member_name))
+    {
+        if (c == '_')
+        {
+            is_word_start = true;
+            continue;
+        }
+
+        type_name += is_word_start ? static_cast<char>(toupper(static_cast<unsigned char>(c))) : c;
+        is_word_start = false;
+    }
+
+    return type_name.empty() || isdigit(static_cast<unsigned char>(type_name[0])) ? "T" + type_name : type_name;
+}
+
+static std::vector<JSONInfo_DescriptorVariable> sorted_by_offset(std::vector<JSONInfo_DescriptorVariable> member_list)
+{
+    std::stable_sort(member_list.begin(), member_list.end(), [](const JSONInfo_DescriptorVariable& a, const JSONInfo_DescriptorVariable& b) { return a.offset < b.offset; });
+
+    return member_list;
+}
+
+// Writes the members of a struct of struct_size bytes at the given indent, nested structs and padding included,
+// and queues the static_asserts of every member under qualified_name.
+static void generate_members(Generator& generator, const std::vector<JSONInfo_DescriptorVariable>& member_list, const uint32_t struct_size,
+    const std::string& qualified_name, const std::string& indent, const std::string& uint_member_name)
+{
+    uint32_t cursor = 0;
+    uint32_t pad_idx = 0;
+
+    for (const JSONInfo_DescriptorVariable& member : sorted_by_offset(member_list))
+    {
+        const uint32_t count = std::max(member.count, 1u);
+        const uint64_t member_end = member.offset + static_cast<uint64_t>(member.size) * count;
+
+        if (member.size == 0 || member.size % 4 != 0 || member.offset % 4 != 0)
+        {
+            generator.error_list.push_back(qualified_name + "::" + member.name + " is not made of 4 byte aligned lanes");
+            continue;
+        }
+
+        if (member.offset < cursor || member_end > struct_size)
+        {
+            generator.error_list.push_back(qualified_name + "::" + member.name + " overlaps another member or ends past the block");
+            continue;
+        }
+
+        if (member.offset > cursor)
+        {
+            generator.struct_stream << indent << "uint8_t pad" << pad_idx++ << "[" << member.offset - cursor << "];\n";
+        }
+
+        std::string type_name;
+
+        if (!member.internal_structure.empty())
+        {
+            type_name = to_type_name(member.name);
+
+            generator.struct_stream << indent << "struct " << type_name << "\n" << indent << "{\n";
+            generate_members(generator, member.internal_structure, member.size, qualified_name + "::" + type_name, indent + "    ", "");
+            generator.struct_stream << indent << "};\n";
+        }
+        else
+        {
+            const bool is_uint = member.name == uint_member_name || generator.uint_member_name_set.contains(member.name);
+            const char* const lane_type_name = is_uint ? "uint32_t" : "float";
+            const uint32_t lane_count = member.size / 4;
+
+            type_name = lane_count == 1 ? lane_type_name : "std::array<" + std::string(lane_type_name) + ", " + std::to_string(lane_count) + ">";
+        }
+
+        if (count > 1)
+        {
+            type_name = "std::array<" + type_name + ", " + std::to_string(count) + ">";
+        }
+
+        generator.struct_stream << indent << type_name << " " << to_identifier(member.name) << ";\n";
+        generator.assert_stream << "static_assert(offsetof(" << qualified_name << ", " << to_identifier(member.name) << ") == " << member.offset << ");\n";
+
+        cursor = static_cast<uint32_t>(member_end);
+    }
+
+    if (cursor < struct_size)
+    {
+        generator.struct_stream << indent << "uint8_t pad" << pad_idx << "[" << struct_size - cursor << "];\n";
+    }
+
+    generator.assert_stream << "static_assert(sizeof(" << qualified_name << ") == " << struct_size << ");\n";
+}
+
+static void generate_layout(Generator& generator, const std::string& qualified_name, const char* const buffer_type, const std::string& name,
+    const uint32_t block_size, const uint32_t data_size, const std::vector<JSONInfo_DescriptorVariable>& member_list, const std::string& material_reference_name)
+{
+    generator.layout_stream << "    template<> struct UniformLayout<" << qualified_name << ">\n    {\n"
+                            << "        static constexpr BufferType buffer_type = BufferType::" << buffer_type << ";\n"
+                            << "        static constexpr const char* name = \"" << name << "\";\n"
+                            << "        static constexpr uint32_t block_size = " << block_size << ";\n"
+                            << "        static constexpr uint32_t data_size = " << data_size << ";\n"
+                            << "    };\n\n";
+
+    const bool is_frame = std::string(buffer_type) == "eFrame";
+    const std::vector<JSONInfo_DescriptorVariable> sorted_member_list = sorted_by_offset(member_list);
+
+    // Frame UBO members are indexed in offset order by UniformBuffer.
+    for (uint32_t member_idx = 0; member_idx < sorted_member_list.size(); member_idx++)
+    {
+        const JSONInfo_DescriptorVariable& member = sorted_member_list[member_idx];
+
+        // Owned by the renderer, see create_renderable.
+        if (member.name == material_reference_name)
+        {
+            continue;
+        }
+
+        // The member the renderer derives culling bounds from, see set_renderable_transform.
+        const bool is_model_mat = std::string(buffer_type) == "eDraw" && member.name == "model_mat";
+
+        generator.layout_stream << "    template<> struct UniformMember<&" << qualified_name << "::" << to_identifier(member.name) << ">\n    {\n"
+                                << "        static constexpr UniformHandle handle {\n"
+                                << "            .buffer_type = BufferType::" << buffer_type << ",\n"
+                                << "            .member_idx = " << (is_frame ? std::to_string(member_idx) : "UINT32_MAX") << ",\n"
+                                << "            .block_size = " << (is_frame ? 0 : block_size) << ",\n"
+                                << "            .offset = " << member.offset << ",\n"
+                                << "            .size = " << member.size * std::max(member.count, 1u) << ",\n"
+                                << "        };\n"
+                                << "        static constexpr bool is_model_mat = " << (is_model_mat ? "true" : "false") << ";\n"
+                                << "    };\n\n";
+    }
+}
+
+static void generate_block(Generator& generator, const std::string& namespace_name, const std::string& sortbin_namespace_name, const char* const struct_name,
+    const char* const buffer_type, const std::string& sortbin_name, const JSONInfo_SortBinReflection::BlockDefinition& block_definition, const bool is_draw_data)
+{
+    if (block_definition.size == 0 || block_definition.members.empty())
+    {
+        return;
+    }
+
+    if (block_definition.end_padding >= block_definition.size)
+    {
+        generator.error_list.push_back(sortbin_name + " " + struct_name + " padding fills the whole block");
+        return;
+    }
+
+    const uint32_t data_size = block_definition.size - block_definition.end_padding;
+    const std::string qualified_name = namespace_name + "::" + sortbin_namespace_name + "::" + struct_name;
+
+    // The renderer writes the material reference into the last 4 bytes of the draw data.
+    std::string material_reference_name;
+
+    if (is_draw_data)
+    {
+        const auto iter = std::find_if(block_definition.members.begin(), block_definition.members.end(),
+            [data_size](const JSONInfo_DescriptorVariable& member) { return member.offset + member.size == data_size; });
+
+        if (iter == block_definition.members.end() || iter->size != 4 || data_size < 4)
+        {
+            generator.error_list.push_back(sortbin_name + " " + struct_name + " does not end in a 4 byte material reference");
+            return;
+        }
+
+        material_reference_name = iter->name;
+    }
+
+    generator.struct_stream << "        struct " << struct_name << "\n        {\n";
+    generate_members(generator, block_definition.members, data_size, qualified_name, "            ", material_reference_name);
+    generator.struct_stream << "        };\n";
+
+    generate_layout(generator, qualified_name, buffer_type, sortbin_name, block_definition.size, data_size, block_definition.members, material_reference_name);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 5 || (argc - 5) % 2 != 0)
+    {
+        fprintf(stderr, "usage: %s <frame desc set reflection> <sortbin reflection> <header> <namespace> [--uint <member name>]...\n", argv[0]);
+        return 1;
+    }
+
+    Generator generator;
+    const std::string namespace_name = to_identifier(argv[4]);
+
+    for (int i = 5; i < argc; i += 2)
+    {
+        if (std::string(argv[i]) != "--uint")
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+
+        generator.uint_member_name_set.insert(argv[i + 1]);
+    }
+
+    std::vector<JSONInfo_DescriptorBinding> frame_desc_set_binding_list;
+    JSONInfo_SortBinReflection sortbin_reflection_info;
+
+    try
+    {
+        std::ifstream frame_desc_set_file(argv[1]);
+        std::ifstream sortbin_file(argv[2]);
+
+        frame_desc_set_binding_list = nlohmann::json::parse(frame_desc_set_file).at("bindings").get<std::vector<JSONInfo_DescriptorBinding>>();
+        sortbin_reflection_info = nlohmann::json::parse(sortbin_file).at("sortbin-reflections").get<JSONInfo_SortBinReflection>();
+    }
+    catch (const nlohmann::json::exception& exception)
+    {
+        fprintf(stderr, "Failed to parse the reflection files: %s\n", exception.what());
+        return 1;
+    }
+
+    generator.struct_stream << "namespace " << namespace_name << "\n{\n";
+
+    // Only uniform buffers have a CPU side layout, storage buffer bindings are the material and draw data pools.
+    uint32_t frame_struct_count = 0;
+
+    for (const JSONInfo_DescriptorBinding& binding : frame_desc_set_binding_list)
+    {
+        if (binding.descriptor_type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || binding.buffer_variables.empty())
+        {
+            continue;
+        }
+
+        const std::string struct_name = to_identifier(binding.name);
+        const std::string qualified_name = namespace_name + "::" + struct_name;
+
+        uint32_t struct_size = 0;
+        for (const JSONInfo_DescriptorVariable& member : binding.buffer_variables)
+        {
+            struct_size = std::max(struct_size, member.offset + member.size * std::max(member.count, 1u));
+        }
+
+        generator.struct_stream << "    struct " << struct_name << "\n    {\n";
+        generate_members(generator, binding.buffer_variables, struct_size, qualified_name, "        ", "");
+        generator.struct_stream << "    };\n\n";
+
+        // The other UBOs have no update path, their structs only document the layout.
+        if (binding.name == s_frame_ubo_name)
+        {
+            generate_layout(generator, qualified_name, "eFrame", binding.name, struct_size, struct_size, binding.buffer_variables, "");
+        }
+
+        frame_struct_count++;
+    }
+
+    std::vector<const JSONInfo_SortBinReflection::State*> sortbin_state_list;
+    for (const auto& [sortbin_name, sortbin_state] : sortbin_reflection_info.state_umap)
+    {
+        sortbin_state_list.push_back(&sortbin_state);
+    }
+
+    std::sort(sortbin_state_list.begin(), sortbin_state_list.end(), [](const auto* a, const auto* b) { return a->sortbin_name < b->sortbin_name; });
+
+    for (const JSONInfo_SortBinReflection::State* p_sortbin_state : sortbin_state_list)
+    {
+        const std::string sortbin_namespace_name = "sortbin_" + to_identifier(p_sortbin_state->sortbin_name);
+
+        generator.struct_stream << "    namespace " << sortbin_namespace_name << "\n    {\n";
+        generate_block(generator, namespace_name, sortbin_namespace_name, "MaterialData", "eMaterial", p_sortbin_state->sortbin_name, p_sortbin_state->definition_material_data, false);
+        generate_block(generator, namespace_name, sortbin_namespace_name, "DrawData", "eDraw", p_sortbin_state->sortbin_name, p_sortbin_state->definition_draw_data, true);
+        generator.struct_stream << "    }; // " << sortbin_namespace_name << "\n\n";
+    }
+
+    generator.struct_stream << "}; // " << namespace_name << "\n";
+
+    for (const std::string& error : generator.error_list)
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+    }
+
+    if (!generator.error_list.empty())
+    {
+        return 1;
+    }
+
+    std::string guard_name = "RENDERER_REFLECTION_" + namespace_name + "_HPP";
+    std::transform(guard_name.begin(), guard_name.end(), guard_name.begin(), [](const char c) { return static_cast<char>(toupper(static_cast<unsigned char>(c))); });
+
+    std::ostringstream header_stream;
+    header_stream << "// Generated by renderer_reflection_struct_generator from " << argv[1] << " and " << argv[2] << ", do not edit.\n\n"
+                  << "#ifndef " << guard_name << "\n#define " << guard_name << "\n\n"
+                  << "#include \"renderer.hpp\"\n\n"
+                  << "#include <array>\n#include <stddef.h>\n#include <stdint.h>\n\n"
+                  << generator.struct_stream.str() << "\n"
+                  << generator.assert_stream.str() << "\n"
+                  << "namespace renderer\n{\n" << generator.layout_stream.str() << "}; // renderer\n\n"
+                  << "#endif // " << guard_name << "\n";
+
+    std::ofstream header_file(argv[3], std::ios::binary | std::ios::trunc);
+    header_file << header_stream.str();
+
+    if (!header_file.good())
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[3]);
+        return 1;
+    }
+
+    printf("%s: %u frame UBO structs, %zu sortbins\n", argv[3], frame_struct_count, sortbin_state_list.size());
+
+    return 0;
+}
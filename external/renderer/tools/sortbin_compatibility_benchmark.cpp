@@ -0,0 +1,132 @@
+// Classifies synthetic sortbins into compatibility classes and checks the result against a first fit over every
+// class, see internal/misc/sortbin_compatibility.hpp.
+//
+// renderer_sortbin_compatibility_benchmark [sortbin count, 10000] [seed, 1]
+
+#include "internal/misc/sortbin_compatibility.hpp"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct AttributeChoice
+{
+    const char* usage;
+    uint32_t location;
+    VkFormat format_list[2]; // full precision, quantized
+    uint32_t size_list[2];
+};
+
+static const AttributeChoice s_attribute_choice_list[] = {
+    { "vertex_pos",       0, { VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R16G16B16A16_SNORM }, { 12, 8 } },
+    { "vertex_normal",    1, { VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R16G16_SNORM },       { 12, 4 } },
+    { "vertex_texcoord",  2, { VK_FORMAT_R32G32_SFLOAT,    VK_FORMAT_R16G16_SFLOAT },      { 8,  4 } },
+    { "vertex_tangent",   3, { VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R16G16_SNORM },       { 12, 4 } },
+    { "vertex_color",     4, { VK_FORMAT_R8G8B8A8_UNORM,   VK_FORMAT_R8G8B8A8_UNORM },     { 4,  4 } },
+    { "vertex_texcoord1", 5, { VK_FORMAT_R32G32_SFLOAT,    VK_FORMAT_R16G16_SFLOAT },      { 8,  4 } },
+};
+
+static constexpr uint32_t s_attribute_choice_count = sizeof(s_attribute_choice_list) / sizeof(s_attribute_choice_list[0]);
+
+static std::vector<JSONInfo_DescriptorVariable> create_definition(const uint32_t variant)
+{
+    std::vector<JSONInfo_DescriptorVariable> desc_var_list;
+
+    for (uint32_t i = 0; i < variant; i++)
+    {
+        desc_var_list.push_back({ .name = "member_" + std::to_string(i), .offset = 16 * i, .size = 16, .count = 1, .internal_structure = {} });
+    }
+
+    return desc_var_list;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t sortbin_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 10000;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1;
+
+    std::mt19937 rng(seed);
+
+    // Vertex layouts are a vertex_pos plus any of the other attributes, each at either precision, in the order the
+    // fields sit in the vertex but declared in any order. Definitions come from a few variants, the first one empty.
+    std::vector<JSONInfo_SortBinPipelineState::VertexInputState> vertex_input_state_list(sortbin_count);
+    std::vector<std::vector<JSONInfo_DescriptorVariable>> definition_list;
+
+    for (uint32_t variant = 0; variant < 8; variant++)
+    {
+        definition_list.push_back(create_definition(variant));
+    }
+
+    std::vector<sortbin_compatibility::SortBinState> state_list;
+
+    for (uint32_t sortbin_idx = 0; sortbin_idx < sortbin_count; sortbin_idx++)
+    {
+        JSONInfo_SortBinPipelineState::VertexInputState& vertex_input_state = vertex_input_state_list[sortbin_idx];
+
+        const uint32_t attribute_mask = (rng() & 0x1F) << 1 | 0x1;
+        const uint32_t precision_mask = rng() % 4 == 0 ? rng() : 0x0;
+        uint32_t offset = 0;
+
+        for (uint32_t choice_idx = 0; choice_idx < s_attribute_choice_count; choice_idx++)
+        {
+            if (attribute_mask & (1 << choice_idx))
+            {
+                const AttributeChoice& choice = s_attribute_choice_list[choice_idx];
+                const uint32_t precision = (precision_mask >> choice_idx) & 0x1;
+
+                vertex_input_state.attribute_description_list.push_back({
+                    .usage = choice.usage,
+                    .attribute_desctiption = { .location = choice.location, .binding = 0, .format = choice.format_list[precision], .offset = offset },
+                });
+
+                offset += choice.size_list[precision];
+            }
+        }
+
+        std::shuffle(vertex_input_state.attribute_description_list.begin(), vertex_input_state.attribute_description_list.end(), rng);
+        vertex_input_state.binding_description_list.push_back({ .binding = 0, .stride = offset, .inputRate = VK_VERTEX_INPUT_RATE_VERTEX });
+
+        state_list.push_back({
+            .p_vertex_input_state = &vertex_input_state,
+            .p_definition_material_data = &definition_list[rng() % 8],
+            .p_definition_draw_data = &definition_list[rng() % 2 == 0 ? 0 : 1 + rng() % 3],
+        });
+    }
+
+    sortbin_compatibility::ClassifyStats stats;
+    const std::vector<uint16_t> class_list = sortbin_compatibility::classify(state_list, stats);
+
+    printf("%u sortbins in %u classes, classified in %.3f ms: %u by signature, %lu candidate classes compared\n",
+        sortbin_count, stats.class_count, static_cast<double>(stats.classify_ns) * 1e-6, stats.signature_hit_count, stats.candidate_count);
+
+    // Reference: every sortbin joins the first class whose founder it is compatible with.
+    const auto reference_start = std::chrono::steady_clock::now();
+
+    std::vector<uint32_t> founder_list;
+    uint32_t mismatch_count = 0;
+
+    for (uint32_t sortbin_idx = 0; sortbin_idx < sortbin_count; sortbin_idx++)
+    {
+        uint32_t class_ID = 0;
+
+        while (class_ID < founder_list.size() && !sortbin_compatibility::is_compatible(state_list[founder_list[class_ID]], state_list[sortbin_idx]))
+        {
+            class_ID++;
+        }
+
+        if (class_ID == founder_list.size())
+        {
+            founder_list.push_back(sortbin_idx);
+        }
+
+        mismatch_count += class_ID != class_list[sortbin_idx];
+    }
+
+    const auto reference_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - reference_start).count();
+
+    printf("reference first fit: %zu classes in %.3f ms, %u sortbins classified differently\n",
+        founder_list.size(), static_cast<double>(reference_ns) * 1e-6, mismatch_count);
+
+    return mismatch_count == 0 ? 0 : 1;
+}
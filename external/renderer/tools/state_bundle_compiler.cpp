@@ -0,0 +1,58 @@
+// Compiles the renderer's JSON description files into the state bundle renderer::InitInfo::file_state_bundle loads.
+// The files are validated against each other first and the written bundle is read back before reporting success.
+//
+// renderer_state_bundle_compiler <frame desc set reflection> <sortbin reflection> <sortbin pipeline state> <app state> <bundle>
+
+#include "internal/misc/state_bundle.hpp"
+
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+    if (argc != 6)
+    {
+        fprintf(stderr, "usage: %s <frame desc set reflection> <sortbin reflection> <sortbin pipeline state> <app state> <bundle>\n", argv[0]);
+        return 1;
+    }
+
+    StateDescription description;
+
+    try
+    {
+        description = state_bundle::parse_json_files(argv[1], argv[2], argv[3], argv[4]);
+    }
+    catch (const nlohmann::json::exception& exception)
+    {
+        fprintf(stderr, "Failed to parse the description files: %s\n", exception.what());
+        return 1;
+    }
+
+    const std::vector<std::string> error_list = state_bundle::validate(description);
+
+    for (const std::string& error : error_list)
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+    }
+
+    if (!error_list.empty())
+    {
+        return 1;
+    }
+
+    StateDescription read_description;
+
+    if (!state_bundle::write(description, argv[5]) || !state_bundle::read(argv[5], read_description) || !state_bundle::validate(read_description).empty())
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[5]);
+        return 1;
+    }
+
+    printf("%s: %lu render attachments, %lu render passes, %lu sortbins, %lu frame descriptor bindings\n",
+        argv[5],
+        read_description.render_attachment_info.image_state_list.size(),
+        read_description.render_pass_info.state_list.size(),
+        read_description.sortbin_info.sortbin_list.size(),
+        read_description.frame_desc_set_binding_list.size());
+
+    return 0;
+}
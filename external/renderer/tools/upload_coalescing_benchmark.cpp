@@ -0,0 +1,104 @@
+// Writes the model matrix member of a random share of a BufferPool_VariableBlock's draw blocks and coalesces the
+// dirty granules into copy regions with get_queued_uploads(), see internal/buffers/BufferPool_VariableBlock.hpp.
+// Region and byte counts are compared with one copy per written member. The regions must be sorted, disjoint and
+// cover every written byte.
+//
+// renderer_upload_coalescing_benchmark [block count, 100000] [iterations, 20] [block size, 80] [member size, 64]
+
+#include "internal/buffers/BufferPool_VariableBlock.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+static double get_elapsed_ms(const std::chrono::steady_clock::time_point start)
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) * 1e-6;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t block_count = argc > 1 ? std::max(static_cast<uint32_t>(atoi(argv[1])), 1u) : 100000;
+    const uint32_t iteration_count = argc > 2 ? std::max(static_cast<uint32_t>(atoi(argv[2])), 1u) : 20;
+    const uint32_t block_size = argc > 3 ? std::max(static_cast<uint32_t>(atoi(argv[3])), 16u) : 80;
+    const uint32_t member_size = argc > 4 ? std::clamp(static_cast<uint32_t>(atoi(argv[4])), 1u, block_size) : 64;
+
+    BufferPool_VariableBlock buffer_pool(1, static_cast<uint64_t>(block_count) * block_size);
+
+    std::vector<uint32_t> block_id_list(block_count);
+
+    for (uint32_t& block_id : block_id_list)
+    {
+        block_id = buffer_pool.acquire_block(block_size);
+    }
+
+    // The initial contents upload as a whole.
+    buffer_pool.get_queued_uploads(0);
+
+    std::mt19937 rng(1);
+    std::vector<uint8_t> member_data(static_cast<size_t>(block_count) * member_size, 0xAB);
+
+    printf("%u blocks of %u bytes, %u byte member, %u iterations, best ms\n", block_count, block_size, member_size, iteration_count);
+    printf("dirty %%   writes   regions  per member  staged KiB  written KiB     write  coalesce\n");
+
+    bool is_valid = true;
+
+    for (const uint32_t dirty_percent : { 1u, 5u, 25u, 100u })
+    {
+        const uint32_t write_count = std::max(static_cast<uint32_t>(static_cast<uint64_t>(block_count) * dirty_percent / 100), 1u);
+
+        double best_write_ms = 1e30;
+        double best_coalesce_ms = 1e30;
+        uint64_t region_count = 0;
+        uint64_t staged_byte_count = 0;
+
+        for (uint32_t iteration = 0; iteration < iteration_count; iteration++)
+        {
+            // Random blocks in random order, as transforms of scattered renderables change.
+            std::shuffle(block_id_list.begin(), block_id_list.end(), rng);
+
+            auto start = std::chrono::steady_clock::now();
+            buffer_pool.write_member_list(block_size, block_id_list.data(), write_count, 0, member_size, member_data.data(), member_size);
+            best_write_ms = std::min(best_write_ms, get_elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            const std::vector<UploadInfo> upload_info_list = buffer_pool.get_queued_uploads(0);
+            best_coalesce_ms = std::min(best_coalesce_ms, get_elapsed_ms(start));
+
+            region_count = upload_info_list.size();
+            staged_byte_count = buffer_pool.get_upload_stats().last_staged_byte_count;
+
+            // Sorted and disjoint, so every written member lies in the last region starting at or before it.
+            for (uint32_t region_idx = 1; region_idx < upload_info_list.size(); region_idx++)
+            {
+                const UploadInfo& prev_upload_info = upload_info_list[region_idx - 1];
+                is_valid = is_valid && prev_upload_info.dst_offset + prev_upload_info.size <= upload_info_list[region_idx].dst_offset;
+            }
+
+            for (uint32_t write_idx = 0; write_idx < write_count; write_idx++)
+            {
+                const VkDeviceSize offset = static_cast<VkDeviceSize>(block_id_list[write_idx]) * block_size;
+
+                const auto iter = std::upper_bound(upload_info_list.begin(), upload_info_list.end(), offset,
+                    [](const VkDeviceSize value, const UploadInfo& upload_info) { return value < upload_info.dst_offset; });
+
+                is_valid = is_valid && iter != upload_info_list.begin() && offset + member_size <= (iter - 1)->dst_offset + (iter - 1)->size;
+            }
+        }
+
+        printf("%7u  %7u  %8llu  %10.3f  %10.1f  %11.1f  %8.3f  %8.3f\n",
+            dirty_percent, write_count, static_cast<unsigned long long>(region_count), static_cast<double>(region_count) / write_count,
+            static_cast<double>(staged_byte_count) / 1024.0, static_cast<double>(write_count) * member_size / 1024.0,
+            best_write_ms, best_coalesce_ms);
+    }
+
+    if (!is_valid)
+    {
+        printf("MISMATCH: copy regions overlap or miss a written member\n");
+        return 1;
+    }
+
+    return 0;
+}
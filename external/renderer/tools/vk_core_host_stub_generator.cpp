@@ -0,0 +1,224 @@
+// Generates host-only definitions of every function vk_core.hpp declares and every Vulkan command vulkan_core.h
+// prototypes, so the CPU-only benchmarks can drive the device-backed renderer classes without a device. Nothing is
+// written by hand: a stub returns a distinct non-null handle when its result is a handle and a value initialised
+// result otherwise (VK_SUCCESS, false, 0, empty lists, allocations without memory), and has no other effect.
+//
+// renderer_vk_core_host_stub_generator <vk_core.hpp> <vulkan_core.h> <output .cpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+struct FunctionDeclaration
+{
+    std::string return_type;
+    std::string declaration; // without the closing ';'
+};
+
+static std::string read_file(const char* const path)
+{
+    std::ifstream file(path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+
+    return stream.str();
+}
+
+static std::string trim(const std::string& text)
+{
+    const size_t begin = text.find_first_not_of(" \t\r\n");
+    const size_t end = text.find_last_not_of(" \t\r\n");
+
+    return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+}
+
+static std::string strip_comments(const std::string& text)
+{
+    std::string stripped;
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if (text.compare(i, 2, "//") == 0)
+        {
+            i = text.find('\n', i);
+
+            if (i == std::string::npos)
+            {
+                break;
+            }
+        }
+        else if (text.compare(i, 2, "/*") == 0)
+        {
+            i = text.find("*/", i);
+
+            if (i == std::string::npos)
+            {
+                break;
+            }
+
+            i++;
+            continue;
+        }
+
+        stripped += text[i];
+    }
+
+    return stripped;
+}
+
+// Statements directly inside namespace vk_core that declare a function, struct bodies are skipped.
+static std::vector<FunctionDeclaration> parse_vk_core_declarations(const std::string& header)
+{
+    std::vector<FunctionDeclaration> declaration_list;
+
+    const size_t namespace_pos = header.find("namespace vk_core");
+
+    if (namespace_pos == std::string::npos)
+    {
+        return declaration_list;
+    }
+
+    std::string statement;
+    uint32_t depth = 0;
+
+    for (size_t i = header.find('{', namespace_pos); i < header.size(); i++)
+    {
+        const char c = header[i];
+
+        if (c == '{' || c == '}')
+        {
+            depth = c == '{' ? depth + 1 : depth - 1;
+            statement.clear();
+
+            if (depth == 0)
+            {
+                break;
+            }
+        }
+        else if (depth == 1 && c == ';')
+        {
+            const std::string declaration = trim(statement);
+            const size_t paren_pos = declaration.find('(');
+            statement.clear();
+
+            if (paren_pos == std::string::npos)
+            {
+                continue;
+            }
+
+            const std::string head = trim(declaration.substr(0, paren_pos));
+            const size_t name_pos = head.find_last_of(" \t\n*&");
+
+            declaration_list.push_back({
+                .return_type = trim(head.substr(0, name_pos + 1)),
+                .declaration = declaration,
+            });
+        }
+        else if (depth == 1)
+        {
+            statement += c;
+        }
+    }
+
+    return declaration_list;
+}
+
+// VKAPI_ATTR <result> VKAPI_CALL vk<name>(<parameters>);
+static std::vector<FunctionDeclaration> parse_vulkan_prototypes(const std::string& header)
+{
+    std::vector<FunctionDeclaration> declaration_list;
+
+    for (size_t pos = header.find("VKAPI_ATTR "); pos != std::string::npos; pos = header.find("VKAPI_ATTR ", pos + 1))
+    {
+        const size_t call_pos = header.find(" VKAPI_CALL ", pos);
+        const size_t end_pos = header.find(';', pos);
+
+        if (call_pos == std::string::npos || end_pos == std::string::npos || call_pos > end_pos)
+        {
+            continue;
+        }
+
+        declaration_list.push_back({
+            .return_type = trim(header.substr(pos + 11, call_pos - pos - 11)),
+            .declaration = trim(header.substr(pos, end_pos - pos)),
+        });
+    }
+
+    return declaration_list;
+}
+
+static void write_definitions(std::ostringstream& stream, const std::vector<FunctionDeclaration>& declaration_list, const char* const indent)
+{
+    for (const FunctionDeclaration& function : declaration_list)
+    {
+        stream << indent << function.declaration << "\n"
+            << indent << "{\n"
+            << indent << "    return stub_result<" << function.return_type << ">();\n"
+            << indent << "}\n\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "usage: renderer_vk_core_host_stub_generator <vk_core.hpp> <vulkan_core.h> <output .cpp>\n");
+        return 1;
+    }
+
+    const std::vector<FunctionDeclaration> vk_core_declaration_list = parse_vk_core_declarations(strip_comments(read_file(argv[1])));
+    const std::vector<FunctionDeclaration> vulkan_declaration_list = parse_vulkan_prototypes(strip_comments(read_file(argv[2])));
+
+    if (vk_core_declaration_list.empty() || vulkan_declaration_list.empty())
+    {
+        fprintf(stderr, "no declarations found in %s or %s\n", argv[1], argv[2]);
+        return 1;
+    }
+
+    std::ostringstream stream;
+
+    stream << "// Generated by renderer_vk_core_host_stub_generator from " << argv[1] << " and " << argv[2] << ", do not edit.\n\n"
+        << "#include \"vk_core.hpp\"\n\n"
+        << "#include <vulkan/vulkan.h>\n\n"
+        << "#include <atomic>\n"
+        << "#include <stdint.h>\n"
+        << "#include <type_traits>\n\n"
+        << "static std::atomic<uintptr_t> s_next_handle { 1 };\n\n"
+        << "template<typename T>\n"
+        << "static T stub_result()\n"
+        << "{\n"
+        << "    if constexpr (std::is_pointer_v<T> && std::is_class_v<std::remove_pointer_t<T>>)\n"
+        << "    {\n"
+        << "        return reinterpret_cast<T>(s_next_handle++);\n"
+        << "    }\n"
+        << "    else if constexpr (!std::is_void_v<T>)\n"
+        << "    {\n"
+        << "        return T {};\n"
+        << "    }\n"
+        << "}\n\n"
+        << "namespace vk_core\n"
+        << "{\n";
+
+    write_definitions(stream, vk_core_declaration_list, "    ");
+
+    stream << "}; // vk_core\n\n";
+
+    write_definitions(stream, vulkan_declaration_list, "");
+
+    std::ofstream file(argv[3]);
+
+    if (!file)
+    {
+        fprintf(stderr, "cannot write %s\n", argv[3]);
+        return 1;
+    }
+
+    file << stream.str();
+
+    printf("%zu vk_core functions and %zu Vulkan commands stubbed into %s\n", vk_core_declaration_list.size(), vulkan_declaration_list.size(), argv[3]);
+
+    return 0;
+}
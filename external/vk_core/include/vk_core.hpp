@@ -10,7 +10,41 @@ class GLFWwindow;
 
 namespace vk_core
 {
+    // Range of a pooled (or dedicated) VkDeviceMemory. mapped_ptr points at offset and is valid for
+    // the lifetime of the allocation when the memory type is host visible, nullptr otherwise.
+    struct MemoryAllocation
+    {
+        VkDeviceMemory vk_handle_memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mapped_ptr = nullptr;
+        uint32_t pool_idx = UINT32_MAX;
+        uint32_t block_idx = UINT32_MAX; // UINT32_MAX for dedicated allocations
+    };
+
+    struct MemoryHeapStats
+    {
+        VkDeviceSize heap_size = 0;
+        VkDeviceSize block_byte_count = 0;
+        VkDeviceSize used_byte_count = 0;
+        VkDeviceSize dedicated_byte_count = 0;
+        uint32_t block_count = 0;
+        uint32_t allocation_count = 0;
+        uint32_t dedicated_allocation_count = 0;
+    };
+
+    // Pipelines created since init. is_warm when the config's "pipeline_cache" file was loaded and its header matched
+    // this driver and device, comparing pipeline_create_ns of a cold and a warm run gives the startup saving.
+    struct PipelineCacheStats
+    {
+        bool is_warm = false;
+        uint64_t loaded_byte_count = 0;
+        uint32_t pipeline_count = 0;
+        uint64_t pipeline_create_ns = 0; // summed over the create calls
+    };
+
     VkSampler create_sampler(const VkSamplerCreateInfo& create_info);
+    void destroy_sampler(const VkSampler vk_handle_sampler);
 
     VkImage create_image(const VkImageCreateInfo& create_info);
     VkImageView create_image_view(const VkImageViewCreateInfo& create_info);
@@ -24,13 +58,32 @@ namespace vk_core
     void bind_buffer_memory(const VkBuffer vk_handle_buffer, const VkDeviceMemory vk_handle_buffer_memory); 
     void destroy_buffer(const VkBuffer vk_handle_buffer);
 
+    // Sub-allocates memory for the resource out of per memory type blocks and binds it.
+    // Large resources and those the driver asks for get a dedicated VkDeviceMemory instead.
+    MemoryAllocation allocate_and_bind_buffer_memory(const VkBuffer vk_handle_buffer, const VkMemoryPropertyFlags flags);
+    MemoryAllocation allocate_and_bind_image_memory(const VkImage vk_handle_image, const VkMemoryPropertyFlags flags);
+    // Requirements of an image created from create_info, queried without creating the image.
+    VkMemoryRequirements get_image_memory_requirements(const VkImageCreateInfo& create_info);
+    bool has_memory_type(const uint32_t memory_type_indices, const VkMemoryPropertyFlags flags);
+    // Pooled image memory for explicit requirements, e.g. a range shared by several aliased images.
+    // The caller binds the images through bind_image_memory(image, allocation).
+    MemoryAllocation allocate_image_memory_for_requirements(const VkMemoryRequirements& memory_requirements, const VkMemoryPropertyFlags flags);
+    void bind_image_memory(const VkImage vk_handle_image, const MemoryAllocation& allocation);
+    void free_allocation(const MemoryAllocation& allocation);
+    // Indexed by memory heap.
+    std::vector<MemoryHeapStats> get_memory_heap_stats();
+
     VkShaderModule create_shader_module(const VkShaderModuleCreateInfo& create_info);
     void destroy_shader_module(const VkShaderModule vk_handle_shader_module);
 
+    // Both go through the pipeline cache, which terminate saves when the config names a "pipeline_cache" file.
     VkPipeline create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& create_info);
+    VkPipeline create_compute_pipeline(const VkComputePipelineCreateInfo& create_info);
     void destroy_pipeline(const VkPipeline vk_handle_pipeline);
+    PipelineCacheStats get_pipeline_cache_stats();
 
     VkCommandPool create_command_pool(const VkCommandPoolCreateFlags flags);
+    VkCommandPool create_transfer_command_pool(const VkCommandPoolCreateFlags flags);
     void reset_command_pool(const VkCommandPool pool);
     void destroy_command_pool(const VkCommandPool pool);
 
@@ -59,6 +112,8 @@ namespace vk_core
     // Events
 
     void queue_submit(const uint32_t submit_count, const VkSubmitInfo* const p_submit_infos, const VkFence vk_handle_signal_fence);
+    // Submits to the transfer queue. Aliases the graphics queue when the device has no separate transfer family.
+    void transfer_queue_submit(const uint32_t submit_count, const VkSubmitInfo* const p_submit_infos, const VkFence vk_handle_signal_fence);
 
     void device_wait_idle();
 
@@ -70,11 +125,26 @@ namespace vk_core
     void reset_fences(const uint32_t fence_count, const VkFence* vk_handle_fence_list);
     void destroy_fence(const VkFence vk_handle_fence);
 
+    VkSemaphore create_semaphore(); // binary
+    VkSemaphore create_timeline_semaphore(const uint64_t initial_value);
+    uint64_t get_semaphore_counter_value(const VkSemaphore vk_handle_sem4);
+    void wait_semaphore(const VkSemaphore vk_handle_sem4, const uint64_t value, const uint64_t timeout);
+    void destroy_semaphore(const VkSemaphore vk_handle_sem4);
+
     // Getters
 
     VkImageMemoryBarrier get_active_swapchain_image_memory_barrier(const VkAccessFlags src_access_flags, const VkAccessFlags dst_access_flags, const VkImageLayout old_layout, const VkImageLayout new_layout);
     uint32_t get_queue_family_idx();
+    uint32_t get_transfer_queue_family_idx();
+    bool has_dedicated_transfer_queue();
+    // Optional device features, enabled at init whenever supported.
+    bool has_multi_draw_indirect(); // multiDrawIndirect together with drawIndirectFirstInstance
+    bool has_draw_indirect_count();
+    bool has_index_type_uint8();
+    bool has_extended_dynamic_state(); // vkCmdSetCullMode / FrontFace / PrimitiveTopology / DepthTestEnable / DepthWriteEnable / DepthCompareOp
     VkImage get_active_swapchain_image();
+    uint32_t get_active_swapchain_image_idx();
+    uint32_t get_swapchain_image_count();
 };
 
 
@@ -6,8 +6,14 @@
 #include "json.hpp"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <map>
 #include <vector>
 
 #define LOG(fmt, ...)                    \
@@ -202,7 +208,91 @@ static uint32_t select_queue_family_index(VkPhysicalDevice physicalDevice, VkSur
     return graphicsQueueFamilyIndex;
 }
 
-static VkDevice create_device(const nlohmann::json& json_data, const VkPhysicalDevice physical_device, const uint32_t q_fam_idx)
+// Prefers a transfer-only family (dedicated DMA engine), then any other transfer-capable family.
+// Falls back to the graphics family, in which case all "transfer" work shares the graphics queue.
+static uint32_t select_transfer_queue_family_index(VkPhysicalDevice physicalDevice, const uint32_t graphics_q_fam_idx)
+{
+    uint32_t numQueueFamilyProperties = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueueFamilyProperties, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(numQueueFamilyProperties);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueueFamilyProperties, queueFamilyProperties.data());
+
+    // Graphics and compute queues implicitly support transfer.
+    const VkQueueFlags transfer_capable_flags = VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+
+    uint32_t transferQueueFamilyIndex = graphics_q_fam_idx;
+    for (uint32_t i = 0; i < numQueueFamilyProperties; ++i)
+    {
+        const VkQueueFlags flags = queueFamilyProperties[i].queueFlags;
+
+        if (i == graphics_q_fam_idx || !(flags & transfer_capable_flags))
+            continue;
+
+        if (!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+        {
+            transferQueueFamilyIndex = i;
+            break;
+        }
+
+        if (transferQueueFamilyIndex == graphics_q_fam_idx)
+            transferQueueFamilyIndex = i;
+    }
+
+    return transferQueueFamilyIndex;
+}
+
+// Optional features, enabled whenever the physical device supports them.
+struct OptionalDeviceFeatures
+{
+    bool multi_draw_indirect = false; // multiDrawIndirect + drawIndirectFirstInstance (draw ids travel in firstInstance)
+    bool draw_indirect_count = false;
+    bool index_type_uint8 = false; // VK_EXT_index_type_uint8, the renderer then draws meshes with 8 bit indices
+    // VK_EXT_extended_dynamic_state, core (without a feature bit) from Vulkan 1.3. The device already needs 1.3 for
+    // dynamicRendering, so only the version the physical device reports is checked.
+    bool extended_dynamic_state = false;
+};
+
+static OptionalDeviceFeatures query_optional_device_features(const VkPhysicalDevice physical_device)
+{
+    uint32_t extension_count = 0;
+    VK_CHECK(vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr));
+    std::vector<VkExtensionProperties> extension_list(extension_count);
+    VK_CHECK(vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, extension_list.data()));
+
+    const bool has_index_type_uint8_extension = std::any_of(extension_list.begin(), extension_list.end(), [](const VkExtensionProperties& extension)
+    {
+        return strcmp(extension.extensionName, VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME) == 0;
+    });
+
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT features_index_type_uint8 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT,
+        .pNext = nullptr,
+    };
+
+    VkPhysicalDeviceVulkan12Features features12 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = has_index_type_uint8_extension ? &features_index_type_uint8 : nullptr,
+    };
+
+    VkPhysicalDeviceFeatures2 features2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &features12,
+    };
+
+    vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    return {
+        .multi_draw_indirect = features2.features.multiDrawIndirect == VK_TRUE && features2.features.drawIndirectFirstInstance == VK_TRUE,
+        .draw_indirect_count = features12.drawIndirectCount == VK_TRUE,
+        .index_type_uint8 = features_index_type_uint8.indexTypeUint8 == VK_TRUE,
+        .extended_dynamic_state = properties.apiVersion >= VK_API_VERSION_1_3,
+    };
+}
+
+static VkDevice create_device(const nlohmann::json& json_data, const VkPhysicalDevice physical_device, const uint32_t q_fam_idx, const uint32_t transfer_q_fam_idx, const OptionalDeviceFeatures& optional_features)
 {
     const ConfigInfoDevice config_info = json_data.at("device").get<ConfigInfoDevice>();
 
@@ -214,31 +304,66 @@ static VkDevice create_device(const nlohmann::json& json_data, const VkPhysicalD
     for (uint32_t i = 0; i < extensions.size(); ++i)
         extensions[i] = config_info.extensions.at(i).c_str();
 
+    if (optional_features.index_type_uint8 && std::find_if(extensions.begin(), extensions.end(), [](const char* extension) { return strcmp(extension, VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME) == 0; }) == extensions.end())
+    {
+        extensions.push_back(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+    }
+
     const float q_priority = 1.0f;
 
-    const VkDeviceQueueCreateInfo queue_create_info = {
-        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-        .queueFamilyIndex = q_fam_idx,
-        .queueCount = 1,
-        .pQueuePriorities = &q_priority
+    std::vector<VkDeviceQueueCreateInfo> queue_create_info_list {
+        {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = q_fam_idx,
+            .queueCount = 1,
+            .pQueuePriorities = &q_priority
+        }
     };
 
-    const VkPhysicalDeviceVulkan13Features vk_physicalDeviceFeatures13 {
-        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+    if (transfer_q_fam_idx != q_fam_idx)
+    {
+        queue_create_info_list.push_back({
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = transfer_q_fam_idx,
+            .queueCount = 1,
+            .pQueuePriorities = &q_priority
+        });
+    }
+
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT vk_physicalDeviceFeaturesIndexTypeUint8 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT,
         .pNext = nullptr,
+        .indexTypeUint8 = VK_TRUE
+    };
+
+    VkPhysicalDeviceVulkan13Features vk_physicalDeviceFeatures13 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .pNext = optional_features.index_type_uint8 ? &vk_physicalDeviceFeaturesIndexTypeUint8 : nullptr,
         .dynamicRendering = VK_TRUE
     };
 
+    const VkPhysicalDeviceVulkan12Features vk_physicalDeviceFeatures12 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = &vk_physicalDeviceFeatures13,
+        .drawIndirectCount = optional_features.draw_indirect_count ? VK_TRUE : VK_FALSE,
+        .timelineSemaphore = VK_TRUE
+    };
+
+    const VkPhysicalDeviceFeatures vk_physicalDeviceFeatures {
+        .multiDrawIndirect = optional_features.multi_draw_indirect ? VK_TRUE : VK_FALSE,
+        .drawIndirectFirstInstance = optional_features.multi_draw_indirect ? VK_TRUE : VK_FALSE,
+    };
+
     const VkDeviceCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext =  &vk_physicalDeviceFeatures13,
-        .queueCreateInfoCount = 1,
-        .pQueueCreateInfos = &queue_create_info,
+        .pNext =  &vk_physicalDeviceFeatures12,
+        .queueCreateInfoCount = static_cast<uint32_t>(queue_create_info_list.size()),
+        .pQueueCreateInfos = queue_create_info_list.data(),
         .enabledLayerCount = static_cast<uint32_t>(layers.size()),
         .ppEnabledLayerNames = (layers.size() == 0) ? nullptr : layers.data(),
         .enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
         .ppEnabledExtensionNames = extensions.data(),
-        .pEnabledFeatures = nullptr
+        .pEnabledFeatures = &vk_physicalDeviceFeatures
     };
 
     VkDevice device = VK_NULL_HANDLE;
@@ -513,6 +638,94 @@ static std::vector<VkImageView> create_swapchain_image_views(const VkDevice vk_d
     return vk_swapchainImageViews;
 }
 
+// Contents of the pipeline cache file, empty when it is missing or was written by another driver or device.
+// The header layout is VkPipelineCacheHeaderVersionOne, see the vkGetPipelineCacheData spec.
+static std::vector<uint8_t> read_pipeline_cache_file(const std::string& file_name, const VkPhysicalDevice physical_device)
+{
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open())
+    {
+        LOG("Vulkan Info - No pipeline cache at %s, starting cold\n", file_name.c_str());
+        return {};
+    }
+
+    std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    VkPipelineCacheHeaderVersionOne header {};
+
+    if (!file || data.size() < sizeof(header))
+    {
+        LOG("Vulkan Info - Pipeline cache %s is truncated, starting cold\n", file_name.c_str());
+        return {};
+    }
+
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (header.headerSize < sizeof(header) || header.headerSize > data.size() ||
+        header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header.vendorID != properties.vendorID ||
+        header.deviceID != properties.deviceID ||
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        LOG("Vulkan Info - Pipeline cache %s belongs to another device or driver, starting cold\n", file_name.c_str());
+        return {};
+    }
+
+    return data;
+}
+
+static VkPipelineCache create_pipeline_cache(const VkDevice vk_device, const std::vector<uint8_t>& initial_data)
+{
+    const VkPipelineCacheCreateInfo create_info {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .initialDataSize = initial_data.size(),
+        .pInitialData = initial_data.empty() ? nullptr : initial_data.data(),
+    };
+
+    VkPipelineCache vk_pipeline_cache = VK_NULL_HANDLE;
+    VK_CHECK(vkCreatePipelineCache(vk_device, &create_info, nullptr, &vk_pipeline_cache));
+
+    return vk_pipeline_cache;
+}
+
+// Written next to the file and renamed over it, so a crash mid-write never leaves a torn cache behind.
+static uint64_t write_pipeline_cache_file(const std::string& file_name, const VkDevice vk_device, const VkPipelineCache vk_pipeline_cache)
+{
+    size_t size = 0;
+    VK_CHECK(vkGetPipelineCacheData(vk_device, vk_pipeline_cache, &size, nullptr));
+
+    std::vector<uint8_t> data(size);
+    VK_CHECK(vkGetPipelineCacheData(vk_device, vk_pipeline_cache, &size, data.data()));
+
+    const std::string tmp_file_name = file_name + ".tmp";
+    FILE* const file = fopen(tmp_file_name.c_str(), "wb");
+
+    if (!file)
+    {
+        LOG("WARNING - Could not write pipeline cache %s\n", tmp_file_name.c_str());
+        return 0;
+    }
+
+    const bool is_written = fwrite(data.data(), 1, size, file) == size;
+
+    if (fclose(file) != 0 || !is_written || rename(tmp_file_name.c_str(), file_name.c_str()) != 0)
+    {
+        LOG("WARNING - Could not write pipeline cache %s\n", file_name.c_str());
+        remove(tmp_file_name.c_str());
+        return 0;
+    }
+
+    return size;
+}
+
 
 namespace vk_core
 {
@@ -524,12 +737,40 @@ static VkPhysicalDeviceMemoryProperties vk_phys_dev_mem_props;
 static VkDevice vk_handle_device = VK_NULL_HANDLE;
 static VkQueue vk_handle_queue = VK_NULL_HANDLE;
 static uint32_t queue_family_idx = 0u;
+static VkQueue vk_handle_transfer_queue = VK_NULL_HANDLE;
+static uint32_t transfer_queue_family_idx = 0u;
+static OptionalDeviceFeatures optional_device_features {};
 static VkSwapchainKHR vk_handle_swapchain = VK_NULL_HANDLE;
 static std::vector<VkImage> vk_handle_swapchain_image_list;
 static std::vector<VkImageView> vk_handle_swapchain_image_view_list;
 static VkFormat vk_format_swapchain_image = VK_FORMAT_UNDEFINED;
 static uint32_t active_swapchain_image_idx = 0u;
 
+// Every pipeline goes through the cache. It is loaded from and saved to pipeline_cache_file when the config names one.
+static VkPipelineCache vk_handle_pipeline_cache = VK_NULL_HANDLE;
+static std::string pipeline_cache_file;
+static bool is_pipeline_cache_warm = false;
+static uint64_t pipeline_cache_loaded_byte_count = 0;
+static std::atomic<uint32_t> pipeline_count { 0 };
+static std::atomic<uint64_t> pipeline_create_ns { 0 };
+
+// Device memory sub-allocator. Pools are keyed by memory type and resource kind (buffer / image), which keeps
+// linear and optimally tiled resources in separate blocks so bufferImageGranularity never applies between neighbours.
+// Blocks of host visible memory types stay mapped for their whole lifetime.
+struct MemoryBlock
+{
+    VkDeviceMemory vk_handle_memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    VkDeviceSize used_size = 0;
+    uint8_t* mapped_ptr = nullptr;
+    uint32_t allocation_count = 0;
+    std::map<VkDeviceSize, VkDeviceSize> free_range_map; // offset -> size
+};
+
+static constexpr VkDeviceSize s_memory_block_size = 64ull << 20;
+static std::array<std::vector<MemoryBlock>, VK_MAX_MEMORY_TYPES * 2> memory_pool_list;
+static std::array<MemoryHeapStats, VK_MAX_MEMORY_HEAPS> memory_heap_dedicated_stats_list {};
+
 uint32_t get_memory_type_idx(const uint32_t memory_type_indices, const VkMemoryPropertyFlags memory_property_flags)
 {
    	// Iterate over all memory types available for the device used in this example
@@ -558,8 +799,23 @@ void init(const uint32_t window_width, const uint32_t window_height, GLFWwindow*
     vk_handle_surface = create_surface(vk_handle_instance, window);
     vk_handle_physical_device = select_physical_device(vk_handle_instance);
     queue_family_idx = select_queue_family_index(vk_handle_physical_device, vk_handle_surface);
-    vk_handle_device = create_device(json_data, vk_handle_physical_device, queue_family_idx);
+    transfer_queue_family_idx = select_transfer_queue_family_index(vk_handle_physical_device, queue_family_idx);
+    optional_device_features = query_optional_device_features(vk_handle_physical_device);
+    vk_handle_device = create_device(json_data, vk_handle_physical_device, queue_family_idx, transfer_queue_family_idx, optional_device_features);
     vk_handle_queue = get_queue(vk_handle_device, queue_family_idx);
+    vk_handle_transfer_queue = get_queue(vk_handle_device, transfer_queue_family_idx);
+
+    std::vector<uint8_t> pipeline_cache_data;
+
+    if (json_data.contains("pipeline_cache"))
+    {
+        pipeline_cache_file = json_data.at("pipeline_cache").at("file").get<std::string>();
+        pipeline_cache_data = read_pipeline_cache_file(pipeline_cache_file, vk_handle_physical_device);
+    }
+
+    vk_handle_pipeline_cache = create_pipeline_cache(vk_handle_device, pipeline_cache_data);
+    is_pipeline_cache_warm = !pipeline_cache_data.empty();
+    pipeline_cache_loaded_byte_count = pipeline_cache_data.size();
 
     const VkSwapchainCreateInfoKHR swapchain_create_info = populate_swapchain_create_info(json_data, vk_handle_physical_device, vk_handle_surface, vk_handle_device, { window_width, window_height });
     vk_handle_swapchain = create_swapchain(vk_handle_device, swapchain_create_info);
@@ -646,6 +902,24 @@ void terminate()
         vkDestroyImageView(vk_handle_device, vk_handle_swapchain_image_view_list[i], nullptr);
     }
 
+    for (std::vector<MemoryBlock>& pool : memory_pool_list)
+    {
+        for (const MemoryBlock& block : pool)
+        {
+            ASSERT(block.allocation_count == 0, "vk_core - Memory block freed with %u live allocations!\n", block.allocation_count);
+            vkFreeMemory(vk_handle_device, block.vk_handle_memory, nullptr);
+        }
+
+        pool.clear();
+    }
+
+    if (!pipeline_cache_file.empty())
+    {
+        const uint64_t saved_byte_count = write_pipeline_cache_file(pipeline_cache_file, vk_handle_device, vk_handle_pipeline_cache);
+        LOG("Vulkan Info - Pipeline cache: %lu bytes loaded, %lu bytes saved to %s\n", pipeline_cache_loaded_byte_count, saved_byte_count, pipeline_cache_file.c_str());
+    }
+
+    vkDestroyPipelineCache(vk_handle_device, vk_handle_pipeline_cache, nullptr);
     vkDestroySwapchainKHR(vk_handle_device, vk_handle_swapchain, nullptr);
     vkDestroyDevice(vk_handle_device, nullptr);
     vkDestroySurfaceKHR(vk_handle_instance, vk_handle_surface, nullptr);
@@ -661,6 +935,11 @@ VkSampler create_sampler(const VkSamplerCreateInfo& create_info)
     return vk_handle_sampler;;
 }
 
+void destroy_sampler(const VkSampler vk_handle_sampler)
+{
+    vkDestroySampler(vk_handle_device, vk_handle_sampler, nullptr);
+}
+
 VkImage create_image(const VkImageCreateInfo& create_info)
 {
     VkImage image = VK_NULL_HANDLE;
@@ -688,7 +967,7 @@ VkDeviceMemory allocate_image_memory(const VkImage vk_handle_image, const VkMemo
     };
 
     VkDeviceMemory vk_image_memory = VK_NULL_HANDLE;
-    vkAllocateMemory(vk_handle_device, &memory_alloc_info, nullptr, &vk_image_memory);
+    VK_CHECK(vkAllocateMemory(vk_handle_device, &memory_alloc_info, nullptr, &vk_image_memory));
     return vk_image_memory;
 }
 
@@ -727,7 +1006,7 @@ VkDeviceMemory allocate_buffer_memory(const VkBuffer vk_handle_buffer, const VkM
     };
 
     VkDeviceMemory vk_buffer_memory = VK_NULL_HANDLE;
-    vkAllocateMemory(vk_handle_device, &memory_alloc_info, nullptr, &vk_buffer_memory);
+    VK_CHECK(vkAllocateMemory(vk_handle_device, &memory_alloc_info, nullptr, &vk_buffer_memory));
 
     size = memory_requirements.size;
     return vk_buffer_memory;
@@ -744,6 +1023,369 @@ void destroy_buffer(const VkBuffer vk_handle_buffer)
     vkDestroyBuffer(vk_handle_device, vk_handle_buffer, nullptr);
 }
 
+static VkDeviceSize get_memory_block_size(const uint32_t memory_type_idx)
+{
+    // Small heaps (e.g. the 256 MiB device local + host visible heap) get proportionally smaller blocks.
+    const VkDeviceSize heap_size = vk_phys_dev_mem_props.memoryHeaps[vk_phys_dev_mem_props.memoryTypes[memory_type_idx].heapIndex].size;
+    return heap_size <= (1ull << 30) ? heap_size / 8 : s_memory_block_size;
+}
+
+static VkDeviceMemory allocate_device_memory(const VkDeviceSize size, const uint32_t memory_type_idx, const void* const p_next, VkResult& result)
+{
+    const VkMemoryAllocateInfo memory_alloc_info {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = p_next,
+        .allocationSize = size,
+        .memoryTypeIndex = memory_type_idx,
+    };
+
+    VkDeviceMemory vk_handle_memory = VK_NULL_HANDLE;
+    result = vkAllocateMemory(vk_handle_device, &memory_alloc_info, nullptr, &vk_handle_memory);
+    return vk_handle_memory;
+}
+
+static uint8_t* map_whole_memory(const VkDeviceMemory vk_handle_memory, const uint32_t memory_type_idx)
+{
+    if (!(vk_phys_dev_mem_props.memoryTypes[memory_type_idx].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+    {
+        return nullptr;
+    }
+
+    void* mapped_ptr = nullptr;
+    VK_CHECK(vkMapMemory(vk_handle_device, vk_handle_memory, 0, VK_WHOLE_SIZE, 0x0, &mapped_ptr));
+    return static_cast<uint8_t*>(mapped_ptr);
+}
+
+static uint32_t create_memory_block(std::vector<MemoryBlock>& pool, const uint32_t memory_type_idx, const VkDeviceSize min_size)
+{
+    // Halve the block on out of memory, down to what the request needs.
+    VkDeviceSize block_size = std::max(get_memory_block_size(memory_type_idx), min_size);
+    VkResult result = VK_SUCCESS;
+    VkDeviceMemory vk_handle_memory = VK_NULL_HANDLE;
+
+    while (true)
+    {
+        vk_handle_memory = allocate_device_memory(block_size, memory_type_idx, nullptr, result);
+
+        if (result == VK_SUCCESS || block_size / 2 < min_size || (result != VK_ERROR_OUT_OF_DEVICE_MEMORY && result != VK_ERROR_OUT_OF_HOST_MEMORY))
+        {
+            break;
+        }
+
+        block_size /= 2;
+    }
+
+    ASSERT(result == VK_SUCCESS, "vk_core - Failed to allocate %lu byte memory block of type %u (VkResult %d)!\n", block_size, memory_type_idx, (int)result);
+
+    MemoryBlock block {};
+    block.vk_handle_memory = vk_handle_memory;
+    block.size = block_size;
+    block.mapped_ptr = map_whole_memory(vk_handle_memory, memory_type_idx);
+    block.free_range_map.emplace(0, block_size);
+
+    for (uint32_t block_idx = 0; block_idx < pool.size(); block_idx++)
+    {
+        if (pool[block_idx].vk_handle_memory == VK_NULL_HANDLE)
+        {
+            pool[block_idx] = std::move(block);
+            return block_idx;
+        }
+    }
+
+    pool.push_back(std::move(block));
+    return static_cast<uint32_t>(pool.size() - 1);
+}
+
+static bool try_sub_allocate(MemoryBlock& block, const VkMemoryRequirements& memory_requirements, VkDeviceSize& offset)
+{
+    // First fit, the range in front of the aligned start and the tail stay free.
+    for (auto iter = block.free_range_map.begin(); iter != block.free_range_map.end(); ++iter)
+    {
+        const VkDeviceSize range_offset = iter->first;
+        const VkDeviceSize range_end = iter->first + iter->second;
+        const VkDeviceSize aligned_offset = ((range_offset + memory_requirements.alignment - 1) / memory_requirements.alignment) * memory_requirements.alignment;
+
+        if (aligned_offset + memory_requirements.size > range_end)
+        {
+            continue;
+        }
+
+        block.free_range_map.erase(iter);
+
+        if (aligned_offset > range_offset)
+        {
+            block.free_range_map.emplace(range_offset, aligned_offset - range_offset);
+        }
+
+        if (aligned_offset + memory_requirements.size < range_end)
+        {
+            block.free_range_map.emplace(aligned_offset + memory_requirements.size, range_end - aligned_offset - memory_requirements.size);
+        }
+
+        offset = aligned_offset;
+        return true;
+    }
+
+    return false;
+}
+
+static MemoryAllocation allocate_memory(const VkMemoryRequirements& memory_requirements, const VkMemoryDedicatedRequirements& dedicated_requirements,
+    const VkMemoryPropertyFlags flags, const bool is_image, const VkBuffer vk_handle_buffer, const VkImage vk_handle_image)
+{
+    const uint32_t memory_type_idx = get_memory_type_idx(memory_requirements.memoryTypeBits, flags);
+    const uint32_t pool_idx = memory_type_idx * 2 + (is_image ? 1 : 0);
+    const bool use_dedicated = dedicated_requirements.requiresDedicatedAllocation || dedicated_requirements.prefersDedicatedAllocation ||
+        memory_requirements.size > get_memory_block_size(memory_type_idx) / 2;
+
+    MemoryAllocation allocation {};
+    allocation.size = memory_requirements.size;
+    allocation.pool_idx = pool_idx;
+
+    if (use_dedicated)
+    {
+        const VkMemoryDedicatedAllocateInfo dedicated_alloc_info {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .image = vk_handle_image,
+            .buffer = vk_handle_buffer,
+        };
+
+        // Memory without an owning resource (e.g. shared by aliased images) is dedicated to nothing in particular.
+        const bool has_owner = vk_handle_buffer != VK_NULL_HANDLE || vk_handle_image != VK_NULL_HANDLE;
+
+        VkResult result = VK_SUCCESS;
+        allocation.vk_handle_memory = allocate_device_memory(memory_requirements.size, memory_type_idx, has_owner ? &dedicated_alloc_info : nullptr, result);
+        ASSERT(result == VK_SUCCESS, "vk_core - Failed to allocate %lu byte dedicated memory of type %u (VkResult %d)!\n", memory_requirements.size, memory_type_idx, (int)result);
+        allocation.mapped_ptr = map_whole_memory(allocation.vk_handle_memory, memory_type_idx);
+
+        MemoryHeapStats& stats = memory_heap_dedicated_stats_list[vk_phys_dev_mem_props.memoryTypes[memory_type_idx].heapIndex];
+        stats.dedicated_allocation_count++;
+        stats.dedicated_byte_count += memory_requirements.size;
+
+        return allocation;
+    }
+
+    std::vector<MemoryBlock>& pool = memory_pool_list[pool_idx];
+
+    uint32_t block_idx = 0;
+    VkDeviceSize offset = 0;
+
+    for (; block_idx < pool.size(); block_idx++)
+    {
+        if (pool[block_idx].vk_handle_memory != VK_NULL_HANDLE && try_sub_allocate(pool[block_idx], memory_requirements, offset))
+        {
+            break;
+        }
+    }
+
+    if (block_idx == pool.size())
+    {
+        block_idx = create_memory_block(pool, memory_type_idx, memory_requirements.size);
+        const bool allocated = try_sub_allocate(pool[block_idx], memory_requirements, offset);
+        ASSERT(allocated, "vk_core - Fresh memory block too small for %lu bytes!\n", memory_requirements.size);
+    }
+
+    MemoryBlock& block = pool[block_idx];
+    block.allocation_count++;
+    block.used_size += memory_requirements.size;
+
+    allocation.vk_handle_memory = block.vk_handle_memory;
+    allocation.offset = offset;
+    allocation.block_idx = block_idx;
+    allocation.mapped_ptr = block.mapped_ptr ? block.mapped_ptr + offset : nullptr;
+
+    return allocation;
+}
+
+MemoryAllocation allocate_and_bind_buffer_memory(const VkBuffer vk_handle_buffer, const VkMemoryPropertyFlags flags)
+{
+    VkMemoryDedicatedRequirements dedicated_requirements {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+        .pNext = nullptr,
+    };
+
+    VkMemoryRequirements2 memory_requirements {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+        .pNext = &dedicated_requirements,
+    };
+
+    const VkBufferMemoryRequirementsInfo2 requirements_info {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,
+        .pNext = nullptr,
+        .buffer = vk_handle_buffer,
+    };
+
+    vkGetBufferMemoryRequirements2(vk_handle_device, &requirements_info, &memory_requirements);
+
+    const MemoryAllocation allocation = allocate_memory(memory_requirements.memoryRequirements, dedicated_requirements, flags, false, vk_handle_buffer, VK_NULL_HANDLE);
+    VK_CHECK(vkBindBufferMemory(vk_handle_device, vk_handle_buffer, allocation.vk_handle_memory, allocation.offset));
+
+    return allocation;
+}
+
+MemoryAllocation allocate_and_bind_image_memory(const VkImage vk_handle_image, const VkMemoryPropertyFlags flags)
+{
+    VkMemoryDedicatedRequirements dedicated_requirements {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+        .pNext = nullptr,
+    };
+
+    VkMemoryRequirements2 memory_requirements {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+        .pNext = &dedicated_requirements,
+    };
+
+    const VkImageMemoryRequirementsInfo2 requirements_info {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,
+        .pNext = nullptr,
+        .image = vk_handle_image,
+    };
+
+    vkGetImageMemoryRequirements2(vk_handle_device, &requirements_info, &memory_requirements);
+
+    const MemoryAllocation allocation = allocate_memory(memory_requirements.memoryRequirements, dedicated_requirements, flags, true, VK_NULL_HANDLE, vk_handle_image);
+    VK_CHECK(vkBindImageMemory(vk_handle_device, vk_handle_image, allocation.vk_handle_memory, allocation.offset));
+
+    return allocation;
+}
+
+VkMemoryRequirements get_image_memory_requirements(const VkImageCreateInfo& create_info)
+{
+    const VkDeviceImageMemoryRequirements requirements_info {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS,
+        .pNext = nullptr,
+        .pCreateInfo = &create_info,
+        .planeAspect = VK_IMAGE_ASPECT_COLOR_BIT,
+    };
+
+    VkMemoryRequirements2 memory_requirements {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+        .pNext = nullptr,
+    };
+
+    vkGetDeviceImageMemoryRequirements(vk_handle_device, &requirements_info, &memory_requirements);
+
+    return memory_requirements.memoryRequirements;
+}
+
+bool has_memory_type(const uint32_t memory_type_indices, const VkMemoryPropertyFlags flags)
+{
+    for (uint32_t i = 0; i < vk_phys_dev_mem_props.memoryTypeCount; i++)
+    {
+        if (memory_type_indices & (1 << i) && (vk_phys_dev_mem_props.memoryTypes[i].propertyFlags & flags) == flags)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+MemoryAllocation allocate_image_memory_for_requirements(const VkMemoryRequirements& memory_requirements, const VkMemoryPropertyFlags flags)
+{
+    const VkMemoryDedicatedRequirements dedicated_requirements {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+        .pNext = nullptr,
+        .prefersDedicatedAllocation = VK_FALSE,
+        .requiresDedicatedAllocation = VK_FALSE,
+    };
+
+    return allocate_memory(memory_requirements, dedicated_requirements, flags, true, VK_NULL_HANDLE, VK_NULL_HANDLE);
+}
+
+void bind_image_memory(const VkImage vk_handle_image, const MemoryAllocation& allocation)
+{
+    VK_CHECK(vkBindImageMemory(vk_handle_device, vk_handle_image, allocation.vk_handle_memory, allocation.offset));
+}
+
+void free_allocation(const MemoryAllocation& allocation)
+{
+    if (allocation.vk_handle_memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    const uint32_t memory_type_idx = allocation.pool_idx / 2;
+
+    if (allocation.block_idx == UINT32_MAX)
+    {
+        vkFreeMemory(vk_handle_device, allocation.vk_handle_memory, nullptr);
+
+        MemoryHeapStats& stats = memory_heap_dedicated_stats_list[vk_phys_dev_mem_props.memoryTypes[memory_type_idx].heapIndex];
+        stats.dedicated_allocation_count--;
+        stats.dedicated_byte_count -= allocation.size;
+        return;
+    }
+
+    std::vector<MemoryBlock>& pool = memory_pool_list[allocation.pool_idx];
+    MemoryBlock& block = pool[allocation.block_idx];
+
+    VkDeviceSize offset = allocation.offset;
+    VkDeviceSize size = allocation.size;
+
+    // Coalesce with both neighbours.
+    const auto next = block.free_range_map.lower_bound(offset);
+    if (next != block.free_range_map.end() && next->first == offset + size)
+    {
+        size += next->second;
+        block.free_range_map.erase(next);
+    }
+
+    const auto prev = block.free_range_map.lower_bound(offset);
+    if (prev != block.free_range_map.begin() && std::prev(prev)->first + std::prev(prev)->second == offset)
+    {
+        offset = std::prev(prev)->first;
+        size += std::prev(prev)->second;
+        block.free_range_map.erase(std::prev(prev));
+    }
+
+    block.free_range_map.emplace(offset, size);
+    block.allocation_count--;
+    block.used_size -= allocation.size;
+
+    // Keep one empty block per pool around to avoid thrashing vkAllocateMemory on alloc / free cycles.
+    if (block.allocation_count == 0)
+    {
+        const uint32_t live_block_count = static_cast<uint32_t>(std::count_if(pool.begin(), pool.end(), [](const MemoryBlock& b) { return b.vk_handle_memory != VK_NULL_HANDLE; }));
+
+        if (live_block_count > 1)
+        {
+            vkFreeMemory(vk_handle_device, block.vk_handle_memory, nullptr);
+            block = MemoryBlock {};
+        }
+    }
+}
+
+std::vector<MemoryHeapStats> get_memory_heap_stats()
+{
+    std::vector<MemoryHeapStats> heap_stats_list(vk_phys_dev_mem_props.memoryHeapCount);
+
+    for (uint32_t heap_idx = 0; heap_idx < vk_phys_dev_mem_props.memoryHeapCount; heap_idx++)
+    {
+        heap_stats_list[heap_idx] = memory_heap_dedicated_stats_list[heap_idx];
+        heap_stats_list[heap_idx].heap_size = vk_phys_dev_mem_props.memoryHeaps[heap_idx].size;
+    }
+
+    for (uint32_t pool_idx = 0; pool_idx < memory_pool_list.size(); pool_idx++)
+    {
+        for (const MemoryBlock& block : memory_pool_list[pool_idx])
+        {
+            if (block.vk_handle_memory == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            MemoryHeapStats& stats = heap_stats_list[vk_phys_dev_mem_props.memoryTypes[pool_idx / 2].heapIndex];
+            stats.block_count++;
+            stats.block_byte_count += block.size;
+            stats.used_byte_count += block.used_size;
+            stats.allocation_count += block.allocation_count;
+        }
+    }
+
+    return heap_stats_list;
+}
+
 VkShaderModule create_shader_module(const VkShaderModuleCreateInfo& create_info)
 {
     VkShaderModule vk_handle_shader_module = VK_NULL_HANDLE;
@@ -757,13 +1399,46 @@ void destroy_shader_module(const VkShaderModule vk_handle_shader_module)
 }
 
 
+static void add_pipeline_create_time(const std::chrono::steady_clock::time_point create_start)
+{
+    pipeline_count++;
+    pipeline_create_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - create_start).count());
+}
+
 VkPipeline create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& create_info)
 {
+    const auto create_start = std::chrono::steady_clock::now();
+
     VkPipeline vk_handle_pipeline = VK_NULL_HANDLE;
-    VK_CHECK(vkCreateGraphicsPipelines(vk_handle_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &vk_handle_pipeline));
+    VK_CHECK(vkCreateGraphicsPipelines(vk_handle_device, vk_handle_pipeline_cache, 1, &create_info, nullptr, &vk_handle_pipeline));
+
+    add_pipeline_create_time(create_start);
     return vk_handle_pipeline;
 }
 
+VkPipeline create_compute_pipeline(const VkComputePipelineCreateInfo& create_info)
+{
+    const auto create_start = std::chrono::steady_clock::now();
+
+    VkPipeline vk_handle_pipeline = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateComputePipelines(vk_handle_device, vk_handle_pipeline_cache, 1, &create_info, nullptr, &vk_handle_pipeline));
+
+    add_pipeline_create_time(create_start);
+    return vk_handle_pipeline;
+}
+
+PipelineCacheStats get_pipeline_cache_stats()
+{
+    const PipelineCacheStats stats {
+        .is_warm = is_pipeline_cache_warm,
+        .loaded_byte_count = pipeline_cache_loaded_byte_count,
+        .pipeline_count = pipeline_count.load(),
+        .pipeline_create_ns = pipeline_create_ns.load(),
+    };
+
+    return stats;
+}
+
 void destroy_pipeline(const VkPipeline vk_handle_pipeline)
 {
     vkDestroyPipeline(vk_handle_device, vk_handle_pipeline, nullptr);
@@ -784,6 +1459,20 @@ VkCommandPool create_command_pool(const VkCommandPoolCreateFlags flags)
     return cmd_pool;
 }
 
+VkCommandPool create_transfer_command_pool(const VkCommandPoolCreateFlags flags)
+{
+    const VkCommandPoolCreateInfo create_info {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = flags,
+        .queueFamilyIndex = transfer_queue_family_idx,
+    };
+
+    VkCommandPool cmd_pool = VK_NULL_HANDLE;
+    VK_CHECK( vkCreateCommandPool(vk_handle_device, &create_info, nullptr, &cmd_pool) );
+    return cmd_pool;
+}
+
 void reset_command_pool( const VkCommandPool pool )
 {
     VK_CHECK( vkResetCommandPool( vk_handle_device, pool, 0x0 ) );
@@ -875,7 +1564,12 @@ void free_memory(const VkDeviceMemory vk_handle_memory)
 
 void queue_submit(const uint32_t submit_count, const VkSubmitInfo* const p_submit_infos, const VkFence vk_handle_signal_fence)
 {
-    vkQueueSubmit(vk_handle_queue, submit_count, p_submit_infos, vk_handle_signal_fence);
+    VK_CHECK(vkQueueSubmit(vk_handle_queue, submit_count, p_submit_infos, vk_handle_signal_fence));
+}
+
+void transfer_queue_submit(const uint32_t submit_count, const VkSubmitInfo* const p_submit_infos, const VkFence vk_handle_signal_fence)
+{
+    VK_CHECK(vkQueueSubmit(vk_handle_transfer_queue, submit_count, p_submit_infos, vk_handle_signal_fence));
 }
 
 void device_wait_idle()
@@ -933,16 +1627,115 @@ void destroy_fence(const VkFence vk_handle_fence)
     vkDestroyFence(vk_handle_device, vk_handle_fence, nullptr);
 }
 
+VkSemaphore create_semaphore()
+{
+    const VkSemaphoreCreateInfo create_info {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+    };
+
+    VkSemaphore vk_handle_sem4 = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateSemaphore(vk_handle_device, &create_info, nullptr, &vk_handle_sem4));
+    return vk_handle_sem4;
+}
+
+VkSemaphore create_timeline_semaphore(const uint64_t initial_value)
+{
+    const VkSemaphoreTypeCreateInfo type_create_info {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = initial_value,
+    };
+
+    const VkSemaphoreCreateInfo create_info {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &type_create_info,
+        .flags = 0x0,
+    };
+
+    VkSemaphore vk_handle_sem4 = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateSemaphore(vk_handle_device, &create_info, nullptr, &vk_handle_sem4));
+    return vk_handle_sem4;
+}
+
+uint64_t get_semaphore_counter_value(const VkSemaphore vk_handle_sem4)
+{
+    uint64_t value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(vk_handle_device, vk_handle_sem4, &value));
+    return value;
+}
+
+void wait_semaphore(const VkSemaphore vk_handle_sem4, const uint64_t value, const uint64_t timeout)
+{
+    const VkSemaphoreWaitInfo wait_info {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .semaphoreCount = 1,
+        .pSemaphores = &vk_handle_sem4,
+        .pValues = &value,
+    };
+
+    VK_CHECK(vkWaitSemaphores(vk_handle_device, &wait_info, timeout));
+}
+
+void destroy_semaphore(const VkSemaphore vk_handle_sem4)
+{
+    vkDestroySemaphore(vk_handle_device, vk_handle_sem4, nullptr);
+}
+
 uint32_t get_queue_family_idx()
 {
     return queue_family_idx;
 }
 
+uint32_t get_transfer_queue_family_idx()
+{
+    return transfer_queue_family_idx;
+}
+
+bool has_dedicated_transfer_queue()
+{
+    return transfer_queue_family_idx != queue_family_idx;
+}
+
+bool has_multi_draw_indirect()
+{
+    return optional_device_features.multi_draw_indirect;
+}
+
+bool has_draw_indirect_count()
+{
+    return optional_device_features.draw_indirect_count;
+}
+
+bool has_index_type_uint8()
+{
+    return optional_device_features.index_type_uint8;
+}
+
+bool has_extended_dynamic_state()
+{
+    return optional_device_features.extended_dynamic_state;
+}
+
 VkImage get_active_swapchain_image()
 {
     return vk_handle_swapchain_image_list[active_swapchain_image_idx];
 }
 
+uint32_t get_active_swapchain_image_idx()
+{
+    return active_swapchain_image_idx;
+}
+
+uint32_t get_swapchain_image_count()
+{
+    return static_cast<uint32_t>(vk_handle_swapchain_image_list.size());
+}
+
 VkImageMemoryBarrier get_active_swapchain_image_memory_barrier(const VkAccessFlags src_access_flags, const VkAccessFlags dst_access_flags, const VkImageLayout old_layout, const VkImageLayout new_layout)
 {
     const VkImageMemoryBarrier barrier {